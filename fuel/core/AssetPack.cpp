@@ -0,0 +1,141 @@
+/*****************************************************************
+ * AssetPack.cpp
+ *****************************************************************
+ * Created on: 20.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include <cstring>
+#include "AssetPack.h"
+#include "LZ4.h"
+
+namespace fuel
+{
+	using namespace std;
+
+	namespace
+	{
+		// Content of empty assets, which are valid as well
+		const uint8_t EMPTY = 0;
+	}
+
+	vector<unique_ptr<AssetPack>> &AssetPack::getMounted(void)
+	{
+		static vector<unique_ptr<AssetPack>> packs;
+		return packs;
+	}
+
+	AssetPack::AssetPack(const string &filename)
+		:m_file(filename), m_pHeader(nullptr), m_pSeeds(nullptr), m_pEntries(nullptr), m_pNames(nullptr)
+	{
+		if(!m_file.isValid() || m_file.getSize() < sizeof(PackFile::Header)) return;
+
+		const PackFile::Header *pHeader = reinterpret_cast<const PackFile::Header *>(m_file.getData());
+		if(pHeader->magic != PackFile::MAGIC || (pHeader->entries > 0 && pHeader->buckets == 0)) return;
+
+		// Seeds follow the header, the entry table starts 8 byte aligned behind them
+		uint64_t size = m_file.getSize();
+		uint64_t tableOffset = (sizeof(PackFile::Header) + pHeader->buckets * 4ULL + 7) & ~7ULL;
+		if(tableOffset + pHeader->entries * static_cast<uint64_t>(sizeof(PackFile::Entry)) > size
+			|| pHeader->namesOffset > size || pHeader->namesSize > size - pHeader->namesOffset) return;
+
+		// Check every entry once, so lookups can trust the table
+		const PackFile::Entry *pEntries = reinterpret_cast<const PackFile::Entry *>(m_file.getData() + tableOffset);
+		for(uint32_t i = 0; i < pHeader->entries; ++i)
+		{
+			const PackFile::Entry &entry = pEntries[i];
+			if(entry.offset > size || entry.size > size - entry.offset
+				|| entry.nameOffset > pHeader->namesSize || entry.nameLength > pHeader->namesSize - entry.nameOffset
+				|| (entry.compression == PackFile::NONE && entry.size != entry.originalSize)
+				|| (entry.compression == PackFile::LZ4 && entry.originalSize / 255 > entry.size)
+				|| (entry.compression != PackFile::NONE && entry.compression != PackFile::LZ4)) return;
+		}
+
+		m_pHeader = pHeader;
+		m_pSeeds = reinterpret_cast<const uint32_t *>(pHeader + 1);
+		m_pEntries = pEntries;
+		m_pNames = reinterpret_cast<const char *>(m_file.getData() + pHeader->namesOffset);
+	}
+
+	const PackFile::Entry *AssetPack::find(const string &name) const
+	{
+		if(m_pHeader->entries == 0) return nullptr;
+
+		// Any name maps to exactly one slot, which holds the asset if the pack has it
+		uint64_t hash = hashFNV1a(name);
+		uint32_t seed = m_pSeeds[PackFile::bucket(hash, m_pHeader->buckets)];
+		const PackFile::Entry &entry = m_pEntries[PackFile::slot(hash, seed, m_pHeader->entries)];
+		if(entry.hash != hash || entry.nameLength != name.size() || memcmp(m_pNames + entry.nameOffset, name.data(), name.size()) != 0)
+		{
+			return nullptr;
+		}
+		return &entry;
+	}
+
+	bool AssetPack::mount(const string &filename)
+	{
+		unique_ptr<AssetPack> pPack(new AssetPack(filename));
+		if(pPack->m_pHeader == nullptr)
+		{
+			cerr << "Could not mount asset pack '" << filename << "'." << endl;
+			return false;
+		}
+
+		cout << "Mounted asset pack '" << filename << "' (" << pPack->m_pHeader->entries << " assets)." << endl;
+		getMounted().push_back(std::move(pPack));
+		return true;
+	}
+
+	AssetData AssetPack::open(const string &name, bool map)
+	{
+		AssetData asset;
+		for(const auto &pPack : getMounted())
+		{
+			const PackFile::Entry *pEntry = pPack->find(name);
+			if(pEntry == nullptr) continue;
+
+			const uint8_t *pPayload = pPack->m_file.getData() + pEntry->offset;
+			if(pEntry->compression == PackFile::NONE)
+			{
+				// Zero-copy
+				asset.m_pData = pPayload;
+				asset.m_size = pEntry->size;
+				return asset;
+			}
+
+			asset.m_buffer.resize(pEntry->originalSize);
+			if(!LZ4::decompress(pPayload, pEntry->size, asset.m_buffer.data(), asset.m_buffer.size()))
+			{
+				cerr << "Asset '" << name << "' is corrupt." << endl;
+				return AssetData();
+			}
+			asset.m_pData = asset.m_buffer.empty() ? &EMPTY : asset.m_buffer.data();
+			asset.m_size = asset.m_buffer.size();
+			return asset;
+		}
+
+		// Loose file
+		if(map)
+		{
+			asset.m_pFile = fuel::make_unique<MappedFile>(name);
+			asset.m_pData = asset.m_pFile->getData();
+			asset.m_size = asset.m_pFile->getSize();
+		}
+		else if(readFile(name, asset.m_buffer))
+		{
+			asset.m_pData = asset.m_buffer.empty() ? &EMPTY : asset.m_buffer.data();
+			asset.m_size = asset.m_buffer.size();
+		}
+		return asset;
+	}
+
+	bool AssetPack::exists(const string &name)
+	{
+		for(const auto &pPack : getMounted())
+		{
+			if(pPack->find(name)) return true;
+		}
+		return fileExists(name);
+	}
+}
@@ -0,0 +1,161 @@
+/*****************************************************************
+ * AssetPack.h
+ *****************************************************************
+ * Created on: 20.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef CORE_ASSETPACK_H_
+#define CORE_ASSETPACK_H_
+
+#include "MappedFile.h"
+#include "PackFile.h"
+
+namespace fuel
+{
+	/**
+	 * Content of an asset, as returned by AssetPack::open().
+	 * Points into the memory mapping of a pack for uncompressed entries,
+	 * otherwise owns the decompressed data or the loose file it was read from.
+	 * The content stays valid as long as the object and the pack are alive.
+	 */
+	class AssetData
+	{
+		friend class AssetPack;
+
+	private:
+		// Start of the content, nullptr if the asset was not found
+		const uint8_t *m_pData;
+
+		// Size of the content in bytes
+		size_t m_size;
+
+		// Decompressed entry or loose file content
+		std::vector<uint8_t> m_buffer;
+
+		// Mapping of a loose file
+		std::unique_ptr<MappedFile> m_pFile;
+
+	public:
+		/**
+		 * Instantiates an empty, invalid asset.
+		 */
+		AssetData(void)
+			:m_pData(nullptr), m_size(0)
+		{
+			;;
+		}
+
+		AssetData(AssetData &&) = default;
+		AssetData &operator=(AssetData &&) = default;
+
+		/**
+		 * Returns whether the asset was found.
+		 *
+		 * @return False if neither a pack nor the file system holds the asset.
+		 */
+		inline bool isValid(void) const { return m_pData != nullptr; }
+
+		/**
+		 * Returns the asset content.
+		 *
+		 * @return Start of the content.
+		 */
+		inline const uint8_t *getData(void) const { return m_pData; }
+
+		/**
+		 * Returns the asset size.
+		 *
+		 * @return Size in bytes.
+		 */
+		inline size_t getSize(void) const { return m_size; }
+	};
+
+	/**
+	 * Memory mapped asset pack (.fpk, see PackFile.h).
+	 * Packs are mounted once at startup, after which assets are opened by the same
+	 * file names the engine used before, searching the packs in mounting order and
+	 * falling back to the file system. Looking up a packed asset costs no system call
+	 * and uncompressed entries are never copied, their pages are loaded by the OS on
+	 * first access. Lookups may run on any thread, mounting must not overlap them.
+	 */
+	class AssetPack
+	{
+	private:
+		// Mapping of the pack file
+		MappedFile m_file;
+
+		// Tables within the mapping, the header is nullptr if the pack is invalid
+		const PackFile::Header *m_pHeader;
+		const uint32_t *m_pSeeds;
+		const PackFile::Entry *m_pEntries;
+		const char *m_pNames;
+
+		/**
+		 * Returns the mounted packs.
+		 *
+		 * @return Packs in mounting order.
+		 */
+		static std::vector<std::unique_ptr<AssetPack>> &getMounted(void);
+
+		/**
+		 * Maps a pack file and validates its tables.
+		 *
+		 * @param filename
+		 * 		Pack file.
+		 */
+		AssetPack(const std::string &filename);
+
+		/**
+		 * Looks up an entry.
+		 *
+		 * @param name
+		 * 		Asset file name.
+		 *
+		 * @return The entry, nullptr if the pack does not hold the asset.
+		 */
+		const PackFile::Entry *find(const std::string &name) const;
+
+	public:
+		AssetPack(const AssetPack &) = delete;
+		AssetPack &operator=(const AssetPack &) = delete;
+
+		/**
+		 * Maps a pack and adds it to the searched packs.
+		 * Intended to be called at startup, before any asset is opened.
+		 *
+		 * @param filename
+		 * 		Pack file.
+		 *
+		 * @return False if the pack could not be mapped or is corrupt.
+		 */
+		static bool mount(const std::string &filename);
+
+		/**
+		 * Opens an asset, packs first, then the file system.
+		 *
+		 * @param name
+		 * 		Asset file name, as stored in the pack.
+		 *
+		 * @param map
+		 * 		Memory map loose files rather than reading them,
+		 * 		for large files of which only parts are accessed.
+		 *
+		 * @return The asset content, invalid if it was not found.
+		 */
+		static AssetData open(const std::string &name, bool map = false);
+
+		/**
+		 * Returns whether an asset exists in a pack or the file system.
+		 *
+		 * @param name
+		 * 		Asset file name.
+		 *
+		 * @return Whether the asset exists.
+		 */
+		static bool exists(const std::string &name);
+	};
+}
+
+#endif // CORE_ASSETPACK_H_
@@ -0,0 +1,128 @@
+/*****************************************************************
+ * FileWatcher.cpp
+ *****************************************************************
+ * Created on: 10.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include <algorithm>
+#include "FileWatcher.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+namespace fuel
+{
+	using namespace std;
+
+	#ifdef __linux__
+
+	FileWatcher::FileWatcher(void)
+	{
+		m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(m_inotify < 0)
+		{
+			cerr << "Could not initialize inotify, file changes are not detected." << endl;
+		}
+	}
+
+	void FileWatcher::watch(const string &filename)
+	{
+		if(!m_files.insert(filename).second || m_inotify < 0) return;
+
+		// Watch the directory, editors often save by replacing the file
+		size_t slash = filename.find_last_of('/');
+		string prefix = (slash == string::npos) ? "" : filename.substr(0, slash + 1);
+		string directory = prefix.empty() ? "." : prefix;
+
+		int descriptor = inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if(descriptor < 0)
+		{
+			cerr << "Could not watch directory '" << directory << "'" << endl;
+			return;
+		}
+
+		// inotify returns the same descriptor for every path to the directory
+		m_directories[descriptor].insert(prefix);
+	}
+
+	vector<string> FileWatcher::poll(void)
+	{
+		vector<string> modified;
+		if(m_inotify < 0) return modified;
+
+		alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+		ssize_t length;
+		while((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
+		{
+			for(char *pEvent = buffer; pEvent < buffer + length; )
+			{
+				const inotify_event *pInfo = reinterpret_cast<const inotify_event *>(pEvent);
+				pEvent += sizeof(inotify_event) + pInfo->len;
+
+				auto directory = m_directories.find(pInfo->wd);
+				if(directory == m_directories.end() || pInfo->len == 0) continue;
+
+				for(const string &prefix : directory->second)
+				{
+					string filename = prefix + pInfo->name;
+					if(m_files.count(filename) > 0 && std::find(modified.begin(), modified.end(), filename) == modified.end())
+					{
+						modified.push_back(filename);
+					}
+				}
+			}
+		}
+		return modified;
+	}
+
+	FileWatcher::~FileWatcher(void)
+	{
+		if(m_inotify >= 0) close(m_inotify);
+	}
+
+	#else
+
+	FileWatcher::FileWatcher(void)
+	{
+		;;
+	}
+
+	time_t FileWatcher::getModificationTime(const string &filename)
+	{
+		struct stat info;
+		return (stat(filename.c_str(), &info) == 0) ? info.st_mtime : 0;
+	}
+
+	void FileWatcher::watch(const string &filename)
+	{
+		if(!m_files.insert(filename).second) return;
+		m_modificationTimes[filename] = getModificationTime(filename);
+	}
+
+	vector<string> FileWatcher::poll(void)
+	{
+		vector<string> modified;
+		for(auto &file : m_modificationTimes)
+		{
+			time_t modificationTime = getModificationTime(file.first);
+			if(modificationTime != file.second)
+			{
+				file.second = modificationTime;
+				modified.push_back(file.first);
+			}
+		}
+		return modified;
+	}
+
+	FileWatcher::~FileWatcher(void)
+	{
+		;;
+	}
+
+	#endif
+}
@@ -0,0 +1,81 @@
+/*****************************************************************
+ * FileWatcher.h
+ *****************************************************************
+ * Created on: 10.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef CORE_FILEWATCHER_H_
+#define CORE_FILEWATCHER_H_
+
+#include <map>
+#include <set>
+#include <ctime>
+#include "Util.h"
+
+namespace fuel
+{
+	/**
+	 * Reports modifications of a set of files.
+	 * Uses inotify on Linux, watching the containing directories so that
+	 * editors replacing files on save are noticed as well. Other platforms
+	 * compare modification times whenever poll() is called.
+	 */
+	class FileWatcher
+	{
+	private:
+		// Watched files, as passed to watch()
+		std::set<std::string> m_files;
+
+		#ifdef __linux__
+			// inotify instance
+			int m_inotify;
+
+			// Path prefixes of each watched directory by watch descriptor,
+			// several if the directory was reached along different paths
+			std::map<int, std::set<std::string>> m_directories;
+		#else
+			// Last known modification time of each watched file
+			std::map<std::string, time_t> m_modificationTimes;
+
+			/**
+			 * Returns the modification time of a file.
+			 *
+			 * @param filename
+			 * 		File name.
+			 *
+			 * @return Modification time, 0 if the file does not exist.
+			 */
+			static time_t getModificationTime(const std::string &filename);
+		#endif
+
+	public:
+		/**
+		 * Instantiates a new file watcher without any files.
+		 */
+		FileWatcher(void);
+
+		/**
+		 * Starts watching a file. Watching a file twice has no effect.
+		 *
+		 * @param filename
+		 * 		File name, reported back by poll() exactly as given.
+		 */
+		void watch(const std::string &filename);
+
+		/**
+		 * Returns the watched files modified since the last call without blocking.
+		 *
+		 * @return Modified files, each at most once.
+		 */
+		std::vector<std::string> poll(void);
+
+		/**
+		 * Stops watching all files.
+		 */
+		~FileWatcher(void);
+	};
+}
+
+#endif // CORE_FILEWATCHER_H_
@@ -11,33 +11,106 @@
 #define RESOLUTION_X		 	1440
 #define RESOLUTION_Y 			810
 #define FULLSCREEN				0
+#define RESIZABLE				1
+// G-buffer samples per pixel. Above 1 the G-buffer attachments become multisampled
+// (GL_TEXTURE_2D_MULTISAMPLE) and fullscreen passes run twice per frame, once for
+// pixels without edges and once per sample for edge pixels. Scene shaders then have
+// to read the G-buffer through sampler2DMS and texelFetch, shading and averaging
+// Game::getShadingSampleCount() samples, plain sampler2D reads return black.
+#define MSAA_SAMPLES			1
+#define TEMPORAL_AA				0
+#define TARGET_GPU_TIME			0.014f
+#define MIN_RESOLUTION_SCALE	0.5f
+#define RENDER_TARGET_BUDGET	(128u << 20)
+#define SHADER_HOT_RELOAD		1
+#define MAX_OBJECTS_PER_FRAME	4096
+#define TEXTURE_UPLOAD_BUDGET	(4u << 20)
+#define TEXTURE_BUDGET			(512u << 20)
+#define ASSET_PACK				"res.fpk"
+#define MATERIAL_TEXTURES		4
 
 namespace fuel
 {
 	Game::Game(void)
-		:m_window({RESOLUTION_X, RESOLUTION_Y, FULLSCREEN}),
+		:m_window({RESOLUTION_X, RESOLUTION_Y, FULLSCREEN, "", RESIZABLE}),
 		 m_keyboard(m_window),
 		 m_projection(glm::perspective(45.0f, RESOLUTION_X / (float)RESOLUTION_Y, 0.1f, 100.0f)),
-		 m_deferredFBO(RESOLUTION_X, RESOLUTION_Y),
+		 m_renderProjection(m_projection),
+		 m_previousViewProjection(m_projection),
+		 m_renderTargetPool(RENDER_TARGET_BUDGET),
+		 m_deferredFBO(m_renderTargetPool, RESOLUTION_X, RESOLUTION_Y, TEMPORAL_AA ? 1 : MSAA_SAMPLES),
+		 m_dynamicResolution(TARGET_GPU_TIME, MIN_RESOLUTION_SCALE),
+		 m_shadingSampleCount(1),
+		 m_cameraUBO(CAMERA_BLOCK, sizeof(CameraBlock)),
+		 m_frameUBO(FRAME_BLOCK, sizeof(FrameBlock)),
+		 m_lightUBO(LIGHT_BLOCK, sizeof(LightBlock)),
+		 m_objectUBO(OBJECT_BLOCK, sizeof(ObjectBlock), MAX_OBJECTS_PER_FRAME),
+		 m_textureMgr(TEXTURE_UPLOAD_BUDGET, TEXTURE_BUDGET),
+		 m_materials(m_textureMgr, MATERIAL_BLOCK, MATERIAL_TEXTURES),
 		 m_pSceneRoot(nullptr),
 		 m_sleepTime(0.0f),
 		 m_updateTime(0.0f),
 		 m_geomRenderTime(0.0f),
-		 m_fsRenderTime(0.0f)
+		 m_fsRenderTime(0.0f),
+		 m_gpuRenderTime(0.0f),
+		 m_pendingShaderPrograms(~0u),
+		 m_frame(0)
 	{
 		// Seed RNG
 		srand(time(nullptr));
 
+		// Resources are read from the asset pack if there is one, loose files otherwise
+		if(fileExists(ASSET_PACK)) AssetPack::mount(ASSET_PACK);
+
 		// Move camera
 		m_camera.getTransform().setPosition({0, 0, 5});
 
+		// Engine uniform blocks are found at the same binding points in every program
+		GLShaderProgram::setDefaultBlockBinding("CameraBlock", CAMERA_BLOCK);
+		GLShaderProgram::setDefaultBlockBinding("FrameBlock",  FRAME_BLOCK);
+		GLShaderProgram::setDefaultBlockBinding("LightBlock",  LIGHT_BLOCK);
+		GLShaderProgram::setDefaultBlockBinding("ObjectBlock", OBJECT_BLOCK);
+		setPointLights({});
+
 		// Setup default deferred framebuffer (diffuse, position & normal channels, depth)
 		GLFramebuffer::bind(m_deferredFBO);
 		m_deferredFBO.attach("diffuse",  GL_RGB32F);
 		m_deferredFBO.attach("normal",   GL_RGB32F);
 		m_deferredFBO.attach("depth",    GL_DEPTH_COMPONENT32F);
-		m_deferredFBO.setDrawAttachments({"diffuse", "normal"});
+		if(TEMPORAL_AA)
+		{
+			m_deferredFBO.attach("velocity", GL_RG16F);
+			m_deferredFBO.setDrawAttachments({"diffuse", "normal", "velocity"});
+		}
+		else m_deferredFBO.setDrawAttachments({"diffuse", "normal"});
 		GLFramebuffer::unbind();
+
+		// Temporal resolve from G-buffer to window resolution
+		if(TEMPORAL_AA)
+		{
+			m_pTemporalAA = make_unique<TemporalAA>(m_renderTargetPool,
+				m_deferredFBO.getWidth(), m_deferredFBO.getHeight(),
+				m_window.getFramebufferWidth(), m_window.getFramebufferHeight());
+		}
+
+		// Keep a full set of render targets idle, so resizing back and forth reuses them
+		size_t renderTargetSize = m_deferredFBO.getByteSize() + (m_pTemporalAA ? m_pTemporalAA->getByteSize() : 0);
+		m_renderTargetPool.setIdleBudget(std::max<size_t>(RENDER_TARGET_BUDGET, 2 * renderTargetSize));
+
+		// Edge classification for per-sample shading
+		if(m_deferredFBO.getSamples() > 1)
+		{
+			m_pClassifyShader = make_unique<GLShaderProgram>();
+			m_pClassifyShader->setDefine("SAMPLE_COUNT", to_string(m_deferredFBO.getSamples()));
+			m_pClassifyShader->setShader(EGLShaderType::VERTEX,   "res/glsl/fullscreen.vert");
+			m_pClassifyShader->setShader(EGLShaderType::FRAGMENT, "res/glsl/classify.frag");
+			m_pClassifyShader->bindVertexAttribute(0, "vPosition");
+			m_pClassifyShader->bindVertexAttribute(1, "vTexCoord");
+			m_pClassifyShader->link();
+			m_classifyNormalUnit = m_pClassifyShader->getUniformHandle<GLint>("uNormalUnit");
+			m_classifyDepthUnit  = m_pClassifyShader->getUniformHandle<GLint>("uDepthUnit");
+			m_classifyScreenSize = m_pClassifyShader->getUniformHandle<glm::vec2>("uScreenSize");
+		}
 	}
 
 	void Game::update(void)
@@ -75,9 +148,35 @@ namespace fuel
 			 << endl;
 	}
 
+	void Game::updateRenderResolution(void)
+	{
+		uint16_t width = m_window.getFramebufferWidth();
+		uint16_t height = m_window.getFramebufferHeight();
+		bool resize = false;
+
+		// Window was resized, keep the vertical field of view
+		if(m_window.wasResized() && width > 0 && height > 0)
+		{
+			m_projection[0][0] = m_projection[1][1] * height / width;
+			resize = true;
+		}
+
+		// Results arrive a few frames late, so this never waits for the GPU
+		if(m_gpuTimer.poll(m_gpuRenderTime) && m_dynamicResolution.update(m_gpuRenderTime))
+			resize = true;
+
+		// Minimized windows have a zero sized framebuffer
+		if(resize && width > 0 && height > 0)
+		{
+			m_deferredFBO.resize(m_dynamicResolution.scale(width), m_dynamicResolution.scale(height));
+			if(m_pTemporalAA) m_pTemporalAA->resize(m_deferredFBO.getWidth(), m_deferredFBO.getHeight(), width, height);
+		}
+	}
+
 	void Game::prepareGeometryPasses(void)
 	{
 		GLFramebuffer::bind(m_deferredFBO);
+		glViewport(0, 0, m_deferredFBO.getWidth(), m_deferredFBO.getHeight());
 
 		//Disable blending, enable depth
 		glDepthMask(GL_TRUE);
@@ -89,7 +188,18 @@ namespace fuel
 
 	void Game::prepareFullscreenPasses(void)
 	{
-		GLFramebuffer::unbind();
+		if(m_pTemporalAA)
+		{
+			// Lit image stays at G-buffer resolution until the temporal resolve
+			GLFramebuffer &target = m_pTemporalAA->getColorFramebuffer();
+			GLFramebuffer::bind(target, GLFramebuffer::DRAW);
+			glViewport(0, 0, target.getWidth(), target.getHeight());
+		}
+		else
+		{
+			GLFramebuffer::unbind();
+			glViewport(0, 0, m_window.getFramebufferWidth(), m_window.getFramebufferHeight());
+		}
 		glClear(GL_COLOR_BUFFER_BIT);
 
 		GLFramebuffer::bind(m_deferredFBO, GLFramebuffer::READ);
@@ -102,6 +212,56 @@ namespace fuel
 		glBlendFunc(GL_ONE, GL_ONE);
 	}
 
+	void Game::classifyComplexPixels(void)
+	{
+		glEnable(GL_STENCIL_TEST);
+		glStencilMask(0xFF);
+		glClearStencil(0);
+		glClear(GL_STENCIL_BUFFER_BIT);
+
+		// Write 1 wherever the classification shader keeps the fragment
+		glStencilFunc(GL_ALWAYS, 1, 0xFF);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+		m_pClassifyShader->use();
+		m_classifyNormalUnit.set(static_cast<GLint>(m_deferredFBO.getAttachment("normal").textureUnit));
+		m_classifyDepthUnit.set(static_cast<GLint>(m_deferredFBO.getAttachment("depth").textureUnit));
+		m_classifyScreenSize.set(glm::vec2(m_window.getFramebufferWidth(), m_window.getFramebufferHeight()));
+		m_window.renderFullscreenQuad();
+
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glStencilMask(0x00);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+	}
+
+	void Game::renderFullscreenPasses(void)
+	{
+		if(!m_pSceneRoot) return;
+
+		if(m_deferredFBO.getSamples() == 1)
+		{
+			m_shadingSampleCount = 1;
+			m_pSceneRoot->fullscreenPass(*this);
+			return;
+		}
+
+		this->classifyComplexPixels();
+
+		// Pixels without edges, shade a single sample
+		m_shadingSampleCount = 1;
+		glStencilFunc(GL_EQUAL, 0, 0xFF);
+		m_pSceneRoot->fullscreenPass(*this);
+
+		// Edge pixels, shade every sample
+		m_shadingSampleCount = m_deferredFBO.getSamples();
+		glStencilFunc(GL_EQUAL, 1, 0xFF);
+		m_pSceneRoot->fullscreenPass(*this);
+
+		glDisable(GL_STENCIL_TEST);
+		m_shadingSampleCount = 1;
+	}
+
 	void Game::prepareGUIPasses(void)
 	{
 		GLFramebuffer::bind(m_deferredFBO, GLFramebuffer::READ);
@@ -118,8 +278,36 @@ namespace fuel
 	{
 		float startTime = static_cast<float>(glfwGetTime());
 
+		// Finish shader programs compiled in the background, report startup cost once all are done
+		if(SHADER_HOT_RELOAD) m_shaderMgr.update();
+		unsigned pendingShaderPrograms = GLShaderProgram::pollPending();
+		if(pendingShaderPrograms == 0 && m_pendingShaderPrograms > 0) GLProgramCache::printStatistics();
+		m_pendingShaderPrograms = pendingShaderPrograms;
+
+		// Upload textures decoded in the background, evict textures over budget
+		m_textureMgr.update();
+
+		// Material textures may have been replaced by the texture manager
+		m_materials.update();
+		m_materials.bind();
+
+		// Jitter the projection by a different sub-pixel offset every frame
+		if(m_pTemporalAA)
+		{
+			m_pTemporalAA->advanceJitter();
+			m_renderProjection = m_pTemporalAA->jitterProjection(m_projection);
+		}
+		else m_renderProjection = m_projection;
+
+		// Per-frame uniform blocks, shared by all programs
+		GLCallCounter::reset();
+		++m_frame;
+		m_objectUBO.beginFrame();
+		this->updateUniformBlocks();
+
 		// Prepare geometry passes
 		m_window.prepare();
+		m_gpuTimer.begin();
 		this->prepareGeometryPasses();
 
 		// Render scene
@@ -137,7 +325,9 @@ namespace fuel
 
 		// Fullscreen passes
 		this->prepareFullscreenPasses();
-		if(m_pSceneRoot) m_pSceneRoot->fullscreenPass(*this);
+		this->renderFullscreenPasses();
+		if(m_pTemporalAA) m_pTemporalAA->resolve(m_window, m_deferredFBO);
+		m_gpuTimer.end();
 
 		// GUI passes
 		this->prepareGUIPasses();
@@ -153,15 +343,88 @@ namespace fuel
 		}
 
 		m_window.display();
+		m_objectUBO.endFrame();
+
+		// Remember camera for next frame's motion vectors
+		m_previousViewProjection = calculateUnjitteredViewProjectionMatrix();
 
 		// Determine fullscreen passes rendering time
 		cout << "Fullscreen passes:\t"
 			 << 1E3 * (m_fsRenderTime = static_cast<float>(glfwGetTime()) - startTime)
 			 << "ms."
+			 << endl;
+		GLCallCounter::print();
+		GLMemoryCounter::print();
+
+		// Adapt internal resolution to the GPU load
+		this->updateRenderResolution();
+		cout << "GPU passes:\t\t"
+			 << 1E3 * m_gpuRenderTime
+			 << "ms at "
+			 << m_deferredFBO.getWidth() << "x" << m_deferredFBO.getHeight()
+			 << "."
 			 << endl << endl;
 	}
 
+	void Game::updateUniformBlocks(void)
+	{
+		CameraBlock camera;
+		camera.view = m_camera.calculateViewMatrix();
+		camera.projection = m_renderProjection;
+		camera.viewProjection = m_renderProjection * camera.view;
+		camera.previousViewProjection = m_previousViewProjection;
+		camera.position = glm::vec4(m_camera.getTransform().getPosition(), 1.0f);
+		m_cameraUBO.update(camera);
+
+		float renderWidth = m_deferredFBO.getWidth(), renderHeight = m_deferredFBO.getHeight();
+		float outputWidth = m_window.getFramebufferWidth(), outputHeight = m_window.getFramebufferHeight();
+		FrameBlock frame;
+		frame.renderSize = glm::vec4(renderWidth, renderHeight, 1.0f / renderWidth, 1.0f / renderHeight);
+		frame.outputSize = glm::vec4(outputWidth, outputHeight, 1.0f / outputWidth, 1.0f / outputHeight);
+		frame.jitter = m_pTemporalAA ? m_pTemporalAA->getJitter() : glm::vec2(0.0f);
+		frame.time = static_cast<float>(glfwGetTime());
+		frame.padding = 0.0f;
+		m_frameUBO.update(frame);
+
+		m_cameraUBO.bind();
+		m_frameUBO.bind();
+		m_lightUBO.bind();
+	}
+
+	void Game::setPointLights(const vector<PointLight> &lights)
+	{
+		LightBlock block;
+		unsigned count = std::min<unsigned>(lights.size(), MAX_POINT_LIGHTS);
+		block.count = glm::ivec4(count, 0, 0, 0);
+		for(unsigned i = 0; i < count; ++i)
+		{
+			const PointLight &light = lights[i];
+			block.pointLights[i].positionRadius = glm::vec4(light.position, light.getRadius());
+			block.pointLights[i].color = glm::vec4(light.color, 1.0f);
+			block.pointLights[i].attenuation = glm::vec4(light.linearAttenuation, light.quadraticAttenuation, 0.0f, 0.0f);
+		}
+
+		// Only the used part of the light array is uploaded
+		m_lightUBO.update(&block, sizeof(block.count) + count * sizeof(PointLightData));
+	}
+
+	bool Game::setObjectTransform(Transform &transform)
+	{
+		ObjectBlock object;
+		object.world = transform.commitWorldMatrix(m_frame);
+		object.previousWorld = transform.getPreviousWorldMatrix();
+		if(m_objectUBO.push(object)) return true;
+
+		cerr << "More than " << MAX_OBJECTS_PER_FRAME << " objects drawn this frame." << endl;
+		return false;
+	}
+
 	glm::mat4 Game::calculateViewProjectionMatrix(void)
+	{
+		return m_renderProjection * m_camera.calculateViewMatrix();
+	}
+
+	glm::mat4 Game::calculateUnjitteredViewProjectionMatrix(void)
 	{
 		return m_projection * m_camera.calculateViewMatrix();
 	}
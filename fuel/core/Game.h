@@ -13,9 +13,18 @@
 #include "Util.h"
 #include "../mgmt/ShaderManager.h"
 #include "../mgmt/TextureManager.h"
+#include "../graphics/shaders/GLProgramCache.h"
 #include "../graphics/GLWindow.h"
 #include "../graphics/GLVertexArray.h"
 #include "../graphics/GLFramebuffer.h"
+#include "../graphics/GLTimerQuery.h"
+#include "../graphics/DynamicResolution.h"
+#include "../graphics/TemporalAA.h"
+#include "../graphics/GLUniformBuffer.h"
+#include "../graphics/GLUniformRing.h"
+#include "../graphics/GLMaterialTable.h"
+#include "../graphics/UniformBlocks.h"
+#include "../graphics/lighting/PointLight.h"
 #include "../graphics/Camera.h"
 #include "../input/Keyboard.h"
 #include "GameComponent.h"
@@ -34,18 +43,55 @@ namespace fuel
 		// Projection matrix
 		glm::mat4 m_projection;
 
+		// Projection matrix used for rendering the current frame (jittered with TAA)
+		glm::mat4 m_renderProjection;
+
+		// Unjittered view-projection matrix of the previous frame
+		glm::mat4 m_previousViewProjection;
+
 		// Main camera
 		Camera m_camera;
 
+		// Pool of render target textures
+		GLTexturePool m_renderTargetPool;
+
 		// Framebuffer object used to render GBuffer textures to
 		GLFramebuffer m_deferredFBO;
 
+		// GPU timer around the geometry and fullscreen passes
+		GLTimerQuery m_gpuTimer;
+
+		// Controls the internal resolution of the deferred FBO
+		DynamicResolution m_dynamicResolution;
+
+		// Shader marking pixels whose G-buffer samples differ (MSAA only)
+		unique_ptr<GLShaderProgram> m_pClassifyShader;
+
+		// Uniforms of the classification shader
+		GLUniformHandle<GLint> m_classifyNormalUnit, m_classifyDepthUnit;
+		GLUniformHandle<glm::vec2> m_classifyScreenSize;
+
+		// Samples per pixel the current fullscreen pass has to shade
+		uint8_t m_shadingSampleCount;
+
+		// Temporal anti-aliasing and upsampling stage (if enabled)
+		unique_ptr<TemporalAA> m_pTemporalAA;
+
+		// Uniform buffers of the camera, frame and light blocks
+		GLUniformBuffer m_cameraUBO, m_frameUBO, m_lightUBO;
+
+		// Per-object blocks of the current frame's draws
+		GLUniformRing m_objectUBO;
+
 		// Shader program manager
 		ShaderManager m_shaderMgr;
 
 		// Texture manager
 		TextureManager m_textureMgr;
 
+		// Textures of the scene's materials, selected per draw
+		GLMaterialTable m_materials;
+
 		// Scene root
 		GameComponent *m_pSceneRoot;
 
@@ -61,6 +107,15 @@ namespace fuel
 		// Time taken for fullscreen passes in seconds
 		float m_fsRenderTime;
 
+		// GPU time taken for geometry and fullscreen passes in seconds
+		float m_gpuRenderTime;
+
+		// Number of shader programs still being compiled in the background
+		unsigned m_pendingShaderPrograms;
+
+		// Number of the frame being rendered, object transforms are committed per frame
+		uint32_t m_frame;
+
 		/**
 		 * Updates the current scene.
 		 */
@@ -71,20 +126,51 @@ namespace fuel
 		 */
 		void render(void);
 
+		/**
+		 * Reads back the GPU frame time and resizes the deferred FBO
+		 * if the window was resized or the dynamic resolution controller asks for it.
+		 * On window resizes the projection's aspect ratio is corrected as well,
+		 * keeping its vertical field of view.
+		 */
+		void updateRenderResolution(void);
+
 		/**
 		 * Prepares the renderer for following geometry passes.
-		 * This binds the deferred FBO and clears its buffers.
+		 * This binds the deferred FBO, sets the viewport to its size and clears its buffers.
 		 * Also enables depth tests and disables blending.
 		 */
 		void prepareGeometryPasses(void);
 
 		/**
 		 * Prepares the renderer for following fullscreen passes.
-		 * This binds the default FBO and clears its color buffer.
+		 * This binds the default FBO, sets the viewport to the window size and clears its color buffer.
+		 * Sampling the deferred FBO here upscales it to the window resolution.
+		 * With TAA the lit image is rendered at G-buffer resolution instead
+		 * and upscaled by the temporal resolve.
 		 * Also disables depth tests and enables blending.
 		 */
 		void prepareFullscreenPasses(void);
 
+		/**
+		 * Marks pixels of the multisampled G-buffer whose samples differ
+		 * by writing 1 to the stencil buffer, all other pixels receive 0.
+		 * Leaves the stencil test enabled with writes masked.
+		 */
+		void classifyComplexPixels(void);
+
+		/**
+		 * Runs the fullscreen passes of the scene.
+		 * With a multisampled G-buffer this happens twice: once per pixel for pixels
+		 * without edges and once per sample for the pixels marked complex.
+		 */
+		void renderFullscreenPasses(void);
+
+		/**
+		 * Uploads the camera and frame blocks and binds all engine uniform blocks.
+		 * Called once per frame before any geometry is drawn.
+		 */
+		void updateUniformBlocks(void);
+
 		/**
 		 * Prepares the renderer for following GUI passes.
 		 * Binds the deferred FBO for reading and enables depth.
@@ -139,6 +225,31 @@ namespace fuel
 		 */
 		inline Keyboard &getKeyboard(void){ return m_keyboard; }
 
+		/**
+		 * Returns the dynamic resolution controller.
+		 *
+		 * @return Dynamic resolution controller.
+		 */
+		inline DynamicResolution &getDynamicResolution(void){ return m_dynamicResolution; }
+
+		/**
+		 * Returns the number of G-buffer samples the current fullscreen pass
+		 * has to shade per pixel and average. This is 1 for pixels without
+		 * geometric edges and the MSAA sample count for edge pixels.
+		 * Always 1 unless MSAA_SAMPLES is raised above its default of 1 in Game.cpp,
+		 * which requires shaders reading the G-buffer through sampler2DMS and texelFetch.
+		 *
+		 * @return Number of samples to shade.
+		 */
+		inline uint8_t getShadingSampleCount(void) const { return m_shadingSampleCount; }
+
+		/**
+		 * Returns the deferred framebuffer holding the G-buffer.
+		 *
+		 * @return Deferred framebuffer.
+		 */
+		inline const GLFramebuffer &getDeferredFramebuffer(void) const { return m_deferredFBO; }
+
 		/**
 		 * Returns the texture manager.
 		 *
@@ -146,6 +257,15 @@ namespace fuel
 		 */
 		inline TextureManager &getTextureManager(void){ return m_textureMgr; }
 
+		/**
+		 * Returns the material table, bound for every geometry pass.
+		 * Shaders including materials.glsl need FUEL_BINDLESS defined if it is bindless,
+		 * and FUEL_NONUNIFORM_MATERIALS to select materials per instance.
+		 *
+		 * @return Material table.
+		 */
+		inline GLMaterialTable &getMaterialTable(void){ return m_materials; }
+
 		/**
 		 * Returns the shader manager.
 		 *
@@ -169,29 +289,87 @@ namespace fuel
 		inline void setSceneRoot(GameComponent *root){ m_pSceneRoot = root; }
 
 		/**
-		 * Returns the projection matrix.
+		 * Returns the temporal anti-aliasing stage.
+		 *
+		 * @return TAA stage. Null if TAA is disabled.
+		 */
+		inline TemporalAA *getTemporalAA(void){ return m_pTemporalAA.get(); }
+
+		/**
+		 * Returns the projection matrix used to render the current frame.
+		 * With TAA this includes the frame's sub-pixel jitter.
 		 *
 		 * @return
 		 * 		The projection matrix.
 		 */
-		inline const glm::mat4 &getProjectionMatrix(void) const{ return m_projection; }
+		inline const glm::mat4 &getProjectionMatrix(void) const{ return m_renderProjection; }
+
+		/**
+		 * Returns the projection matrix without TAA jitter.
+		 *
+		 * @return
+		 * 		The unjittered projection matrix.
+		 */
+		inline const glm::mat4 &getUnjitteredProjectionMatrix(void) const{ return m_projection; }
 
 		/**
 		 * Sets the projection matrix.
+		 * With TAA the jitter is applied on top of it every frame.
 		 *
 		 * @param projection
 		 *		New projection matrix.
 		 */
-		inline void setProjectionMatrix(const glm::mat4 &projection){ m_projection = projection; }
+		inline void setProjectionMatrix(const glm::mat4 &projection){ m_projection = m_renderProjection = projection; }
 
 		/**
-		 * Returns the view-projection-matrix.
+		 * Returns the view-projection-matrix used to render the current frame.
 		 *
 		 * @return
 		 *		View-projection-matrix. (P x V)
 		 */
 		glm::mat4 calculateViewProjectionMatrix(void);
 
+		/**
+		 * Returns the view-projection-matrix without TAA jitter.
+		 * Motion vectors are computed from this and the previous frame's matrix.
+		 *
+		 * @return
+		 *		Unjittered view-projection-matrix. (P x V)
+		 */
+		glm::mat4 calculateUnjitteredViewProjectionMatrix(void);
+
+		/**
+		 * Uploads the scene's point lights to the light block.
+		 * Only needs to be called when the lights change.
+		 *
+		 * @param lights
+		 * 		Point lights, only the first MAX_POINT_LIGHTS are used.
+		 */
+		void setPointLights(const vector<PointLight> &lights);
+
+		/**
+		 * Uploads the object block for the next draw call and binds it.
+		 * Replaces setting the world matrices as individual uniforms.
+		 * Commits the transform's world matrix for this frame, so the next
+		 * frame's previous world matrix is the one drawn now.
+		 *
+		 * @param transform
+		 * 		Transform of the object drawn next.
+		 *
+		 * @return False if the per-frame object limit is exceeded.
+		 */
+		bool setObjectTransform(Transform &transform);
+
+		/**
+		 * Returns the unjittered view-projection-matrix of the previous frame.
+		 * Geometry passes write (current - previous) texture space positions
+		 * into the "velocity" attachment when TAA is enabled.
+		 *
+		 * @return
+		 *		Previous view-projection-matrix. (P x V)
+		 */
+		inline const glm::mat4 &getPreviousViewProjectionMatrix(void) const{ return m_previousViewProjection; }
+
 		/**
 		 * Releases any resources and destroy scene root.
 		 */
@@ -0,0 +1,175 @@
+/*****************************************************************
+ * LZ4.cpp
+ *****************************************************************
+ * Created on: 20.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include <cstring>
+#include <algorithm>
+#include "LZ4.h"
+
+namespace fuel
+{
+	namespace LZ4
+	{
+		namespace
+		{
+			// Shortest match the format can encode
+			const size_t MIN_MATCH = 4;
+
+			// The last bytes of a block are always literals
+			const size_t LAST_LITERALS = 5;
+
+			// The last match has to start this many bytes before the end of the block
+			const size_t MATCH_LIMIT = 12;
+
+			// Farthest distance a match may reference
+			const size_t MAX_OFFSET = 65535;
+
+			// Size of the match finder's hash table, as a power of two
+			const unsigned HASH_BITS = 12;
+
+			/**
+			 * Reads 4 bytes in native byte order.
+			 */
+			inline uint32_t read32(const uint8_t *pData)
+			{
+				uint32_t value;
+				memcpy(&value, pData, sizeof(value));
+				return value;
+			}
+
+			/**
+			 * Hashes the 4 bytes at a position into the match finder's table.
+			 */
+			inline uint32_t hash(const uint8_t *pData)
+			{
+				return (read32(pData) * 2654435761u) >> (32 - HASH_BITS);
+			}
+
+			/**
+			 * Writes the continuation bytes of a length that did not fit into the token.
+			 */
+			inline uint8_t *writeLength(uint8_t *pDest, size_t length)
+			{
+				for(; length >= 255; length -= 255) *pDest++ = 255;
+				*pDest++ = static_cast<uint8_t>(length);
+				return pDest;
+			}
+
+			/**
+			 * Reads the continuation bytes of a length, false if they run past the block.
+			 */
+			inline bool readLength(const uint8_t *&pSource, const uint8_t *pEnd, size_t &length)
+			{
+				uint8_t byte;
+				do
+				{
+					if(pSource == pEnd) return false;
+					byte = *pSource++;
+					length += byte;
+				}
+				while(byte == 255);
+				return true;
+			}
+		}
+
+		size_t compress(const uint8_t *pSource, size_t size, uint8_t *pDest, size_t capacity)
+		{
+			uint32_t table[1 << HASH_BITS] = {0};
+			uint8_t *pOut = pDest, *pOutEnd = pDest + capacity;
+			size_t anchor = 0, pos = 0;
+
+			// Greedy matching, skipping faster through incompressible data
+			if(size > MATCH_LIMIT)
+			{
+				size_t matchEnd = size - LAST_LITERALS;
+				unsigned misses = 0;
+				while(pos <= size - MATCH_LIMIT)
+				{
+					uint32_t &slot = table[hash(pSource + pos)];
+					size_t ref = slot;
+					slot = static_cast<uint32_t>(pos);
+					if(ref >= pos || pos - ref > MAX_OFFSET || read32(pSource + ref) != read32(pSource + pos))
+					{
+						pos += 1 + (misses++ >> 6);
+						continue;
+					}
+					misses = 0;
+
+					// Extend the match in both directions
+					while(pos > anchor && ref > 0 && pSource[pos - 1] == pSource[ref - 1]){ --pos; --ref; }
+					size_t length = MIN_MATCH;
+					while(pos + length < matchEnd && pSource[ref + length] == pSource[pos + length]) ++length;
+
+					// Token, literals, offset and match length
+					size_t literals = pos - anchor;
+					if(static_cast<size_t>(pOutEnd - pOut) < 1 + literals + literals / 255 + 1 + 2 + (length - MIN_MATCH) / 255 + 1) return 0;
+					uint8_t *pToken = pOut++;
+					*pToken = static_cast<uint8_t>(std::min<size_t>(literals, 15) << 4);
+					if(literals >= 15) pOut = writeLength(pOut, literals - 15);
+					memcpy(pOut, pSource + anchor, literals);
+					pOut += literals;
+
+					size_t offset = pos - ref;
+					*pOut++ = static_cast<uint8_t>(offset);
+					*pOut++ = static_cast<uint8_t>(offset >> 8);
+					*pToken |= static_cast<uint8_t>(std::min<size_t>(length - MIN_MATCH, 15));
+					if(length - MIN_MATCH >= 15) pOut = writeLength(pOut, length - MIN_MATCH - 15);
+
+					pos += length;
+					anchor = pos;
+				}
+			}
+
+			// Trailing literals end the block
+			size_t literals = size - anchor;
+			if(static_cast<size_t>(pOutEnd - pOut) < 1 + literals + literals / 255 + 1) return 0;
+			*pOut++ = static_cast<uint8_t>(std::min<size_t>(literals, 15) << 4);
+			if(literals >= 15) pOut = writeLength(pOut, literals - 15);
+			memcpy(pOut, pSource + anchor, literals);
+			return pOut + literals - pDest;
+		}
+
+		bool decompress(const uint8_t *pSource, size_t size, uint8_t *pDest, size_t destSize)
+		{
+			const uint8_t *pEnd = pSource + size;
+			uint8_t *pOut = pDest;
+			while(pSource < pEnd)
+			{
+				uint8_t token = *pSource++;
+
+				// Literals
+				size_t literals = token >> 4;
+				if(literals == 15 && !readLength(pSource, pEnd, literals)) return false;
+				if(literals > static_cast<size_t>(pEnd - pSource) || literals > destSize - (pOut - pDest)) return false;
+				memcpy(pOut, pSource, literals);
+				pSource += literals;
+				pOut += literals;
+
+				// The last sequence has no match
+				if(pSource == pEnd) break;
+
+				// Match
+				if(pEnd - pSource < 2) return false;
+				size_t offset = pSource[0] | (pSource[1] << 8);
+				pSource += 2;
+				if(offset == 0 || offset > static_cast<size_t>(pOut - pDest)) return false;
+
+				size_t length = token & 15;
+				if(length == 15 && !readLength(pSource, pEnd, length)) return false;
+				length += MIN_MATCH;
+				if(length > destSize - (pOut - pDest)) return false;
+
+				// Overlapping matches repeat the last offset bytes
+				const uint8_t *pMatch = pOut - offset;
+				if(offset >= length) memcpy(pOut, pMatch, length);
+				else for(size_t i = 0; i < length; ++i) pOut[i] = pMatch[i];
+				pOut += length;
+			}
+			return static_cast<size_t>(pOut - pDest) == destSize;
+		}
+	}
+}
@@ -0,0 +1,76 @@
+/*****************************************************************
+ * LZ4.h
+ *****************************************************************
+ * Created on: 20.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef CORE_LZ4_H_
+#define CORE_LZ4_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fuel
+{
+	/**
+	 * LZ4 block format (de)compression.
+	 * Blocks are compatible with the reference implementation's LZ4_compress_default
+	 * and LZ4_decompress_safe, but carry no frame header, so the decompressed size
+	 * has to be stored alongside. The compressor is a single pass greedy matcher,
+	 * the decompressor validates every length and offset against both buffers.
+	 */
+	namespace LZ4
+	{
+		/**
+		 * Returns the largest compressed size of a block.
+		 *
+		 * @param size
+		 * 		Uncompressed size in bytes.
+		 *
+		 * @return Worst case compressed size in bytes.
+		 */
+		inline size_t compressBound(size_t size){ return size + size / 255 + 16; }
+
+		/**
+		 * Compresses a block.
+		 *
+		 * @param pSource
+		 * 		Data to compress.
+		 *
+		 * @param size
+		 * 		Size of the data in bytes.
+		 *
+		 * @param pDest
+		 * 		Receives the compressed block.
+		 *
+		 * @param capacity
+		 * 		Size of the destination in bytes, compressBound(size) always suffices.
+		 *
+		 * @return Compressed size in bytes, 0 if the destination is too small.
+		 */
+		size_t compress(const uint8_t *pSource, size_t size, uint8_t *pDest, size_t capacity);
+
+		/**
+		 * Decompresses a block.
+		 *
+		 * @param pSource
+		 * 		Compressed block.
+		 *
+		 * @param size
+		 * 		Size of the compressed block in bytes.
+		 *
+		 * @param pDest
+		 * 		Receives the decompressed data.
+		 *
+		 * @param destSize
+		 * 		Exact decompressed size in bytes.
+		 *
+		 * @return False if the block is malformed or does not decompress to destSize bytes.
+		 */
+		bool decompress(const uint8_t *pSource, size_t size, uint8_t *pDest, size_t destSize);
+	}
+}
+
+#endif // CORE_LZ4_H_
@@ -0,0 +1,75 @@
+/*****************************************************************
+ * MappedFile.cpp
+ *****************************************************************
+ * Created on: 14.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include "MappedFile.h"
+
+#ifndef __WIN32__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+namespace fuel
+{
+	using namespace std;
+
+	#ifdef __WIN32__
+
+	MappedFile::MappedFile(const string &filename)
+		:m_pData(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+	{
+		m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if(m_file == INVALID_HANDLE_VALUE) return;
+
+		LARGE_INTEGER size;
+		if(!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) return;
+
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(m_mapping == nullptr) return;
+
+		m_pData = static_cast<const uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		if(m_pData) m_size = static_cast<size_t>(size.QuadPart);
+	}
+
+	MappedFile::~MappedFile(void)
+	{
+		if(m_pData) UnmapViewOfFile(m_pData);
+		if(m_mapping) CloseHandle(m_mapping);
+		if(m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+	}
+
+	#else
+
+	MappedFile::MappedFile(const string &filename)
+		:m_pData(nullptr), m_size(0)
+	{
+		int file = open(filename.c_str(), O_RDONLY);
+		if(file < 0) return;
+
+		struct stat status;
+		if(fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			void *pData = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+			if(pData != MAP_FAILED)
+			{
+				m_pData = static_cast<const uint8_t *>(pData);
+				m_size = status.st_size;
+			}
+		}
+
+		// The mapping stays valid without the descriptor
+		close(file);
+	}
+
+	MappedFile::~MappedFile(void)
+	{
+		if(m_pData) munmap(const_cast<uint8_t *>(m_pData), m_size);
+	}
+
+	#endif
+}
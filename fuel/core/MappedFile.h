@@ -0,0 +1,75 @@
+/*****************************************************************
+ * MappedFile.h
+ *****************************************************************
+ * Created on: 14.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef CORE_MAPPEDFILE_H_
+#define CORE_MAPPEDFILE_H_
+
+#include "Util.h"
+
+namespace fuel
+{
+	/**
+	 * Read-only memory mapping of a whole file.
+	 * Pages are loaded by the OS on first access and shared with the file cache,
+	 * so mapped content is never copied into the process before it is used.
+	 */
+	class MappedFile
+	{
+	private:
+		// Start of the mapping, nullptr if the file could not be mapped
+		const uint8_t *m_pData;
+
+		// Size of the file in bytes
+		size_t m_size;
+
+		#ifdef __WIN32__
+			// File and file mapping handles
+			HANDLE m_file, m_mapping;
+		#endif
+
+	public:
+		/**
+		 * Maps a file into memory.
+		 *
+		 * @param filename
+		 * 		File to map.
+		 */
+		MappedFile(const std::string &filename);
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile &operator=(const MappedFile &) = delete;
+
+		/**
+		 * Returns whether the file is mapped.
+		 *
+		 * @return False if the file could not be opened or is empty.
+		 */
+		inline bool isValid(void) const { return m_pData != nullptr; }
+
+		/**
+		 * Returns the mapped file content.
+		 *
+		 * @return Start of the file.
+		 */
+		inline const uint8_t *getData(void) const { return m_pData; }
+
+		/**
+		 * Returns the file size.
+		 *
+		 * @return Size in bytes.
+		 */
+		inline size_t getSize(void) const { return m_size; }
+
+		/**
+		 * Unmaps the file.
+		 */
+		~MappedFile(void);
+	};
+}
+
+#endif // CORE_MAPPEDFILE_H_
@@ -0,0 +1,123 @@
+/*****************************************************************
+ * PackFile.h
+ *****************************************************************
+ * Created on: 20.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef CORE_PACKFILE_H_
+#define CORE_PACKFILE_H_
+
+#include <cstdint>
+
+namespace fuel
+{
+	/**
+	 * Layout of asset packs (.fpk), written by tools/assetpack.
+	 * A pack starts with the header, followed by the displacement seed of every
+	 * bucket, the entry table and the entry names. Entries are placed in the table
+	 * by a minimal perfect hash of their name, so a lookup hashes the name once,
+	 * reads one seed and compares one entry. Each payload starts at a multiple of
+	 * ALIGNMENT and is stored either as is, so the runtime hands out pointers into
+	 * the memory mapping of the pack, or as an LZ4 block.
+	 */
+	namespace PackFile
+	{
+		// File identifier "FPK1"
+		const uint32_t MAGIC = 0x314B5046;
+
+		// Alignment of payloads in bytes (page size)
+		const uint32_t ALIGNMENT = 4096;
+
+		// Average number of entries per bucket of the perfect hash
+		const uint32_t BUCKET_SIZE = 4;
+
+		// Payload encodings
+		enum ECompression : uint32_t
+		{
+			NONE = 0,	// Stored as is
+			LZ4  = 1	// Single LZ4 block (see fuel/core/LZ4.h)
+		};
+
+		// File header
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t entries;
+			uint32_t buckets;
+			uint32_t padding;
+
+			// Location of the name strings, not terminated
+			uint64_t namesOffset;
+			uint64_t namesSize;
+		};
+
+		// Entry table entry
+		struct Entry
+		{
+			// 64-bit FNV-1a hash of the name
+			uint64_t hash;
+
+			// Stored payload
+			uint64_t offset;
+			uint64_t size;
+
+			// Size after decompression
+			uint64_t originalSize;
+
+			// Name within the name strings
+			uint32_t nameOffset, nameLength;
+
+			uint32_t compression;
+			uint32_t padding;
+		};
+
+		static_assert(sizeof(Header) == 32, "Asset pack header must be packed");
+		static_assert(sizeof(Entry) == 48, "Asset pack entry must be packed");
+
+		/**
+		 * Returns the bucket of a name hash.
+		 *
+		 * @param hash
+		 * 		64-bit FNV-1a hash of the name.
+		 *
+		 * @param buckets
+		 * 		Number of buckets.
+		 *
+		 * @return Bucket index.
+		 */
+		inline uint32_t bucket(uint64_t hash, uint32_t buckets)
+		{
+			return static_cast<uint32_t>((hash >> 32) % buckets);
+		}
+
+		/**
+		 * Returns the entry table slot of a name hash.
+		 *
+		 * @param hash
+		 * 		64-bit FNV-1a hash of the name.
+		 *
+		 * @param seed
+		 * 		Displacement seed of the hash's bucket.
+		 *
+		 * @param entries
+		 * 		Number of entries.
+		 *
+		 * @return Slot index.
+		 */
+		inline uint32_t slot(uint64_t hash, uint32_t seed, uint32_t entries)
+		{
+			// 64-bit finalizer of MurmurHash3
+			hash ^= seed * 0x9E3779B97F4A7C15ULL;
+			hash ^= hash >> 33;
+			hash *= 0xFF51AFD7ED558CCDULL;
+			hash ^= hash >> 33;
+			hash *= 0xC4CEB9FE1A85EC53ULL;
+			hash ^= hash >> 33;
+			return static_cast<uint32_t>(hash % entries);
+		}
+	}
+}
+
+#endif // CORE_PACKFILE_H_
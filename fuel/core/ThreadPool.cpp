@@ -0,0 +1,72 @@
+/*****************************************************************
+ * ThreadPool.cpp
+ *****************************************************************
+ * Created on: 13.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include <algorithm>
+#include "ThreadPool.h"
+
+namespace fuel
+{
+	using namespace std;
+
+	ThreadPool::ThreadPool(unsigned threads)
+		:m_stopping(false)
+	{
+		if(threads == 0)
+		{
+			// hardware_concurrency() may report 0 if unknown
+			threads = std::max(thread::hardware_concurrency(), 2u) - 1;
+		}
+
+		for(unsigned i = 0; i < threads; ++i)
+		{
+			m_workers.emplace_back(&ThreadPool::work, this);
+		}
+		cout << "Started " << threads << " worker thread(s)." << endl;
+	}
+
+	void ThreadPool::work(void)
+	{
+		while(true)
+		{
+			function<void(void)> task;
+			{
+				unique_lock<mutex> lock(m_mutex);
+				m_condition.wait(lock, [this]{ return m_stopping || !m_tasks.empty(); });
+				if(m_stopping) return;
+
+				task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+	void ThreadPool::submit(function<void(void)> task)
+	{
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_tasks.push_back(std::move(task));
+		}
+		m_condition.notify_one();
+	}
+
+	ThreadPool::~ThreadPool(void)
+	{
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_stopping = true;
+			m_tasks.clear();
+		}
+		m_condition.notify_all();
+
+		for(thread &worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+}
@@ -0,0 +1,80 @@
+/*****************************************************************
+ * ThreadPool.h
+ *****************************************************************
+ * Created on: 13.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef CORE_THREADPOOL_H_
+#define CORE_THREADPOOL_H_
+
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+#include "Util.h"
+
+namespace fuel
+{
+	/**
+	 * Fixed set of worker threads executing tasks in submission order.
+	 * Tasks must not touch OpenGL, the context is only current on the render thread.
+	 */
+	class ThreadPool
+	{
+	private:
+		// Worker threads
+		std::vector<std::thread> m_workers;
+
+		// Tasks not yet picked up by a worker
+		std::deque<std::function<void(void)>> m_tasks;
+
+		// Guards the task queue and the stop flag
+		std::mutex m_mutex;
+
+		// Signaled when a task is queued or the pool stops
+		std::condition_variable m_condition;
+
+		// Whether the workers should exit
+		bool m_stopping;
+
+		/**
+		 * Worker thread loop, runs tasks until the pool stops.
+		 */
+		void work(void);
+
+	public:
+		/**
+		 * Starts the worker threads.
+		 *
+		 * @param threads
+		 * 		Number of workers. 0 to leave one hardware thread to the render thread.
+		 */
+		ThreadPool(unsigned threads = 0);
+
+		/**
+		 * Returns the number of worker threads.
+		 *
+		 * @return Thread count.
+		 */
+		inline unsigned getThreadCount(void) const { return m_workers.size(); }
+
+		/**
+		 * Queues a task for execution on any worker.
+		 *
+		 * @param task
+		 * 		Task to execute.
+		 */
+		void submit(std::function<void(void)> task);
+
+		/**
+		 * Finishes the tasks already picked up and joins the workers.
+		 * Tasks still queued are discarded.
+		 */
+		~ThreadPool(void);
+	};
+}
+
+#endif // CORE_THREADPOOL_H_
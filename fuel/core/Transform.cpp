@@ -11,13 +11,25 @@
 namespace fuel
 {
 	Transform::Transform(const glm::vec3 &position, const glm::vec3 &rotation, const glm::vec3 &scale)
-		:m_position(position), m_rotation(rotation), m_scale(scale){ }
+		:m_position(position), m_rotation(rotation), m_scale(scale),
+		 m_worldMatrix(calculateWorldMatrix()), m_previousWorldMatrix(m_worldMatrix), m_commitFrame(0)
+	{
+		;;
+	}
 
 	Transform::Transform(const glm::vec3 &position)
-		:m_position(position), m_rotation({0,0,0}), m_scale({1,1,1}){ }
+		:m_position(position), m_rotation({0,0,0}), m_scale({1,1,1}),
+		 m_worldMatrix(calculateWorldMatrix()), m_previousWorldMatrix(m_worldMatrix), m_commitFrame(0)
+	{
+		;;
+	}
 
 	Transform::Transform(void)
-		:m_position({0,0,0}), m_rotation({0,0,0}), m_scale({1,1,1}){ }
+		:m_position({0,0,0}), m_rotation({0,0,0}), m_scale({1,1,1}),
+		 m_worldMatrix(calculateWorldMatrix()), m_previousWorldMatrix(m_worldMatrix), m_commitFrame(0)
+	{
+		;;
+	}
 
 	glm::mat4 Transform::calculateWorldMatrix(void)
 	{
@@ -28,4 +40,17 @@ namespace fuel
 		glm::mat4 scale 	= glm::scale(		glm::mat4(), m_scale);
 		return translate * pitch * yaw * roll * scale;
 	}
+
+	const glm::mat4 &Transform::commitWorldMatrix(uint32_t frame)
+	{
+		glm::mat4 world = calculateWorldMatrix();
+		if(frame != m_commitFrame)
+		{
+			// Objects not drawn during the frame before start without motion
+			m_previousWorldMatrix = (frame == m_commitFrame + 1) ? m_worldMatrix : world;
+			m_commitFrame = frame;
+		}
+		m_worldMatrix = world;
+		return m_worldMatrix;
+	}
 }
@@ -26,6 +26,15 @@ namespace fuel
 		// Scale factors
 		glm::vec3 m_scale;
 
+		// World matrix committed during the current frame
+		glm::mat4 m_worldMatrix;
+
+		// World matrix committed during the previous frame
+		glm::mat4 m_previousWorldMatrix;
+
+		// Frame the world matrix was last committed in
+		uint32_t m_commitFrame;
+
 	public:
 		/**
 		 * Instantiates a new transform.
@@ -127,6 +136,28 @@ namespace fuel
 		 * @return World (a.k.a. model-) matrix.
 		 */
 		glm::mat4 calculateWorldMatrix(void);
+
+		/**
+		 * Returns the world matrix committed during the previous frame.
+		 * Used together with the current world matrix to compute motion vectors.
+		 *
+		 * @return Previous world matrix.
+		 */
+		inline const glm::mat4 &getPreviousWorldMatrix(void) const { return m_previousWorldMatrix; }
+
+		/**
+		 * Commits the world matrix for the given frame and returns it. The first
+		 * commit of a frame moves the matrix committed during the frame before
+		 * to the previous world matrix; if the transform was not committed then,
+		 * the previous world matrix equals the current one (no motion). Further
+		 * commits during the same frame only update the current world matrix.
+		 *
+		 * @param frame
+		 * 		Number of the frame being rendered.
+		 *
+		 * @return World matrix.
+		 */
+		const glm::mat4 &commitWorldMatrix(uint32_t frame);
 	};
 }
 
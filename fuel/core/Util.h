@@ -14,6 +14,8 @@
 #include <type_traits>
 #include <utility>
 #include <cstdio>
+#include <cstdint>
+#include <string>
 #include <vector>
 
 #ifndef __DEBUG__
@@ -26,6 +28,9 @@
 
 #ifdef __WIN32__
 #include <windows.h>
+#include <direct.h>
+#else
+#include <sys/stat.h>
 #endif
 
 // Macro shortcut to create a const-qualified by-const-reference getter.
@@ -95,8 +100,137 @@ namespace fuel
 	 */
 	inline bool fileExists (const std::string &filename)
 	{
-		if(FILE *file = fopen(filename.c_str(), "r")) { fclose(file); return true; }
-		return false;
+		// Query the attributes rather than opening the file
+		#ifdef __WIN32__
+			DWORD attributes = GetFileAttributesA(filename.c_str());
+			return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+		#else
+			struct stat status;
+			return stat(filename.c_str(), &status) == 0 && !S_ISDIR(status.st_mode);
+		#endif
+	}
+
+	/**
+	 * Creates a directory if it does not exist yet.
+	 * Parent directories have to exist already.
+	 *
+	 * @param path
+	 * 		Directory path.
+	 */
+	inline void createDirectory(const std::string &path)
+	{
+		#ifdef __WIN32__
+			_mkdir(path.c_str());
+		#else
+			mkdir(path.c_str(), 0755);
+		#endif
+	}
+
+	/**
+	 * Collapses "." and ".." components and repeated slashes of a path,
+	 * so that every file has a single name, e.g. "res/glsl/include/../a.glsl"
+	 * becomes "res/glsl/a.glsl". Leading ".." of relative paths are kept.
+	 *
+	 * @param path
+	 * 		Path with '/' separators.
+	 *
+	 * @return Normalized path, "." if nothing remains.
+	 */
+	inline std::string normalizePath(const std::string &path)
+	{
+		bool absolute = !path.empty() && path[0] == '/';
+		std::vector<std::string> components;
+		for(size_t begin = 0; begin < path.size(); )
+		{
+			size_t end = path.find('/', begin);
+			if(end == std::string::npos) end = path.size();
+			std::string component = path.substr(begin, end - begin);
+			begin = end + 1;
+
+			if(component.empty() || component == ".") continue;
+			if(component == ".." && !components.empty() && components.back() != "..") components.pop_back();
+			else if(component != ".." || !absolute) components.push_back(component);
+		}
+
+		std::string normalized = absolute ? "/" : "";
+		for(size_t i = 0; i < components.size(); ++i)
+		{
+			if(i > 0) normalized += '/';
+			normalized += components[i];
+		}
+		if(normalized.empty()) return ".";
+		if(path.back() == '/' && normalized.back() != '/') normalized += '/';
+		return normalized;
+	}
+
+	/**
+	 * Reads a whole file into memory.
+	 *
+	 * @param filename
+	 * 		Name of the file.
+	 *
+	 * @param data
+	 * 		Receives the file content.
+	 *
+	 * @return Whether the file could be read.
+	 */
+	inline bool readFile(const std::string &filename, std::vector<uint8_t> &data)
+	{
+		FILE *file = fopen(filename.c_str(), "rb");
+		if(file == nullptr) return false;
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		data.resize(size > 0 ? size : 0);
+		bool success = size >= 0 && fread(data.data(), 1, data.size(), file) == data.size();
+		fclose(file);
+		return success;
+	}
+
+	// Initial value of 64-bit FNV-1a hashes
+	const uint64_t FNV1A_OFFSET_BASIS = 14695981039346656037ULL;
+
+	/**
+	 * Calculates the 64-bit FNV-1a hash of a block of memory.
+	 *
+	 * @param data
+	 * 		Data to hash.
+	 *
+	 * @param size
+	 * 		Size of the data in bytes.
+	 *
+	 * @param hash
+	 * 		Hash to continue from, allows hashing several blocks in sequence.
+	 *
+	 * @return Hash value.
+	 */
+	inline uint64_t hashFNV1a(const void *data, size_t size, uint64_t hash = FNV1A_OFFSET_BASIS)
+	{
+		const unsigned char *bytes = static_cast<const unsigned char *>(data);
+		for(size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	/**
+	 * Calculates the 64-bit FNV-1a hash of a string.
+	 *
+	 * @param string
+	 * 		String to hash.
+	 *
+	 * @param hash
+	 * 		Hash to continue from, allows hashing several strings in sequence.
+	 *
+	 * @return Hash value.
+	 */
+	inline uint64_t hashFNV1a(const std::string &string, uint64_t hash = FNV1A_OFFSET_BASIS)
+	{
+		return hashFNV1a(string.data(), string.size(), hash);
 	}
 
 	/**
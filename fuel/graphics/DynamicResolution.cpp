@@ -0,0 +1,48 @@
+/*****************************************************************
+ * DynamicResolution.cpp
+ *****************************************************************
+ * Created on: 02.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include "DynamicResolution.h"
+
+namespace fuel
+{
+	DynamicResolution::DynamicResolution(float targetTime, float minScale, float maxScale)
+		:m_targetTime(targetTime),
+		 m_minScale(minScale),
+		 m_maxScale(maxScale),
+		 m_scale(maxScale),
+		 m_averageTime(targetTime),
+		 m_cooldown(COOLDOWN_FRAMES)
+	{
+		;;
+	}
+
+	bool DynamicResolution::update(float gpuTime)
+	{
+		m_averageTime += SMOOTHING * (gpuTime - m_averageTime);
+
+		// Let the measurements settle after the last change
+		if(m_cooldown > 0){ m_cooldown--; return false; }
+
+		// GPU time is roughly proportional to the pixel count, i.e. the squared scale
+		float desired = m_scale;
+		if(m_averageTime > m_targetTime)
+			desired = m_scale * std::sqrt(m_targetTime / m_averageTime);
+		else if(m_averageTime < HEADROOM * m_targetTime)
+			desired = m_scale + SCALE_STEP;
+
+		// Quantize towards the lower step so that an overloaded GPU always gets relief
+		desired = std::floor(desired / SCALE_STEP + 1E-3f) * SCALE_STEP;
+		desired = CLAMP(desired, m_minScale, m_maxScale);
+
+		if(std::fabs(desired - m_scale) < SCALE_STEP / 2) return false;
+
+		m_scale = desired;
+		m_cooldown = COOLDOWN_FRAMES;
+		return true;
+	}
+}
@@ -0,0 +1,126 @@
+/*****************************************************************
+ * DynamicResolution.h
+ *****************************************************************
+ * Created on: 02.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_DYNAMICRESOLUTION_H_
+#define GRAPHICS_DYNAMICRESOLUTION_H_
+
+#include <algorithm>
+#include "../core/Util.h"
+
+namespace fuel
+{
+	/**
+	 * Controls the internal render resolution so that the measured
+	 * GPU frame time stays close to a target value.
+	 * The scale factor is applied to both axes and quantized to fixed
+	 * steps, so that the render targets are only resized once the
+	 * load has changed noticeably.
+	 */
+	class DynamicResolution
+	{
+	private:
+		// Scale factor quantization step
+		static constexpr float SCALE_STEP = 0.05f;
+
+		// Fraction of the target frame time below which the resolution is raised again
+		static constexpr float HEADROOM = 0.8f;
+
+		// Smoothing factor of the GPU time moving average
+		static constexpr float SMOOTHING = 0.1f;
+
+		// Frames to wait after a change before the next one is considered
+		static const unsigned COOLDOWN_FRAMES = 30;
+
+		// Target GPU frame time in seconds
+		float m_targetTime;
+
+		// Minimum scale factor
+		float m_minScale;
+
+		// Maximum scale factor
+		float m_maxScale;
+
+		// Current scale factor
+		float m_scale;
+
+		// Smoothed GPU frame time in seconds
+		float m_averageTime;
+
+		// Frames left until the scale may change again
+		unsigned m_cooldown;
+
+	public:
+		/**
+		 * Instantiates a new dynamic resolution controller.
+		 *
+		 * @param targetTime
+		 * 		Target GPU frame time in seconds.
+		 *
+		 * @param minScale
+		 * 		Lowest scale factor that may be chosen.
+		 *
+		 * @param maxScale
+		 * 		Highest scale factor that may be chosen.
+		 */
+		DynamicResolution(float targetTime, float minScale = 0.5f, float maxScale = 1.0f);
+
+		/**
+		 * Returns the current scale factor.
+		 *
+		 * @return Scale factor applied to both axes.
+		 */
+		inline float getScale(void) const { return m_scale; }
+
+		/**
+		 * Returns the smoothed GPU frame time.
+		 *
+		 * @return GPU frame time in seconds.
+		 */
+		inline float getAverageTime(void) const { return m_averageTime; }
+
+		/**
+		 * Returns the target GPU frame time.
+		 *
+		 * @return Target time in seconds.
+		 */
+		inline float getTargetTime(void) const { return m_targetTime; }
+
+		/**
+		 * Sets the target GPU frame time.
+		 *
+		 * @param targetTime
+		 * 		Target time in seconds.
+		 */
+		inline void setTargetTime(float targetTime){ m_targetTime = targetTime; }
+
+		/**
+		 * Applies the current scale factor to a base resolution.
+		 *
+		 * @param base
+		 * 		Full resolution size in pixels.
+		 *
+		 * @return Scaled size in pixels. (at least 1)
+		 */
+		inline uint16_t scale(uint16_t base) const
+		{
+			return static_cast<uint16_t>(std::max(1.0f, std::floor(base * m_scale + 0.5f)));
+		}
+
+		/**
+		 * Feeds a new GPU time measurement into the controller.
+		 *
+		 * @param gpuTime
+		 * 		Measured GPU frame time in seconds.
+		 *
+		 * @return Whether the scale factor has changed.
+		 */
+		bool update(float gpuTime);
+	};
+}
+
+#endif // GRAPHICS_DYNAMICRESOLUTION_H_
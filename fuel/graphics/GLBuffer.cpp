@@ -14,7 +14,7 @@ namespace fuel
 	using namespace std;
 
 	GLBuffer::GLBuffer(GLenum target)
-		:m_ID(GL_NONE), m_target(target), m_bound(false)
+		:m_ID(GL_NONE), m_target(target), m_bound(false), m_byteSize(0)
 	{
 		glGenBuffers(1, &m_ID);
 		if(m_ID == GL_NONE)
@@ -43,5 +43,6 @@ namespace fuel
 			glDeleteBuffers(1, &m_ID);
 			m_ID = GL_NONE;
 		}
+		GLMemoryCounter::release(EGLMemory::BUFFER, m_byteSize);
 	}
 }
@@ -10,6 +10,7 @@
 #define GRAPHICS_GLBUFFER_H_
 
 #include "GLCalls.h"
+#include "GLMemoryCounter.h"
 #include <vector>
 
 namespace fuel
@@ -33,6 +34,9 @@ namespace fuel
 		// Is this buffer currently bound to the target?
 		bool m_bound;
 
+		// Size of the buffer's data store in bytes
+		size_t m_byteSize;
+
 	public:
 		/**
 		 * Instantiates a new GL buffer.
@@ -108,6 +112,10 @@ namespace fuel
 			// Ensure the buffer is bound
 			if(!m_bound){ GLBuffer::bind(*this); }
 			glBufferData(m_target, data.size() * sizeof(T), (const GLvoid *)&data[0], usage);
+
+			// The previous data store is replaced
+			GLMemoryCounter::release(EGLMemory::BUFFER, m_byteSize);
+			GLMemoryCounter::allocate(EGLMemory::BUFFER, m_byteSize = data.size() * sizeof(T));
 		}
 
 		/**
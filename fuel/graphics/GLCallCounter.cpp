@@ -0,0 +1,38 @@
+/*****************************************************************
+ * GLCallCounter.cpp
+ *****************************************************************
+ * Created on: 12.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include "GLCallCounter.h"
+
+namespace fuel
+{
+	using namespace std;
+
+	unsigned GLCallCounter::s_calls[static_cast<unsigned>(EGLCall::COUNT)] = {};
+
+	unsigned GLCallCounter::getTotal(void)
+	{
+		unsigned total = 0;
+		for(unsigned calls : s_calls) total += calls;
+		return total;
+	}
+
+	void GLCallCounter::print(void)
+	{
+		cout << "GL calls:\t\t" << getTotal()
+			 << " (uniform " << get(EGLCall::UNIFORM)
+			 << ", buffer "  << get(EGLCall::BUFFER)
+			 << ", program " << get(EGLCall::PROGRAM)
+			 << ", draw "    << get(EGLCall::DRAW) << ")"
+			 << endl;
+	}
+
+	void GLCallCounter::reset(void)
+	{
+		for(unsigned &calls : s_calls) calls = 0;
+	}
+}
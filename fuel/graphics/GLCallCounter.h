@@ -0,0 +1,79 @@
+/*****************************************************************
+ * GLCallCounter.h
+ *****************************************************************
+ * Created on: 12.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_GLCALLCOUNTER_H_
+#define GRAPHICS_GLCALLCOUNTER_H_
+
+#include <iostream>
+
+namespace fuel
+{
+	/**
+	 * Categories of OpenGL calls issued by the engine.
+	 */
+	enum class EGLCall : unsigned char
+	{
+		UNIFORM,//!< UNIFORM
+		BUFFER, //!< BUFFER
+		PROGRAM,//!< PROGRAM
+		DRAW,   //!< DRAW
+		COUNT   //!< COUNT
+	};
+
+	/**
+	 * Counts the OpenGL calls issued through the engine's wrappers per frame.
+	 * Calls made directly by applications are not included.
+	 */
+	class GLCallCounter
+	{
+	private:
+		// Calls per category since the last reset
+		static unsigned s_calls[static_cast<unsigned>(EGLCall::COUNT)];
+
+	public:
+		/**
+		 * Records calls of the given category.
+		 *
+		 * @param call
+		 * 		Call category.
+		 *
+		 * @param count
+		 * 		Number of OpenGL calls.
+		 */
+		static inline void count(EGLCall call, unsigned count = 1){ s_calls[static_cast<unsigned>(call)] += count; }
+
+		/**
+		 * Returns the calls of a category since the last reset.
+		 *
+		 * @param call
+		 * 		Call category.
+		 *
+		 * @return Number of calls.
+		 */
+		static inline unsigned get(EGLCall call){ return s_calls[static_cast<unsigned>(call)]; }
+
+		/**
+		 * Returns the calls of all categories since the last reset.
+		 *
+		 * @return Number of calls.
+		 */
+		static unsigned getTotal(void);
+
+		/**
+		 * Prints the calls since the last reset by category.
+		 */
+		static void print(void);
+
+		/**
+		 * Starts counting from zero.
+		 */
+		static void reset(void);
+	};
+}
+
+#endif // GRAPHICS_GLCALLCOUNTER_H_
@@ -6,13 +6,22 @@
  *****************************************************************
  *****************************************************************/
 
+#include <algorithm>
 #include "GLFramebuffer.h"
 
 namespace fuel
 {
-	GLFramebuffer::GLFramebuffer(uint16_t width, uint16_t height)
-		:m_ID(GL_NONE), m_width(width), m_height(height), m_colorAttachmentCount(0)
+	GLFramebuffer::GLFramebuffer(GLTexturePool &texturePool, uint16_t width, uint16_t height, uint8_t samples)
+		:m_ID(GL_NONE), m_texturePool(texturePool), m_width(width), m_height(height), m_samples(std::max<uint8_t>(samples, 1)),
+		 m_unitCount(0), m_colorAttachmentCount(0)
 	{
+		for(GLFramebufferAttachment &a : m_attachments)
+		{
+			a.pTexture = nullptr;
+			a.textureFormat = a.colorFormat = a.datatype = a.attachmentSlot = GL_NONE;
+			a.textureUnit = 0;
+		}
+
 		glGenFramebuffers(1, &m_ID);
 
 		if(m_ID == GL_NONE)
@@ -23,18 +32,25 @@ namespace fuel
 		{
 			cout << "Generated OpenGL framebuffer: " << m_ID << endl;
 
+			// Multisampled textures can only be fetched per texel
 			m_blitShader = make_unique<GLShaderProgram>();
 			m_blitShader->setShader(EGLShaderType::VERTEX,   "res/glsl/fullscreen.vert");
-			m_blitShader->setShader(EGLShaderType::FRAGMENT, "res/glsl/blit.frag");
+			m_blitShader->setShader(EGLShaderType::FRAGMENT, m_samples > 1 ? "res/glsl/blit_ms.frag" : "res/glsl/blit.frag");
 			m_blitShader->bindVertexAttribute(0, "vPosition");
 			m_blitShader->bindVertexAttribute(1, "vTexCoord");
 			m_blitShader->link();
-			m_blitShader->registerUniform("uTextureUnit");
+			m_blitTextureUnit = m_blitShader->getUniformHandle<GLint>("uTextureUnit");
+			m_blitViewport = m_blitShader->getUniformHandle<glm::vec4>("uViewport");
 		}
 	}
 
 	GLenum GLFramebuffer::getColorFormat(GLenum txrFormat)
 	{
+		// RG encoded
+		if(txrFormat == GL_RG32F
+				|| txrFormat == GL_RG16F)
+			return GL_RG;
+
 		// RGB encoded
 		if(txrFormat == GL_RGB32F
 				|| txrFormat == GL_RGB32UI
@@ -59,12 +75,14 @@ namespace fuel
 	GLenum GLFramebuffer::getDatatype(GLenum txrFormat)
 	{
 		// 16-bit floating points
-		if(txrFormat == GL_RGB16F
+		if(txrFormat == GL_RG16F
+				|| txrFormat == GL_RGB16F
 				|| txrFormat == GL_RGBA16F)
 			return GL_HALF_FLOAT;
 
 		// 32-bit floating points
-		if(txrFormat == GL_RGB32F
+		if(txrFormat == GL_RG32F
+				|| txrFormat == GL_RGB32F
 				|| txrFormat == GL_RGBA32F
 				|| txrFormat == GL_DEPTH_COMPONENT32F)
 			return GL_FLOAT;
@@ -95,25 +113,27 @@ namespace fuel
 		if((colorFormat = getColorFormat(txrFormat)) == GL_NONE || (datatype = getDatatype(txrFormat)) == GL_NONE)
 		{
 			cerr << "Invalid texture format specified." << endl;
-			cerr << "Should be one of: GL_RGB32(F/UI), GL_RGBA32(F/UI), GL_DEPTH_COMPONENT32F." << endl;
+			cerr << "Should be one of: GL_RG(16/32)F, GL_RGB(16/32)(F/UI), GL_RGBA(16/32)(F/UI), GL_DEPTH_COMPONENT32F." << endl;
 			return;
 		}
 
 		// Get FBO attachment slot for the new texture
 		GLenum slot = findAttachmentSlot(txrFormat);
+		uint8_t index = (slot == GL_DEPTH_ATTACHMENT) ? DEPTH_INDEX : m_colorAttachmentCount;
+
+		if(m_attachmentIndices.count(attachment) > 0
+				|| (index == DEPTH_INDEX && m_attachments[DEPTH_INDEX].pTexture != nullptr)
+				|| m_colorAttachmentCount == MAX_COLOR_ATTACHMENTS)
+		{
+			cerr << "Cannot add framebuffer attachment '" << attachment << "'." << endl;
+			return;
+		}
 
-		GLTexture *pTexture = new GLTexture();
-		GLTexture::bind(0, *pTexture);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	    glTexImage2D(GL_TEXTURE_2D, 0, txrFormat, m_width, m_height, 0, colorFormat, datatype, nullptr);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, slot, GL_TEXTURE_2D, pTexture->getID(), 0);
-		GLTexture::unbind(0);
+		GLTexture *pTexture = m_texturePool.acquire(txrFormat, m_width, m_height, colorFormat, datatype, m_samples);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, slot, pTexture->getTarget(), pTexture->getID(), 0);
 
 		// Construct new FBO attachment
-		GLFramebufferAttachment fboAttachment;
+		GLFramebufferAttachment &fboAttachment = m_attachments[index];
 		fboAttachment.name = attachment;
 		fboAttachment.pTexture = pTexture;
 		fboAttachment.textureFormat = txrFormat;
@@ -121,17 +141,94 @@ namespace fuel
 		fboAttachment.datatype = datatype;
 		fboAttachment.attachmentSlot = slot;
 
-		m_attachments.insert({attachment, fboAttachment});
+		m_attachmentIndices.insert({attachment, index});
 
 		// Increment color attachment count if neccessary
-		if(txrFormat != GL_DEPTH_COMPONENT32F) m_colorAttachmentCount++;
+		if(index != DEPTH_INDEX) m_colorAttachmentCount++;
+
+		// Assign texture units once, so binding does not have to search
+		updateUnitTable();
+	}
+
+	void GLFramebuffer::updateUnitTable(void)
+	{
+		m_unitCount = 0;
+
+		for(uint8_t index = 0; index < m_colorAttachmentCount; ++index)
+		{
+			m_attachments[index].textureUnit = m_unitCount;
+			m_unitTargets[m_unitCount] = m_attachments[index].pTexture->getTarget();
+			m_unitTextures[m_unitCount++] = m_attachments[index].pTexture->getID();
+		}
+
+		GLFramebufferAttachment &depth = m_attachments[DEPTH_INDEX];
+		if(depth.pTexture != nullptr)
+		{
+			depth.textureUnit = m_unitCount;
+			m_unitTargets[m_unitCount] = depth.pTexture->getTarget();
+			m_unitTextures[m_unitCount++] = depth.pTexture->getID();
+		}
+	}
+
+	uint8_t GLFramebuffer::getAttachmentIndex(const string &attachment) const
+	{
+		auto iter = m_attachmentIndices.find(attachment);
+		return (iter != m_attachmentIndices.end()) ? iter->second : MAX_ATTACHMENTS;
+	}
+
+	const GLFramebufferAttachment &GLFramebuffer::getAttachment(uint8_t index) const
+	{
+		static const GLFramebufferAttachment none = { "", nullptr, GL_NONE, GL_NONE, GL_NONE, GL_NONE, 0 };
+		return (index < MAX_ATTACHMENTS) ? m_attachments[index] : none;
+	}
+
+	size_t GLFramebuffer::getByteSize(void) const
+	{
+		size_t size = 0;
+		for(const GLFramebufferAttachment &a : m_attachments)
+		{
+			if(a.pTexture) size += a.pTexture->getByteSize();
+		}
+		return size;
+	}
+
+	void GLFramebuffer::resize(uint16_t width, uint16_t height)
+	{
+		if(width == m_width && height == m_height) return;
+
+		m_width = width;
+		m_height = height;
+
+		// Keep the current bindings intact
+		GLint prevDraw, prevRead;
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevDraw);
+		glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prevRead);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+
+		// Swap every attachment for a pooled texture of the new size. The pool is
+		// trimmed only afterwards, so the old attachments are not deleted before
+		// the new ones could reuse idle textures
+		for(GLFramebufferAttachment &a : m_attachments)
+		{
+			if(a.pTexture == nullptr) continue;
+			m_texturePool.release(a.pTexture, false);
+			a.pTexture = m_texturePool.acquire(a.textureFormat, m_width, m_height, a.colorFormat, a.datatype, m_samples);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, a.attachmentSlot, a.pTexture->getTarget(), a.pTexture->getID(), 0);
+		}
+		m_texturePool.trim(m_texturePool.getIdleBudget());
+
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, prevDraw);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, prevRead);
+		updateUnitTable();
+
+		cout << "Resized OpenGL framebuffer " << m_ID << " to " << m_width << "x" << m_height << " pixels." << endl;
 	}
 
 	void GLFramebuffer::setDrawAttachments(const vector<string> &attachments)
 	{
 		vector<GLenum> buffers;
 		for(unsigned i=0; i<attachments.size(); ++i)
-			buffers.push_back(m_attachments[attachments[i]].attachmentSlot);
+			buffers.push_back(getAttachment(attachments[i]).attachmentSlot);
 
 		glDrawBuffers(buffers.size(), &buffers[0]);
 	}
@@ -140,32 +237,17 @@ namespace fuel
 	{
 		if(target & READ)
 		{
-			// Next texture unit to use
-			// Layout in the end will be: (COLOR[0], ..., COLOR[N], DEPTH)
-			GLuint textureUnit = 0;
-
-			for(; textureUnit < fbo.m_colorAttachmentCount; ++textureUnit)
+			// Units were assigned on attach, so this is a single call with ARB_multi_bind
+			if(GLEW_ARB_multi_bind)
 			{
-				// Go through all attachment textures
-				for(auto iter = fbo.m_attachments.begin(); iter != fbo.m_attachments.end(); ++iter)
-				{
-					// Bind color textures
-					if(iter->second.attachmentSlot == GL_COLOR_ATTACHMENT0 + textureUnit)
-					{
-						GLTexture::bind(textureUnit, *(iter->second.pTexture));
-						break;
-					}
-				}
+				glBindTextures(0, fbo.m_unitCount, fbo.m_unitTextures);
 			}
-
-			// Go through all attachment textures
-			for(auto iter = fbo.m_attachments.begin(); iter != fbo.m_attachments.end(); ++iter)
+			else
 			{
-				// Bind depth texture
-				if(iter->second.attachmentSlot == GL_DEPTH_ATTACHMENT)
+				for(GLuint unit = 0; unit < fbo.m_unitCount; ++unit)
 				{
-					GLTexture::bind(fbo.m_colorAttachmentCount, *(iter->second.pTexture));
-					break;
+					glActiveTexture(GL_TEXTURE0 + unit);
+					glBindTexture(fbo.m_unitTargets[unit], fbo.m_unitTextures[unit]);
 				}
 			}
 		}
@@ -173,37 +255,31 @@ namespace fuel
 		if(target & DRAW) glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo.m_ID);
 	}
 
-	void GLFramebuffer::showAttachmentContent(GLWindow &window, const string &attachment, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+	void GLFramebuffer::showAttachmentContent(GLWindow &window, uint8_t index, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
 	{
-		GLFramebuffer::bind(*this, READ);
+		const GLFramebufferAttachment &a = getAttachment(index);
+		if(a.pTexture == nullptr) return;
 
-		GLint textureUnit = 0;
-		for(const auto &a : m_attachments)
-		{
-			if(a.second.name == attachment)
-			{
-				// Determine texture unit
-				textureUnit = a.second.attachmentSlot; // FBO attachment ID
-				if(textureUnit == GL_DEPTH_ATTACHMENT) textureUnit = m_colorAttachmentCount; // Depth attachment
-				else textureUnit -= GL_COLOR_ATTACHMENT0; // Color attachment
-				break;
-			}
-		}
+		GLFramebuffer::bind(*this, READ);
 
 		glPushAttrib(GL_VIEWPORT_BIT);
 		glViewport(x, y, w, h);
 		m_blitShader->use();
-		m_blitShader->getUniform("uTextureUnit").set(textureUnit);
+		m_blitTextureUnit.set(static_cast<GLint>(a.textureUnit));
+		m_blitViewport.set(glm::vec4(x, y, w, h));
 		window.renderFullscreenQuad();
 		glPopAttrib();
 	}
 
 	GLFramebuffer::~GLFramebuffer(void)
 	{
-		// Delete attachment textures
-		for(auto &attachment : m_attachments)
-			delete attachment.second.pTexture;
-		m_attachments.clear();
+		// Return attachment textures to the pool
+		for(GLFramebufferAttachment &a : m_attachments)
+		{
+			m_texturePool.release(a.pTexture);
+			a.pTexture = nullptr;
+		}
+		m_attachmentIndices.clear();
 
 		// Delete FBO itself
 		if(m_ID != GL_NONE)
@@ -15,6 +15,7 @@
 #include <vector>
 #include "../core/Util.h"
 #include "GLTexture.h"
+#include "GLTexturePool.h"
 #include "shaders/GLShaderProgram.h"
 
 namespace fuel
@@ -28,7 +29,7 @@ namespace fuel
 		// Attachment name
 		string name;
 
-		// Attachment texture
+		// Attachment texture (owned by the framebuffer's texture pool while attached)
 		GLTexture *pTexture;
 
 		// OpenGL texture format
@@ -42,6 +43,9 @@ namespace fuel
 
 		// Framebuffer attachment ID
 		GLenum attachmentSlot;
+
+		// Texture unit the attachment is bound to by GLFramebuffer::bind(READ)
+		GLuint textureUnit;
 	};
 
 	/**
@@ -49,28 +53,68 @@ namespace fuel
 	 */
 	class GLFramebuffer
 	{
+	public:
+		// Maximum number of color attachments
+		static const uint8_t MAX_COLOR_ATTACHMENTS = 8;
+
+		// Index of the depth attachment
+		static const uint8_t DEPTH_INDEX = MAX_COLOR_ATTACHMENTS;
+
+		// Maximum number of attachments (color and depth)
+		static const uint8_t MAX_ATTACHMENTS = MAX_COLOR_ATTACHMENTS + 1;
+
 	private:
 		// OpenGL FBO ID
 		GLuint m_ID;
 
+		// Pool the attachment textures are taken from
+		GLTexturePool &m_texturePool;
+
 		// Framebuffer attachment texture width
 		uint16_t m_width;
 
 		// Framebuffer attachment texture height
 		uint16_t m_height;
 
-		// Attachment information
-		map<string, GLFramebufferAttachment> m_attachments;
+		// Number of samples per attachment texel
+		uint8_t m_samples;
+
+		// Attachment information, indexed by color attachment number (depth last)
+		GLFramebufferAttachment m_attachments[MAX_ATTACHMENTS];
+
+		// Attachment index by name (only used when setting up or debugging)
+		map<string, uint8_t> m_attachmentIndices;
+
+		// Texture IDs in texture unit order, used for READ binding
+		GLuint m_unitTextures[MAX_ATTACHMENTS];
 
-		// Shader used to blit an attachment texture
+		// Texture targets in texture unit order, used for READ binding without ARB_multi_bind
+		GLenum m_unitTargets[MAX_ATTACHMENTS];
+
+		// Number of valid entries in m_unitTextures
+		uint8_t m_unitCount;
+
+		// Shader used to blit an attachment texture, the OpenGL program is shared between framebuffers
 		unique_ptr<GLShaderProgram> m_blitShader;
 
+		// Texture unit uniform of the blit shader
+		GLUniformHandle<GLint> m_blitTextureUnit;
+
+		// Destination viewport uniform of the multisample blit shader (inactive in the regular one)
+		GLUniformHandle<glm::vec4> m_blitViewport;
+
 		/**
 		 * Number of color attachments bound
 		 * Used to determine the FBO attachment slot for new textures
 		 */
 		uint8_t m_colorAttachmentCount;
 
+		/**
+		 * Rebuilds the texture unit table used by bind(READ).
+		 * Layout will be: (COLOR[0], ..., COLOR[N], DEPTH)
+		 */
+		void updateUnitTable(void);
+
 	public:
 		// Read framebuffer bit
 		static const unsigned READ = 1 << 0;
@@ -81,12 +125,19 @@ namespace fuel
 		/**
 		 * Instantiates a new OpenGL framebuffer.
 		 *
+		 * @param texturePool
+		 * 		Pool to take attachment textures from. Must outlive the framebuffer.
+		 *
 		 * @param width
 		 *        Framebuffer texture width.
 		 * @param height
 		 *        Framebuffer texture height.
+		 *
+		 * @param samples
+		 * 		Number of samples per texel. Values above 1 create multisampled
+		 * 		attachments, which shaders have to read through sampler2DMS.
 		 */
-		GLFramebuffer(uint16_t width, uint16_t height);
+		GLFramebuffer(GLTexturePool &texturePool, uint16_t width, uint16_t height, uint8_t samples = 1);
 
 		/**
 		 * Returns the ID of this FBO.
@@ -109,6 +160,33 @@ namespace fuel
 		 */
 		inline uint16_t getHeight(void) const { return m_height; }
 
+		/**
+		 * Returns the number of samples per attachment texel.
+		 *
+		 * @return Sample count.
+		 */
+		inline uint8_t getSamples(void) const { return m_samples; }
+
+		/**
+		 * Changes the size of all attachment textures.
+		 * The current textures are returned to the pool and replaced by
+		 * pooled textures of the new size, so their contents are undefined afterwards.
+		 *
+		 * @param width
+		 * 		New framebuffer texture width.
+		 *
+		 * @param height
+		 * 		New framebuffer texture height.
+		 */
+		void resize(uint16_t width, uint16_t height);
+
+		/**
+		 * Returns the size of all attachment textures.
+		 *
+		 * @return Size in bytes.
+		 */
+		size_t getByteSize(void) const;
+
 		/**
 		 * Clears color and depth buffer of the currently bound draw framebuffer.
 		 */
@@ -121,7 +199,7 @@ namespace fuel
 		 */
 		inline uint8_t getAttachmentCount(void) const
 		{
-			return static_cast<uint8_t>(m_attachments.size());
+			return static_cast<uint8_t>(m_attachmentIndices.size());
 		}
 
 		/**
@@ -132,7 +210,8 @@ namespace fuel
 		 *
 		 * @param target
 		 * 		Flags determining which framebuffer targets to bind the FBO to.
-		 * 		Specifying READ will load all color attachment textures into texture units 0,..,N-1.
+		 * 		Specifying READ will load all color attachment textures into texture units 0,..,N-1
+		 * 		and the depth texture into unit N, using a single multi-bind call if available.
 		 * 		Specifying DRAW will set this FBO to be the draw buffer.
 		 * 		By default (READ | DRAW) is passed, meaning that both operations are performed.
 		 */
@@ -187,17 +266,37 @@ namespace fuel
 		 */
 		void attach(const string &attachment, GLenum txrFormat);
 
+		/**
+		 * Returns the index of the framebuffer attachment.
+		 *
+		 * @param attachment
+		 * 		Name of the attachment texture.
+		 *
+		 * @return Attachment index. MAX_ATTACHMENTS if there is no such attachment.
+		 */
+		uint8_t getAttachmentIndex(const string &attachment) const;
+
+		/**
+		 * Returns information about the framebuffer attachment.
+		 *
+		 * @param index
+		 * 		Attachment index.
+		 *
+		 * @return Attachment information. Its texture is null for unused indices.
+		 */
+		const GLFramebufferAttachment &getAttachment(uint8_t index) const;
+
 		/**
 		 * Returns information about the framebuffer attachment.
 		 *
 		 * @param attachment
 		 * 		Name of the attachment texture.
 		 *
-		 * @return OpenGL texture ID.
+		 * @return Attachment information.
 		 */
-		inline const GLFramebufferAttachment &getAttachment(const string &attachment)
+		inline const GLFramebufferAttachment &getAttachment(const string &attachment) const
 		{
-			return m_attachments[attachment];
+			return getAttachment(getAttachmentIndex(attachment));
 		}
 
 		/**
@@ -229,10 +328,36 @@ namespace fuel
 		 * @param h
 		 * 		Destination height in pixels.
 		 */
-		void showAttachmentContent(GLWindow &window, const string &attachment, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+		void showAttachmentContent(GLWindow &window, const string &attachment, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+		{
+			showAttachmentContent(window, getAttachmentIndex(attachment), x, y, w, h);
+		}
+
+		/**
+		 * Renders the content of the specified attachment to the currently bound FBO.
+		 *
+		 * @param window
+		 * 		Window reference.
+		 *
+		 * @param index
+		 * 		Index of the attachment texture to show.
+		 *
+		 * @param x
+		 * 		X coordinate. (screenspace)
+		 *
+		 * @param y
+		 * 		Y coordinate. (screenspace)
+		 *
+		 * @param w
+		 * 		Destination width in pixels.
+		 *
+		 * @param h
+		 * 		Destination height in pixels.
+		 */
+		void showAttachmentContent(GLWindow &window, uint8_t index, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
 
 		/**
-		 * Deletes the attachment textures.
+		 * Returns the attachment textures to the pool.
 		 */
 		~GLFramebuffer(void);
 	};
@@ -0,0 +1,135 @@
+/*****************************************************************
+ * GLMaterialTable.cpp
+ *****************************************************************
+ * Created on: 24.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include <algorithm>
+#include "GLMaterialTable.h"
+
+namespace fuel
+{
+	using namespace std;
+
+	GLMaterialTable::GLMaterialTable(const TextureManager &textureMgr, GLuint binding, unsigned slots)
+		:m_textureMgr(textureMgr), m_ID(GL_NONE), m_binding(binding), m_slots(std::max(slots, 1u)), m_bindless(isBindlessSupported()), m_capacity(0)
+	{
+		if(m_bindless)
+		{
+			glGenBuffers(1, &m_ID);
+			cout << "Generated OpenGL material table: " << m_ID << " (bindless textures, binding " << binding
+				 << (isNonUniformSupported() ? ", non-uniform indices" : ", uniform indices only") << ")" << endl;
+		}
+		else
+		{
+			cout << "Bindless textures not supported, binding material textures to texture units." << endl;
+		}
+	}
+
+	bool GLMaterialTable::isBindlessSupported(void)
+	{
+		return GLTexture::isBindlessSupported() && GLEW_ARB_shader_storage_buffer_object;
+	}
+
+	bool GLMaterialTable::isNonUniformSupported(void)
+	{
+		// Bindless samplers may only be indexed non-uniformly with NV_gpu_shader5
+		return isBindlessSupported() && GLEW_NV_gpu_shader5;
+	}
+
+	unsigned GLMaterialTable::add(const vector<TextureManager::Handle> &textures)
+	{
+		unsigned material = getCount();
+		m_textures.resize(m_textures.size() + m_slots);
+		m_handles.resize(m_textures.size(), 0);
+		for(unsigned slot = 0; slot < m_slots && slot < textures.size(); ++slot)
+		{
+			m_textures[material * m_slots + slot] = textures[slot];
+		}
+		return material;
+	}
+
+	void GLMaterialTable::set(unsigned material, unsigned slot, TextureManager::Handle texture)
+	{
+		if(material >= getCount() || slot >= m_slots) return;
+		m_textures[material * m_slots + slot] = texture;
+	}
+
+	void GLMaterialTable::update(void)
+	{
+		if(!m_bindless || m_textures.empty()) return;
+
+		// Handles change when textures finish loading, are streamed or removed, find the changed range
+		size_t first = m_textures.size(), last = 0;
+		for(size_t i = 0; i < m_textures.size(); ++i)
+		{
+			GLuint64 handle = 0;
+			if(!m_textures[i].isNull())
+			{
+				const GLTexture *pTexture = m_textureMgr.get(m_textures[i]);
+				handle = pTexture ? pTexture->getResidentHandle() : GLTexture::getPlaceholder().getResidentHandle();
+			}
+			if(handle == m_handles[i]) continue;
+
+			m_handles[i] = handle;
+			first = std::min(first, i);
+			last = i;
+		}
+
+		// New materials were added, reallocate and upload everything
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ID);
+		if(m_capacity < m_handles.size())
+		{
+			GLMemoryCounter::release(EGLMemory::BUFFER, m_capacity * sizeof(GLuint64));
+			m_capacity = std::max(m_handles.size(), m_capacity * 2);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, m_capacity * sizeof(GLuint64), nullptr, GL_DYNAMIC_DRAW);
+			GLMemoryCounter::allocate(EGLMemory::BUFFER, m_capacity * sizeof(GLuint64));
+			first = 0;
+			last = m_handles.size() - 1;
+			GLCallCounter::count(EGLCall::BUFFER);
+		}
+		if(first <= last)
+		{
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, first * sizeof(GLuint64), (last - first + 1) * sizeof(GLuint64), &m_handles[first]);
+			GLCallCounter::count(EGLCall::BUFFER);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, GL_NONE);
+		GLCallCounter::count(EGLCall::BUFFER, 2);
+	}
+
+	void GLMaterialTable::bind(void) const
+	{
+		if(!m_bindless) return;
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_binding, m_ID);
+		GLCallCounter::count(EGLCall::BUFFER);
+	}
+
+	void GLMaterialTable::bind(unsigned material, GLint firstUnit) const
+	{
+		if(material >= getCount()) return;
+
+		const TextureManager::Handle *pTextures = &m_textures[material * m_slots];
+		for(unsigned slot = 0; slot < m_slots; ++slot)
+		{
+			if(pTextures[slot].isNull()) continue;
+
+			const GLTexture *pTexture = m_textureMgr.get(pTextures[slot]);
+			if(m_bindless){ if(pTexture) pTexture->markUsed(); }
+			else GLTexture::bind(firstUnit + slot, pTexture ? *pTexture : GLTexture::getPlaceholder());
+		}
+	}
+
+	GLMaterialTable::~GLMaterialTable(void)
+	{
+		if(m_ID != GL_NONE)
+		{
+			cout << "Deleting OpenGL material table: " << m_ID << endl;
+			glDeleteBuffers(1, &m_ID);
+			m_ID = GL_NONE;
+			GLMemoryCounter::release(EGLMemory::BUFFER, m_capacity * sizeof(GLuint64));
+		}
+	}
+}
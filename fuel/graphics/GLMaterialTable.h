@@ -0,0 +1,169 @@
+/*****************************************************************
+ * GLMaterialTable.h
+ *****************************************************************
+ * Created on: 24.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_GLMATERIALTABLE_H_
+#define GRAPHICS_GLMATERIALTABLE_H_
+
+#include "../mgmt/TextureManager.h"
+
+namespace fuel
+{
+	/**
+	 * Textures of all materials, for shaders to select per draw.
+	 * With ARB_bindless_texture, the resident handles of every material's textures
+	 * are kept in a shader storage buffer, bound once per frame. Draws then only
+	 * pass their material index instead of binding textures. The index has to be
+	 * dynamically uniform, the same for all invocations of a draw, e.g. a uniform
+	 * or gl_DrawIDARB of a multi-draw issuing one draw per material. Sampling
+	 * through a handle selected per vertex or instance is undefined, unless
+	 * NV_gpu_shader5 lifts the restriction (see isNonUniformSupported()). Only
+	 * then may draws with different materials be merged into one instanced draw.
+	 * Without bindless textures the table falls back to binding the material's
+	 * textures to texture units before each draw.
+	 * Textures are referenced by their TextureManager handles, so removed or
+	 * replaced textures are detected and show the placeholder instead.
+	 * Shaders declare the table by including res/glsl/include/materials.glsl,
+	 * with FUEL_BINDLESS defined for the bindless path and FUEL_NONUNIFORM_MATERIALS
+	 * for non-uniform material indices.
+	 */
+	class GLMaterialTable
+	{
+	private:
+		// Resolves the texture handles
+		const TextureManager &m_textureMgr;
+
+		// Shader storage buffer, GL_NONE without bindless textures
+		GLuint m_ID;
+
+		// Shader storage buffer binding point
+		GLuint m_binding;
+
+		// Texture slots per material
+		unsigned m_slots;
+
+		// Whether handles are used rather than texture units
+		bool m_bindless;
+
+		// Textures of all materials, m_slots per material, null handles for empty slots
+		std::vector<TextureManager::Handle> m_textures;
+
+		// Handles as stored in the buffer, indexed like m_textures
+		std::vector<GLuint64> m_handles;
+
+		// Number of handles the buffer holds
+		size_t m_capacity;
+
+	public:
+		/**
+		 * Instantiates a new, empty material table.
+		 *
+		 * @param textureMgr
+		 * 		Texture manager the materials' textures are added to, has to outlive the table.
+		 *
+		 * @param binding
+		 * 		Shader storage buffer binding point, MATERIAL_BINDING in the shaders.
+		 *
+		 * @param slots
+		 * 		Texture slots per material, MATERIAL_TEXTURES in the shaders.
+		 */
+		GLMaterialTable(const TextureManager &textureMgr, GLuint binding, unsigned slots);
+
+		GLMaterialTable(const GLMaterialTable &) = delete;
+		GLMaterialTable &operator=(const GLMaterialTable &) = delete;
+
+		/**
+		 * Returns whether materials can be selected per draw through bindless handles.
+		 *
+		 * @return Whether ARB_bindless_texture and ARB_shader_storage_buffer_object are available.
+		 */
+		static bool isBindlessSupported(void);
+
+		/**
+		 * Returns whether the material index may differ within a draw,
+		 * e.g. be passed as instance data.
+		 *
+		 * @return Whether bindless materials are supported along with NV_gpu_shader5.
+		 */
+		static bool isNonUniformSupported(void);
+
+		/**
+		 * Returns whether this table uses bindless handles.
+		 * Shaders have to be compiled with FUEL_BINDLESS defined if so.
+		 *
+		 * @return False if it binds texture units.
+		 */
+		inline bool isBindless(void) const { return m_bindless; }
+
+		/**
+		 * Returns the number of materials.
+		 *
+		 * @return Material count.
+		 */
+		inline unsigned getCount(void) const { return m_textures.size() / m_slots; }
+
+		/**
+		 * Adds a material.
+		 *
+		 * @param textures
+		 * 		Texture handles of the slots in order, missing slots and null handles are empty.
+		 *
+		 * @return Index of the material.
+		 */
+		unsigned add(const std::vector<TextureManager::Handle> &textures);
+
+		/**
+		 * Replaces the texture of a material's slot.
+		 *
+		 * @param material
+		 * 		Material index.
+		 *
+		 * @param slot
+		 * 		Texture slot.
+		 *
+		 * @param texture
+		 * 		Texture handle, the null handle for an empty slot, which must not be sampled.
+		 */
+		void set(unsigned material, unsigned slot, TextureManager::Handle texture);
+
+		/**
+		 * Writes the handles of textures changed since the last update to the buffer,
+		 * e.g. after they finished loading, were streamed or removed. Without bindless
+		 * textures nothing needs to be updated.
+		 * Intended to be called once per frame after TextureManager::update(),
+		 * which may replace texture storage, and before any draw.
+		 */
+		void update(void);
+
+		/**
+		 * Binds the table for all draws following.
+		 * Binds the shader storage buffer, or does nothing without bindless textures.
+		 */
+		void bind(void) const;
+
+		/**
+		 * Prepares a draw with the given material.
+		 * Binds the material's textures to consecutive texture units without bindless
+		 * textures, the placeholder for removed ones. With them it only records the
+		 * textures as used, the shader selects the material by its index.
+		 *
+		 * @param material
+		 * 		Material index.
+		 *
+		 * @param firstUnit
+		 * 		Texture unit of slot 0 when binding texture units.
+		 */
+		void bind(unsigned material, GLint firstUnit = 0) const;
+
+		/**
+		 * Release the shader storage buffer.
+		 */
+		~GLMaterialTable(void);
+	};
+}
+
+#endif // GRAPHICS_GLMATERIALTABLE_H_
@@ -0,0 +1,35 @@
+/*****************************************************************
+ * GLMemoryCounter.cpp
+ *****************************************************************
+ * Created on: 21.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include "GLMemoryCounter.h"
+
+namespace fuel
+{
+	using namespace std;
+
+	size_t GLMemoryCounter::s_bytes[static_cast<unsigned>(EGLMemory::COUNT)] = {};
+
+	size_t GLMemoryCounter::getTotal(void)
+	{
+		size_t total = 0;
+		for(size_t bytes : s_bytes) total += bytes;
+		return total;
+	}
+
+	void GLMemoryCounter::print(void)
+	{
+		const double MB = 1024.0 * 1024.0;
+		cout << "GPU memory:\t\t" << getTotal() / MB << "MB"
+			 << " (texture "       << get(EGLMemory::TEXTURE) / MB
+			 << ", render target " << get(EGLMemory::RENDER_TARGET) / MB
+			 << ", buffer "        << get(EGLMemory::BUFFER) / MB
+			 << ", uniform "       << get(EGLMemory::UNIFORM) / MB
+			 << ", staging "       << get(EGLMemory::STAGING) / MB << ")"
+			 << endl;
+	}
+}
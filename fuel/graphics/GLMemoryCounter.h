@@ -0,0 +1,89 @@
+/*****************************************************************
+ * GLMemoryCounter.h
+ *****************************************************************
+ * Created on: 21.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_GLMEMORYCOUNTER_H_
+#define GRAPHICS_GLMEMORYCOUNTER_H_
+
+#include <cstddef>
+#include <iostream>
+
+namespace fuel
+{
+	/**
+	 * Categories of GPU memory allocated by the engine.
+	 */
+	enum class EGLMemory : unsigned char
+	{
+		TEXTURE,		//!< Textures loaded from files
+		RENDER_TARGET,	//!< Framebuffer attachments, including idle pooled ones
+		BUFFER,			//!< Vertex and index buffers
+		UNIFORM,		//!< Uniform buffers
+		STAGING,		//!< Pixel unpack buffers of the texture loader
+		COUNT			//!< COUNT
+	};
+
+	/**
+	 * Tracks the GPU memory held by the engine's wrappers.
+	 * Every object reports the size of its storage when allocating and releasing it,
+	 * so the totals are live. Sizes are computed from formats and dimensions,
+	 * driver overhead (alignment, padding, metadata) is not included.
+	 */
+	class GLMemoryCounter
+	{
+	private:
+		// Resident bytes per category
+		static size_t s_bytes[static_cast<unsigned>(EGLMemory::COUNT)];
+
+	public:
+		/**
+		 * Records allocated storage.
+		 *
+		 * @param category
+		 * 		Memory category.
+		 *
+		 * @param bytes
+		 * 		Size of the storage.
+		 */
+		static inline void allocate(EGLMemory category, size_t bytes){ s_bytes[static_cast<unsigned>(category)] += bytes; }
+
+		/**
+		 * Records released storage.
+		 *
+		 * @param category
+		 * 		Memory category the storage was allocated in.
+		 *
+		 * @param bytes
+		 * 		Size of the storage.
+		 */
+		static inline void release(EGLMemory category, size_t bytes){ s_bytes[static_cast<unsigned>(category)] -= bytes; }
+
+		/**
+		 * Returns the resident bytes of a category.
+		 *
+		 * @param category
+		 * 		Memory category.
+		 *
+		 * @return Size in bytes.
+		 */
+		static inline size_t get(EGLMemory category){ return s_bytes[static_cast<unsigned>(category)]; }
+
+		/**
+		 * Returns the resident bytes of all categories.
+		 *
+		 * @return Size in bytes.
+		 */
+		static size_t getTotal(void);
+
+		/**
+		 * Prints the resident memory by category.
+		 */
+		static void print(void);
+	};
+}
+
+#endif // GRAPHICS_GLMEMORYCOUNTER_H_
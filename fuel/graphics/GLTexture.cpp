@@ -6,13 +6,19 @@
  *****************************************************************
  *****************************************************************/
 
+#include <algorithm>
 #include <SOIL.h>
+#include "../core/AssetPack.h"
 #include "GLTexture.h"
 
 namespace fuel
 {
+	uint32_t GLTexture::s_frame = 1;
+
 	GLTexture::GLTexture(void)
-		:m_ID(GL_NONE), m_width(0), m_height(0)
+		:m_ID(GL_NONE), m_width(0), m_height(0), m_format(GL_NONE), m_target(GL_TEXTURE_2D), m_samples(1), m_ready(true),
+		 m_loading(false), m_levelCount(0), m_baseLevel(0), m_byteSize(0), m_memory(EGLMemory::TEXTURE), m_lastUse(0),
+		 m_requestedLevel(0), m_requestFrame(0), m_handle(0)
 	{
 		// Create empty texture
 		glGenTextures(1, &m_ID);
@@ -28,10 +34,16 @@ namespace fuel
 	}
 
 	GLTexture::GLTexture(const string &filename)
-		:m_ID(GL_NONE), m_width(0), m_height(0)
+		:m_ID(GL_NONE), m_width(0), m_height(0), m_format(GL_RGBA8), m_target(GL_TEXTURE_2D), m_samples(1), m_ready(true),
+		 m_loading(false), m_levelCount(0), m_baseLevel(0), m_byteSize(0), m_memory(EGLMemory::TEXTURE), m_lastUse(0),
+		 m_requestedLevel(0), m_requestFrame(0), m_handle(0)
 	{
-		// Load texture using SOIL
-		m_ID = SOIL_load_OGL_texture(filename.c_str(), 4, 0, SOIL_FLAG_MIPMAPS | SOIL_FLAG_INVERT_Y);
+		// Load texture using SOIL, from an asset pack if one holds the file
+		AssetData file = AssetPack::open(filename);
+		if(file.isValid())
+		{
+			m_ID = SOIL_load_OGL_texture_from_memory(file.getData(), file.getSize(), 4, 0, SOIL_FLAG_MIPMAPS | SOIL_FLAG_INVERT_Y);
+		}
 
 		if(m_ID != GL_NONE)
 		{
@@ -47,6 +59,10 @@ namespace fuel
 			m_width = static_cast<uint16_t>(w);
 			m_height = static_cast<uint16_t>(h);
 
+			// SOIL uploads the complete RGBA8 mipmap chain
+			while((std::max(m_width, m_height) >> m_levelCount) > 0) ++m_levelCount;
+			setByteSize(EGLMemory::TEXTURE, getStorageSize(GL_RGBA8, m_width, m_height, 0, m_levelCount));
+
 			cout << "Texture size is: " << m_width << "x" << m_height << " pixels." << endl;
 
 			glBindTexture(GL_TEXTURE_2D, GL_NONE);
@@ -57,14 +73,169 @@ namespace fuel
 		}
 	}
 
+	GLTexture::GLTexture(GLenum format, uint16_t width, uint16_t height, GLenum colorFormat, GLenum datatype, uint8_t samples)
+		:m_ID(GL_NONE), m_width(width), m_height(height), m_format(format),
+		 m_target(samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D), m_samples(std::max<uint8_t>(samples, 1)), m_ready(true),
+		 m_loading(false), m_levelCount(1), m_baseLevel(0), m_byteSize(0), m_memory(EGLMemory::RENDER_TARGET), m_lastUse(0),
+		 m_requestedLevel(0), m_requestFrame(0), m_handle(0)
+	{
+		glGenTextures(1, &m_ID);
+
+		if(m_ID != GL_NONE)
+		{
+			cout << "Generated OpenGL texture: " << m_ID << " (" << m_width << "x" << m_height << ")" << endl;
+
+			glBindTexture(m_target, m_ID);
+			if(m_samples > 1)
+			{
+				if(GLEW_ARB_texture_storage_multisample)
+					glTexStorage2DMultisample(m_target, m_samples, format, width, height, GL_TRUE);
+				else
+					glTexImage2DMultisample(m_target, m_samples, format, width, height, GL_TRUE);
+			}
+			else
+			{
+				if(GLEW_ARB_texture_storage)
+					glTexStorage2D(m_target, 1, format, width, height);
+				else
+					glTexImage2D(m_target, 0, format, width, height, 0, colorFormat, datatype, nullptr);
+				glTexParameteri(m_target, GL_TEXTURE_MAX_LEVEL, 0);
+			}
+			glBindTexture(m_target, GL_NONE);
+			setByteSize(EGLMemory::RENDER_TARGET, getStorageSize(format, width, height, 0, 1) * m_samples);
+		}
+		else
+		{
+			cerr << "Could not generate OpenGL texture." << endl;
+		}
+	}
+
+	const GLTexture &GLTexture::getPlaceholder(void)
+	{
+		static GLTexture *s_pPlaceholder = nullptr;
+		if(s_pPlaceholder == nullptr)
+		{
+			const uint8_t gray[4] = {128, 128, 128, 255};
+			s_pPlaceholder = new GLTexture(GL_RGBA8, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+			s_pPlaceholder->setByteSize(EGLMemory::TEXTURE, 4);
+			glBindTexture(GL_TEXTURE_2D, s_pPlaceholder->m_ID);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, gray);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		}
+		return *s_pPlaceholder;
+	}
+
+	void GLTexture::request(float screenSize) const
+	{
+		// Each level halves the texels covering the screen
+		unsigned coarsest = m_levelCount > 0 ? m_levelCount - 1 : 0;
+		float texels = std::max(m_width, m_height);
+		unsigned level = coarsest;
+		if(screenSize >= texels) level = 0;
+		else if(screenSize > 0.0f) level = std::min(static_cast<unsigned>(std::log2(texels / screenSize)), coarsest);
+
+		if(m_requestFrame != s_frame || level < m_requestedLevel)
+		{
+			m_requestedLevel = level;
+			m_requestFrame = s_frame;
+		}
+	}
+
+	GLuint64 GLTexture::getResidentHandle(void) const
+	{
+		// Parameters of textures with handles are frozen, but the loader still
+		// moves the base level of textures filled in place
+		if(!m_ready || (m_loading && m_byteSize == 0)) return getPlaceholder().getResidentHandle();
+
+		if(m_handle == 0)
+		{
+			m_handle = glGetTextureHandleARB(m_ID);
+			glMakeTextureHandleResidentARB(m_handle);
+		}
+		return m_handle;
+	}
+
+	void GLTexture::replaceID(GLuint textureID)
+	{
+		if(m_handle != 0)
+		{
+			glMakeTextureHandleNonResidentARB(m_handle);
+			m_handle = 0;
+		}
+		glDeleteTextures(1, &m_ID);
+		m_ID = textureID;
+	}
+
+	void GLTexture::setByteSize(EGLMemory category, size_t bytes)
+	{
+		GLMemoryCounter::release(m_memory, m_byteSize);
+		GLMemoryCounter::allocate(category, bytes);
+		m_memory = category;
+		m_byteSize = bytes;
+	}
+
+	size_t GLTexture::getStorageSize(GLenum format, uint16_t width, uint16_t height, unsigned firstLevel, unsigned levels)
+	{
+		// Compressed formats store 4x4 blocks
+		unsigned blockSize = 0;
+		switch(format)
+		{
+			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+				blockSize = 8;
+				break;
+
+			case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT: case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: case GL_COMPRESSED_RGBA_BPTC_UNORM_ARB:
+				blockSize = 16;
+				break;
+		}
+		unsigned texelSize = blockSize ? 0 : getTexelSize(format);
+
+		size_t size = 0;
+		for(unsigned level = firstLevel; level < firstLevel + levels; ++level)
+		{
+			size_t w = std::max(width >> level, 1), h = std::max(height >> level, 1);
+			size += blockSize ? ((w + 3) / 4) * ((h + 3) / 4) * blockSize : w * h * texelSize;
+		}
+		return size;
+	}
+
+	unsigned GLTexture::getTexelSize(GLenum format)
+	{
+		switch(format)
+		{
+			case GL_RGBA32F: case GL_RGBA32UI:
+				return 16;
+
+			case GL_RGB32F: case GL_RGB32UI:
+				return 12;
+
+			case GL_RGBA16F: case GL_RGBA16UI: case GL_RG32F:
+				return 8;
+
+			case GL_RGB16F: case GL_RGB16UI:
+				return 6;
+
+			case GL_RGBA8: case GL_RG16F: case GL_DEPTH_COMPONENT32F: case GL_DEPTH24_STENCIL8:
+				return 4;
+
+			case GL_RGB8:
+				return 3;
+
+			default:
+				return 0;
+		}
+	}
+
 	GLTexture::~GLTexture(void)
 	{
 		// Delete texture
 		if(m_ID != GL_NONE)
 		{
 			cout << "Deleting OpenGL texture: " << m_ID << endl;
-			glDeleteTextures(1, &m_ID);
-			m_ID = GL_NONE;
+			replaceID(GL_NONE);
 		}
+		GLMemoryCounter::release(m_memory, m_byteSize);
 	}
 }
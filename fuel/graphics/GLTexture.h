@@ -10,6 +10,7 @@
 #define GRAPHICS_GLTEXTURE_H_
 
 #include "GLWindow.h"
+#include "GLMemoryCounter.h"
 #include <vector>
 
 namespace fuel
@@ -21,16 +22,90 @@ namespace fuel
 	 */
 	class GLTexture
 	{
+		// Allocates storage and uploads texels of asynchronously loaded textures
+		friend class GLTextureLoader;
+
+		// Replaces the storage of packed textures by views of its layers
+		friend class GLTextureArray;
+
+		// Shows the placeholder for textures removed meanwhile
+		friend class GLMaterialTable;
+
 	private:
 		// OpenGL texture ID
 		GLuint m_ID;
 
-		// Texture width
+		// Texture width (of the complete image, resident storage may start at a coarser level)
 		uint16_t m_width;
 
-		// Texture height
+		// Texture height (of the complete image, resident storage may start at a coarser level)
 		uint16_t m_height;
 
+		// OpenGL internal format
+		GLenum m_format;
+
+		// OpenGL texture target (GL_TEXTURE_2D or GL_TEXTURE_2D_MULTISAMPLE)
+		GLenum m_target;
+
+		// Number of samples per texel
+		uint8_t m_samples;
+
+		// Whether the texel data is complete, the placeholder is bound otherwise
+		bool m_ready;
+
+		// Whether the loader is (re)loading the texel data
+		bool m_loading;
+
+		// Mipmap levels of the complete image, 0 if unknown
+		uint8_t m_levelCount;
+
+		// Finest level of the complete image held by the storage, m_levelCount if none
+		uint8_t m_baseLevel;
+
+		// Size of the storage and the category it is accounted in
+		size_t m_byteSize;
+		EGLMemory m_memory;
+
+		// Frame the texture was last bound in
+		mutable uint32_t m_lastUse;
+
+		// Finest mipmap level required in m_requestFrame, from screen size estimates
+		mutable uint8_t m_requestedLevel;
+		mutable uint32_t m_requestFrame;
+
+		// Current frame, for m_lastUse
+		static uint32_t s_frame;
+
+		// Bindless handle, resident once created, 0 if there is none
+		mutable GLuint64 m_handle;
+
+		/**
+		 * Replaces the texture object, deleting the current one and its bindless handle.
+		 *
+		 * @param textureID
+		 * 		New texture object.
+		 */
+		void replaceID(GLuint textureID);
+
+		/**
+		 * Accounts the texture's storage, replacing the previous size.
+		 *
+		 * @param category
+		 * 		Memory category.
+		 *
+		 * @param bytes
+		 * 		Size of the storage in bytes.
+		 */
+		void setByteSize(EGLMemory category, size_t bytes);
+
+		/**
+		 * Returns the texture bound in place of textures still loading.
+		 * Created on first use.
+		 *
+		 * @return Single texel mid-gray texture.
+		 */
+		static const GLTexture &getPlaceholder(void);
+
 	public:
 		/**
 		 * Instantiates a new empty OpenGL texture.
@@ -45,6 +120,31 @@ namespace fuel
 		 */
 		GLTexture(const string &filename);
 
+		/**
+		 * Instantiates a new single level texture with immutable storage.
+		 * Falls back to mutable storage if ARB_texture_storage is unavailable.
+		 * Multisampled textures are bound to GL_TEXTURE_2D_MULTISAMPLE.
+		 *
+		 * @param format
+		 * 		OpenGL internal format. (GL_RGB32F, ..)
+		 *
+		 * @param width
+		 * 		Width in pixels.
+		 *
+		 * @param height
+		 * 		Height in pixels.
+		 *
+		 * @param colorFormat
+		 * 		OpenGL pixel value format used by the mutable fallback.
+		 *
+		 * @param datatype
+		 * 		OpenGL pixel value datatype used by the mutable fallback.
+		 *
+		 * @param samples
+		 * 		Number of samples per texel.
+		 */
+		GLTexture(GLenum format, uint16_t width, uint16_t height, GLenum colorFormat, GLenum datatype, uint8_t samples = 1);
+
 		/**
 		 * Returns the OpenGL texture ID.
 		 *
@@ -52,6 +152,23 @@ namespace fuel
 		 */
 		inline GLuint getID(void) const { return m_ID; }
 
+		/**
+		 * Returns whether textures can be accessed through bindless handles.
+		 *
+		 * @return Whether ARB_bindless_texture is available.
+		 */
+		static inline bool isBindlessSupported(void){ return GLEW_ARB_bindless_texture != GL_FALSE; }
+
+		/**
+		 * Returns a bindless handle for sampling the texture, made resident on first use.
+		 * Textures still loading return the placeholder's handle, as bind() would bind it.
+		 * The handle changes whenever the texture's storage is replaced, e.g. by streaming.
+		 * Requires ARB_bindless_texture.
+		 *
+		 * @return Texture handle.
+		 */
+		GLuint64 getResidentHandle(void) const;
+
 		/**
 		 * Returns the texture width in pixels.
 		 *
@@ -67,7 +184,165 @@ namespace fuel
 		inline uint16_t getHeight(void) const { return m_height; }
 
 		/**
-		 * Binds the given texture to the GL_TEXTURE_2D target of the texture unit specified.
+		 * Returns the OpenGL internal format.
+		 *
+		 * @return Internal format. GL_NONE if unknown.
+		 */
+		inline GLenum getFormat(void) const { return m_format; }
+
+		/**
+		 * Returns the OpenGL texture target.
+		 *
+		 * @return Texture target.
+		 */
+		inline GLenum getTarget(void) const { return m_target; }
+
+		/**
+		 * Returns the number of samples per texel.
+		 *
+		 * @return Sample count.
+		 */
+		inline uint8_t getSamples(void) const { return m_samples; }
+
+		/**
+		 * Returns whether the texel data is complete.
+		 * Only textures loaded in the background are ever incomplete.
+		 *
+		 * @return Whether the texture is ready.
+		 */
+		inline bool isReady(void) const { return m_ready; }
+
+		/**
+		 * Returns whether the texture loader is (re)loading the texel data.
+		 *
+		 * @return Whether a load is in flight.
+		 */
+		inline bool isLoading(void) const { return m_loading; }
+
+		/**
+		 * Returns the number of mipmap levels of the complete image.
+		 *
+		 * @return Level count, 0 if unknown (e.g. the texture failed to load).
+		 */
+		inline uint8_t getLevelCount(void) const { return m_levelCount; }
+
+		/**
+		 * Returns the finest mipmap level of the complete image that is resident.
+		 * Levels below were evicted to save memory, the storage's level 0 is this level.
+		 *
+		 * @return Base level, the level count if the texture is not resident at all.
+		 */
+		inline uint8_t getBaseLevel(void) const { return m_baseLevel; }
+
+		/**
+		 * Returns the size of the texture's storage.
+		 *
+		 * @return Size in bytes.
+		 */
+		inline size_t getByteSize(void) const { return m_byteSize; }
+
+		/**
+		 * Returns the frame the texture was last bound in.
+		 *
+		 * @return Frame number, 0 if it was never bound.
+		 */
+		inline uint32_t getLastUse(void) const { return m_lastUse; }
+
+		/**
+		 * Records the texture as used in the current frame, as bind() does.
+		 * For textures sampled without being bound, e.g. through bindless handles.
+		 */
+		inline void markUsed(void) const { m_lastUse = s_frame; }
+
+		/**
+		 * Records the size the texture is drawn at in the current frame.
+		 * Mipmap levels finer than the size needs are not required to be resident,
+		 * the finest level required by any call within a frame counts.
+		 *
+		 * @param screenSize
+		 * 		Extent in pixels the texture's larger dimension covers on screen,
+		 * 		e.g. from getScreenSize().
+		 */
+		void request(float screenSize) const;
+
+		/**
+		 * Returns the finest mipmap level required in the current frame.
+		 *
+		 * @return Level of the complete image. 0 if the texture was drawn without
+		 * 		   a screen size estimate, or not at all.
+		 */
+		inline uint8_t getRequestedLevel(void) const { return m_requestFrame == s_frame ? m_requestedLevel : 0; }
+
+		/**
+		 * Estimates the on-screen size of an object, for request().
+		 *
+		 * @param extent
+		 * 		Size of the object in world units, along which the texture repeats once.
+		 *
+		 * @param distance
+		 * 		Distance of the object to the camera.
+		 *
+		 * @param projection
+		 * 		Perspective projection matrix.
+		 *
+		 * @param viewportHeight
+		 * 		Height of the viewport in pixels.
+		 *
+		 * @return Size in pixels.
+		 */
+		static inline float getScreenSize(float extent, float distance, const glm::mat4 &projection, float viewportHeight)
+		{
+			return extent * projection[1][1] * viewportHeight * 0.5f / std::max(distance, 1e-4f);
+		}
+
+		/**
+		 * Returns the current frame number, as recorded by bind().
+		 *
+		 * @return Frame number.
+		 */
+		static inline uint32_t getFrame(void){ return s_frame; }
+
+		/**
+		 * Starts a new frame for the usage tracking of bind().
+		 */
+		static inline void advanceFrame(void){ ++s_frame; }
+
+		/**
+		 * Returns the size of a range of mipmap levels.
+		 *
+		 * @param format
+		 * 		OpenGL internal format, uncompressed or S3TC/BPTC compressed.
+		 *
+		 * @param width
+		 * 		Width of level 0 in pixels.
+		 *
+		 * @param height
+		 * 		Height of level 0 in pixels.
+		 *
+		 * @param firstLevel
+		 * 		First level of the range.
+		 *
+		 * @param levels
+		 * 		Number of levels in the range.
+		 *
+		 * @return Size in bytes. 0 if the format is unknown.
+		 */
+		static size_t getStorageSize(GLenum format, uint16_t width, uint16_t height, unsigned firstLevel, unsigned levels);
+
+		/**
+		 * Returns the size of a single texel of the given internal format.
+		 *
+		 * @param format
+		 * 		OpenGL internal format.
+		 *
+		 * @return Texel size in bytes. 0 if the format is unknown.
+		 */
+		static unsigned getTexelSize(GLenum format);
+
+		/**
+		 * Binds the given texture to its target of the texture unit specified.
+		 * Textures still loading are replaced by a placeholder.
+		 * Records the texture as used in the current frame.
 		 *
 		 * @param unit
 		 * 		Texture unit to bind texture to.
@@ -77,9 +352,28 @@ namespace fuel
 		 */
 		static inline void bind(GLint unit, const GLTexture &txr)
 		{
+			txr.markUsed();
 			glActiveTexture(GL_TEXTURE0 + unit);
 			glEnable(GL_TEXTURE_2D);
-			glBindTexture(GL_TEXTURE_2D, txr.m_ID);
+			glBindTexture(txr.m_target, txr.m_ready ? txr.m_ID : getPlaceholder().m_ID);
+		}
+
+		/**
+		 * Binds the given texture drawn at the given size to the texture unit specified.
+		 *
+		 * @param unit
+		 * 		Texture unit to bind texture to.
+		 *
+		 * @param txr
+		 * 		Texture to bind.
+		 *
+		 * @param screenSize
+		 * 		Extent in pixels the texture covers on screen, see request().
+		 */
+		static inline void bind(GLint unit, const GLTexture &txr, float screenSize)
+		{
+			txr.request(screenSize);
+			bind(unit, txr);
 		}
 
 		/**
@@ -0,0 +1,117 @@
+/*****************************************************************
+ * GLTextureArray.cpp
+ *****************************************************************
+ * Created on: 23.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include <algorithm>
+#include "GLTextureArray.h"
+
+namespace fuel
+{
+	using namespace std;
+
+	GLTextureArray::GLTextureArray(GLenum format, uint16_t width, uint16_t height, uint8_t levelCount)
+	{
+		m_texture.m_target = GL_TEXTURE_2D_ARRAY;
+		m_texture.m_format = format;
+		m_texture.m_width = width;
+		m_texture.m_height = height;
+		m_texture.m_levelCount = levelCount;
+	}
+
+	bool GLTextureArray::isSupported(void)
+	{
+		return GLEW_ARB_texture_storage && GLEW_ARB_copy_image && GLEW_ARB_texture_view;
+	}
+
+	bool GLTextureArray::accepts(const GLTexture &txr) const
+	{
+		return txr.m_target == GL_TEXTURE_2D && txr.m_ready && !txr.m_loading && txr.m_baseLevel == 0
+			&& txr.m_format == m_texture.m_format && txr.m_width == m_texture.m_width && txr.m_height == m_texture.m_height
+			&& txr.m_levelCount == m_texture.m_levelCount;
+	}
+
+	void GLTextureArray::createView(GLTexture &txr, uint16_t layer) const
+	{
+		// Views need a name that was never bound
+		GLuint textureID;
+		glGenTextures(1, &textureID);
+		txr.replaceID(textureID);
+		glTextureView(txr.m_ID, GL_TEXTURE_2D, m_texture.m_ID, m_texture.m_format, 0, m_texture.m_levelCount, layer, 1);
+		glBindTexture(GL_TEXTURE_2D, txr.m_ID);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, GL_NONE);
+
+		// The array accounts the storage
+		txr.setByteSize(EGLMemory::TEXTURE, 0);
+	}
+
+	bool GLTextureArray::grow(uint16_t capacity)
+	{
+		GLint maxLayers;
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+		if(capacity > maxLayers) return false;
+
+		GLuint textureID;
+		glGenTextures(1, &textureID);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, m_texture.m_levelCount, m_texture.m_format, m_texture.m_width, m_texture.m_height, capacity);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, GL_NONE);
+
+		// Copy all layers at once, level by level
+		if(!m_layers.empty())
+		{
+			for(unsigned level = 0; level < m_texture.m_levelCount; ++level)
+			{
+				GLsizei w = std::max(m_texture.m_width >> level, 1), h = std::max(m_texture.m_height >> level, 1);
+				glCopyImageSubData(m_texture.m_ID, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+					textureID, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, w, h, m_layers.size());
+			}
+		}
+		m_texture.replaceID(textureID);
+		m_texture.setByteSize(EGLMemory::TEXTURE, GLTexture::getStorageSize(m_texture.m_format, m_texture.m_width, m_texture.m_height,
+			0, m_texture.m_levelCount) * capacity);
+
+		// Views keep the old storage alive, point them to the new one
+		for(uint16_t layer = 0; layer < m_layers.size(); ++layer)
+		{
+			if(auto pTexture = m_layers[layer].lock()) createView(*pTexture, layer);
+		}
+		m_layers.resize(capacity);
+		return true;
+	}
+
+	int GLTextureArray::add(const shared_ptr<GLTexture> &pTexture)
+	{
+		auto iter = find_if(m_layers.begin(), m_layers.end(), [](const weak_ptr<GLTexture> &pLayer){ return pLayer.expired(); });
+		if(iter == m_layers.end())
+		{
+			size_t capacity = m_layers.size();
+			size_t grown = std::min<size_t>(std::max<size_t>(capacity * 2, 4), 0xFFFF);
+			if(grown == capacity || !grow(grown)) return -1;
+			iter = m_layers.begin() + capacity;
+		}
+		uint16_t layer = iter - m_layers.begin();
+
+		GLTexture &txr = *pTexture;
+		for(unsigned level = 0; level < txr.m_levelCount; ++level)
+		{
+			GLsizei w = std::max(txr.m_width >> level, 1), h = std::max(txr.m_height >> level, 1);
+			glCopyImageSubData(txr.m_ID, GL_TEXTURE_2D, level, 0, 0, 0,
+				m_texture.m_ID, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1);
+		}
+		createView(txr, layer);
+		*iter = pTexture;
+		return layer;
+	}
+}
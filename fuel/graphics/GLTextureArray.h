@@ -0,0 +1,129 @@
+/*****************************************************************
+ * GLTextureArray.h
+ *****************************************************************
+ * Created on: 23.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_GLTEXTUREARRAY_H_
+#define GRAPHICS_GLTEXTUREARRAY_H_
+
+#include "GLTexture.h"
+
+namespace fuel
+{
+	/**
+	 * Array texture holding equally sized textures in its layers.
+	 * Textures are copied into a layer on the GPU, after which their own storage
+	 * is replaced by a view of that layer. They remain usable on their own while
+	 * sharing the array's memory, and draws sampling different textures of the
+	 * array can be batched with the array bound once. The array grows by
+	 * doubling its layer count, copying the layers into the new storage.
+	 * Requires ARB_texture_storage, ARB_copy_image and ARB_texture_view.
+	 */
+	class GLTextureArray
+	{
+	private:
+		// Array texture, bound to GL_TEXTURE_2D_ARRAY
+		GLTexture m_texture;
+
+		// Textures per layer, expired for free layers
+		std::vector<std::weak_ptr<GLTexture>> m_layers;
+
+		/**
+		 * Replaces a texture's storage with a view of a layer.
+		 *
+		 * @param txr
+		 * 		Texture to replace the storage of.
+		 *
+		 * @param layer
+		 * 		Layer to view.
+		 */
+		void createView(GLTexture &txr, uint16_t layer) const;
+
+		/**
+		 * Reallocates the array with more layers, keeping the current ones.
+		 *
+		 * @param capacity
+		 * 		New layer count.
+		 *
+		 * @return False if the layer count exceeds the implementation's limit.
+		 */
+		bool grow(uint16_t capacity);
+
+	public:
+		/**
+		 * Instantiates a new, empty texture array.
+		 *
+		 * @param format
+		 * 		OpenGL internal format of the layers.
+		 *
+		 * @param width
+		 * 		Width of the layers in pixels.
+		 *
+		 * @param height
+		 * 		Height of the layers in pixels.
+		 *
+		 * @param levelCount
+		 * 		Number of mipmap levels of the layers.
+		 */
+		GLTextureArray(GLenum format, uint16_t width, uint16_t height, uint8_t levelCount);
+
+		GLTextureArray(const GLTextureArray &) = delete;
+		GLTextureArray &operator=(const GLTextureArray &) = delete;
+
+		/**
+		 * Returns whether texture arrays can be filled on this implementation.
+		 *
+		 * @return Whether the required extensions are available.
+		 */
+		static bool isSupported(void);
+
+		/**
+		 * Returns whether a texture fits the layers of this array.
+		 *
+		 * @param txr
+		 * 		Texture to check.
+		 *
+		 * @return Whether format, size and mipmap levels match.
+		 */
+		bool accepts(const GLTexture &txr) const;
+
+		/**
+		 * Copies a texture into a free layer and makes it view that layer.
+		 * Layers of textures deleted meanwhile are reused.
+		 *
+		 * @param pTexture
+		 * 		Completely resident texture accepted by this array.
+		 *
+		 * @return The layer, -1 if the array cannot grow any further.
+		 */
+		int add(const std::shared_ptr<GLTexture> &pTexture);
+
+		/**
+		 * Frees a layer for later additions.
+		 * A texture still viewing the layer shows whatever is copied into it next.
+		 *
+		 * @param layer
+		 * 		Layer returned by add().
+		 */
+		inline void remove(uint16_t layer){ if(layer < m_layers.size()) m_layers[layer].reset(); }
+
+		/**
+		 * Returns the array texture.
+		 *
+		 * @return Texture to bind for sampling any layer.
+		 */
+		inline const GLTexture &getTexture(void) const { return m_texture; }
+
+		/**
+		 * Returns the number of layers, used or not.
+		 *
+		 * @return Layer count.
+		 */
+		inline size_t getCapacity(void) const { return m_layers.size(); }
+	};
+}
+
+#endif // GRAPHICS_GLTEXTUREARRAY_H_
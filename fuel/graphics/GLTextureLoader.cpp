@@ -0,0 +1,467 @@
+/*****************************************************************
+ * GLTextureLoader.cpp
+ *****************************************************************
+ * Created on: 13.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <stb_image_aug.h>
+#include <stbi_SIMD.h>
+#include <image_mipmap.h>
+#include "GLTextureLoader.h"
+
+namespace fuel
+{
+	using namespace std;
+
+	GLTextureLoader::GLTextureLoader(size_t uploadBudget, unsigned threads)
+		:m_budget(uploadBudget), m_frame(0), m_pending(0), m_workers(threads)
+	{
+		// JPEG decoding kernels, installed before any worker decodes
+		cout << "JPEG decoder kernels: " << stbi_install_SIMD(1) << endl;
+		cout << "Mipmap kernels: " << set_mipmap_SIMD(1) << endl;
+
+		glGenBuffers(FRAMES, m_buffers);
+		for(unsigned i = 0; i < FRAMES; ++i)
+		{
+			m_bufferSizes[i] = 0;
+			m_fences[i] = nullptr;
+		}
+	}
+
+	void GLTextureLoader::decode(Image &image, EMipmapMode mode)
+	{
+		AssetData file = AssetPack::open(image.filename);
+		if(!file.isValid())
+		{
+			image.error = "file not readable";
+			return;
+		}
+
+		int width, height, channels;
+		stbi_uc *pTexels = stbi_load_from_memory(file.getData(), file.getSize(), &width, &height, &channels, 4);
+		if(pTexels == nullptr)
+		{
+			// Kept per thread, so this is the reason of this worker's decode
+			image.error = stbi_failure_reason();
+			return;
+		}
+		if(width > 0xFFFF || height > 0xFFFF)
+		{
+			stbi_image_free(pTexels);
+			image.error = "image too large";
+			return;
+		}
+
+		// Lay out the mipmap chain down to a single texel in one allocation,
+		// only level 0 if the GPU builds the others
+		image.format = GL_RGBA8;
+		image.levelCount = mipmap_chain_levels(width, height);
+		clampFirstLevel(image, width, height);
+		image.generateMipmaps = mode == EMipmapMode::GPU && image.levelCount > 1 && image.firstLevel == 0;
+		GLsizei stored = image.generateMipmaps ? 1 : image.levelCount;
+		image.storage.resize(image.generateMipmaps ? static_cast<size_t>(width) * height * 4 : mipmap_chain_size(width, height, 4));
+		size_t offset = 0;
+		uint16_t w = width, h = height;
+		for(GLsizei i = 0; i < stored; ++i, w = std::max(w / 2, 1), h = std::max(h / 2, 1))
+		{
+			image.levels.push_back({w, h, image.storage.data() + offset, static_cast<size_t>(w) * h * 4});
+			offset += image.levels.back().size;
+		}
+		image.uploaded = image.levels.size();
+
+		// OpenGL expects the bottom row first
+		size_t rowSize = width * 4;
+		uint8_t *pBase = image.storage.data();
+		for(int y = 0; y < height; ++y)
+		{
+			memcpy(pBase + (height - 1 - y) * rowSize, pTexels + y * rowSize, rowSize);
+		}
+		stbi_image_free(pTexels);
+
+		// Box filtered mipmap chain, behind level 0
+		if(!image.generateMipmaps) mipmap_chain(pBase, width, height, 4, mode == EMipmapMode::BOX_LINEAR);
+	}
+
+	void GLTextureLoader::map(Image &image)
+	{
+		image.file = AssetPack::open(image.filename, true);
+		const AssetData &file = image.file;
+		if(!file.isValid())
+		{
+			image.error = "file not readable";
+			return;
+		}
+
+		const TextureContainer::Header *pHeader = reinterpret_cast<const TextureContainer::Header *>(file.getData());
+		if(file.getSize() < sizeof(TextureContainer::Header) || pHeader->magic != TextureContainer::MAGIC || pHeader->levels == 0
+			|| file.getSize() < sizeof(TextureContainer::Header) + pHeader->levels * sizeof(TextureContainer::Level))
+		{
+			image.error = "not a texture container";
+			return;
+		}
+
+		switch(pHeader->format)
+		{
+			case TextureContainer::RGBA8: image.format = GL_RGBA8; break;
+			case TextureContainer::BC1:   image.format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; break;
+			case TextureContainer::BC3:   image.format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+			case TextureContainer::BC7:   image.format = GL_COMPRESSED_RGBA_BPTC_UNORM_ARB; break;
+			default: image.error = "unknown texel format"; return;
+		}
+		if((pHeader->format == TextureContainer::BC1 || pHeader->format == TextureContainer::BC3) && !GLEW_EXT_texture_compression_s3tc)
+		{
+			image.error = "S3TC compression not supported";
+			return;
+		}
+		if(pHeader->format == TextureContainer::BC7 && !GLEW_ARB_texture_compression_bptc)
+		{
+			image.error = "BPTC compression not supported";
+			return;
+		}
+		if(pHeader->width == 0 || pHeader->height == 0 || pHeader->width > 0xFFFF || pHeader->height > 0xFFFF)
+		{
+			image.error = "invalid texture size";
+			return;
+		}
+		if(pHeader->levels > static_cast<uint32_t>(mipmap_chain_levels(pHeader->width, pHeader->height)))
+		{
+			image.error = "more levels than the texture size allows";
+			return;
+		}
+
+		const TextureContainer::Level *pTable = reinterpret_cast<const TextureContainer::Level *>(pHeader + 1);
+		vector<Level> levels;
+		for(uint32_t i = 0; i < pHeader->levels; ++i)
+		{
+			const TextureContainer::Level &entry = pTable[i];
+			if(entry.offset > file.getSize() || entry.size > file.getSize() - entry.offset)
+			{
+				image.error = "level table out of bounds";
+				return;
+			}
+
+			// Each level halves the previous one, its size follows from the format's texel or block size
+			uint16_t width = std::max(pHeader->width >> i, 1u), height = std::max(pHeader->height >> i, 1u);
+			if(entry.width != width || entry.height != height
+				|| entry.size != GLTexture::getStorageSize(image.format, pHeader->width, pHeader->height, i, 1))
+			{
+				image.error = "level " + to_string(i) + " does not match the texture size";
+				return;
+			}
+			levels.push_back({static_cast<uint16_t>(entry.width), static_cast<uint16_t>(entry.height), file.getData() + entry.offset, entry.size});
+		}
+		image.levels = std::move(levels);
+		image.levelCount = image.levels.size();
+		clampFirstLevel(image, image.levels.front().width, image.levels.front().height);
+		image.uploaded = image.levels.size();
+	}
+
+	void GLTextureLoader::clampFirstLevel(Image &image, unsigned width, unsigned height)
+	{
+		// Levels larger than the limit are left to later reloads
+		if(image.maxSize > 0)
+		{
+			while(image.firstLevel + 1 < static_cast<unsigned>(image.levelCount) && (std::max(width, height) >> image.firstLevel) > image.maxSize)
+			{
+				++image.firstLevel;
+			}
+		}
+		image.firstLevel = std::min<unsigned>(image.firstLevel, image.levelCount - 1);
+	}
+
+	void GLTextureLoader::createStorage(GLuint textureID, GLenum format, uint16_t width, uint16_t height, unsigned firstLevel, unsigned levelCount)
+	{
+		GLsizei levels = levelCount - firstLevel;
+		GLsizei baseWidth = std::max(width >> firstLevel, 1), baseHeight = std::max(height >> firstLevel, 1);
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		if(GLEW_ARB_texture_storage)
+		{
+			glTexStorage2D(GL_TEXTURE_2D, levels, format, baseWidth, baseHeight);
+		}
+		else
+		{
+			GLsizei w = baseWidth, h = baseHeight;
+			for(GLsizei i = 0; i < levels; ++i, w = std::max(w / 2, 1), h = std::max(h / 2, 1))
+			{
+				if(format == GL_RGBA8)
+					glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+				else
+					glCompressedTexImage2D(GL_TEXTURE_2D, i, format, w, h, 0, GLTexture::getStorageSize(format, width, height, firstLevel + i, 1), nullptr);
+			}
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	void GLTextureLoader::copyLevels(const GLTexture &txr, GLuint textureID, unsigned firstLevel, unsigned fromLevel)
+	{
+		for(unsigned level = fromLevel; level < txr.m_levelCount; ++level)
+		{
+			GLsizei w = std::max(txr.m_width >> level, 1), h = std::max(txr.m_height >> level, 1);
+			glCopyImageSubData(txr.m_ID, GL_TEXTURE_2D, level - txr.m_baseLevel, 0, 0, 0,
+				textureID, GL_TEXTURE_2D, level - firstLevel, 0, 0, 0, w, h, 1);
+		}
+	}
+
+	void GLTextureLoader::allocate(GLTexture &txr, Image &image)
+	{
+		// Immutable storage cannot be specified again, so textures holding texels get a new object
+		bool resident = txr.m_byteSize > 0;
+		if(resident) glGenTextures(1, &image.textureID);
+		createStorage(image.textureID ? image.textureID : txr.m_ID, image.format,
+			image.levels.front().width, image.levels.front().height, image.firstLevel, image.levelCount);
+		image.allocated = true;
+
+		// Levels resident already need no upload
+		if(resident && GLEW_ARB_copy_image && txr.m_format == image.format && txr.m_levelCount == image.levelCount
+			&& txr.m_width == image.levels.front().width && txr.m_height == image.levels.front().height)
+		{
+			unsigned fromLevel = std::max<unsigned>(image.firstLevel, txr.m_baseLevel);
+			copyLevels(txr, image.textureID, image.firstLevel, fromLevel);
+			image.uploaded = std::min<unsigned>(image.uploaded, fromLevel);
+		}
+		txr.m_width = image.levels.front().width;
+		txr.m_height = image.levels.front().height;
+		txr.m_format = image.format;
+	}
+
+	void GLTextureLoader::request(const shared_ptr<GLTexture> &pTexture, const string &filename, EMipmapMode mode, unsigned firstLevel, uint16_t maxSize)
+	{
+		pTexture->m_loading = true;
+		++m_pending;
+
+		auto pImage = make_shared<Image>();
+		pImage->pTexture = pTexture;
+		pImage->filename = filename;
+		pImage->levelCount = 0;
+		pImage->firstLevel = firstLevel;
+		pImage->maxSize = maxSize;
+		pImage->textureID = GL_NONE;
+		pImage->generateMipmaps = false;
+		pImage->uploaded = 0;
+		pImage->allocated = false;
+
+		// Cooked containers are recognized by their extension
+		bool cooked = filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".ftx") == 0;
+
+		m_workers.submit([this, pImage, cooked, mode]
+		{
+			if(cooked) map(*pImage);
+			else decode(*pImage, mode);
+
+			lock_guard<mutex> lock(m_mutex);
+			m_decoded.push_back(pImage);
+		});
+	}
+
+	shared_ptr<GLTexture> GLTextureLoader::load(const string &filename, EMipmapMode mode, uint16_t maxSize)
+	{
+		auto pTexture = make_shared<GLTexture>();
+		pTexture->m_ready = false;
+		request(pTexture, filename, mode, 0, maxSize);
+		return pTexture;
+	}
+
+	void GLTextureLoader::reload(const shared_ptr<GLTexture> &pTexture, const string &filename, EMipmapMode mode, unsigned firstLevel)
+	{
+		GLTexture &txr = *pTexture;
+		if(txr.m_loading) return;
+
+		// Coarser levels are resident already, copy them into smaller storage without decoding the file
+		if(GLEW_ARB_copy_image && txr.m_byteSize > 0 && firstLevel > txr.m_baseLevel && firstLevel < txr.m_levelCount)
+		{
+			GLuint textureID;
+			glGenTextures(1, &textureID);
+			createStorage(textureID, txr.m_format, txr.m_width, txr.m_height, firstLevel, txr.m_levelCount);
+			glBindTexture(GL_TEXTURE_2D, GL_NONE);
+			copyLevels(txr, textureID, firstLevel, firstLevel);
+			txr.replaceID(textureID);
+			txr.m_baseLevel = firstLevel;
+			txr.setByteSize(EGLMemory::TEXTURE, GLTexture::getStorageSize(txr.m_format, txr.m_width, txr.m_height,
+				firstLevel, txr.m_levelCount - firstLevel));
+			return;
+		}
+		request(pTexture, filename, mode, firstLevel, 0);
+	}
+
+	void GLTextureLoader::unload(GLTexture &txr)
+	{
+		if(txr.m_loading || txr.m_byteSize == 0) return;
+
+		GLuint textureID;
+		glGenTextures(1, &textureID);
+		txr.replaceID(textureID);
+		txr.m_ready = false;
+		txr.m_baseLevel = txr.m_levelCount;
+		txr.setByteSize(EGLMemory::TEXTURE, 0);
+	}
+
+	void GLTextureLoader::update(void)
+	{
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_uploads.insert(m_uploads.end(), m_decoded.begin(), m_decoded.end());
+			m_decoded.clear();
+		}
+
+		// Drop failed images and those whose texture was deleted meanwhile
+		for(auto iter = m_uploads.begin(); iter != m_uploads.end();)
+		{
+			Image &image = **iter;
+			auto pTexture = image.pTexture.lock();
+			if(!image.levels.empty() && pTexture){ ++iter; continue; }
+
+			if(image.levels.empty())
+				cerr << "Could not load texture data from: " << image.filename << " (" << image.error << ")" << endl;
+			if(pTexture) pTexture->m_loading = false;
+			if(image.textureID) glDeleteTextures(1, &image.textureID);
+			iter = m_uploads.erase(iter);
+			--m_pending;
+		}
+		if(m_uploads.empty()) return;
+
+		// Never wait for the GPU, rather try the next staging buffer next frame
+		m_frame = (m_frame + 1) % FRAMES;
+		if(m_fences[m_frame])
+		{
+			if(glClientWaitSync(m_fences[m_frame], 0, 0) == GL_TIMEOUT_EXPIRED) return;
+			glDeleteSync(m_fences[m_frame]);
+			m_fences[m_frame] = nullptr;
+		}
+
+		// Select the levels to upload this frame, coarsest first. Storage is allocated
+		// once an image is reached, before sourcing texels from the staging buffer
+		struct Copy
+		{
+			Image *pImage;
+			unsigned level;
+			GLintptr offset;
+		};
+		vector<Copy> copies;
+		GLsizeiptr total = 0;
+		bool full = false;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+		for(auto iter = m_uploads.begin(); iter != m_uploads.end() && !full; ++iter)
+		{
+			Image &image = **iter;
+			if(!image.allocated) allocate(*image.pTexture.lock(), image);
+			for(unsigned level = image.uploaded; level-- > image.firstLevel;)
+			{
+				GLsizeiptr size = image.levels[level].size;
+				if(total > 0 && total + size > m_budget){ full = true; break; }
+				copies.push_back({&image, level, total});
+				total += size;
+			}
+		}
+		if(copies.empty())
+		{
+			complete();
+			return;
+		}
+
+		// Orphan the staging buffer, growing it if a single level exceeds the budget
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffers[m_frame]);
+		if(m_bufferSizes[m_frame] < total)
+		{
+			GLMemoryCounter::release(EGLMemory::STAGING, m_bufferSizes[m_frame]);
+			m_bufferSizes[m_frame] = std::max(total, m_budget);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, m_bufferSizes[m_frame], nullptr, GL_STREAM_DRAW);
+			GLMemoryCounter::allocate(EGLMemory::STAGING, m_bufferSizes[m_frame]);
+		}
+		uint8_t *pMapped = static_cast<uint8_t *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, total,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+		if(pMapped == nullptr)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+			return;
+		}
+		for(const Copy &copy : copies)
+		{
+			const Level &level = copy.pImage->levels[copy.level];
+			memcpy(pMapped + copy.offset, level.pData, level.size);
+		}
+
+		// Contents are undefined if the buffer was lost while mapped, retry next frame
+		if(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+			return;
+		}
+
+		for(const Copy &copy : copies)
+		{
+			Image &image = *copy.pImage;
+			const Level &level = image.levels[copy.level];
+			GLuint textureID = image.textureID ? image.textureID : image.pTexture.lock()->getID();
+			GLint target = copy.level - image.firstLevel;
+			glBindTexture(GL_TEXTURE_2D, textureID);
+			const void *pOffset = reinterpret_cast<const void *>(copy.offset);
+			if(image.format == GL_RGBA8)
+				glTexSubImage2D(GL_TEXTURE_2D, target, 0, 0, level.width, level.height, GL_RGBA, GL_UNSIGNED_BYTE, pOffset);
+			else
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, target, 0, 0, level.width, level.height, image.format, level.size, pOffset);
+			image.uploaded = copy.level;
+
+			// The GPU filters the remaining levels from the uploaded ones
+			if(image.generateMipmaps) glGenerateMipmap(GL_TEXTURE_2D);
+
+			// Textures without texels show the levels uploaded so far, sampling is clamped to them
+			if(image.textureID == GL_NONE)
+			{
+				GLTexture &txr = *image.pTexture.lock();
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, target);
+				txr.m_levelCount = image.levelCount;
+				txr.m_baseLevel = copy.level;
+				txr.m_ready = true;
+			}
+		}
+		glBindTexture(GL_TEXTURE_2D, GL_NONE);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+		m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		complete();
+	}
+
+	void GLTextureLoader::complete(void)
+	{
+		for(auto iter = m_uploads.begin(); iter != m_uploads.end();)
+		{
+			Image &image = **iter;
+			if(!image.allocated || image.uploaded > image.firstLevel){ ++iter; continue; }
+
+			// Replace the previously resident levels
+			auto pTexture = image.pTexture.lock();
+			if(image.textureID)
+			{
+				pTexture->replaceID(image.textureID);
+			}
+			pTexture->m_levelCount = image.levelCount;
+			pTexture->m_baseLevel = image.firstLevel;
+			pTexture->setByteSize(EGLMemory::TEXTURE, GLTexture::getStorageSize(image.format, pTexture->getWidth(), pTexture->getHeight(),
+				image.firstLevel, image.levelCount - image.firstLevel));
+			pTexture->m_ready = true;
+			pTexture->m_loading = false;
+			cout << "Loaded texture data from: " << image.filename << " (" << pTexture->getWidth() << "x"
+				 << pTexture->getHeight() << " from level " << image.firstLevel << ", texture " << pTexture->getID() << ")" << endl;
+
+			iter = m_uploads.erase(iter);
+			--m_pending;
+		}
+	}
+
+	GLTextureLoader::~GLTextureLoader(void)
+	{
+		for(GLsync fence : m_fences)
+		{
+			if(fence) glDeleteSync(fence);
+		}
+		glDeleteBuffers(FRAMES, m_buffers);
+		for(GLsizeiptr size : m_bufferSizes) GLMemoryCounter::release(EGLMemory::STAGING, size);
+	}
+}
@@ -0,0 +1,332 @@
+/*****************************************************************
+ * GLTextureLoader.h
+ *****************************************************************
+ * Created on: 13.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_GLTEXTURELOADER_H_
+#define GRAPHICS_GLTEXTURELOADER_H_
+
+#include <deque>
+#include "../core/ThreadPool.h"
+#include "../core/AssetPack.h"
+#include "TextureContainer.h"
+#include "GLTexture.h"
+
+namespace fuel
+{
+	/**
+	 * How the mipmap chain of a decoded (not cooked) texture is built.
+	 */
+	enum class EMipmapMode : uint8_t
+	{
+		// 2x2 box filter on the stored values
+		BOX,
+
+		// 2x2 box filter in linear space, for sRGB encoded color textures
+		BOX_LINEAR,
+
+		// glGenerateMipmap after uploading level 0
+		GPU
+	};
+
+	/**
+	 * Loads textures in the background.
+	 * Files are opened through AssetPack, so packed textures are read straight out of the pack.
+	 * Cooked texture containers (.ftx) are memory mapped and uploaded as stored.
+	 * Other image files are read, decoded, flipped and mipmapped on worker threads. The render
+	 * thread uploads the finished levels through a ring of pixel unpack buffers,
+	 * at most a fixed number of bytes per frame, so loading never causes a frame
+	 * to stall. Textures are handed out immediately and show a placeholder until
+	 * their coarsest level is uploaded. Levels are uploaded coarsest first, the
+	 * texture's base level follows the finest level uploaded so far.
+	 * Reloads copy the levels still resident on the GPU rather than uploading them.
+	 */
+	class GLTextureLoader
+	{
+	private:
+		// Number of frames the CPU may run ahead of the GPU
+		static const unsigned FRAMES = 3;
+
+		// Single mipmap level of a decoded image
+		struct Level
+		{
+			uint16_t width, height;
+
+			// Texel data in the image's format, within storage or the container file
+			const uint8_t *pData;
+			size_t size;
+		};
+
+		// Decoded image waiting for upload
+		struct Image
+		{
+			// Texture to upload into, dropped if it is deleted meanwhile
+			std::weak_ptr<GLTexture> pTexture;
+
+			// Source file name
+			std::string filename;
+
+			// OpenGL internal format (GL_RGBA8 or a compressed format)
+			GLenum format;
+
+			// Levels to upload, empty if decoding failed
+			std::vector<Level> levels;
+
+			// Levels of the complete image, more than decoded if the GPU builds the rest
+			GLsizei levelCount;
+
+			// First level to make resident, coarser than 0 when (re)loading an evicted texture
+			unsigned firstLevel;
+
+			// Largest dimension of the first level to make resident, 0 for no limit
+			uint16_t maxSize;
+
+			// Texture object receiving the levels, replaces the texture's current one on completion
+			GLuint textureID;
+
+			// Build the levels after the uploaded ones with glGenerateMipmap
+			bool generateMipmaps;
+
+			// Decoded texels of all levels
+			std::vector<uint8_t> storage;
+
+			// Content of a cooked texture container, mapped or within an asset pack
+			AssetData file;
+
+			// Reason for a failed decode
+			std::string error;
+
+			// Finest level held by the storage so far (uploaded or copied), levels.size() if none
+			unsigned uploaded;
+
+			// Whether the storage was allocated
+			bool allocated;
+		};
+
+		// Bytes to upload per frame at most, one level is always uploaded
+		GLsizeiptr m_budget;
+
+		// Staging buffers, one per frame in flight
+		GLuint m_buffers[FRAMES];
+
+		// Allocated size of each staging buffer
+		GLsizeiptr m_bufferSizes[FRAMES];
+
+		// Fences signaled once the GPU finished reading a staging buffer
+		GLsync m_fences[FRAMES];
+
+		// Staging buffer used this frame
+		unsigned m_frame;
+
+		// Textures requested but not completely uploaded yet
+		unsigned m_pending;
+
+		// Images decoded by the workers, guarded by m_mutex
+		std::deque<std::shared_ptr<Image>> m_decoded;
+
+		// Guards m_decoded
+		std::mutex m_mutex;
+
+		// Images being uploaded, oldest first (render thread only)
+		std::deque<std::shared_ptr<Image>> m_uploads;
+
+		// Decoding threads, declared last so they are joined first
+		ThreadPool m_workers;
+
+		/**
+		 * Queues a texture for (re)loading on the workers.
+		 *
+		 * @param pTexture
+		 * 		Texture to fill in.
+		 *
+		 * @param filename
+		 * 		File to load the texture from.
+		 *
+		 * @param mode
+		 * 		How to build the mipmap chain.
+		 *
+		 * @param firstLevel
+		 * 		First level of the complete image to make resident.
+		 *
+		 * @param maxSize
+		 * 		Largest dimension of the first level to make resident, 0 for no limit.
+		 */
+		void request(const std::shared_ptr<GLTexture> &pTexture, const std::string &filename, EMipmapMode mode, unsigned firstLevel, uint16_t maxSize);
+
+		/**
+		 * Moves the first level of an image to its size limit and clamps it to the image's levels.
+		 *
+		 * @param image
+		 * 		Image with its level count set.
+		 *
+		 * @param width
+		 * 		Width of level 0 in pixels.
+		 *
+		 * @param height
+		 * 		Height of level 0 in pixels.
+		 */
+		static void clampFirstLevel(Image &image, unsigned width, unsigned height);
+
+		/**
+		 * Decodes an image file into a flipped RGBA8 mipmap chain.
+		 * Runs on a worker thread.
+		 *
+		 * @param image
+		 * 		Image to fill in, the file name is set already.
+		 *
+		 * @param mode
+		 * 		How to build the mipmap chain.
+		 */
+		static void decode(Image &image, EMipmapMode mode);
+
+		/**
+		 * Maps a cooked texture container and validates its level table.
+		 * Runs on a worker thread.
+		 *
+		 * @param image
+		 * 		Image to fill in, the file name is set already.
+		 */
+		static void map(Image &image);
+
+		/**
+		 * Allocates storage for a range of mipmap levels and sets the sampling parameters.
+		 * Leaves the texture object bound to GL_TEXTURE_2D.
+		 *
+		 * @param textureID
+		 * 		Texture object without storage.
+		 *
+		 * @param format
+		 * 		OpenGL internal format.
+		 *
+		 * @param width
+		 * 		Width of level 0 of the complete image.
+		 *
+		 * @param height
+		 * 		Height of level 0 of the complete image.
+		 *
+		 * @param firstLevel
+		 * 		Level of the complete image stored as the storage's level 0.
+		 *
+		 * @param levelCount
+		 * 		Levels of the complete image.
+		 */
+		static void createStorage(GLuint textureID, GLenum format, uint16_t width, uint16_t height, unsigned firstLevel, unsigned levelCount);
+
+		/**
+		 * Copies resident levels of a texture into another texture object on the GPU.
+		 * Requires ARB_copy_image.
+		 *
+		 * @param txr
+		 * 		Source texture.
+		 *
+		 * @param textureID
+		 * 		Destination texture object, created by createStorage().
+		 *
+		 * @param firstLevel
+		 * 		Level of the complete image stored as the destination's level 0.
+		 *
+		 * @param fromLevel
+		 * 		First level to copy, resident in both textures.
+		 */
+		static void copyLevels(const GLTexture &txr, GLuint textureID, unsigned firstLevel, unsigned fromLevel);
+
+		/**
+		 * Allocates the texture storage for the resident levels of a decoded image.
+		 * Textures holding storage already get a new texture object,
+		 * which replaces the current one once all levels are uploaded.
+		 * Levels the texture holds already are copied and skipped by the upload.
+		 *
+		 * @param txr
+		 * 		Texture to allocate.
+		 *
+		 * @param image
+		 * 		Decoded image, receives the texture object.
+		 */
+		static void allocate(GLTexture &txr, Image &image);
+
+		/**
+		 * Hands the completely uploaded images over to their textures.
+		 */
+		void complete(void);
+
+	public:
+		/**
+		 * Instantiates a new texture loader.
+		 *
+		 * @param uploadBudget
+		 * 		Bytes to upload per frame at most.
+		 *
+		 * @param threads
+		 * 		Number of decoding threads. 0 to choose by hardware.
+		 */
+		GLTextureLoader(size_t uploadBudget, unsigned threads = 0);
+
+		/**
+		 * Returns the number of textures still loading.
+		 *
+		 * @return Pending texture count.
+		 */
+		inline unsigned getPendingCount(void) const { return m_pending; }
+
+		/**
+		 * Starts loading a texture from a file.
+		 *
+		 * @param filename
+		 * 		File to load the texture from.
+		 *
+		 * @param mode
+		 * 		How to build the mipmap chain, cooked containers bring their own.
+		 *
+		 * @param maxSize
+		 * 		Largest dimension of the first level to make resident, 0 to load all levels.
+		 * 		Finer levels are left to reload(), e.g. once the texture is drawn.
+		 *
+		 * @return The texture, incomplete until enough update() calls uploaded it.
+		 */
+		std::shared_ptr<GLTexture> load(const std::string &filename, EMipmapMode mode = EMipmapMode::BOX, uint16_t maxSize = 0);
+
+		/**
+		 * Starts reloading a texture with a different set of resident levels.
+		 * The current texel data stays in use until the new levels are uploaded.
+		 * Dropping levels completes immediately if ARB_copy_image is available.
+		 *
+		 * @param pTexture
+		 * 		Texture previously returned by load().
+		 *
+		 * @param filename
+		 * 		File the texture was loaded from.
+		 *
+		 * @param mode
+		 * 		How to build the mipmap chain, as passed to load().
+		 *
+		 * @param firstLevel
+		 * 		Finest level of the complete image to make resident,
+		 * 		coarser levels to save memory, finer ones to restore detail.
+		 */
+		void reload(const std::shared_ptr<GLTexture> &pTexture, const std::string &filename, EMipmapMode mode, unsigned firstLevel);
+
+		/**
+		 * Releases the storage of a texture, which shows the placeholder until reloaded.
+		 *
+		 * @param txr
+		 * 		Texture previously returned by load(), not loading.
+		 */
+		void unload(GLTexture &txr);
+
+		/**
+		 * Uploads decoded levels within the per-frame budget.
+		 * Intended to be called once per frame.
+		 */
+		void update(void);
+
+		/**
+		 * Stops the workers and releases the staging buffers.
+		 */
+		~GLTextureLoader(void);
+	};
+}
+
+#endif // GRAPHICS_GLTEXTURELOADER_H_
@@ -0,0 +1,78 @@
+/*****************************************************************
+ * GLTexturePool.cpp
+ *****************************************************************
+ * Created on: 04.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include "GLTexturePool.h"
+
+namespace fuel
+{
+	GLTexturePool::GLTexturePool(size_t idleBudget)
+		:m_idleBytes(0), m_idleBudget(idleBudget)
+	{
+		;;
+	}
+
+	GLTexture *GLTexturePool::acquire(GLenum format, uint16_t width, uint16_t height, GLenum colorFormat, GLenum datatype, uint8_t samples)
+	{
+		Bucket bucket(format, width, height, samples);
+		auto iter = m_idle.find(bucket);
+
+		// Reuse the most recently released texture of this bucket
+		if(iter != m_idle.end() && !iter->second.empty())
+		{
+			GLTexture *pTexture = iter->second.back().release();
+			iter->second.pop_back();
+
+			for(auto order = m_releaseOrder.rbegin(); order != m_releaseOrder.rend(); ++order)
+			{
+				if(*order == bucket){ m_releaseOrder.erase(std::next(order).base()); break; }
+			}
+
+			m_idleBytes -= pTexture->getByteSize();
+			return pTexture;
+		}
+
+		// Allocate new immutable storage
+		GLTexture *pTexture = new GLTexture(format, width, height, colorFormat, datatype, samples);
+
+		// Multisampled textures have no sampler state
+		if(samples > 1) return pTexture;
+
+		GLTexture::bind(0, *pTexture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		GLTexture::unbind(0);
+		return pTexture;
+	}
+
+	void GLTexturePool::release(GLTexture *pTexture, bool trimIdle)
+	{
+		if(pTexture == nullptr) return;
+
+		Bucket bucket(pTexture->getFormat(), pTexture->getWidth(), pTexture->getHeight(), pTexture->getSamples());
+		m_idle[bucket].emplace_back(pTexture);
+		m_releaseOrder.push_back(bucket);
+		m_idleBytes += pTexture->getByteSize();
+
+		if(trimIdle) trim(m_idleBudget);
+	}
+
+	void GLTexturePool::trim(size_t idleBudget)
+	{
+		while(m_idleBytes > idleBudget && !m_releaseOrder.empty())
+		{
+			// The oldest texture of a bucket is always stored first
+			auto &textures = m_idle[m_releaseOrder.front()];
+			m_releaseOrder.pop_front();
+
+			m_idleBytes -= textures.front()->getByteSize();
+			textures.erase(textures.begin());
+		}
+	}
+}
@@ -0,0 +1,131 @@
+/*****************************************************************
+ * GLTexturePool.h
+ *****************************************************************
+ * Created on: 04.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_GLTEXTUREPOOL_H_
+#define GRAPHICS_GLTEXTUREPOOL_H_
+
+#include <map>
+#include <list>
+#include <tuple>
+#include "../core/Util.h"
+#include "GLTexture.h"
+
+namespace fuel
+{
+	/**
+	 * Pool of immutable render target textures.
+	 * Textures are bucketed by format, size and sample count. Releasing a texture
+	 * keeps it around, so that switching back and forth between
+	 * resolutions does not allocate driver memory again.
+	 */
+	class GLTexturePool
+	{
+	private:
+		// Bucket key (format, width, height, samples)
+		typedef std::tuple<GLenum, uint16_t, uint16_t, uint8_t> Bucket;
+
+		// Idle textures per bucket, most recently released last
+		std::map<Bucket, std::vector<std::unique_ptr<GLTexture>>> m_idle;
+
+		// Release order of idle textures, oldest first
+		std::list<Bucket> m_releaseOrder;
+
+		// Total size of idle textures in bytes
+		size_t m_idleBytes;
+
+		// Size of idle textures to keep around at most
+		size_t m_idleBudget;
+
+	public:
+		/**
+		 * Instantiates a new texture pool.
+		 *
+		 * @param idleBudget
+		 * 		Size of idle textures in bytes to keep around at most.
+		 */
+		GLTexturePool(size_t idleBudget);
+
+		/**
+		 * Returns the size of all idle textures.
+		 *
+		 * @return Size in bytes.
+		 */
+		inline size_t getIdleBytes(void) const { return m_idleBytes; }
+
+		/**
+		 * Hands out a texture with the given format and size.
+		 * An idle texture of the same bucket is reused if possible.
+		 * The caller owns the texture until it is released again.
+		 *
+		 * @param format
+		 * 		OpenGL internal format.
+		 *
+		 * @param width
+		 * 		Width in pixels.
+		 *
+		 * @param height
+		 * 		Height in pixels.
+		 *
+		 * @param colorFormat
+		 * 		OpenGL pixel value format. (only used without ARB_texture_storage)
+		 *
+		 * @param datatype
+		 * 		OpenGL pixel value datatype. (only used without ARB_texture_storage)
+		 *
+		 * @param samples
+		 * 		Number of samples per texel.
+		 *
+		 * @return The texture.
+		 */
+		GLTexture *acquire(GLenum format, uint16_t width, uint16_t height, GLenum colorFormat, GLenum datatype, uint8_t samples = 1);
+
+		/**
+		 * Returns the size of idle textures to keep around at most.
+		 *
+		 * @return Size in bytes.
+		 */
+		inline size_t getIdleBudget(void) const { return m_idleBudget; }
+
+		/**
+		 * Sets the size of idle textures to keep around at most, enforced on the next release.
+		 *
+		 * @param idleBudget
+		 * 		Size in bytes.
+		 */
+		inline void setIdleBudget(size_t idleBudget){ m_idleBudget = idleBudget; }
+
+		/**
+		 * Returns a texture to the pool.
+		 * Deletes the least recently released textures if the idle budget is exceeded.
+		 *
+		 * @param pTexture
+		 * 		Texture previously handed out by acquire().
+		 *
+		 * @param trimIdle
+		 * 		Whether to enforce the idle budget right away. Pass false when
+		 * 		replacing several textures, then call trim() once they are acquired.
+		 */
+		void release(GLTexture *pTexture, bool trimIdle = true);
+
+		/**
+		 * Deletes least recently released textures until the idle budget is met.
+		 *
+		 * @param idleBudget
+		 * 		Size of idle textures in bytes to keep around at most.
+		 */
+		void trim(size_t idleBudget);
+
+		/**
+		 * Deletes all idle textures.
+		 * Textures still handed out are not affected.
+		 */
+		~GLTexturePool(void) = default;
+	};
+}
+
+#endif // GRAPHICS_GLTEXTUREPOOL_H_
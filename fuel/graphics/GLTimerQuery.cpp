@@ -0,0 +1,80 @@
+/*****************************************************************
+ * GLTimerQuery.cpp
+ *****************************************************************
+ * Created on: 02.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include "GLTimerQuery.h"
+
+namespace fuel
+{
+	GLTimerQuery::GLTimerQuery(void)
+		:m_issued(0), m_retrieved(0), m_active(false)
+	{
+		glGenQueries(RING_SIZE, m_IDs);
+
+		if(m_IDs[0] == GL_NONE)
+		{
+			cerr << "Could not generate OpenGL timer queries." << endl;
+		}
+		else
+		{
+			cout << "Generated OpenGL timer queries: " << m_IDs[0] << " - " << m_IDs[RING_SIZE - 1] << endl;
+		}
+	}
+
+	void GLTimerQuery::begin(void)
+	{
+		if(m_active) return;
+
+		// Ring is full, forget about the oldest result
+		if(m_issued - m_retrieved == RING_SIZE) m_retrieved++;
+
+		glBeginQuery(GL_TIME_ELAPSED, m_IDs[m_issued % RING_SIZE]);
+		m_active = true;
+	}
+
+	void GLTimerQuery::end(void)
+	{
+		if(!m_active) return;
+
+		glEndQuery(GL_TIME_ELAPSED);
+		m_issued++;
+		m_active = false;
+	}
+
+	bool GLTimerQuery::poll(float &seconds)
+	{
+		bool received = false;
+
+		while(m_retrieved < m_issued)
+		{
+			GLuint id = m_IDs[m_retrieved % RING_SIZE];
+
+			// Stop at the first query the GPU has not finished yet
+			GLint available = GL_FALSE;
+			glGetQueryObjectiv(id, GL_QUERY_RESULT_AVAILABLE, &available);
+			if(available != GL_TRUE) break;
+
+			GLuint64 nanoseconds;
+			glGetQueryObjectui64v(id, GL_QUERY_RESULT, &nanoseconds);
+			seconds = static_cast<float>(nanoseconds * 1E-9);
+
+			m_retrieved++;
+			received = true;
+		}
+
+		return received;
+	}
+
+	GLTimerQuery::~GLTimerQuery(void)
+	{
+		if(m_IDs[0] != GL_NONE)
+		{
+			cout << "Deleting OpenGL timer queries: " << m_IDs[0] << " - " << m_IDs[RING_SIZE - 1] << endl;
+			glDeleteQueries(RING_SIZE, m_IDs);
+		}
+	}
+}
@@ -0,0 +1,73 @@
+/*****************************************************************
+ * GLTimerQuery.h
+ *****************************************************************
+ * Created on: 02.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_GLTIMERQUERY_H_
+#define GRAPHICS_GLTIMERQUERY_H_
+
+#include "GLWindow.h"
+
+namespace fuel
+{
+	/**
+	 * Wrapper class for a ring of OpenGL GL_TIME_ELAPSED queries.
+	 * Results are read back a few frames late so that polling never
+	 * stalls the CPU on the GPU.
+	 */
+	class GLTimerQuery
+	{
+	private:
+		// Number of queries that may be in flight at once
+		static const unsigned RING_SIZE = 4;
+
+		// OpenGL query IDs
+		GLuint m_IDs[RING_SIZE];
+
+		// Number of queries issued so far
+		unsigned m_issued;
+
+		// Number of query results read back or dropped so far
+		unsigned m_retrieved;
+
+		// Whether a query is currently between begin() and end()
+		bool m_active;
+
+	public:
+		/**
+		 * Instantiates a new timer query ring.
+		 */
+		GLTimerQuery(void);
+
+		/**
+		 * Starts measuring GPU time.
+		 * If all queries are still in flight the oldest result is dropped.
+		 */
+		void begin(void);
+
+		/**
+		 * Stops measuring GPU time.
+		 */
+		void end(void);
+
+		/**
+		 * Reads back all finished query results without blocking.
+		 *
+		 * @param seconds
+		 * 		Receives the most recent GPU time in seconds, if any.
+		 *
+		 * @return Whether a new result was available.
+		 */
+		bool poll(float &seconds);
+
+		/**
+		 * Deletes the OpenGL query objects.
+		 */
+		~GLTimerQuery(void);
+	};
+}
+
+#endif // GRAPHICS_GLTIMERQUERY_H_
@@ -0,0 +1,57 @@
+/*****************************************************************
+ * GLUniformBuffer.cpp
+ *****************************************************************
+ * Created on: 12.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include "GLUniformBuffer.h"
+
+namespace fuel
+{
+	using namespace std;
+
+	GLUniformBuffer::GLUniformBuffer(GLuint binding, GLsizeiptr size)
+		:m_ID(GL_NONE), m_binding(binding), m_size(size)
+	{
+		glGenBuffers(1, &m_ID);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+		glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, GL_NONE);
+		GLMemoryCounter::allocate(EGLMemory::UNIFORM, size);
+		cout << "Generated OpenGL uniform buffer: " << m_ID << " (" << size << " bytes, binding " << binding << ")" << endl;
+	}
+
+	void GLUniformBuffer::update(const void *pData, GLsizeiptr size, GLintptr offset)
+	{
+		if(GLEW_ARB_direct_state_access)
+		{
+			glNamedBufferSubData(m_ID, offset, size, pData);
+			GLCallCounter::count(EGLCall::BUFFER);
+		}
+		else
+		{
+			glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+			glBufferSubData(GL_UNIFORM_BUFFER, offset, size, pData);
+			GLCallCounter::count(EGLCall::BUFFER, 2);
+		}
+	}
+
+	void GLUniformBuffer::bind(void) const
+	{
+		glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_ID);
+		GLCallCounter::count(EGLCall::BUFFER);
+	}
+
+	GLUniformBuffer::~GLUniformBuffer(void)
+	{
+		if(m_ID != GL_NONE)
+		{
+			cout << "Deleting OpenGL uniform buffer: " << m_ID << endl;
+			glDeleteBuffers(1, &m_ID);
+			m_ID = GL_NONE;
+			GLMemoryCounter::release(EGLMemory::UNIFORM, m_size);
+		}
+	}
+}
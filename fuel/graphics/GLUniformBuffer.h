@@ -0,0 +1,88 @@
+/*****************************************************************
+ * GLUniformBuffer.h
+ *****************************************************************
+ * Created on: 12.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_GLUNIFORMBUFFER_H_
+#define GRAPHICS_GLUNIFORMBUFFER_H_
+
+#include "GLCalls.h"
+#include "GLCallCounter.h"
+#include "GLMemoryCounter.h"
+
+namespace fuel
+{
+	/**
+	 * Uniform buffer backing one uniform block, shared by all programs
+	 * through a fixed binding point.
+	 */
+	class GLUniformBuffer
+	{
+	private:
+		// OpenGL buffer ID
+		GLuint m_ID;
+
+		// Uniform buffer binding point
+		GLuint m_binding;
+
+		// Buffer size in bytes
+		GLsizeiptr m_size;
+
+	public:
+		/**
+		 * Instantiates a new uniform buffer.
+		 *
+		 * @param binding
+		 * 		Uniform buffer binding point.
+		 *
+		 * @param size
+		 * 		Buffer size in bytes.
+		 */
+		GLUniformBuffer(GLuint binding, GLsizeiptr size);
+
+		/**
+		 * Returns the OpenGL buffer ID.
+		 *
+		 * @return ID.
+		 */
+		inline GLuint getID(void) const { return m_ID; }
+
+		/**
+		 * Replaces part of the buffer content.
+		 *
+		 * @param pData
+		 * 		New content.
+		 *
+		 * @param size
+		 * 		Size of the content in bytes.
+		 *
+		 * @param offset
+		 * 		Offset into the buffer in bytes.
+		 */
+		void update(const void *pData, GLsizeiptr size, GLintptr offset = 0);
+
+		/**
+		 * Replaces the buffer content by a block structure.
+		 *
+		 * @param block
+		 * 		Block laid out according to std140.
+		 */
+		template<typename T>
+		inline void update(const T &block){ update(&block, sizeof(T)); }
+
+		/**
+		 * Binds the buffer to its binding point.
+		 */
+		void bind(void) const;
+
+		/**
+		 * Release OpenGL buffer.
+		 */
+		~GLUniformBuffer(void);
+	};
+}
+
+#endif // GRAPHICS_GLUNIFORMBUFFER_H_
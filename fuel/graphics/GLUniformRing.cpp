@@ -0,0 +1,112 @@
+/*****************************************************************
+ * GLUniformRing.cpp
+ *****************************************************************
+ * Created on: 12.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include <cstring>
+#include "GLUniformRing.h"
+
+namespace fuel
+{
+	using namespace std;
+
+	GLUniformRing::GLUniformRing(GLuint binding, GLsizeiptr blockSize, unsigned slots)
+		:m_ID(GL_NONE), m_binding(binding), m_blockSize(blockSize), m_slots(slots), m_frame(0), m_cursor(0), m_pMapped(nullptr)
+	{
+		for(GLsync &fence : m_fences) fence = nullptr;
+
+		GLint alignment = 256;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		m_stride = ((blockSize + alignment - 1) / alignment) * alignment;
+		GLsizeiptr size = m_stride * slots * FRAMES;
+
+		glGenBuffers(1, &m_ID);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+		if(GLEW_ARB_buffer_storage)
+		{
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+			m_pMapped = static_cast<uint8_t *>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags));
+		}
+		else
+		{
+			glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		}
+		glBindBuffer(GL_UNIFORM_BUFFER, GL_NONE);
+		GLMemoryCounter::allocate(EGLMemory::UNIFORM, size);
+
+		cout << "Generated OpenGL uniform ring buffer: " << m_ID << " (" << size << " bytes"
+			 << (m_pMapped ? ", persistently mapped" : "") << ")" << endl;
+	}
+
+	void GLUniformRing::beginFrame(void)
+	{
+		m_frame = (m_frame + 1) % FRAMES;
+		m_cursor = 0;
+
+		// The region was last used FRAMES frames ago, usually long finished
+		if(m_fences[m_frame])
+		{
+			glClientWaitSync(m_fences[m_frame], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(m_fences[m_frame]);
+			m_fences[m_frame] = nullptr;
+		}
+	}
+
+	void GLUniformRing::endFrame(void)
+	{
+		if(m_fences[m_frame]) glDeleteSync(m_fences[m_frame]);
+		m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	bool GLUniformRing::push(const void *pData)
+	{
+		if(m_cursor >= m_slots) return false;
+
+		GLintptr offset = (static_cast<GLintptr>(m_frame) * m_slots + m_cursor++) * m_stride;
+		if(m_pMapped)
+		{
+			memcpy(m_pMapped + offset, pData, m_blockSize);
+		}
+		else if(GLEW_ARB_direct_state_access)
+		{
+			glNamedBufferSubData(m_ID, offset, m_blockSize, pData);
+			GLCallCounter::count(EGLCall::BUFFER);
+		}
+		else
+		{
+			glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+			glBufferSubData(GL_UNIFORM_BUFFER, offset, m_blockSize, pData);
+			GLCallCounter::count(EGLCall::BUFFER, 2);
+		}
+
+		glBindBufferRange(GL_UNIFORM_BUFFER, m_binding, m_ID, offset, m_blockSize);
+		GLCallCounter::count(EGLCall::BUFFER);
+		return true;
+	}
+
+	GLUniformRing::~GLUniformRing(void)
+	{
+		for(GLsync fence : m_fences)
+		{
+			if(fence) glDeleteSync(fence);
+		}
+
+		if(m_ID != GL_NONE)
+		{
+			cout << "Deleting OpenGL uniform ring buffer: " << m_ID << endl;
+			if(m_pMapped)
+			{
+				glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+				glUnmapBuffer(GL_UNIFORM_BUFFER);
+				glBindBuffer(GL_UNIFORM_BUFFER, GL_NONE);
+			}
+			glDeleteBuffers(1, &m_ID);
+			m_ID = GL_NONE;
+			GLMemoryCounter::release(EGLMemory::UNIFORM, m_stride * m_slots * FRAMES);
+		}
+	}
+}
@@ -0,0 +1,112 @@
+/*****************************************************************
+ * GLUniformRing.h
+ *****************************************************************
+ * Created on: 12.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_GLUNIFORMRING_H_
+#define GRAPHICS_GLUNIFORMRING_H_
+
+#include "GLCalls.h"
+#include "GLCallCounter.h"
+#include "GLMemoryCounter.h"
+
+namespace fuel
+{
+	/**
+	 * Large uniform buffer holding one block instance per draw call.
+	 * Each draw writes its data into the next slot and binds that range, which
+	 * replaces several glUniform calls by one buffer binding. The buffer is split
+	 * into one region per frame in flight, guarded by fences, so writes never
+	 * stall on draws the GPU has not finished yet. With ARB_buffer_storage the
+	 * buffer stays persistently mapped and writes are plain memory copies.
+	 */
+	class GLUniformRing
+	{
+	private:
+		// Number of frames the CPU may run ahead of the GPU
+		static const unsigned FRAMES = 3;
+
+		// OpenGL buffer ID
+		GLuint m_ID;
+
+		// Uniform buffer binding point
+		GLuint m_binding;
+
+		// Size of one block instance in bytes
+		GLsizeiptr m_blockSize;
+
+		// Distance between slots in bytes, respecting the offset alignment
+		GLsizeiptr m_stride;
+
+		// Slots per frame region
+		unsigned m_slots;
+
+		// Frame region currently written
+		unsigned m_frame;
+
+		// Next free slot in the current region
+		unsigned m_cursor;
+
+		// Persistently mapped buffer memory, nullptr without ARB_buffer_storage
+		uint8_t *m_pMapped;
+
+		// Fences signaled once the GPU finished with a region
+		GLsync m_fences[FRAMES];
+
+	public:
+		/**
+		 * Instantiates a new uniform ring buffer.
+		 *
+		 * @param binding
+		 * 		Uniform buffer binding point.
+		 *
+		 * @param blockSize
+		 * 		Size of one block instance in bytes.
+		 *
+		 * @param slots
+		 * 		Maximum number of draws per frame.
+		 */
+		GLUniformRing(GLuint binding, GLsizeiptr blockSize, unsigned slots);
+
+		/**
+		 * Switches to the next frame region, waiting for the GPU if it still uses it.
+		 */
+		void beginFrame(void);
+
+		/**
+		 * Marks the end of the draws using the current frame region.
+		 */
+		void endFrame(void);
+
+		/**
+		 * Writes a block instance into the next slot and binds it for the next draw.
+		 *
+		 * @param pData
+		 * 		Block data of the size given on construction.
+		 *
+		 * @return False if all slots of this frame are used.
+		 */
+		bool push(const void *pData);
+
+		/**
+		 * Writes a block instance into the next slot and binds it for the next draw.
+		 *
+		 * @param block
+		 * 		Block laid out according to std140.
+		 *
+		 * @return False if all slots of this frame are used.
+		 */
+		template<typename T>
+		inline bool push(const T &block){ return push(static_cast<const void *>(&block)); }
+
+		/**
+		 * Release OpenGL buffer.
+		 */
+		~GLUniformRing(void);
+	};
+}
+
+#endif // GRAPHICS_GLUNIFORMRING_H_
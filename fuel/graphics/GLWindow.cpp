@@ -13,7 +13,10 @@ namespace fuel
 {
 	GLWindow::GLWindow(const GLWindowSettings &settings)
 		:m_pWindow(nullptr),
-		 m_pFullscreenQuadVAO(nullptr)
+		 m_pFullscreenQuadVAO(nullptr),
+		 m_framebufferWidth(settings.width),
+		 m_framebufferHeight(settings.height),
+		 m_resized(false)
 	{
 		// Try to initialize GLFW
 		if( glfwInit() != GL_TRUE )
@@ -23,7 +26,8 @@ namespace fuel
 
 		// Setup window properties
 		glfwWindowHint( GLFW_VISIBLE, 	GL_FALSE );
-		glfwWindowHint( GLFW_RESIZABLE, GL_FALSE );
+		glfwWindowHint( GLFW_RESIZABLE, settings.resizable ? GL_TRUE : GL_FALSE );
+		glfwWindowHint( GLFW_STENCIL_BITS, 8 );
 
 		// Create window
 		m_pWindow = glfwCreateWindow(
@@ -51,6 +55,21 @@ namespace fuel
 			);
 		}
 
+		// Track framebuffer size changes
+		int fbWidth, fbHeight;
+		glfwGetFramebufferSize(m_pWindow, &fbWidth, &fbHeight);
+		m_framebufferWidth = static_cast<uint16_t>(fbWidth);
+		m_framebufferHeight = static_cast<uint16_t>(fbHeight);
+
+		glfwSetWindowUserPointer(m_pWindow, this);
+		glfwSetFramebufferSizeCallback(m_pWindow, [](GLFWwindow *window, int width, int height)
+		{
+			GLWindow &self = *static_cast<GLWindow *>(glfwGetWindowUserPointer(window));
+			self.m_framebufferWidth = static_cast<uint16_t>(width);
+			self.m_framebufferHeight = static_cast<uint16_t>(height);
+			self.m_resized = true;
+		});
+
 		// Make the window visible
 		glfwShowWindow( m_pWindow );
 
@@ -78,7 +97,7 @@ namespace fuel
 		glClampColor(GL_CLAMP_VERTEX_COLOR, GL_FALSE);
 		glClampColor(GL_CLAMP_FRAGMENT_COLOR, GL_FALSE);
 
-		glViewport(0, 0, settings.width, settings.height);
+		glViewport(0, 0, m_framebufferWidth, m_framebufferHeight);
 
 		// Setup fullscreen quad VAO
 		m_pFullscreenQuadVAO = make_unique<GLVertexArray>(2);
@@ -149,6 +168,7 @@ namespace fuel
 	{
 		GLVertexArray::bind(vao);
 		glDrawArrays(primitive, 0, verts);
+		GLCallCounter::count(EGLCall::DRAW);
 	}
 
 	GLWindow::~GLWindow(void)
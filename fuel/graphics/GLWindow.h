@@ -11,6 +11,7 @@
 
 #include <iostream>
 #include "GLVertexArray.h"
+#include "GLCallCounter.h"
 #include "GLWindowSettings.h"
 
 namespace fuel
@@ -29,6 +30,15 @@ namespace fuel
 		// Fullscreen quad vertices
 		std::unique_ptr<GLVertexArray> m_pFullscreenQuadVAO;
 
+		// Framebuffer width in pixels
+		uint16_t m_framebufferWidth;
+
+		// Framebuffer height in pixels
+		uint16_t m_framebufferHeight;
+
+		// Whether the framebuffer was resized since the last call to wasResized()
+		bool m_resized;
+
 	public:
 		/**
 		 * Instantiates a new OpenGL window using the given settings.
@@ -66,6 +76,33 @@ namespace fuel
 		 */
 		uint16_t getHeight(void) const;
 
+		/**
+		 * Returns the width of the window's default framebuffer in pixels.
+		 *
+		 * @return Framebuffer width in pixels.
+		 */
+		inline uint16_t getFramebufferWidth(void) const { return m_framebufferWidth; }
+
+		/**
+		 * Returns the height of the window's default framebuffer in pixels.
+		 *
+		 * @return Framebuffer height in pixels.
+		 */
+		inline uint16_t getFramebufferHeight(void) const { return m_framebufferHeight; }
+
+		/**
+		 * Returns whether the framebuffer was resized since the last call
+		 * and resets the flag.
+		 *
+		 * @return Whether the framebuffer was resized.
+		 */
+		inline bool wasResized(void)
+		{
+			bool resized = m_resized;
+			m_resized = false;
+			return resized;
+		}
+
 		/**
 		 * Tells the window to close.
 		 */
@@ -95,6 +132,7 @@ namespace fuel
 			GLVertexArray::bind(vao);
 			GLBuffer::bind(ibo);
 			glDrawElements(primitive, ibo.getElementCount<INDEX_TYPE>(), glIndexType, nullptr);
+			GLCallCounter::count(EGLCall::DRAW);
 		}
 
 		/**
@@ -30,6 +30,9 @@ namespace fuel
 
 		//Window title
 		std::string title;
+
+		//Whether the user may resize the window
+		bool resizable;
 	};
 }
 
@@ -0,0 +1,128 @@
+/*****************************************************************
+ * TemporalAA.cpp
+ *****************************************************************
+ * Created on: 08.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include "TemporalAA.h"
+
+namespace fuel
+{
+	TemporalAA::TemporalAA(GLTexturePool &texturePool, uint16_t renderWidth, uint16_t renderHeight, uint16_t outputWidth, uint16_t outputHeight)
+		:m_colorFBO(texturePool, renderWidth, renderHeight),
+		 m_current(0),
+		 m_historyValid(false),
+		 m_frameIndex(0),
+		 m_jitter(0.0f, 0.0f)
+	{
+		// Lit image, written by the fullscreen passes
+		GLFramebuffer::bind(m_colorFBO);
+		m_colorFBO.attach("color", GL_RGBA16F);
+		m_colorFBO.setDrawAttachments({"color"});
+
+		// Ping-pong history buffers
+		for(auto &history : m_historyFBOs)
+		{
+			history = make_unique<GLFramebuffer>(texturePool, outputWidth, outputHeight);
+			GLFramebuffer::bind(*history);
+			history->attach("color", GL_RGBA16F);
+			history->setDrawAttachments({"color"});
+		}
+		GLFramebuffer::unbind();
+
+		m_resolveShader = make_unique<GLShaderProgram>();
+		m_resolveShader->setShader(EGLShaderType::VERTEX,   "res/glsl/fullscreen.vert");
+		m_resolveShader->setShader(EGLShaderType::FRAGMENT, "res/glsl/taa.frag");
+		m_resolveShader->bindVertexAttribute(0, "vPosition");
+		m_resolveShader->bindVertexAttribute(1, "vTexCoord");
+		m_resolveShader->link();
+		m_colorUnit           = m_resolveShader->getUniformHandle<GLint>("uColorUnit");
+		m_historyUnit         = m_resolveShader->getUniformHandle<GLint>("uHistoryUnit");
+		m_velocityUnit        = m_resolveShader->getUniformHandle<GLint>("uVelocityUnit");
+		m_depthUnit           = m_resolveShader->getUniformHandle<GLint>("uDepthUnit");
+		m_jitterUniform       = m_resolveShader->getUniformHandle<glm::vec2>("uJitter");
+		m_renderSize          = m_resolveShader->getUniformHandle<glm::vec2>("uRenderSize");
+		m_outputSize          = m_resolveShader->getUniformHandle<glm::vec2>("uOutputSize");
+		m_historyValidUniform = m_resolveShader->getUniformHandle<float>("uHistoryValid");
+	}
+
+	float TemporalAA::halton(unsigned index, unsigned base)
+	{
+		float result = 0.0f, fraction = 1.0f;
+		while(index > 0)
+		{
+			fraction /= base;
+			result += fraction * (index % base);
+			index /= base;
+		}
+		return result;
+	}
+
+	void TemporalAA::advanceJitter(void)
+	{
+		m_frameIndex = (m_frameIndex % JITTER_PHASES) + 1;
+		m_jitter = glm::vec2(halton(m_frameIndex, 2) - 0.5f, halton(m_frameIndex, 3) - 0.5f);
+	}
+
+	glm::mat4 TemporalAA::jitterProjection(const glm::mat4 &projection) const
+	{
+		// Shift in normalized device coordinates, one pixel spans 2 / size
+		glm::vec3 offset(2.0f * m_jitter.x / m_colorFBO.getWidth(), 2.0f * m_jitter.y / m_colorFBO.getHeight(), 0.0f);
+		return glm::translate(glm::mat4(), offset) * projection;
+	}
+
+	void TemporalAA::resize(uint16_t renderWidth, uint16_t renderHeight, uint16_t outputWidth, uint16_t outputHeight)
+	{
+		m_colorFBO.resize(renderWidth, renderHeight);
+
+		if(outputWidth != m_historyFBOs[0]->getWidth() || outputHeight != m_historyFBOs[0]->getHeight())
+		{
+			for(auto &history : m_historyFBOs)
+				history->resize(outputWidth, outputHeight);
+			invalidateHistory();
+		}
+	}
+
+	void TemporalAA::resolve(GLWindow &window, const GLFramebuffer &gbuffer)
+	{
+		GLFramebuffer &history = *m_historyFBOs[m_current];
+		const GLFramebuffer &previous = *m_historyFBOs[1 - m_current];
+
+		// G-buffer occupies units 0..N-1, the lit image and previous history follow
+		GLint colorUnit = gbuffer.getAttachmentCount();
+		GLint historyUnit = colorUnit + 1;
+		GLFramebuffer::bind(gbuffer, GLFramebuffer::READ);
+		GLTexture::bind(colorUnit, *m_colorFBO.getAttachment("color").pTexture);
+		GLTexture::bind(historyUnit, *previous.getAttachment("color").pTexture);
+
+		GLFramebuffer::bind(history, GLFramebuffer::DRAW);
+		glViewport(0, 0, history.getWidth(), history.getHeight());
+		glDisable(GL_BLEND);
+
+		m_resolveShader->use();
+		m_colorUnit.set(colorUnit);
+		m_historyUnit.set(historyUnit);
+		m_velocityUnit.set(static_cast<GLint>(gbuffer.getAttachment("velocity").textureUnit));
+		m_depthUnit.set(static_cast<GLint>(gbuffer.getAttachment("depth").textureUnit));
+		m_jitterUniform.set(m_jitter);
+		m_renderSize.set(glm::vec2(m_colorFBO.getWidth(), m_colorFBO.getHeight()));
+		m_outputSize.set(glm::vec2(history.getWidth(), history.getHeight()));
+		m_historyValidUniform.set(m_historyValid ? 1.0f : 0.0f);
+		window.renderFullscreenQuad();
+
+		// Present the new history
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, history.getID());
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		GLFramebuffer::unbind();
+		glBlitFramebuffer(
+			0, 0, history.getWidth(), history.getHeight(),
+			0, 0, history.getWidth(), history.getHeight(),
+			GL_COLOR_BUFFER_BIT, GL_NEAREST
+		);
+
+		m_historyValid = true;
+		m_current = 1 - m_current;
+	}
+}
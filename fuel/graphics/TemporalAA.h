@@ -0,0 +1,168 @@
+/*****************************************************************
+ * TemporalAA.h
+ *****************************************************************
+ * Created on: 08.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_TEMPORALAA_H_
+#define GRAPHICS_TEMPORALAA_H_
+
+#include "GLFramebuffer.h"
+
+namespace fuel
+{
+	/**
+	 * Temporal anti-aliasing and upsampling resolve stage.
+	 * The fullscreen passes render the lit image into the color framebuffer
+	 * at render resolution using a sub-pixel jittered projection. The resolve
+	 * accumulates these samples into a history buffer at output resolution,
+	 * reprojecting it with the G-buffer's motion vectors and clamping it to
+	 * the current frame's neighbourhood to reject stale history.
+	 */
+	class TemporalAA
+	{
+	private:
+		// Number of jitter positions before the sequence repeats
+		static const unsigned JITTER_PHASES = 8;
+
+		// Lit image at render resolution
+		GLFramebuffer m_colorFBO;
+
+		// Accumulated images at output resolution (current and previous)
+		unique_ptr<GLFramebuffer> m_historyFBOs[2];
+
+		// Shader resolving color and history into the new history
+		unique_ptr<GLShaderProgram> m_resolveShader;
+
+		// Uniforms of the resolve shader
+		GLUniformHandle<GLint> m_colorUnit, m_historyUnit, m_velocityUnit, m_depthUnit;
+		GLUniformHandle<glm::vec2> m_jitterUniform, m_renderSize, m_outputSize;
+		GLUniformHandle<float> m_historyValidUniform;
+
+		// Index of the history framebuffer written this frame
+		uint8_t m_current;
+
+		// Whether the previous history buffer holds usable content
+		bool m_historyValid;
+
+		// Frames rendered so far, selects the jitter position
+		unsigned m_frameIndex;
+
+		// Jitter offset of the current frame in render pixels
+		glm::vec2 m_jitter;
+
+		/**
+		 * Returns an element of the Halton low discrepancy sequence.
+		 *
+		 * @param index
+		 * 		Element index, starting at 1.
+		 *
+		 * @param base
+		 * 		Sequence base.
+		 *
+		 * @return Value in [0, 1).
+		 */
+		static float halton(unsigned index, unsigned base);
+
+	public:
+		/**
+		 * Instantiates a new temporal resolve stage.
+		 *
+		 * @param texturePool
+		 * 		Pool to take render targets from.
+		 *
+		 * @param renderWidth
+		 * 		Width of the G-buffer and lit image.
+		 *
+		 * @param renderHeight
+		 * 		Height of the G-buffer and lit image.
+		 *
+		 * @param outputWidth
+		 * 		Width of the resolved image.
+		 *
+		 * @param outputHeight
+		 * 		Height of the resolved image.
+		 */
+		TemporalAA(GLTexturePool &texturePool, uint16_t renderWidth, uint16_t renderHeight, uint16_t outputWidth, uint16_t outputHeight);
+
+		/**
+		 * Returns the framebuffer the fullscreen passes have to render into.
+		 *
+		 * @return Color framebuffer at render resolution.
+		 */
+		inline GLFramebuffer &getColorFramebuffer(void){ return m_colorFBO; }
+
+		/**
+		 * Returns the size of the color and history render targets.
+		 *
+		 * @return Size in bytes.
+		 */
+		inline size_t getByteSize(void) const
+		{
+			return m_colorFBO.getByteSize() + m_historyFBOs[0]->getByteSize() + m_historyFBOs[1]->getByteSize();
+		}
+
+		/**
+		 * Returns the jitter offset of the current frame.
+		 *
+		 * @return Offset in render pixels, within [-0.5, 0.5).
+		 */
+		inline const glm::vec2 &getJitter(void) const { return m_jitter; }
+
+		/**
+		 * Advances to the next jitter position.
+		 * Must be called once per frame before geometry is rendered.
+		 */
+		void advanceJitter(void);
+
+		/**
+		 * Applies the current jitter offset to a projection matrix.
+		 *
+		 * @param projection
+		 * 		Unjittered projection matrix.
+		 *
+		 * @return Projection shifted by the jitter offset in screen space.
+		 */
+		glm::mat4 jitterProjection(const glm::mat4 &projection) const;
+
+		/**
+		 * Resizes the render and output targets.
+		 * The history is discarded if the output size changes.
+		 *
+		 * @param renderWidth
+		 * 		Width of the G-buffer and lit image.
+		 *
+		 * @param renderHeight
+		 * 		Height of the G-buffer and lit image.
+		 *
+		 * @param outputWidth
+		 * 		Width of the resolved image.
+		 *
+		 * @param outputHeight
+		 * 		Height of the resolved image.
+		 */
+		void resize(uint16_t renderWidth, uint16_t renderHeight, uint16_t outputWidth, uint16_t outputHeight);
+
+		/**
+		 * Forgets the accumulated history, e.g. after a camera cut.
+		 */
+		inline void invalidateHistory(void){ m_historyValid = false; }
+
+		/**
+		 * Resolves the lit image into the history buffer and copies the result
+		 * to the default framebuffer. Leaves the default framebuffer bound for
+		 * drawing with a viewport covering the output and blending disabled.
+		 *
+		 * @param window
+		 * 		Window reference.
+		 *
+		 * @param gbuffer
+		 * 		G-buffer holding "velocity" and "depth" attachments.
+		 */
+		void resolve(GLWindow &window, const GLFramebuffer &gbuffer);
+	};
+}
+
+#endif // GRAPHICS_TEMPORALAA_H_
@@ -0,0 +1,64 @@
+/*****************************************************************
+ * TextureContainer.h
+ *****************************************************************
+ * Created on: 14.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_TEXTURECONTAINER_H_
+#define GRAPHICS_TEXTURECONTAINER_H_
+
+#include <cstdint>
+
+namespace fuel
+{
+	/**
+	 * Layout of cooked texture files (.ftx), written by tools/texcook.
+	 * A file starts with the header, followed by one level table entry per
+	 * mipmap level, largest first. Each level's data is stored exactly as the
+	 * GPU expects it and starts at a multiple of ALIGNMENT,
+	 * so the runtime uploads straight out of a memory mapping of the file.
+	 * Rows are stored bottom first, as OpenGL expects them.
+	 */
+	namespace TextureContainer
+	{
+		// File identifier "FTX1"
+		const uint32_t MAGIC = 0x31585446;
+
+		// Alignment of level data in bytes
+		const uint32_t ALIGNMENT = 64;
+
+		// Texel data formats
+		enum EFormat : uint32_t
+		{
+			RGBA8 = 0,	// Uncompressed, 4 bytes per texel
+			BC1   = 1,	// S3TC DXT1, 8 bytes per 4x4 block, no alpha
+			BC3   = 2,	// S3TC DXT5, 16 bytes per 4x4 block
+			BC7   = 3	// BPTC, 16 bytes per 4x4 block (needs ARB_texture_compression_bptc)
+		};
+
+		// File header
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t format;
+			uint32_t width, height;
+			uint32_t levels;
+			uint32_t padding;
+		};
+
+		// Level table entry
+		struct Level
+		{
+			uint64_t offset;
+			uint64_t size;
+			uint32_t width, height;
+		};
+
+		static_assert(sizeof(Header) == 24, "Texture container header must be packed");
+		static_assert(sizeof(Level) == 24, "Texture container level entry must be packed");
+	}
+}
+
+#endif // GRAPHICS_TEXTURECONTAINER_H_
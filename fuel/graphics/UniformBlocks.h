@@ -0,0 +1,109 @@
+/*****************************************************************
+ * UniformBlocks.h
+ *****************************************************************
+ * Created on: 12.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_UNIFORMBLOCKS_H_
+#define GRAPHICS_UNIFORMBLOCKS_H_
+
+#include "GLCalls.h"
+
+namespace fuel
+{
+	/**
+	 * Uniform buffer binding points of the engine's uniform blocks.
+	 * Shaders declare the blocks by including res/glsl/include/blocks.glsl.
+	 */
+	enum EUniformBlockBinding : GLuint
+	{
+		CAMERA_BLOCK = 0,//!< CAMERA_BLOCK
+		FRAME_BLOCK  = 1,//!< FRAME_BLOCK
+		LIGHT_BLOCK  = 2,//!< LIGHT_BLOCK
+		OBJECT_BLOCK = 3 //!< OBJECT_BLOCK
+	};
+
+	/**
+	 * Shader storage buffer binding points of the engine's storage blocks.
+	 * Shaders declare them with explicit bindings, see res/glsl/include/materials.glsl.
+	 */
+	enum EStorageBlockBinding : GLuint
+	{
+		MATERIAL_BLOCK = 0 //!< MATERIAL_BLOCK
+	};
+
+	// Number of point lights the light block holds
+	constexpr unsigned MAX_POINT_LIGHTS = 64;
+
+	/**
+	 * Camera matrices, updated once per frame. (std140)
+	 */
+	struct CameraBlock
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::mat4 viewProjection;
+		glm::mat4 previousViewProjection;
+		glm::vec4 position;
+	};
+
+	/**
+	 * Frame constants, updated once per frame. (std140)
+	 */
+	struct FrameBlock
+	{
+		// Width, height and their reciprocals
+		glm::vec4 renderSize;
+		glm::vec4 outputSize;
+
+		// Sub-pixel jitter in render pixels
+		glm::vec2 jitter;
+
+		// Seconds since startup
+		float time;
+		float padding;
+	};
+
+	/**
+	 * Point light as stored in the light block. (std140)
+	 */
+	struct PointLightData
+	{
+		// Position and radius
+		glm::vec4 positionRadius;
+
+		// Color, alpha unused
+		glm::vec4 color;
+
+		// Linear and quadratic attenuation, zw unused
+		glm::vec4 attenuation;
+	};
+
+	/**
+	 * Scene lights, updated when the lights change. (std140)
+	 */
+	struct LightBlock
+	{
+		// Number of point lights in x
+		glm::ivec4 count;
+		PointLightData pointLights[MAX_POINT_LIGHTS];
+	};
+
+	/**
+	 * Per-object data, one instance per draw. (std140)
+	 */
+	struct ObjectBlock
+	{
+		glm::mat4 world;
+		glm::mat4 previousWorld;
+	};
+
+	static_assert(sizeof(CameraBlock) == 272, "CameraBlock does not match std140 layout");
+	static_assert(sizeof(FrameBlock) == 48, "FrameBlock does not match std140 layout");
+	static_assert(sizeof(LightBlock) == 16 + 48 * MAX_POINT_LIGHTS, "LightBlock does not match std140 layout");
+	static_assert(sizeof(ObjectBlock) == 128, "ObjectBlock does not match std140 layout");
+}
+
+#endif // GRAPHICS_UNIFORMBLOCKS_H_
@@ -0,0 +1,132 @@
+/*****************************************************************
+ * GLProgramCache.cpp
+ *****************************************************************
+ * Created on: 09.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include "GLProgramCache.h"
+
+namespace fuel
+{
+	const string GLProgramCache::DIRECTORY = "cache/glsl/";
+
+	unsigned GLProgramCache::s_hits = 0;
+	unsigned GLProgramCache::s_misses = 0;
+	double GLProgramCache::s_linkTime = 0.0;
+	double GLProgramCache::s_firstSubmitTime = -1.0;
+	double GLProgramCache::s_lastReadyTime = 0.0;
+
+	string GLProgramCache::getFilename(uint64_t key)
+	{
+		stringstream filename;
+		filename << DIRECTORY << hex << setw(16) << setfill('0') << key << ".bin";
+		return filename.str();
+	}
+
+	bool GLProgramCache::isSupported(void)
+	{
+		if(!GLEW_ARB_get_program_binary) return false;
+
+		// Some drivers expose the extension without any binary format
+		GLint formatCount = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+		return formatCount > 0;
+	}
+
+	uint64_t GLProgramCache::hashDriver(uint64_t hash)
+	{
+		for(GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+		{
+			const char *value = reinterpret_cast<const char *>(glGetString(name));
+			if(value != nullptr) hash = hashFNV1a(value, strlen(value), hash);
+		}
+		return hash;
+	}
+
+	bool GLProgramCache::load(GLuint program, uint64_t key)
+	{
+		if(!isSupported()) return false;
+
+		string filename = getFilename(key);
+		ifstream file(filename, ios::binary);
+		if(!file.good()) return false;
+
+		Header header;
+		file.read(reinterpret_cast<char *>(&header), sizeof(header));
+		if(!file.good() || header.magic != MAGIC || header.key != key) return false;
+
+		vector<char> binary(header.length);
+		file.read(binary.data(), header.length);
+		if(!file.good()) return false;
+		file.close();
+
+		glProgramBinary(program, header.format, binary.data(), header.length);
+
+		GLint linkStatus = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+		if(linkStatus != GL_TRUE)
+		{
+			cout << "Discarding stale program binary '" << filename << "'" << endl;
+			remove(filename.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	void GLProgramCache::store(GLuint program, uint64_t key)
+	{
+		if(!isSupported()) return;
+
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if(length <= 0) return;
+
+		Header header;
+		header.magic = MAGIC;
+		header.key = key;
+		vector<char> binary(length);
+		GLsizei written = 0;
+		GLenum format = GL_NONE;
+		glGetProgramBinary(program, length, &written, &format, binary.data());
+		header.format = format;
+		header.length = written;
+
+		createDirectory("cache");
+		createDirectory(DIRECTORY);
+
+		string filename = getFilename(key);
+		ofstream file(filename, ios::binary | ios::trunc);
+		file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		file.write(binary.data(), written);
+		if(!file.good())
+		{
+			cerr << "Could not write program binary '" << filename << "'" << endl;
+			file.close();
+			remove(filename.c_str());
+		}
+	}
+
+	void GLProgramCache::record(bool hit, double seconds)
+	{
+		(hit ? s_hits : s_misses)++;
+		s_linkTime += seconds;
+
+		double now = glfwGetTime();
+		if(s_firstSubmitTime < 0.0 || now - seconds < s_firstSubmitTime) s_firstSubmitTime = now - seconds;
+		s_lastReadyTime = now;
+	}
+
+	void GLProgramCache::printStatistics(void)
+	{
+		double readyTime = (s_firstSubmitTime < 0.0) ? 0.0 : s_lastReadyTime - s_firstSubmitTime;
+		cout << "Shader programs: " << s_hits << " from binary cache, " << s_misses << " compiled, all ready after "
+			 << readyTime * 1000.0 << " ms (" << s_linkTime * 1000.0 << " ms summed over programs)." << endl;
+	}
+}
@@ -0,0 +1,124 @@
+/*****************************************************************
+ * GLProgramCache.h
+ *****************************************************************
+ * Created on: 09.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_SHADERS_GLPROGRAMCACHE_H_
+#define GRAPHICS_SHADERS_GLPROGRAMCACHE_H_
+
+#include "../../core/Util.h"
+#include "../GLWindow.h"
+
+namespace fuel
+{
+	/**
+	 * On-disk cache of linked shader program binaries (ARB_get_program_binary).
+	 * Binaries are keyed by a hash of everything the link result depends on,
+	 * including the driver's vendor, renderer and version strings, so a driver
+	 * update invalidates all entries. If a binary is missing or rejected by the
+	 * driver, the caller compiles from source as usual.
+	 */
+	class GLProgramCache
+	{
+	private:
+		// Directory the binaries are stored in
+		static const string DIRECTORY;
+
+		// Identifies cache files
+		static const uint32_t MAGIC = 0x42475046; // "FPGB"
+
+		// Header preceding the binary in each cache file
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t format;
+			uint32_t length;
+			uint64_t key;
+		};
+
+		// Number of programs restored from / missing in the cache
+		static unsigned s_hits, s_misses;
+
+		// Link times of all programs summed up in seconds, overlapping when compiled in parallel
+		static double s_linkTime;
+
+		// Time the first recorded program was submitted and the last one was ready at in seconds
+		static double s_firstSubmitTime, s_lastReadyTime;
+
+		/**
+		 * Returns the cache file of the given key.
+		 *
+		 * @param key
+		 * 		Cache key.
+		 *
+		 * @return File name.
+		 */
+		static string getFilename(uint64_t key);
+
+	public:
+		/**
+		 * Returns whether the driver can retrieve and load program binaries.
+		 *
+		 * @return Whether the cache is usable.
+		 */
+		static bool isSupported(void);
+
+		/**
+		 * Extends a hash by the current driver's identification strings.
+		 *
+		 * @param hash
+		 * 		Hash of the program inputs.
+		 *
+		 * @return Cache key.
+		 */
+		static uint64_t hashDriver(uint64_t hash);
+
+		/**
+		 * Tries to restore a program from its cached binary.
+		 * Stale binaries rejected by the driver are deleted.
+		 *
+		 * @param program
+		 * 		OpenGL program ID.
+		 *
+		 * @param key
+		 * 		Cache key.
+		 *
+		 * @return Whether the program is linked now.
+		 */
+		static bool load(GLuint program, uint64_t key);
+
+		/**
+		 * Stores the binary of a successfully linked program.
+		 * The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+		 *
+		 * @param program
+		 * 		OpenGL program ID.
+		 *
+		 * @param key
+		 * 		Cache key.
+		 */
+		static void store(GLuint program, uint64_t key);
+
+		/**
+		 * Records a program link for the startup statistics, once the program is ready.
+		 *
+		 * @param hit
+		 * 		Whether the program was restored from the cache.
+		 *
+		 * @param seconds
+		 * 		Time from submission until the program was ready.
+		 */
+		static void record(bool hit, double seconds);
+
+		/**
+		 * Prints the number of cached and compiled programs, the time from the first
+		 * submission until the last program was ready and the summed link times.
+		 */
+		static void printStatistics(void);
+	};
+}
+
+#endif // GRAPHICS_SHADERS_GLPROGRAMCACHE_H_
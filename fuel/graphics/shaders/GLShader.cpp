@@ -6,72 +6,93 @@
  *****************************************************************
  *****************************************************************/
 
-#include <fstream>
 #include "GLShader.h"
 #include "../../core/Util.h"
 
 namespace fuel
 {
-	GLShader::GLShader(EGLShaderType type, const string &filename)
-		:m_ID(GL_NONE), m_type(type)
+	GLShader::GLShader(EGLShaderType type, const string &filename, const GLShaderDefines &defines)
+		:m_ID(GL_NONE), m_type(type), m_filename(filename), m_hash(0), m_submitted(false), m_compiled(false), m_checked(false)
 	{
-		// Check if file exists
-		if(!fileExists(filename))
+		m_source = GLShaderPreprocessor::process(filename, defines, m_dependencies);
+
+		uint8_t typeValue = static_cast<uint8_t>(type);
+		m_hash = hashFNV1a(m_source, hashFNV1a(&typeValue, sizeof(typeValue)));
+	}
+
+	map<uint64_t, weak_ptr<GLShader>> &GLShader::getRegistry(void)
+	{
+		// Never destroyed, so shaders outliving static destruction can still unregister
+		static auto *pRegistry = new map<uint64_t, weak_ptr<GLShader>>();
+		return *pRegistry;
+	}
+
+	shared_ptr<GLShader> GLShader::acquire(EGLShaderType type, const string &filename, const GLShaderDefines &defines)
+	{
+		auto pShader = make_shared<GLShader>(type, filename, defines);
+		auto &registry = getRegistry();
+
+		// Same sourcecode already loaded
+		auto iter = registry.find(pShader->getHash());
+		if(iter != registry.end())
+		{
+			if(auto pShared = iter->second.lock()) return pShared;
+		}
+
+		registry[pShader->getHash()] = pShader;
+		return pShader;
+	}
+
+	void GLShader::submit(void)
+	{
+		if(m_submitted) return;
+		m_submitted = true;
+		if(m_source.empty()) return;
+
+		// Create shader
+		m_ID = glCreateShader(getShaderTypeConstant(m_type));
+		if(m_ID == GL_NONE)
 		{
-			cerr << "Shader source file '" << filename << "' does not exist." << endl;
+			cerr << "Could not create OpenGL shader." << endl;
+			return;
 		}
+		cout << "Created OpenGL shader: " << m_ID << endl;
+
+		// Start compilation
+		const char *sourceCString = m_source.c_str();
+		glShaderSource(m_ID, 1, &sourceCString, nullptr);
+		glCompileShader(m_ID);
+	}
+
+	bool GLShader::checkStatus(void)
+	{
+		if(m_checked || m_ID == GL_NONE) return m_compiled;
+		m_checked = true;
 
-		// File exists
-		else
+		// Check compilation
+		GLint compileResult;
+		glGetShaderiv(m_ID, GL_COMPILE_STATUS, &compileResult);
+		if(compileResult != GL_TRUE)
 		{
-			// Create shader
-			m_ID = glCreateShader(getShaderTypeConstant(type));
+			cerr << "Shader compilation of file '" << m_filename << "' failed." << endl;
 
-			if(m_ID == GL_NONE)
-			{
-				cerr << "Could not create OpenGL shader." << endl;
-			}
+			GLsizei logLength;
+			GLchar  log[1024];
+			glGetShaderInfoLog(	m_ID, sizeof(log), &logLength, log);
 
-			// Successfully created shader
-			else
+			cerr << "Shader info log: " << endl << log << endl;
+
+			// Messages refer to files by their #line source string number
+			for(size_t i = 1; i < m_dependencies.size(); ++i)
 			{
-				cout << "Created OpenGL shader: " << m_ID << endl;
-
-				// Load shader source
-				string line, source;
-				ifstream sourceStream(filename);
-				while(sourceStream.good() && !sourceStream.eof())
-				{
-					getline(sourceStream, line);
-					source.append(line + "\n");
-				}
-
-				// Compile shader
-				const char *sourceCString = source.c_str();
-				glShaderSource(m_ID, 1, &sourceCString, nullptr);
-				glCompileShader(m_ID);
-
-				// Check compilation
-				GLint compileResult;
-				glGetShaderiv(m_ID, GL_COMPILE_STATUS, &compileResult);
-				if(compileResult != GL_TRUE)
-				{
-					cerr << "Shader compilation of file '" << filename << "' failed." << endl;
-
-					GLsizei logLength;
-					GLchar  log[1024];
-					glGetShaderInfoLog(	m_ID, sizeof(log), &logLength, log);
-
-					cerr << "Shader info log: " << endl << log << endl;
-				}
-
-				// Compilation worked
-				else
-				{
-					cout << "Successfully compiled shader '" << filename << "'" << endl;
-				}
+				cerr << "Source string " << i << ": '" << m_dependencies[i] << "'" << endl;
 			}
+			return m_compiled = false;
 		}
+
+		// Compilation worked
+		cout << "Successfully compiled shader '" << m_filename << "'" << endl;
+		return m_compiled = true;
 	}
 
 	GLenum GLShader::getShaderTypeConstant(EGLShaderType type)
@@ -103,6 +124,10 @@ namespace fuel
 
 	GLShader::~GLShader(void)
 	{
+		auto &registry = getRegistry();
+		auto iter = registry.find(m_hash);
+		if(iter != registry.end() && iter->second.expired()) registry.erase(iter);
+
 		if(m_ID != GL_NONE)
 		{
 			cout << "Deleting OpenGL shader: " << m_ID << endl;
@@ -9,7 +9,9 @@
 #ifndef GRAPHICS_SHADERS_GLSHADER_H_
 #define GRAPHICS_SHADERS_GLSHADER_H_
 
+#include <map>
 #include "../GLWindow.h"
+#include "GLShaderPreprocessor.h"
 
 namespace fuel
 {
@@ -28,6 +30,8 @@ namespace fuel
 
 	/**
 	 * OpenGL shader wrapper class.
+	 * Shaders are shared by content: acquire() hands out the live instance
+	 * with the same type and sourcecode if there is one.
 	 */
 	class GLShader
 	{
@@ -38,22 +42,72 @@ namespace fuel
 		// Shader type
 		EGLShaderType m_type;
 
+		// Source file name
+		string m_filename;
+
+		// Preprocessed sourcecode
+		string m_source;
+
+		// Source file and all files it includes, in #line source string order
+		vector<string> m_dependencies;
+
+		// Hash of type and sourcecode
+		uint64_t m_hash;
+
+		// Whether submit() has been called
+		bool m_submitted;
+
+		// Compilation result, only valid once checkStatus() was called
+		bool m_compiled;
+
+		// Whether checkStatus() has been called
+		bool m_checked;
+
+		/**
+		 * Returns the live shaders by content hash.
+		 *
+		 * @return Shader registry.
+		 */
+		static map<uint64_t, weak_ptr<GLShader>> &getRegistry(void);
+
 	public:
 		/**
-		 * Instantiates a new shader and loads it's sourcecode from the given location.
+		 * Instantiates a new shader and loads and preprocesses it's sourcecode from the given location.
+		 * The OpenGL shader is not created before submit(), which is skipped entirely
+		 * if the program can be restored from the binary program cache.
 		 *
 		 * @param type
 		 * 		Shader type.
 		 *
 		 * @param filename
 		 * 		Shader source file.
+		 *
+		 * @param defines
+		 * 		Definitions to inject into the source.
+		 */
+		GLShader(EGLShaderType type, const string &filename, const GLShaderDefines &defines = GLShaderDefines());
+
+		/**
+		 * Returns a shader with the sourcecode of the given file.
+		 * Reuses a live shader with the same type and sourcecode if possible.
+		 *
+		 * @param type
+		 * 		Shader type.
+		 *
+		 * @param filename
+		 * 		Shader source file.
+		 *
+		 * @param defines
+		 * 		Definitions to inject into the source.
+		 *
+		 * @return Shared shader.
 		 */
-		GLShader(EGLShaderType type, const string &filename);
+		static shared_ptr<GLShader> acquire(EGLShaderType type, const string &filename, const GLShaderDefines &defines = GLShaderDefines());
 
 		/**
 		 * Returns the OpenGL shader ID.
 		 *
-		 * @return ID.
+		 * @return ID, GL_NONE before submit().
 		 */
 		inline GLuint getID(void) const { return m_ID; }
 
@@ -64,6 +118,49 @@ namespace fuel
 		 */
 		inline EGLShaderType getType(void) const { return m_type; }
 
+		/**
+		 * Returns the preprocessed sourcecode.
+		 *
+		 * @return Shader source.
+		 */
+		inline const string &getSource(void) const { return m_source; }
+
+		/**
+		 * Returns the source file name.
+		 *
+		 * @return File name.
+		 */
+		inline const string &getFilename(void) const { return m_filename; }
+
+		/**
+		 * Returns the source file and all files it includes.
+		 *
+		 * @return File names.
+		 */
+		inline const vector<string> &getDependencies(void) const { return m_dependencies; }
+
+		/**
+		 * Returns the hash of type and sourcecode.
+		 *
+		 * @return Content hash.
+		 */
+		inline uint64_t getHash(void) const { return m_hash; }
+
+		/**
+		 * Creates the OpenGL shader and starts compiling the loaded sourcecode.
+		 * Does not wait for the result, so the driver can compile several
+		 * shaders in parallel. Does nothing if already submitted.
+		 */
+		void submit(void);
+
+		/**
+		 * Queries the compilation result, waiting for the compiler if necessary.
+		 * Errors are logged on the first call only.
+		 *
+		 * @return Whether compilation succeeded.
+		 */
+		bool checkStatus(void);
+
 		/**
 		 * Converts an EGLShaderType value to its corresponding OpenGL integral identifier.
 		 *
@@ -0,0 +1,130 @@
+/*****************************************************************
+ * GLShaderPreprocessor.cpp
+ *****************************************************************
+ * Created on: 11.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#include <sstream>
+#include <algorithm>
+#include "../../core/AssetPack.h"
+#include "GLShaderPreprocessor.h"
+
+namespace fuel
+{
+	using namespace std;
+
+	map<string, vector<GLShaderPreprocessor::Chunk>> &GLShaderPreprocessor::getCache(void)
+	{
+		static map<string, vector<Chunk>> cache;
+		return cache;
+	}
+
+	const vector<GLShaderPreprocessor::Chunk> *GLShaderPreprocessor::load(const string &filename)
+	{
+		auto &cache = getCache();
+		auto iter = cache.find(filename);
+		if(iter != cache.end()) return &iter->second;
+
+		AssetData file = AssetPack::open(filename);
+		if(!file.isValid())
+		{
+			cerr << "Shader source file '" << filename << "' does not exist." << endl;
+			return nullptr;
+		}
+		string text(reinterpret_cast<const char *>(file.getData()), file.getSize());
+
+		// Includes are resolved relative to the including file
+		size_t slash = filename.find_last_of('/');
+		string directory = (slash == string::npos) ? "" : filename.substr(0, slash + 1);
+
+		// Split at include directives
+		vector<Chunk> chunks(1);
+		chunks.back().line = 1;
+		unsigned line = 1;
+		for(size_t begin = 0; begin < text.size(); ++line)
+		{
+			size_t end = text.find('\n', begin);
+			end = (end == string::npos) ? text.size() : end + 1;
+
+			size_t first = text.find_first_not_of(" \t", begin);
+			size_t open, close;
+			if(first < end && text.compare(first, 8, "#include") == 0 &&
+			   (open = text.find('"', first)) < end && (close = text.find('"', open + 1)) < end)
+			{
+				// Normalized, so a file included along different paths is still included once
+				chunks.back().include = normalizePath(directory + text.substr(open + 1, close - open - 1));
+				chunks.push_back(Chunk());
+				chunks.back().line = line + 1;
+			}
+			else
+			{
+				chunks.back().text.append(text, begin, end - begin);
+			}
+			begin = end;
+		}
+
+		// Make sure the last line is terminated before the next chunk
+		for(auto &chunk : chunks)
+		{
+			if(!chunk.text.empty() && chunk.text.back() != '\n') chunk.text += '\n';
+		}
+
+		return &(cache[filename] = std::move(chunks));
+	}
+
+	void GLShaderPreprocessor::expand(const string &filename, string &source, vector<string> &dependencies)
+	{
+		// Every file is included at most once, which also breaks cycles
+		if(std::find(dependencies.begin(), dependencies.end(), filename) != dependencies.end()) return;
+
+		const vector<Chunk> *pChunks = load(filename);
+		if(pChunks == nullptr) return;
+
+		unsigned index = dependencies.size();
+		dependencies.push_back(filename);
+
+		for(const Chunk &chunk : *pChunks)
+		{
+			source += "#line " + to_string(chunk.line) + " " + to_string(index) + "\n";
+			source += chunk.text;
+			if(!chunk.include.empty()) expand(chunk.include, source, dependencies);
+		}
+	}
+
+	string GLShaderPreprocessor::process(const string &filename, const GLShaderDefines &defines, vector<string> &dependencies)
+	{
+		dependencies.clear();
+
+		string body;
+		expand(filename, body, dependencies);
+		if(body.empty()) return body;
+
+		// #version has to stay the first directive, definitions follow right after
+		string version;
+		size_t versionBegin = body.find("#version");
+		if(versionBegin != string::npos)
+		{
+			size_t versionEnd = body.find('\n', versionBegin) + 1;
+			version = body.substr(versionBegin, versionEnd - versionBegin);
+
+			// Keep an empty line, so the line numbers stay the same
+			body.replace(versionBegin, versionEnd - versionBegin, "\n");
+		}
+
+		stringstream source;
+		source << version;
+		for(const auto &define : defines)
+		{
+			source << "#define " << define.first << " " << define.second << "\n";
+		}
+		source << body;
+		return source.str();
+	}
+
+	void GLShaderPreprocessor::invalidate(const string &filename)
+	{
+		getCache().erase(filename);
+	}
+}
@@ -0,0 +1,106 @@
+/*****************************************************************
+ * GLShaderPreprocessor.h
+ *****************************************************************
+ * Created on: 11.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+#ifndef GRAPHICS_SHADERS_GLSHADERPREPROCESSOR_H_
+#define GRAPHICS_SHADERS_GLSHADERPREPROCESSOR_H_
+
+#include <map>
+#include <set>
+#include "../../core/Util.h"
+
+namespace fuel
+{
+	// Preprocessor definitions (name, value) specializing a shader
+	typedef std::map<std::string, std::string> GLShaderDefines;
+
+	/**
+	 * Prepares GLSL sources for compilation.
+	 * Resolves #include "file" directives relative to the including file,
+	 * where every file is included at most once, and injects definitions right
+	 * after the #version directive. Each file is read and split at its include
+	 * directives only once, later requests reuse the cached include graph.
+	 * #line directives keep compiler messages pointing at the original files,
+	 * the source string number being the file's index in the dependency list.
+	 */
+	class GLShaderPreprocessor
+	{
+	private:
+		/**
+		 * Piece of a source file up to the next include directive.
+		 */
+		struct Chunk
+		{
+			// Text of the piece
+			std::string text;
+
+			// Line number the text starts at
+			unsigned line;
+
+			// File included after the text, empty for the last piece
+			std::string include;
+		};
+
+		/**
+		 * Returns the cached source files, split into chunks.
+		 *
+		 * @return Include graph cache.
+		 */
+		static std::map<std::string, std::vector<Chunk>> &getCache(void);
+
+		/**
+		 * Loads a source file into the cache if necessary.
+		 *
+		 * @param filename
+		 * 		Source file.
+		 *
+		 * @return Chunks of the file, nullptr if it does not exist.
+		 */
+		static const std::vector<Chunk> *load(const std::string &filename);
+
+		/**
+		 * Appends a source file with its includes expanded.
+		 *
+		 * @param filename
+		 * 		Source file.
+		 *
+		 * @param source
+		 * 		Output source.
+		 *
+		 * @param dependencies
+		 * 		Files expanded so far, extended by this file and its includes.
+		 */
+		static void expand(const std::string &filename, std::string &source, std::vector<std::string> &dependencies);
+
+	public:
+		/**
+		 * Returns the preprocessed source of a shader file.
+		 *
+		 * @param filename
+		 * 		Shader source file.
+		 *
+		 * @param defines
+		 * 		Definitions to inject.
+		 *
+		 * @param dependencies
+		 * 		Filled with the shader file and all files it includes.
+		 *
+		 * @return Source ready for compilation, empty if the file does not exist.
+		 */
+		static std::string process(const std::string &filename, const GLShaderDefines &defines, std::vector<std::string> &dependencies);
+
+		/**
+		 * Drops a file from the cache, so the next request reads it again.
+		 *
+		 * @param filename
+		 * 		Modified source file.
+		 */
+		static void invalidate(const std::string &filename);
+	};
+}
+
+#endif // GRAPHICS_SHADERS_GLSHADERPREPROCESSOR_H_
@@ -6,58 +6,508 @@
  *****************************************************************
  *****************************************************************/
 
+#include <algorithm>
 #include "GLShaderProgram.h"
+#include "GLProgramCache.h"
+
+// GL_KHR_parallel_shader_compile is newer than GLEW
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR           0x91B1
+typedef void (APIENTRY *PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+#endif
 
 namespace fuel
 {
+	shared_ptr<GLShaderProgram> GLShaderProgram::s_pPlaceholder;
+	map<string, GLuint> GLShaderProgram::s_defaultBlockBindings;
+
+	bool GLShaderProgram::LinkedProgram::poll(bool wait)
+	{
+		if(state != EState::PENDING) return state == EState::LINKED;
+
+		// Ask without blocking whether the driver is done
+		if(!wait && isParallelCompileSupported())
+		{
+			GLint completed = GL_FALSE;
+			glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &completed);
+			if(completed != GL_TRUE) return false;
+		}
+
+		GLint linkStatus;
+		glGetProgramiv(ID, GL_LINK_STATUS, &linkStatus);
+		if(linkStatus != GL_TRUE)
+		{
+			// Report which shader failed, if any
+			for(const auto &pShader : shaders)
+			{
+				pShader->checkStatus();
+			}
+
+			GLsizei logLength;
+			GLchar  log[1024];
+			glGetProgramInfoLog(ID, sizeof(log), &logLength, log);
+
+			cerr << "Linking OpenGL shader program " << ID << " failed." << endl;
+			cerr << "Program info log: " << endl << log << endl;
+			state = EState::FAILED;
+		}
+		else
+		{
+			GLProgramCache::store(ID, GLProgramCache::hashDriver(key));
+			state = EState::LINKED;
+
+			#ifdef __DEBUG__
+				glValidateProgram(ID);
+			#endif
+		}
+
+		double seconds = glfwGetTime() - submitTime;
+		GLProgramCache::record(false, seconds);
+		cout << "Compiled OpenGL shader program " << ID << ", ready after " << seconds * 1000.0 << " ms" << endl;
+		return state == EState::LINKED;
+	}
+
+	GLShaderProgram::LinkedProgram::~LinkedProgram(void)
+	{
+		auto &registry = getRegistry();
+		auto iter = registry.find(key);
+		if(iter != registry.end() && iter->second.expired()) registry.erase(iter);
+
+		for(const auto &pShader : shaders)
+		{
+			glDetachShader(ID, pShader->getID());
+		}
+
+		if(ID != GL_NONE)
+		{
+			cout << "Deleting OpenGL shader program: " << ID << endl;
+			glDeleteProgram(ID);
+		}
+	}
+
+	map<uint64_t, weak_ptr<GLShaderProgram::LinkedProgram>> &GLShaderProgram::getRegistry(void)
+	{
+		// Never destroyed, so programs outliving static destruction can still unregister
+		static auto *pRegistry = new map<uint64_t, weak_ptr<LinkedProgram>>();
+		return *pRegistry;
+	}
+
 	GLShaderProgram::GLShaderProgram(void)
-		:m_ID(GL_NONE)
+		:m_uniformsResolved(false)
+	{
+		;;
+	}
+
+	bool GLShaderProgram::isParallelCompileSupported(void)
+	{
+		static int supported = -1;
+		if(supported < 0)
+		{
+			supported = glfwExtensionSupported("GL_KHR_parallel_shader_compile") ? 1 : 0;
+			if(supported)
+			{
+				// Let the driver choose the number of compiler threads
+				auto glMaxShaderCompilerThreadsKHR = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(
+					glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+				if(glMaxShaderCompilerThreadsKHR) glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+				cout << "Compiling shaders in parallel (GL_KHR_parallel_shader_compile)." << endl;
+			}
+		}
+		return supported == 1;
+	}
+
+	unsigned GLShaderProgram::pollPending(void)
+	{
+		unsigned pending = 0;
+		for(const auto &entry : getRegistry())
+		{
+			auto pProgram = entry.second.lock();
+			if(pProgram && !pProgram->poll(false) && pProgram->state == LinkedProgram::EState::PENDING) ++pending;
+		}
+		return pending;
+	}
+
+	GLShaderProgram &GLShaderProgram::getPlaceholder(void)
+	{
+		if(!s_pPlaceholder)
+		{
+			s_pPlaceholder = make_shared<GLShaderProgram>();
+			s_pPlaceholder->setShader(EGLShaderType::VERTEX,   "res/glsl/placeholder.vert");
+			s_pPlaceholder->setShader(EGLShaderType::FRAGMENT, "res/glsl/placeholder.frag");
+			s_pPlaceholder->bindVertexAttribute(0, "vPosition");
+			s_pPlaceholder->link();
+			s_pPlaceholder->finish();
+		}
+		return *s_pPlaceholder;
+	}
+
+	void GLShaderProgram::setShader(EGLShaderType type, const string &filename)
+	{
+		m_shaders[type] = GLShader::acquire(type, filename, m_defines);
+	}
+
+	void GLShaderProgram::setDefine(const string &name, const string &value)
+	{
+		m_defines[name] = value;
+		for(auto &shader : m_shaders)
+		{
+			shader.second = GLShader::acquire(shader.first, shader.second->getFilename(), m_defines);
+		}
+	}
+
+	shared_ptr<GLShaderProgram> GLShaderProgram::createVariant(const GLShaderDefines &defines) const
+	{
+		auto pVariant = make_shared<GLShaderProgram>();
+		pVariant->m_defines = m_defines;
+		for(const auto &define : defines)
+		{
+			pVariant->m_defines[define.first] = define.second;
+		}
+
+		for(const auto &shader : m_shaders)
+		{
+			pVariant->setShader(shader.first, shader.second->getFilename());
+		}
+		pVariant->m_attributes = m_attributes;
+		pVariant->link();
+
+		// Same indices as in this program
+		for(const auto &uniform : m_uniforms)
+		{
+			pVariant->getUniformIndex(uniform.getName());
+		}
+		pVariant->m_blockBindings = m_blockBindings;
+		return pVariant;
+	}
+
+	uint64_t GLShaderProgram::calculateKey(const map<EGLShaderType, shared_ptr<GLShader>> &shaders) const
+	{
+		uint64_t hash = FNV1A_OFFSET_BASIS;
+
+		for(const auto &shader : shaders)
+		{
+			uint64_t shaderHash = shader.second->getHash();
+			hash = hashFNV1a(&shaderHash, sizeof(shaderHash), hash);
+		}
+
+		for(const auto &attribute : m_attributes)
+		{
+			hash = hashFNV1a(&attribute.first, sizeof(attribute.first), hash);
+			hash = hashFNV1a(attribute.second, hash);
+		}
+
+		return hash;
+	}
+
+	shared_ptr<GLShaderProgram::LinkedProgram> GLShaderProgram::createProgram(uint64_t key, const map<EGLShaderType, shared_ptr<GLShader>> &shaders) const
 	{
-		m_ID = glCreateProgram();
+		auto pProgram = make_shared<LinkedProgram>();
+		pProgram->key = key;
+		pProgram->state = LinkedProgram::EState::FAILED;
+		pProgram->submitTime = glfwGetTime();
+		pProgram->ID = glCreateProgram();
 
-		if(m_ID == GL_NONE)
+		if(pProgram->ID == GL_NONE)
 		{
 			cerr << "Could not generate OpenGL shader program." << endl;
+			return pProgram;
+		}
+		cout << "Generated OpenGL shader program: " << pProgram->ID << endl;
+		getRegistry()[key] = pProgram;
+
+		// Restore from the binary program cache
+		if(GLProgramCache::load(pProgram->ID, GLProgramCache::hashDriver(key)))
+		{
+			double seconds = glfwGetTime() - pProgram->submitTime;
+			GLProgramCache::record(true, seconds);
+			cout << "Loaded OpenGL shader program " << pProgram->ID << " from binary cache in " << seconds * 1000.0 << " ms" << endl;
+			pProgram->state = LinkedProgram::EState::LINKED;
+			return pProgram;
+		}
+
+		// Submit all shaders before linking, the driver may compile them in parallel
+		for(const auto &shader : shaders)
+		{
+			shader.second->submit();
+			if(shader.second->getID() == GL_NONE) continue;
+			glAttachShader(pProgram->ID, shader.second->getID());
+			pProgram->shaders.push_back(shader.second);
+		}
+
+		for(const auto &attribute : m_attributes)
+		{
+			glBindAttribLocation(pProgram->ID, attribute.first, attribute.second.c_str());
+		}
+
+		if(GLProgramCache::isSupported())
+		{
+			glProgramParameteri(pProgram->ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		glLinkProgram(pProgram->ID);
+		pProgram->state = LinkedProgram::EState::PENDING;
+		return pProgram;
+	}
+
+	void GLShaderProgram::link(void)
+	{
+		uint64_t key = calculateKey(m_shaders);
+		if(m_pProgram && m_pProgram->key == key) return;
+
+		// Share a live program built from the same sourcecode
+		auto &registry = getRegistry();
+		auto iter = registry.find(key);
+		shared_ptr<LinkedProgram> pProgram = (iter != registry.end()) ? iter->second.lock() : nullptr;
+		if(pProgram)
+		{
+			cout << "Sharing OpenGL shader program: " << pProgram->ID << endl;
 		}
 		else
 		{
-			cout << "Generated OpenGL shader program: " << m_ID << endl;
-			this->use();
+			pProgram = createProgram(key, m_shaders);
 		}
+
+		// Uniform locations belong to the previous program
+		m_pProgram = pProgram;
+		resetUniforms();
 	}
 
-	void GLShaderProgram::setShader(EGLShaderType type, const string &filename)
+	void GLShaderProgram::resetUniforms(void)
 	{
-		// Already contains shader of this type
-		if(m_shaders.count(type) > 0)
+		m_uniformsResolved = false;
+		m_uniformBlocks.clear();
+		for(auto &uniform : m_uniforms)
 		{
-			// Detach old shader
-			detachShader(m_shaders[type]);
-			m_shaders.erase(type);
+			uniform.unresolve();
 		}
+	}
+
+	uint16_t GLShaderProgram::getUniformIndex(const string &name)
+	{
+		auto iter = m_uniformIndices.find(name);
+		if(iter != m_uniformIndices.end()) return iter->second;
 
-		// Store and attach new shader
-		m_shaders[type] = make_unique<GLShader>(type, filename);
-		attachShader(m_shaders[type]);
+		uint16_t index = static_cast<uint16_t>(m_uniforms.size());
+		m_uniformIndices[name] = index;
+		m_uniforms.emplace_back(name);
+
+		// Reflection already saw all active uniforms
+		if(m_uniformsResolved) m_uniforms.back().resolve(getID(), -1, GL_NONE, 0);
+		return index;
 	}
 
-	GLShaderProgram::~GLShaderProgram(void)
+	void GLShaderProgram::bindUniformBlock(const string &name, GLuint binding)
+	{
+		m_blockBindings[name] = binding;
+		for(auto &block : m_uniformBlocks)
+		{
+			if(block.name != name) continue;
+			glUniformBlockBinding(getID(), block.index, binding);
+			block.binding = binding;
+		}
+	}
+
+	void GLShaderProgram::reflect(void)
+	{
+		GLuint ID = m_pProgram->ID;
+		vector<char> name;
+
+		// Resolves one active uniform, adding it to the table if unknown
+		auto addUniform = [this, ID](string uniformName, GLint location, GLenum type, GLint size)
+		{
+			// Arrays are reported as their first element
+			if(uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+			{
+				uniformName.resize(uniformName.size() - 3);
+			}
+			m_uniforms[getUniformIndex(uniformName)].resolve(ID, location, type, size);
+		};
+
+		// Uniforms the program lacks stay inactive
+		for(auto &uniform : m_uniforms)
+		{
+			uniform.resolve(ID, -1, GL_NONE, 0);
+		}
+
+		if(GLEW_ARB_program_interface_query)
+		{
+			GLint count = 0, maxNameLength = 0;
+			glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+			glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+			name.resize(maxNameLength + 1);
+
+			static const GLenum uniformProperties[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION, GL_BLOCK_INDEX };
+			for(GLint i = 0; i < count; ++i)
+			{
+				GLint values[4];
+				glGetProgramResourceiv(ID, GL_UNIFORM, i, 4, uniformProperties, 4, nullptr, values);
+				if(values[3] != -1) continue; // Member of a uniform block
+
+				glGetProgramResourceName(ID, GL_UNIFORM, i, name.size(), nullptr, name.data());
+				addUniform(name.data(), values[2], values[0], values[1]);
+			}
+
+			glGetProgramInterfaceiv(ID, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &count);
+			glGetProgramInterfaceiv(ID, GL_UNIFORM_BLOCK, GL_MAX_NAME_LENGTH, &maxNameLength);
+			name.resize(maxNameLength + 1);
+
+			static const GLenum blockProperties[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+			for(GLint i = 0; i < count; ++i)
+			{
+				GLint values[2];
+				glGetProgramResourceiv(ID, GL_UNIFORM_BLOCK, i, 2, blockProperties, 2, nullptr, values);
+				glGetProgramResourceName(ID, GL_UNIFORM_BLOCK, i, name.size(), nullptr, name.data());
+				m_uniformBlocks.push_back({ name.data(), static_cast<GLuint>(i), static_cast<GLuint>(values[0]), values[1] });
+			}
+		}
+		else
+		{
+			GLint count = 0, maxNameLength = 0;
+			glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+			glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+			name.resize(maxNameLength + 1);
+
+			for(GLint i = 0; i < count; ++i)
+			{
+				GLuint index = i;
+				GLint blockIndex, size;
+				GLenum type;
+				glGetActiveUniformsiv(ID, 1, &index, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+				if(blockIndex != -1) continue; // Member of a uniform block
+
+				glGetActiveUniform(ID, index, name.size(), nullptr, &size, &type, name.data());
+				addUniform(name.data(), glGetUniformLocation(ID, name.data()), type, size);
+			}
+
+			glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+			glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxNameLength);
+			name.resize(maxNameLength + 1);
+
+			for(GLint i = 0; i < count; ++i)
+			{
+				GLint binding, dataSize;
+				glGetActiveUniformBlockiv(ID, i, GL_UNIFORM_BLOCK_BINDING, &binding);
+				glGetActiveUniformBlockiv(ID, i, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+				glGetActiveUniformBlockName(ID, i, name.size(), nullptr, name.data());
+				m_uniformBlocks.push_back({ name.data(), static_cast<GLuint>(i), static_cast<GLuint>(binding), dataSize });
+			}
+		}
+
+		// Apply requested binding points, falling back to the engine defaults
+		for(auto &block : m_uniformBlocks)
+		{
+			auto binding = m_blockBindings.find(block.name);
+			if(binding == m_blockBindings.end())
+			{
+				binding = s_defaultBlockBindings.find(block.name);
+				if(binding == s_defaultBlockBindings.end()) continue;
+			}
+
+			glUniformBlockBinding(ID, block.index, binding->second);
+			block.binding = binding->second;
+		}
+	}
+
+	bool GLShaderProgram::isReady(void)
+	{
+		if(m_uniformsResolved) return true;
+		if(!m_pProgram) return false;
+
+		// Without the extension the first check waits for the driver
+		if(!m_pProgram->poll(false)) return false;
+
+		reflect();
+		return m_uniformsResolved = true;
+	}
+
+	bool GLShaderProgram::finish(void)
+	{
+		if(m_pProgram) m_pProgram->poll(true);
+		return isReady();
+	}
+
+	void GLShaderProgram::use(void)
+	{
+		if(isReady())
+		{
+			glUseProgram(m_pProgram->ID);
+			GLCallCounter::count(EGLCall::PROGRAM);
+		}
+		else if(this != s_pPlaceholder.get())
+		{
+			getPlaceholder().use();
+		}
+	}
+
+	bool GLShaderProgram::usesFile(const string &filename) const
 	{
 		for(const auto &shader : m_shaders)
 		{
-			detachShader(shader.second);
+			const auto &dependencies = shader.second->getDependencies();
+			if(std::find(dependencies.begin(), dependencies.end(), filename) != dependencies.end()) return true;
 		}
+		return false;
+	}
 
-		m_shaders.clear();
-		m_uniforms.clear();
+	vector<string> GLShaderProgram::getDependencies(void) const
+	{
+		vector<string> dependencies;
+		for(const auto &shader : m_shaders)
+		{
+			dependencies.insert(dependencies.end(), shader.second->getDependencies().begin(), shader.second->getDependencies().end());
+		}
+		return dependencies;
+	}
 
-		if(m_ID != GL_NONE)
+	void GLShaderProgram::reload(void)
+	{
+		// Keep the current shaders until the new program links
+		map<EGLShaderType, shared_ptr<GLShader>> shaders;
+		for(const auto &shader : m_shaders)
 		{
-			cout << "Deleting OpenGL shader program: " << m_ID << endl;
-			glDeleteProgram(m_ID);
-			m_ID = GL_NONE;
+			shaders[shader.first] = GLShader::acquire(shader.first, shader.second->getFilename(), m_defines);
 		}
+
+		m_pReloadProgram.reset();
+		m_reloadShaders.clear();
+		uint64_t key = calculateKey(shaders);
+		if(m_pProgram && m_pProgram->key == key) return;
+
+		auto &registry = getRegistry();
+		auto iter = registry.find(key);
+		m_pReloadProgram = (iter != registry.end()) ? iter->second.lock() : nullptr;
+		if(!m_pReloadProgram) m_pReloadProgram = createProgram(key, shaders);
+		m_reloadShaders = std::move(shaders);
 	}
-}
 
+	bool GLShaderProgram::swapReloaded(void)
+	{
+		if(!m_pReloadProgram) return false;
+
+		if(!m_pReloadProgram->poll(false))
+		{
+			if(m_pReloadProgram->state == LinkedProgram::EState::PENDING) return false;
+
+			cerr << "Reloading OpenGL shader program " << getID() << " failed, keeping the previous version." << endl;
+			m_pReloadProgram.reset();
+			m_reloadShaders.clear();
+			return false;
+		}
 
+		cout << "Reloaded OpenGL shader program " << getID() << " as " << m_pReloadProgram->ID << endl;
+		m_pProgram = std::move(m_pReloadProgram);
+		m_shaders = std::move(m_reloadShaders);
+		m_reloadShaders.clear();
+		resetUniforms();
+		return true;
+	}
+
+	GLShaderProgram::~GLShaderProgram(void)
+	{
+		m_pReloadProgram.reset();
+		m_reloadShaders.clear();
+		m_uniforms.clear();
+		m_pProgram.reset();
+		m_shaders.clear();
+	}
+}
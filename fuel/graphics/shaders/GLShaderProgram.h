@@ -17,33 +17,181 @@
 
 namespace fuel
 {
+	template<typename T>
+	class GLUniformHandle;
+
+	/**
+	 * Active uniform block of a linked program.
+	 */
+	struct GLUniformBlock
+	{
+		// Block name
+		string name;
+
+		// Block index within the program
+		GLuint index;
+
+		// Uniform buffer binding point
+		GLuint binding;
+
+		// Minimum buffer size in bytes
+		GLint dataSize;
+	};
+
+	/**
+	 * OpenGL shader program wrapper class.
+	 * Shaders and vertex attributes are only recorded until link(), which
+	 * shares the OpenGL program with every other live wrapper built from the
+	 * same sourcecode and attribute bindings. Uniform values are program state,
+	 * so they have to be set before each use.
+	 * Linking does not wait for the driver: until the program is ready, use()
+	 * binds the placeholder program and uniform values set meanwhile are
+	 * kept, to be written to the program once its uniforms are resolved.
+	 * Once linked, all active uniforms and uniform blocks are enumerated into
+	 * flat tables. Uniform indices are assigned in order of first appearance and
+	 * stay valid across reloads, so per-frame access is an array index.
+	 */
 	class GLShaderProgram
 	{
 	private:
-		// OpenGL shader program ID
-		GLuint m_ID;
+		/**
+		 * Linked OpenGL program shared between wrappers.
+		 */
+		struct LinkedProgram
+		{
+			/**
+			 * Link progress.
+			 */
+			enum class EState : uint8_t
+			{
+				PENDING,//!< PENDING
+				LINKED, //!< LINKED
+				FAILED  //!< FAILED
+			};
+
+			// OpenGL shader program ID
+			GLuint ID;
+
+			// Content key in the program registry
+			uint64_t key;
+
+			// Shaders attached to the program
+			vector<shared_ptr<GLShader>> shaders;
+
+			// Link progress
+			EState state;
+
+			// Time the program was submitted at in seconds
+			double submitTime;
+
+			/**
+			 * Checks whether linking has finished and evaluates the result once it has.
+			 * Successfully linked programs are written to the binary program cache.
+			 *
+			 * @param wait
+			 * 		Whether to wait for the driver if the completion status cannot be
+			 * 		queried without blocking. (GL_KHR_parallel_shader_compile)
+			 *
+			 * @return Whether the program is linked.
+			 */
+			bool poll(bool wait);
+
+			/**
+			 * Unregisters and deletes the program.
+			 */
+			~LinkedProgram(void);
+		};
+
+		// Linked program, nullptr before link()
+		shared_ptr<LinkedProgram> m_pProgram;
+
+		// Program being built by reload(), replaces m_pProgram once linked
+		shared_ptr<LinkedProgram> m_pReloadProgram;
 
 		// Shaders used
-		map<EGLShaderType, unique_ptr<GLShader>> m_shaders;
+		map<EGLShaderType, shared_ptr<GLShader>> m_shaders;
+
+		// Shaders reloaded for m_pReloadProgram, replace m_shaders once it is linked
+		map<EGLShaderType, shared_ptr<GLShader>> m_reloadShaders;
+
+		// Uniform variables, addressed by index
+		vector<GLUniform> m_uniforms;
 
-		// Registered uniform variables
-		map<string, unique_ptr<GLUniform>> m_uniforms;
+		// Uniform indices by name
+		map<string, uint16_t> m_uniformIndices;
+
+		// Active uniform blocks of the linked program
+		vector<GLUniformBlock> m_uniformBlocks;
+
+		// Requested uniform buffer binding points by block name
+		map<string, GLuint> m_blockBindings;
+
+		// Bound vertex attribute names by ID
+		map<GLuint, string> m_attributes;
+
+		// Definitions injected into all shaders
+		GLShaderDefines m_defines;
+
+		// Whether the linked program's uniforms have been reflected
+		bool m_uniformsResolved;
+
+		// Program bound while others are not ready yet
+		static shared_ptr<GLShaderProgram> s_pPlaceholder;
+
+		// Binding points of uniform blocks shared by all programs, by block name
+		static map<string, GLuint> s_defaultBlockBindings;
+
+		/**
+		 * Returns the live linked programs by content key.
+		 *
+		 * @return Program registry.
+		 */
+		static map<uint64_t, weak_ptr<LinkedProgram>> &getRegistry(void);
 
 		/**
-		 * Attaches a shader to this program.
+		 * Calculates the content key from the shader sources and vertex attribute bindings.
+		 *
+		 * @param shaders
+		 * 		Shaders of the program.
 		 *
-		 * @param shader
-		 *		The shader to attach.
+		 * @return Content key.
 		 */
-		inline void attachShader(const unique_ptr<GLShader> &shader){ glAttachShader(m_ID, shader->getID()); }
+		uint64_t calculateKey(const map<EGLShaderType, shared_ptr<GLShader>> &shaders) const;
 
 		/**
-		 * Detaches a shader from this program.
+		 * Creates and registers a new OpenGL program.
+		 * The program is restored from the binary program cache if possible,
+		 * otherwise its shaders are submitted for compilation and linking
+		 * without waiting for the result.
+		 *
+		 * @param key
+		 * 		Content key.
 		 *
-		 * @param shader
-		 *		The shader to detach.
+		 * @param shaders
+		 * 		Shaders to link.
+		 *
+		 * @return New program.
+		 */
+		shared_ptr<LinkedProgram> createProgram(uint64_t key, const map<EGLShaderType, shared_ptr<GLShader>> &shaders) const;
+
+		/**
+		 * Enumerates the active uniforms and uniform blocks of the linked program.
+		 * Uses ARB_program_interface_query if available.
+		 */
+		void reflect(void);
+
+		/**
+		 * Marks all uniforms unresolved after the linked program was replaced.
+		 * Their values are written to the new program once it is reflected.
 		 */
-		inline void detachShader(const unique_ptr<GLShader> &shader){ glDetachShader(m_ID, shader->getID()); }
+		void resetUniforms(void);
+
+		/**
+		 * Returns the placeholder program, loading the default one if none was set.
+		 *
+		 * @return Placeholder program.
+		 */
+		static GLShaderProgram &getPlaceholder(void);
 
 	public:
 		/**
@@ -51,42 +199,153 @@ namespace fuel
 		 */
 		GLShaderProgram(void);
 
+		/**
+		 * Returns whether the driver compiles and links shaders in the background,
+		 * allowing the completion status to be queried without blocking.
+		 * Enables as many compiler threads as the driver offers.
+		 *
+		 * @return Whether GL_KHR_parallel_shader_compile is available.
+		 */
+		static bool isParallelCompileSupported(void);
+
+		/**
+		 * Checks all programs still being compiled and finishes those that are done.
+		 * Intended to be called once per frame. Without GL_KHR_parallel_shader_compile
+		 * this waits for all of them.
+		 *
+		 * @return Number of programs still pending.
+		 */
+		static unsigned pollPending(void);
+
+		/**
+		 * Sets the program bound instead of programs that are not ready yet.
+		 * The placeholder has to be linked already. Defaults to a program which
+		 * discards all geometry.
+		 *
+		 * @param pPlaceholder
+		 * 		Placeholder program.
+		 */
+		static inline void setPlaceholder(const shared_ptr<GLShaderProgram> &pPlaceholder){ s_pPlaceholder = pPlaceholder; }
+
+		/**
+		 * Assigns a uniform buffer binding point to a block name in all programs,
+		 * unless a program binds the block explicitly.
+		 * Applies to programs linked afterwards.
+		 *
+		 * @param name
+		 * 		Block name.
+		 *
+		 * @param binding
+		 * 		Uniform buffer binding point.
+		 */
+		static inline void setDefaultBlockBinding(const string &name, GLuint binding){ s_defaultBlockBindings[name] = binding; }
+
+		/**
+		 * Returns whether the program has finished linking successfully.
+		 * Does not block unless the driver lacks GL_KHR_parallel_shader_compile.
+		 *
+		 * @return Whether the program can be used.
+		 */
+		bool isReady(void);
+
+		/**
+		 * Waits until the program has finished linking.
+		 *
+		 * @return Whether linking succeeded.
+		 */
+		bool finish(void);
+
 		/**
 		 * Returns the program ID.
 		 *
-		 * @return Program ID.
+		 * @return Program ID, GL_NONE before link().
 		 */
-		inline GLuint getID(void) const { return m_ID; }
+		inline GLuint getID(void) const { return m_pProgram ? m_pProgram->ID : GL_NONE; }
 
 		/**
-		 * Registers a new uniform variable.
+		 * Returns the index of a uniform variable, adding it if unknown.
+		 * Indices stay valid for the program's lifetime, including reloads.
 		 *
 		 * @param name
 		 *            The uniform's name.
+		 * @return Uniform index.
 		 */
-		inline void registerUniform(const string &name)
-		{
-			m_uniforms[name] = make_unique<GLUniform>(m_ID, name);
-		}
+		uint16_t getUniformIndex(const string &name);
 
 		/**
-		 * Returns a uniform variable.
+		 * Registers a uniform variable before the program is linked.
+		 * Optional, active uniforms are registered by reflection.
 		 *
 		 * @param name
 		 *            The uniform's name.
+		 */
+		inline void registerUniform(const string &name){ getUniformIndex(name); }
+
+		/**
+		 * Returns a uniform variable by index.
+		 * The reference is invalidated when further uniforms are added.
+		 *
+		 * @param index
+		 *            Uniform index.
 		 * @return The uniform variable.
 		 */
-		inline GLUniform &getUniform(const string &name){ return *m_uniforms[name]; }
+		inline GLUniform &getUniform(uint16_t index){ return m_uniforms[index]; }
+
+		/**
+		 * Returns a uniform variable by name.
+		 * Prefer uniform handles for per-frame access.
+		 *
+		 * @param name
+		 *            The uniform's name.
+		 * @return The uniform variable.
+		 */
+		inline GLUniform &getUniform(const string &name){ return m_uniforms[getUniformIndex(name)]; }
+
+		/**
+		 * Returns a typed handle to a uniform variable.
+		 *
+		 * @param name
+		 *            The uniform's name.
+		 * @return Uniform handle.
+		 */
+		template<typename T>
+		GLUniformHandle<T> getUniformHandle(const string &name);
+
+		/**
+		 * Returns the number of known uniform variables.
+		 *
+		 * @return Uniform count.
+		 */
+		inline uint16_t getUniformCount(void) const { return static_cast<uint16_t>(m_uniforms.size()); }
+
+		/**
+		 * Returns the active uniform blocks of the linked program.
+		 *
+		 * @return Uniform blocks, empty until the program is ready.
+		 */
+		inline const vector<GLUniformBlock> &getUniformBlocks(void) const { return m_uniformBlocks; }
+
+		/**
+		 * Assigns a uniform buffer binding point to a uniform block.
+		 * Kept across reloads and applied once the program is linked.
+		 *
+		 * @param name
+		 *            Block name.
+		 * @param binding
+		 *            Uniform buffer binding point.
+		 */
+		void bindUniformBlock(const string &name, GLuint binding);
 
 		/**
 		 * Use this shader program for the following draw calls.
+		 * Binds the placeholder program instead if it is not ready yet.
 		 */
-		inline void use(void){ glUseProgram(m_ID); }
+		void use(void);
 
 		/**
 		 * Sets one of the program's shaders.
 		 * Loads the source from the specified file name.
-		 * If any shader was attached before, it is released.
+		 * If any shader was set before, it is released on the next link().
 		 *
 		 * @param type
 		 *            Shader type.
@@ -95,6 +354,36 @@ namespace fuel
 		 */
 		void setShader(EGLShaderType type, const string &filename);
 
+		/**
+		 * Sets a definition injected into all of the program's shaders, specializing them.
+		 * Shaders set before are reloaded with the new definition.
+		 * Must be followed by link().
+		 *
+		 * @param name
+		 *            Macro name.
+		 * @param value
+		 *            Macro value.
+		 */
+		void setDefine(const string &name, const string &value);
+
+		/**
+		 * Returns the definitions injected into all shaders.
+		 *
+		 * @return Definitions.
+		 */
+		inline const GLShaderDefines &getDefines(void) const { return m_defines; }
+
+		/**
+		 * Creates a variant of this program with additional definitions.
+		 * The variant uses the same shader files, vertex attributes and
+		 * registered uniforms and is linked already.
+		 *
+		 * @param defines
+		 *            Definitions added to or replacing the program's own.
+		 * @return Linked variant.
+		 */
+		shared_ptr<GLShaderProgram> createVariant(const GLShaderDefines &defines) const;
+
 		/**
 		 * Binds a vertex attribute name to the designated ID.
 		 * This attribute can then be used inside shader code.
@@ -106,21 +395,116 @@ namespace fuel
 		 */
 		inline void bindVertexAttribute(GLuint attributeID, const string &name)
 		{
-			glBindAttribLocation(m_ID, attributeID, name.c_str());
+			m_attributes[attributeID] = name;
 		}
 
 		/**
-		 * Validates the shader in order to make it usable in the future.
-		 * All vertex attributes must be bound beforehand and all uniforms
-		 * registered afterwards.
+		 * Starts linking the program in order to make it usable in the future.
+		 * All vertex attributes must be bound beforehand. Reuses a live program
+		 * with the same shaders and attribute bindings if possible. Does nothing
+		 * if neither changed since the last call.
+		 */
+		void link(void);
+
+		/**
+		 * Returns whether one of the program's shaders is loaded from or includes the given file.
+		 *
+		 * @param filename
+		 *            Shader source file.
+		 * @return Whether the file is used.
+		 */
+		bool usesFile(const string &filename) const;
+
+		/**
+		 * Returns all files the program's shaders are loaded from or include.
+		 *
+		 * @return File names.
+		 */
+		vector<string> getDependencies(void) const;
+
+		/**
+		 * Reloads all shader sources from their files and starts building a new
+		 * program in the background. The current program and its shaders stay in
+		 * use until the new one is linked, see swapReloaded().
+		 */
+		void reload(void);
+
+		/**
+		 * Replaces the program and its shaders by the ones built by reload() once
+		 * it is linked. Uniform registrations and values are preserved. If linking
+		 * failed, the current program and shaders are kept.
+		 *
+		 * @return Whether the program was replaced.
 		 */
-		inline void link(void){ glLinkProgram(m_ID); glValidateProgram(m_ID); }
+		bool swapReloaded(void);
 
 		/**
-		 * Delete attached shaders and the program itself.
+		 * Releases the shaders and the program.
+		 * The OpenGL program is deleted with its last user.
 		 */
 		~GLShaderProgram(void);
 	};
+
+	/**
+	 * Typed reference to a uniform variable of a shader program.
+	 * Setting the value is an array access into the program's uniform table.
+	 */
+	template<typename T>
+	class GLUniformHandle
+	{
+	private:
+		// Parent program
+		GLShaderProgram *m_pProgram;
+
+		// Index in the parent's uniform table
+		uint16_t m_index;
+
+	public:
+		/**
+		 * Instantiates a handle referring to no uniform.
+		 */
+		GLUniformHandle(void)
+			:m_pProgram(nullptr), m_index(0)
+		{
+			;;
+		}
+
+		/**
+		 * Instantiates a handle.
+		 *
+		 * @param program
+		 * 		Parent program.
+		 *
+		 * @param index
+		 * 		Uniform index.
+		 */
+		GLUniformHandle(GLShaderProgram &program, uint16_t index)
+			:m_pProgram(&program), m_index(index)
+		{
+			;;
+		}
+
+		/**
+		 * Returns the referenced uniform.
+		 *
+		 * @return Uniform variable.
+		 */
+		inline GLUniform &get(void) const { return m_pProgram->getUniform(m_index); }
+
+		/**
+		 * Sets the uniform value.
+		 *
+		 * @param value
+		 * 		New value.
+		 */
+		inline void set(const T &value) const { get().template set<T>(value); }
+	};
+
+	template<typename T>
+	inline GLUniformHandle<T> GLShaderProgram::getUniformHandle(const string &name)
+	{
+		return GLUniformHandle<T>(*this, getUniformIndex(name));
+	}
 }
 
 #endif // GRAPHICS_SHADERS_GLSHADERPROGRAM_H_
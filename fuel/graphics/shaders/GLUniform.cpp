@@ -6,15 +6,75 @@
  *****************************************************************
  *****************************************************************/
 
+#include <algorithm>
 #include "GLUniform.h"
 #include <glm/gtc/type_ptr.hpp>
 
 namespace fuel
 {
-	GLUniform::GLUniform(GLuint programID, const string &name)
-		:m_parentProgramID(programID), m_name(name)
+	GLUniform::GLUniform(const string &name)
+		:m_parentProgramID(GL_NONE), m_location(-1), m_type(GL_NONE), m_size(0), m_name(name), m_valueType(GL_NONE)
 	{
-		m_location = glGetUniformLocation(programID, name.c_str());
+		;;
+	}
+
+	void GLUniform::resolve(GLuint programID, GLint location, GLenum type, GLint size)
+	{
+		m_parentProgramID = programID;
+		m_location = location;
+		m_type = type;
+		m_size = size;
+		apply();
+	}
+
+	void GLUniform::unresolve(void)
+	{
+		m_parentProgramID = GL_NONE;
+		m_location = -1;
+		m_type = GL_NONE;
+		m_size = 0;
+	}
+
+	void GLUniform::apply(void)
+	{
+		if(m_location < 0 || m_valueType == GL_NONE) return;
+
+		GLCallCounter::count(EGLCall::UNIFORM);
+		bool direct = GLEW_ARB_separate_shader_objects;
+		if(!direct) ensureParentUsage();
+
+		switch(m_valueType)
+		{
+		case GL_FLOAT:
+			if(direct) glProgramUniform1f(m_parentProgramID, m_location, m_value.f[0]);
+			else glUniform1f(m_location, m_value.f[0]);
+			break;
+
+		case GL_INT:
+			if(direct) glProgramUniform1i(m_parentProgramID, m_location, m_value.i);
+			else glUniform1i(m_location, m_value.i);
+			break;
+
+		case GL_FLOAT_VEC2:
+			if(direct) glProgramUniform2fv(m_parentProgramID, m_location, 1, m_value.f);
+			else glUniform2fv(m_location, 1, m_value.f);
+			break;
+
+		case GL_FLOAT_VEC3:
+			if(direct) glProgramUniform3fv(m_parentProgramID, m_location, 1, m_value.f);
+			else glUniform3fv(m_location, 1, m_value.f);
+			break;
+
+		case GL_FLOAT_VEC4:
+			if(direct) glProgramUniform4fv(m_parentProgramID, m_location, 1, m_value.f);
+			else glUniform4fv(m_location, 1, m_value.f);
+			break;
+
+		case GL_FLOAT_MAT4:
+			if(direct) glProgramUniformMatrix4fv(m_parentProgramID, m_location, 1, GL_FALSE, m_value.f);
+			else glUniformMatrix4fv(m_location, 1, GL_FALSE, m_value.f);
+			break;
+		}
 	}
 
 	// Get as float
@@ -31,8 +91,9 @@ namespace fuel
 	template<>
 	void GLUniform::set<float>(const float &value)
 	{
-		ensureParentUsage();
-		glUniform1f(m_location, value);
+		m_valueType = GL_FLOAT;
+		m_value.f[0] = value;
+		apply();
 	}
 
 	// Get as signed integer (e.g. texture unit)
@@ -48,9 +109,29 @@ namespace fuel
 	// Set as signed integer (e.g. texture unit)
 	template<>
 	void GLUniform::set<GLint>(const GLint &value)
+	{
+		m_valueType = GL_INT;
+		m_value.i = value;
+		apply();
+	}
+
+	// Get as 2D vector
+	template<>
+	glm::vec2 GLUniform::get<glm::vec2>(void)
 	{
 		ensureParentUsage();
-		glUniform1i(m_location, value);
+		GLfloat values[2];
+		glGetUniformfv(m_parentProgramID, m_location, values);
+		return glm::make_vec2(values);
+	}
+
+	// Set as 2D vector
+	template<>
+	void GLUniform::set<glm::vec2>(const glm::vec2 &value)
+	{
+		m_valueType = GL_FLOAT_VEC2;
+		std::copy_n(glm::value_ptr(value), 2, m_value.f);
+		apply();
 	}
 
 	// Get as 3D vector
@@ -66,9 +147,29 @@ namespace fuel
 	// Set as 3D vector
 	template<>
 	void GLUniform::set<glm::vec3>(const glm::vec3 &value)
+	{
+		m_valueType = GL_FLOAT_VEC3;
+		std::copy_n(glm::value_ptr(value), 3, m_value.f);
+		apply();
+	}
+
+	// Get as 4D vector
+	template<>
+	glm::vec4 GLUniform::get<glm::vec4>(void)
 	{
 		ensureParentUsage();
-		glUniform3fv(m_location, 1, glm::value_ptr(value));
+		GLfloat values[4];
+		glGetUniformfv(m_parentProgramID, m_location, values);
+		return glm::make_vec4(values);
+	}
+
+	// Set as 4D vector
+	template<>
+	void GLUniform::set<glm::vec4>(const glm::vec4 &value)
+	{
+		m_valueType = GL_FLOAT_VEC4;
+		std::copy_n(glm::value_ptr(value), 4, m_value.f);
+		apply();
 	}
 
 	// Get as 4x4 matrix
@@ -85,7 +186,8 @@ namespace fuel
 	template<>
 	void GLUniform::set<glm::mat4x4>(const glm::mat4x4 &value)
 	{
-		ensureParentUsage();
-		glUniformMatrix4fv(m_location, 1, GL_FALSE, glm::value_ptr(value));
+		m_valueType = GL_FLOAT_MAT4;
+		std::copy_n(glm::value_ptr(value), 16, m_value.f);
+		apply();
 	}
 }
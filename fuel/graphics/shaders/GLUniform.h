@@ -10,44 +10,98 @@
 #define GRAPHICS_SHADERS_GLUNIFORM_H_
 
 #include "../GLWindow.h"
+#include "../GLCallCounter.h"
 
 namespace fuel
 {
 	class GLUniform
 	{
 	private:
-		// OpenGL shader program ID of parent
+		// OpenGL shader program ID of parent, GL_NONE until resolved
 		GLuint m_parentProgramID;
 
-		// Uniform location
+		// Uniform location, -1 until resolved or if the program lacks the uniform
 		GLint m_location;
 
+		// GLSL type, GL_NONE if the program lacks the uniform
+		GLenum m_type;
+
+		// Number of array elements, 1 for non-array uniforms
+		GLint m_size;
+
 		// Uniform name
 		string m_name;
 
+		// GLSL type of the last value set, GL_NONE if none was set
+		GLenum m_valueType;
+
+		// Last value set, applied again whenever the uniform is resolved
+		union
+		{
+			GLint   i;
+			GLfloat f[16];
+		} m_value;
+
+		/**
+		 * Writes the last value set to the parent program.
+		 * Does nothing while the uniform is unresolved or inactive.
+		 */
+		void apply(void);
+
 		/**
 		 * Ensure that the parent program is currently in use
 		 * before any uniform variables are returned or modified.
+		 * Only needed without ARB_separate_shader_objects.
 		 */
 		inline void ensureParentUsage(void)
 		{
 			GLint currentProgramID;
 			glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgramID);
+			GLCallCounter::count(EGLCall::UNIFORM);
 			if(static_cast<GLuint>(currentProgramID) != m_parentProgramID)
 			{
 				glUseProgram(m_parentProgramID);
+				GLCallCounter::count(EGLCall::PROGRAM);
 			}
 		}
 	public:
 		/**
 		 * Instantiates a new GLSL uniform variable.
+		 * The location is filled in by the parent program's reflection once it is linked.
+		 * Values set before are kept and written to the program as soon as it is.
 		 *
-		 * @param programID
-		 *        Parent shader program ID.
 		 * @param name
 		 *        Name of the variable.
 		 */
-		GLUniform(GLuint programID, const string &name);
+		GLUniform(const string &name);
+
+		/**
+		 * Binds the uniform to a linked program.
+		 * Writes the last value set, if any, to the program.
+		 *
+		 * @param programID
+		 *        Parent shader program ID.
+		 * @param location
+		 *        Uniform location, -1 if the program lacks the uniform.
+		 * @param type
+		 *        GLSL type.
+		 * @param size
+		 *        Number of array elements.
+		 */
+		void resolve(GLuint programID, GLint location, GLenum type, GLint size);
+
+		/**
+		 * Forgets the location after the parent program was replaced.
+		 * The last value set is kept for the next program.
+		 */
+		void unresolve(void);
+
+		/**
+		 * Returns whether the uniform has been resolved.
+		 *
+		 * @return Whether the location is known.
+		 */
+		inline bool isResolved(void) const { return m_parentProgramID != GL_NONE; }
 
 		/**
 		 * Returns the uniform's name.
@@ -56,6 +110,27 @@ namespace fuel
 		 */
 		inline const string &getName(void) const { return m_name; }
 
+		/**
+		 * Returns the uniform's location.
+		 *
+		 * @return Location, -1 if unresolved or inactive.
+		 */
+		inline GLint getLocation(void) const { return m_location; }
+
+		/**
+		 * Returns the uniform's GLSL type.
+		 *
+		 * @return Type, e.g. GL_FLOAT_MAT4 or GL_SAMPLER_2D.
+		 */
+		inline GLenum getType(void) const { return m_type; }
+
+		/**
+		 * Returns the number of array elements.
+		 *
+		 * @return Array size, 1 for non-array uniforms.
+		 */
+		inline GLint getSize(void) const { return m_size; }
+
 		/**
 		 * Returns the shader uniform value as the specified type.
 		 *
@@ -66,6 +141,8 @@ namespace fuel
 
 		/**
 		 * Sets the shader uniform value.
+		 * Writes directly to the parent program if ARB_separate_shader_objects is available.
+		 * The value is kept until the uniform is resolved if the program is still linking.
 		 */
 		template<typename T>
 		void set(const T &value);
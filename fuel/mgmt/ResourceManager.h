@@ -10,33 +10,273 @@
 #define CORE_RESOURCEMANAGER_H_
 
 #include "../core/Util.h"
-#include <map>
+#include "../core/AssetPack.h"
+#include <functional>
+#include <unordered_map>
 
 namespace fuel
 {
+	/**
+	 * 32-bit handle of a resource within a ResourceManager.
+	 * Holds the index of the resource's slot and the generation of the slot
+	 * when the handle was issued. Removing a resource advances its slot's
+	 * generation, so handles to it are detected as stale even after the slot
+	 * was reused. The default constructed handle is never valid.
+	 */
+	template<typename RESOURCE>
+	class ResourceHandle
+	{
+	private:
+		// Generation in the upper bits, slot index in the lower ones, 0 for the null handle
+		uint32_t m_value;
+
+	public:
+		// Bits of the slot index, the remaining ones hold the generation
+		static const unsigned INDEX_BITS = 20;
+
+		// Largest slot index and generation
+		static const uint32_t MAX_INDEX = (1u << INDEX_BITS) - 1;
+		static const uint32_t MAX_GENERATION = (1u << (32 - INDEX_BITS)) - 1;
+
+		/**
+		 * Instantiates the null handle.
+		 */
+		ResourceHandle(void)
+			:m_value(0)
+		{
+			;;
+		}
+
+		/**
+		 * Instantiates a handle.
+		 *
+		 * @param index
+		 * 		Slot index.
+		 *
+		 * @param generation
+		 * 		Slot generation, never 0.
+		 */
+		ResourceHandle(uint32_t index, uint32_t generation)
+			:m_value((generation << INDEX_BITS) | index)
+		{
+			;;
+		}
+
+		/**
+		 * Returns the slot index.
+		 *
+		 * @return Slot index.
+		 */
+		inline uint32_t getIndex(void) const { return m_value & MAX_INDEX; }
+
+		/**
+		 * Returns the slot generation.
+		 *
+		 * @return Generation, 0 for the null handle.
+		 */
+		inline uint32_t getGeneration(void) const { return m_value >> INDEX_BITS; }
+
+		/**
+		 * Returns whether this is the null handle.
+		 *
+		 * @return Whether the handle refers to nothing.
+		 */
+		inline bool isNull(void) const { return m_value == 0; }
+
+		inline bool operator==(const ResourceHandle &other) const { return m_value == other.m_value; }
+		inline bool operator!=(const ResourceHandle &other) const { return m_value != other.m_value; }
+	};
+
+	/**
+	 * Slot map of resources, addressed by generational handles.
+	 * Resources are stored in a dense array of slots, a handle resolves with a
+	 * single indexed load and a generation compare, without touching reference
+	 * counts. Keys are hashed once when a resource is added, after which the
+	 * handle is meant to be kept instead of looking the key up again.
+	 * Resources are owned through shared pointers, so objects handed out
+	 * elsewhere (e.g. to the texture loader) stay alive until released there.
+	 */
 	template<typename KEY, typename RESOURCE>
 	class ResourceManager
 	{
+	public:
+		typedef ResourceHandle<RESOURCE> Handle;
+
 	protected:
-		// Loaded resources
-		std::map<KEY, std::shared_ptr<RESOURCE>> m_resources;
+		// Marks the end of the free slot list
+		static const uint32_t NO_SLOT = 0xFFFFFFFF;
+
+		// Hot part of a slot, resolved on every handle access
+		struct Slot
+		{
+			// Resource, nullptr if the slot is free
+			RESOURCE *pResource;
+
+			// Generation of the slot, advanced on every removal
+			uint32_t generation;
+
+			// Next free slot if this one is free
+			uint32_t nextFree;
+		};
+
+		// Slots, indexed by handle
+		std::vector<Slot> m_slots;
+
+		// Owners and keys of the resources, indexed like the slots
+		std::vector<std::shared_ptr<RESOURCE>> m_owners;
+		std::vector<KEY> m_keys;
+
+		// Slot index by key hash
+		std::unordered_map<uint64_t, uint32_t> m_index;
+
+		// First free slot
+		uint32_t m_freeSlot;
+
+		/**
+		 * Hashes a string key.
+		 */
+		static uint64_t hashKey(const std::string &key){ return hashFNV1a(key); }
+
+		/**
+		 * Hashes any other key.
+		 */
+		template<typename K>
+		static uint64_t hashKey(const K &key){ return std::hash<K>()(key); }
+
+		/**
+		 * Adds a resource, replacing any resource of the same key.
+		 *
+		 * @param key
+		 * 		Resource key.
+		 *
+		 * @param pResource
+		 * 		The resource.
+		 *
+		 * @return Handle of the resource, the null handle if there is no free slot left.
+		 */
+		Handle insert(const KEY &key, std::shared_ptr<RESOURCE> pResource)
+		{
+			uint64_t hash = hashKey(key);
+			auto iter = m_index.find(hash);
+			if(iter != m_index.end())
+			{
+				if(!(m_keys[iter->second] == key))
+				{
+					CERRLN("Resource key hash collision, resource not added.");
+					return Handle();
+				}
+
+				// Handles to the replaced resource become stale
+				uint32_t index = iter->second;
+				Slot &slot = m_slots[index];
+				slot.generation = (slot.generation == Handle::MAX_GENERATION) ? 1 : slot.generation + 1;
+				slot.pResource = pResource.get();
+				m_owners[index] = std::move(pResource);
+				return Handle(index, slot.generation);
+			}
+
+			uint32_t index = m_freeSlot;
+			if(index != NO_SLOT) m_freeSlot = m_slots[index].nextFree;
+			else if(m_slots.size() <= Handle::MAX_INDEX)
+			{
+				index = m_slots.size();
+				m_slots.push_back({nullptr, 1, NO_SLOT});
+				m_owners.emplace_back();
+				m_keys.emplace_back();
+			}
+			else
+			{
+				CERRLN("Too many resources, resource not added.");
+				return Handle();
+			}
+
+			Slot &slot = m_slots[index];
+			slot.pResource = pResource.get();
+			slot.nextFree = NO_SLOT;
+			m_owners[index] = std::move(pResource);
+			m_keys[index] = key;
+			m_index[hash] = index;
+			return Handle(index, slot.generation);
+		}
+
+		/**
+		 * Calls a function with every resource.
+		 *
+		 * @param function
+		 * 		Function taking the resource's owner.
+		 */
+		template<typename FUNCTION>
+		void forEach(FUNCTION function)
+		{
+			for(size_t i = 0; i < m_slots.size(); ++i)
+			{
+				if(m_slots[i].pResource) function(m_owners[i]);
+			}
+		}
 
 	public:
 		/**
 		 * Instantiates a new resource manager.
 		 */
-		ResourceManager(void) = default;
+		ResourceManager(void)
+			:m_freeSlot(NO_SLOT)
+		{
+			;;
+		}
+
+		/**
+		 * Returns the resource a handle refers to.
+		 *
+		 * @param handle
+		 * 		Resource handle.
+		 *
+		 * @return
+		 * 		The resource, nullptr if the handle is null or stale.
+		 */
+		inline RESOURCE *get(Handle handle) const
+		{
+			uint32_t index = handle.getIndex();
+			if(index >= m_slots.size() || m_slots[index].generation != handle.getGeneration()) return nullptr;
+			return m_slots[index].pResource;
+		}
+
+		/**
+		 * Returns whether a handle refers to a resource.
+		 *
+		 * @param handle
+		 * 		Resource handle.
+		 *
+		 * @return False if the handle is null or stale.
+		 */
+		inline bool isValid(Handle handle) const { return get(handle) != nullptr; }
 
 		/**
-		 * Returns the requested resource.
+		 * Looks up the handle of a resource by its key.
+		 * Hashes the key, so keep the handle rather than calling this every frame.
 		 *
 		 * @param key
 		 * 		Resource key.
 		 *
 		 * @return
-		 * 		The resource.
+		 * 		Handle of the resource, the null handle if there is none.
 		 */
-		inline RESOURCE &get(const KEY &key){ return *m_resources[key]; }
+		Handle find(const KEY &key) const
+		{
+			auto iter = m_index.find(hashKey(key));
+			if(iter == m_index.end() || !(m_keys[iter->second] == key)) return Handle();
+			return Handle(iter->second, m_slots[iter->second].generation);
+		}
+
+		/**
+		 * Returns a resource by its key.
+		 *
+		 * @param key
+		 * 		Resource key.
+		 *
+		 * @return
+		 * 		The resource, nullptr if there is none.
+		 */
+		inline RESOURCE *get(const KEY &key) const { return get(find(key)); }
 
 		/**
 		 * Adds a new resource.
@@ -44,6 +284,28 @@ namespace fuel
 		template<typename... ARGS>
 		void add(const KEY &key, ...);
 
+		/**
+		 * Removes the specified resource.
+		 * Handles to it become stale, its slot is reused by later additions.
+		 *
+		 * @param handle
+		 * 		Resource handle.
+		 */
+		void remove(Handle handle)
+		{
+			if(!isValid(handle)) return;
+
+			uint32_t index = handle.getIndex();
+			Slot &slot = m_slots[index];
+			m_index.erase(hashKey(m_keys[index]));
+			slot.pResource = nullptr;
+			slot.generation = (slot.generation == Handle::MAX_GENERATION) ? 1 : slot.generation + 1;
+			slot.nextFree = m_freeSlot;
+			m_freeSlot = index;
+			m_owners[index].reset();
+			m_keys[index] = KEY();
+		}
+
 		/**
 		 * Removes the specified resource.
 		 *
@@ -52,7 +314,42 @@ namespace fuel
 		 */
 		void remove(const KEY &key)
 		{
-			m_resources.erase(key);
+			remove(find(key));
+		}
+
+		/**
+		 * Returns the number of resources.
+		 *
+		 * @return Resource count.
+		 */
+		inline size_t getCount(void) const { return m_index.size(); }
+
+		/**
+		 * Mounts an asset pack, resources are looked up in it before the file system.
+		 *
+		 * @param filename
+		 * 		Pack file.
+		 *
+		 * @return False if the pack could not be mapped or is corrupt.
+		 */
+		static bool mount(const std::string &filename)
+		{
+			return AssetPack::mount(filename);
+		}
+
+		/**
+		 * Resolves a resource file name to its content.
+		 * Uncompressed entries of mounted packs are returned as spans into the
+		 * pack's memory mapping, without copying.
+		 *
+		 * @param filename
+		 * 		Resource file name.
+		 *
+		 * @return The file content, invalid if it was not found.
+		 */
+		static AssetData resolve(const std::string &filename)
+		{
+			return AssetPack::open(filename);
 		}
 	};
 }
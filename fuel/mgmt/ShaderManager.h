@@ -10,15 +10,35 @@
 #define CORE_SHADERMANAGER_H_
 
 #include "ResourceManager.h"
+#include "../core/FileWatcher.h"
 #include "../graphics/shaders/GLShaderProgram.h"
 
 namespace fuel
 {
 	class ShaderManager : public ResourceManager<std::string, GLShaderProgram>
 	{
+	private:
+		// Watches the shader source files for hot reloading
+		FileWatcher m_watcher;
+
+		/**
+		 * Watches all files a program is loaded from.
+		 *
+		 * @param program
+		 * 		Shader program.
+		 */
+		void watch(const GLShaderProgram &program)
+		{
+			for(const auto &filename : program.getDependencies())
+			{
+				m_watcher.watch(filename);
+			}
+		}
+
 	public:
 		/**
 		 * Adds a shader program to the list.
+		 * Programs with the same sourcecode share one OpenGL program once linked.
 		 *
 		 * @param key
 		 * 		Shader name.
@@ -26,12 +46,79 @@ namespace fuel
 		 * 		Vertex shader source file.
 		 * @param fragShaderFile
 		 *		Fragment shader source file.
+		 *
+		 * @return Handle of the program.
+		 */
+		Handle add(const std::string &key, const std::string &vertShaderFile, const std::string &fragShaderFile)
+		{
+			auto pProgram = std::make_shared<GLShaderProgram>();
+			pProgram->setShader(EGLShaderType::VERTEX, 	 vertShaderFile);
+			pProgram->setShader(EGLShaderType::FRAGMENT, fragShaderFile);
+			watch(*pProgram);
+			return insert(key, pProgram);
+		}
+
+		/**
+		 * Returns a permutation of a shader program, specialized by additional definitions
+		 * (e.g. the number of lights or the normal encoding). The variant is created
+		 * and linked on first request and kept under its own key afterwards.
+		 *
+		 * @param key
+		 * 		Shader name of the base program, which must be linked already.
+		 * @param defines
+		 * 		Definitions added to or replacing the base program's own.
+		 *
+		 * @return Handle of the variant, the null handle if there is no base program.
 		 */
-		void add(const std::string &key, const std::string &vertShaderFile, const std::string &fragShaderFile)
+		Handle getVariant(const std::string &key, const GLShaderDefines &defines)
 		{
-			m_resources.insert(std::make_pair(key, std::make_shared<GLShaderProgram>()));
-			m_resources[key]->setShader(EGLShaderType::VERTEX, 	 vertShaderFile);
-			m_resources[key]->setShader(EGLShaderType::FRAGMENT, fragShaderFile);
+			std::string variantKey = key;
+			for(const auto &define : defines)
+			{
+				variantKey += "|" + define.first + "=" + define.second;
+			}
+
+			Handle variant = find(variantKey);
+			if(!variant.isNull()) return variant;
+
+			GLShaderProgram *pBase = get(key);
+			if(pBase == nullptr) return Handle();
+
+			auto pVariant = pBase->createVariant(defines);
+			watch(*pVariant);
+			return insert(variantKey, pVariant);
+		}
+
+		/**
+		 * Reloads programs whose shader source files were modified.
+		 * A reloaded program replaces the old one only once it linked
+		 * successfully, so a broken edit keeps the last working version.
+		 * Intended to be called once per frame.
+		 */
+		void update(void)
+		{
+			std::vector<std::string> modified = m_watcher.poll();
+			for(const auto &filename : modified)
+			{
+				cout << "Shader source file '" << filename << "' modified, reloading." << endl;
+				GLShaderPreprocessor::invalidate(filename);
+			}
+
+			forEach([&](const std::shared_ptr<GLShaderProgram> &pProgram)
+			{
+				for(const auto &filename : modified)
+				{
+					if(!pProgram->usesFile(filename)) continue;
+					pProgram->reload();
+					watch(*pProgram);
+					break;
+				}
+			});
+
+			forEach([](const std::shared_ptr<GLShaderProgram> &pProgram)
+			{
+				pProgram->swapReloaded();
+			});
 		}
 	};
 }
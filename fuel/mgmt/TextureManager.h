@@ -8,29 +8,374 @@
 #ifndef MGMT_TEXTUREMANAGER_H_
 #define MGMT_TEXTUREMANAGER_H_
 
+#include <algorithm>
 #include "ResourceManager.h"
-#include "../graphics/GLTexture.h"
+#include "../graphics/GLTextureLoader.h"
+#include "../graphics/GLTextureArray.h"
 
 namespace fuel
 {
+	/**
+	 * Where to sample a managed texture from when batching draws.
+	 */
+	struct TextureRegion
+	{
+		// Texture to bind, the array texture if the texture was packed, nullptr if there is none
+		const GLTexture *pTexture;
+
+		// Layer of the array texture holding the texture, 0 if it is not packed
+		uint16_t layer;
+	};
+
 	/**
 	 * Manages loaded textures.
+	 * Textures are loaded in the background and show a placeholder until complete.
+	 * With a texture budget, textures are added at a coarse mipmap level (no larger
+	 * than MIN_EVICTED_SIZE) and stream in finer levels once bound, and the least
+	 * recently bound textures are evicted while the textures exceed the budget:
+	 * first down to coarser mipmap levels, then completely.
+	 * Textures bound with a screen size estimate (see GLTexture::request()) are
+	 * streamed in up to the mipmap level that size needs, textures holding finer
+	 * levels than needed drop them before any other texture is evicted.
+	 * Evicted textures bound again are streamed back at the finest needed level that fits.
+	 * Small textures are packed into array textures once loaded, one per format and size,
+	 * so draws using different ones can share a single binding (see getRegion()).
+	 * Packed textures stay resident and are exempt from eviction.
 	 */
 	class TextureManager : public ResourceManager<std::string, GLTexture>
 	{
+	private:
+		// Mipmap levels dropped per eviction step, each one quarters the size
+		static const unsigned EVICTION_LEVELS = 2;
+
+		// Textures are unloaded rather than evicted to levels smaller than this
+		static const unsigned MIN_EVICTED_SIZE = 32;
+
+		// Textures up to this size are packed into array textures
+		static const unsigned MAX_PACKED_SIZE = 256;
+
+		// Array index of textures not packed
+		static const uint16_t NOT_PACKED = 0xFFFF;
+
+		// Origin of a texture, to reload it from
+		struct Source
+		{
+			std::string filename;
+			EMipmapMode mode;
+
+			// First level of the last (re)load request
+			unsigned level;
+
+			// Whether to pack the texture once it is loaded
+			bool packPending;
+
+			// Array and layer holding the texture, NOT_PACKED if it is not packed
+			uint16_t array;
+			uint16_t layer;
+		};
+
+		// Decodes and uploads textures without stalling the render thread
+		GLTextureLoader m_loader;
+
+		// Sources of the textures, indexed like the slots
+		std::vector<Source> m_sources;
+
+		// Bytes of texture storage to keep resident at most, 0 for no limit
+		size_t m_budget;
+
+		// Bytes of texture storage resident after pending evictions and reloads
+		size_t m_residentBytes;
+
+		// Arrays holding the packed textures
+		std::vector<std::unique_ptr<GLTextureArray>> m_arrays;
+
+		// Whether small textures are packed
+		bool m_packing;
+
+		/**
+		 * Packs small textures finished loading into the array matching their format and size.
+		 */
+		void packTextures(void)
+		{
+			for(uint32_t i = 0; i < m_slots.size(); ++i)
+			{
+				Source &source = m_sources[i];
+				const GLTexture *pTexture = m_slots[i].pResource;
+				if(pTexture == nullptr || !source.packPending || pTexture->isLoading()) continue;
+
+				source.packPending = false;
+				if(!pTexture->isReady() || pTexture->getLevelCount() == 0
+					|| std::max(pTexture->getWidth(), pTexture->getHeight()) > MAX_PACKED_SIZE) continue;
+
+				// Added at a coarse level, packed once all levels are resident
+				if(pTexture->getBaseLevel() != 0)
+				{
+					source.packPending = true;
+					reload(i, 0);
+					continue;
+				}
+
+				auto iter = std::find_if(m_arrays.begin(), m_arrays.end(), [pTexture](const std::unique_ptr<GLTextureArray> &pArray)
+				{
+					return pArray->accepts(*pTexture);
+				});
+				if(iter == m_arrays.end())
+				{
+					if(m_arrays.size() == NOT_PACKED) continue;
+					m_arrays.emplace_back(new GLTextureArray(pTexture->getFormat(), pTexture->getWidth(), pTexture->getHeight(), pTexture->getLevelCount()));
+					iter = m_arrays.end() - 1;
+				}
+
+				int layer = (*iter)->add(m_owners[i]);
+				if(layer < 0) continue;
+				source.array = iter - m_arrays.begin();
+				source.layer = layer;
+			}
+		}
+
+		/**
+		 * Frees the array layer of a packed texture and forgets its source.
+		 */
+		void releaseSource(uint32_t index)
+		{
+			Source &source = m_sources[index];
+			if(source.array != NOT_PACKED) m_arrays[source.array]->remove(source.layer);
+			source = {std::string(), EMipmapMode::BOX, 0, false, NOT_PACKED, 0};
+		}
+
+		/**
+		 * Requests a texture to be reloaded from the given level on.
+		 */
+		void reload(uint32_t index, unsigned level)
+		{
+			m_sources[index].level = level;
+			m_loader.reload(m_owners[index], m_sources[index].filename, m_sources[index].mode, level);
+		}
+
+		/**
+		 * Returns the storage size of a texture's levels from the given one on.
+		 */
+		static size_t getStorageSize(const GLTexture &txr, unsigned firstLevel)
+		{
+			if(firstLevel >= txr.getLevelCount()) return 0;
+			return GLTexture::getStorageSize(txr.getFormat(), txr.getWidth(), txr.getHeight(), firstLevel, txr.getLevelCount() - firstLevel);
+		}
+
+		/**
+		 * Streams in the levels needed by textures bound last frame,
+		 * then drops unneeded levels and evicts least recently bound
+		 * textures until the budget is met.
+		 */
+		void updateResidency(void)
+		{
+			uint32_t frame = GLTexture::getFrame();
+			std::vector<uint32_t> candidates, surplus;
+			// Textures still reloading count with the size they are reloaded at
+			m_residentBytes = 0;
+			for(uint32_t i = 0; i < m_slots.size(); ++i)
+			{
+				const GLTexture *pTexture = m_slots[i].pResource;
+				if(pTexture) m_residentBytes += pTexture->isLoading() ? getStorageSize(*pTexture, m_sources[i].level) : pTexture->getByteSize();
+			}
+			for(const auto &pArray : m_arrays) m_residentBytes += pArray->getTexture().getByteSize();
+
+			for(uint32_t i = 0; i < m_slots.size(); ++i)
+			{
+				GLTexture *pTexture = m_slots[i].pResource;
+				if(pTexture == nullptr || pTexture->isLoading() || pTexture->getLevelCount() == 0 || m_sources[i].array != NOT_PACKED) continue;
+
+				// Bound last frame with needed levels missing, restore as much detail as fits
+				if(pTexture->getLastUse() == frame)
+				{
+					unsigned needed = pTexture->getRequestedLevel();
+					size_t current = pTexture->getByteSize();
+					for(unsigned level = needed; level < pTexture->getBaseLevel(); ++level)
+					{
+						size_t size = getStorageSize(*pTexture, level);
+						if(m_residentBytes - current + size > m_budget) continue;
+
+						reload(i, level);
+						m_residentBytes = m_residentBytes - current + size;
+						break;
+					}
+					if(pTexture->getBaseLevel() < needed) surplus.push_back(i);
+				}
+				else if(pTexture->getBaseLevel() < pTexture->getLevelCount()) candidates.push_back(i);
+			}
+			if(m_residentBytes <= m_budget) return;
+
+			// Detail finer than drawn costs memory without being visible
+			for(uint32_t i : surplus)
+			{
+				if(m_residentBytes <= m_budget) return;
+
+				GLTexture &txr = *m_slots[i].pResource;
+				unsigned level = txr.getRequestedLevel();
+				m_residentBytes = m_residentBytes - txr.getByteSize() + getStorageSize(txr, level);
+				reload(i, level);
+			}
+
+			// Least recently bound first
+			std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+			{
+				return m_slots[a].pResource->getLastUse() < m_slots[b].pResource->getLastUse();
+			});
+			for(uint32_t i : candidates)
+			{
+				if(m_residentBytes <= m_budget) break;
+
+				GLTexture &txr = *m_slots[i].pResource;
+				unsigned level = txr.getBaseLevel() + EVICTION_LEVELS;
+				m_residentBytes -= txr.getByteSize();
+				if(level < txr.getLevelCount() && static_cast<unsigned>(std::max(txr.getWidth(), txr.getHeight()) >> level) >= MIN_EVICTED_SIZE)
+				{
+					reload(i, level);
+					m_residentBytes += getStorageSize(txr, level);
+				}
+				else m_loader.unload(txr);
+			}
+		}
+
 	public:
 		/**
-		 * Loads a texture from the designated file.
+		 * Instantiates a new texture manager.
+		 *
+		 * @param uploadBudget
+		 * 		Bytes of texel data to upload per frame at most.
+		 *
+		 * @param textureBudget
+		 * 		Bytes of texture storage to keep resident at most, 0 for no limit.
+		 */
+		TextureManager(size_t uploadBudget, size_t textureBudget = 0)
+			:m_loader(uploadBudget), m_budget(textureBudget), m_residentBytes(0), m_packing(GLTextureArray::isSupported())
+		{
+			;;
+		}
+
+		/**
+		 * Starts loading a texture from the designated file.
+		 * With a budget, levels larger than MIN_EVICTED_SIZE are loaded once the texture is bound.
 		 *
 		 * @param key
 		 * 		Resource key.
 		 *
 		 * @param filename
 		 * 		Texture file name.
+		 *
+		 * @param mode
+		 * 		How to build the mipmap chain of image files.
+		 *
+		 * @return Handle of the texture, usable right away.
+		 */
+		Handle add(const std::string &key, const std::string &filename, EMipmapMode mode = EMipmapMode::BOX)
+		{
+			// A texture replaced under the same key gives up its layer
+			Handle previous = find(key);
+			if(!previous.isNull()) releaseSource(previous.getIndex());
+
+			// With a budget, finer levels are only streamed in once the texture is drawn
+			Handle handle = insert(key, m_loader.load(filename, mode, m_budget > 0 ? MIN_EVICTED_SIZE : 0));
+			if(handle.isNull()) return handle;
+
+			if(m_sources.size() < m_slots.size()) m_sources.resize(m_slots.size());
+			m_sources[handle.getIndex()] = {filename, mode, 0, m_packing, NOT_PACKED, 0};
+			return handle;
+		}
+
+		/**
+		 * Removes the specified texture and frees its array layer if it was packed.
+		 * Handles to it become stale, its slot is reused by later additions.
+		 *
+		 * @param handle
+		 * 		Texture handle.
+		 */
+		void remove(Handle handle)
+		{
+			if(!isValid(handle)) return;
+
+			releaseSource(handle.getIndex());
+			ResourceManager::remove(handle);
+		}
+
+		/**
+		 * Removes the specified texture.
+		 *
+		 * @param key
+		 * 		Resource key.
+		 */
+		inline void remove(const std::string &key){ remove(find(key)); }
+
+		/**
+		 * Returns where to sample a texture from.
+		 * Draws whose textures share the region's texture can be merged into one
+		 * instanced or multi-draw call, passing the layer per draw.
+		 *
+		 * @param handle
+		 * 		Texture handle.
+		 *
+		 * @return The array texture and layer if the texture is packed,
+		 * 		   the texture itself otherwise.
+		 */
+		TextureRegion getRegion(Handle handle) const
+		{
+			const GLTexture *pTexture = get(handle);
+			if(pTexture == nullptr) return {nullptr, 0};
+
+			const Source &source = m_sources[handle.getIndex()];
+			if(source.array == NOT_PACKED) return {pTexture, 0};
+			return {&m_arrays[source.array]->getTexture(), source.layer};
+		}
+
+		/**
+		 * Enables or disables packing small textures into array textures.
+		 * Affects textures added afterwards, has no effect if packing is not supported.
+		 *
+		 * @param packing
+		 * 		Whether to pack small textures.
+		 */
+		inline void setPacking(bool packing){ m_packing = packing && GLTextureArray::isSupported(); }
+
+		/**
+		 * Returns the number of textures still loading.
+		 *
+		 * @return Pending texture count.
+		 */
+		inline unsigned getPendingCount(void) const { return m_loader.getPendingCount(); }
+
+		/**
+		 * Returns the texture budget.
+		 *
+		 * @return Bytes of texture storage to keep resident at most, 0 for no limit.
+		 */
+		inline size_t getBudget(void) const { return m_budget; }
+
+		/**
+		 * Sets the texture budget, enforced from the next update() on.
+		 * Only textures added afterwards start at a coarse level.
+		 *
+		 * @param budget
+		 * 		Bytes of texture storage to keep resident at most, 0 for no limit.
+		 */
+		inline void setBudget(size_t budget){ m_budget = budget; }
+
+		/**
+		 * Returns the size of the managed textures' storage,
+		 * including evictions and reloads still in flight.
+		 *
+		 * @return Size in bytes, as of the last update() with a budget.
+		 */
+		inline size_t getResidentBytes(void) const { return m_residentBytes; }
+
+		/**
+		 * Uploads texture data decoded in the background, packs small textures and enforces the budget.
+		 * Intended to be called once per frame, before any texture is bound.
 		 */
-		void add(const std::string &key, const std::string &filename)
+		void update(void)
 		{
-			m_resources.insert(std::make_pair(key, std::make_shared<GLTexture>(filename)));
+			m_loader.update();
+			packTextures();
+			if(m_budget > 0) updateResidency();
+			GLTexture::advanceFrame();
 		}
 	};
 }
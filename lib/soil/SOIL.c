@@ -34,6 +34,7 @@
 #include "stb_image_aug.h"
 #include "image_helper.h"
 #include "image_DXT.h"
+#include "image_mipmap.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -80,6 +81,11 @@ int query_DXT_capability( void );
 #define SOIL_RGBA_S3TC_DXT5		0x83F3
 typedef void (APIENTRY * P_SOIL_GLCOMPRESSEDTEXIMAGE2DPROC) (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid * data);
 P_SOIL_GLCOMPRESSEDTEXIMAGE2DPROC soilGlCompressedTexImage2D = NULL;
+/*	for having OpenGL build the MIPmaps	*/
+static int has_generate_mipmap_capability = SOIL_CAPABILITY_UNKNOWN;
+int query_generate_mipmap_capability( void );
+typedef void (APIENTRY * P_SOIL_GLGENERATEMIPMAPPROC) (GLenum target);
+P_SOIL_GLGENERATEMIPMAPPROC soilGlGenerateMipmap = NULL;
 unsigned int SOIL_direct_load_DDS(
 		const char *filename,
 		unsigned int reuse_texture_ID,
@@ -1258,66 +1264,81 @@ unsigned int
 		/*	are any MIPmaps desired?	*/
 		if( flags & SOIL_FLAG_MIPMAPS )
 		{
-			int MIPlevel = 1;
-			int MIPwidth = (width+1) / 2;
-			int MIPheight = (height+1) / 2;
-			unsigned char *resampled = (unsigned char*)malloc( channels*MIPwidth*MIPheight );
-			while( ((1<<MIPlevel) <= width) || ((1<<MIPlevel) <= height) )
+			if( (flags & SOIL_FLAG_GPU_MIPMAPS) &&
+				(DXT_mode != SOIL_CAPABILITY_PRESENT) &&
+				(opengl_texture_type == GL_TEXTURE_2D) &&
+				(query_generate_mipmap_capability() == SOIL_CAPABILITY_PRESENT) )
 			{
-				/*	do this MIPmap level	*/
-				mipmap_image(
-						img, width, height, channels,
-						resampled,
-						(1 << MIPlevel), (1 << MIPlevel) );
-				/*  upload the MIPmaps	*/
-				if( DXT_mode == SOIL_CAPABILITY_PRESENT )
+				/*	the driver filters the uncompressed level 0 itself	*/
+				soilGlGenerateMipmap( opengl_texture_type );
+				check_for_GL_errors( "glGenerateMipmap" );
+			} else
+			{
+				/*	build every level at once, right behind the main image	*/
+				unsigned char *chain = (unsigned char*)realloc( img,
+						mipmap_chain_size( width, height, channels ) );
+				int MIPlevel, MIPlevels = 0;
+				int MIPwidth = width;
+				int MIPheight = height;
+				unsigned char *resampled = NULL;
+				if( chain != NULL )
 				{
-					/*	user wants me to do the DXT conversion!	*/
-					int DDS_size;
-					unsigned char *DDS_data = NULL;
-					if( (channels & 1) == 1 )
-					{
-						/*	RGB, use DXT1	*/
-						DDS_data = convert_image_to_DXT1(
-								resampled, MIPwidth, MIPheight, channels, &DDS_size );
-					} else
-					{
-						/*	RGBA, use DXT5	*/
-						DDS_data = convert_image_to_DXT5(
-								resampled, MIPwidth, MIPheight, channels, &DDS_size );
-					}
-					if( DDS_data )
+					img = chain;
+					resampled = img;
+					MIPlevels = mipmap_chain( img, width, height, channels,
+							(flags & SOIL_FLAG_SRGB_MIPMAPS) ? 1 : 0 );
+				}
+				for( MIPlevel = 1; MIPlevel < MIPlevels; ++MIPlevel )
+				{
+					/*	step to this MIPmap level	*/
+					resampled += MIPwidth * MIPheight * channels;
+					MIPwidth = (MIPwidth > 1) ? MIPwidth / 2 : 1;
+					MIPheight = (MIPheight > 1) ? MIPheight / 2 : 1;
+					/*  upload the MIPmaps	*/
+					if( DXT_mode == SOIL_CAPABILITY_PRESENT )
 					{
-						soilGlCompressedTexImage2D(
-							opengl_texture_target, MIPlevel,
-							internal_texture_format, MIPwidth, MIPheight, 0,
-							DDS_size, DDS_data );
-						check_for_GL_errors( "glCompressedTexImage2D" );
-						SOIL_free_image_data( DDS_data );
+						/*	user wants me to do the DXT conversion!	*/
+						int DDS_size;
+						unsigned char *DDS_data = NULL;
+						if( (channels & 1) == 1 )
+						{
+							/*	RGB, use DXT1	*/
+							DDS_data = convert_image_to_DXT1(
+									resampled, MIPwidth, MIPheight, channels, &DDS_size );
+						} else
+						{
+							/*	RGBA, use DXT5	*/
+							DDS_data = convert_image_to_DXT5(
+									resampled, MIPwidth, MIPheight, channels, &DDS_size );
+						}
+						if( DDS_data )
+						{
+							soilGlCompressedTexImage2D(
+								opengl_texture_target, MIPlevel,
+								internal_texture_format, MIPwidth, MIPheight, 0,
+								DDS_size, DDS_data );
+							check_for_GL_errors( "glCompressedTexImage2D" );
+							SOIL_free_image_data( DDS_data );
+						} else
+						{
+							/*	my compression failed, try the OpenGL driver's version	*/
+							glTexImage2D(
+								opengl_texture_target, MIPlevel,
+								internal_texture_format, MIPwidth, MIPheight, 0,
+								original_texture_format, GL_UNSIGNED_BYTE, resampled );
+							check_for_GL_errors( "glTexImage2D" );
+						}
 					} else
 					{
-						/*	my compression failed, try the OpenGL driver's version	*/
+						/*	user want OpenGL to do all the work!	*/
 						glTexImage2D(
 							opengl_texture_target, MIPlevel,
 							internal_texture_format, MIPwidth, MIPheight, 0,
 							original_texture_format, GL_UNSIGNED_BYTE, resampled );
 						check_for_GL_errors( "glTexImage2D" );
 					}
-				} else
-				{
-					/*	user want OpenGL to do all the work!	*/
-					glTexImage2D(
-						opengl_texture_target, MIPlevel,
-						internal_texture_format, MIPwidth, MIPheight, 0,
-						original_texture_format, GL_UNSIGNED_BYTE, resampled );
-					check_for_GL_errors( "glTexImage2D" );
 				}
-				/*	prep for the next level	*/
-				++MIPlevel;
-				MIPwidth = (MIPwidth + 1) / 2;
-				MIPheight = (MIPheight + 1) / 2;
 			}
-			SOIL_free_image_data( resampled );
 			/*	instruct OpenGL to use the MIPmaps	*/
 			glTexParameteri( opengl_texture_type, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
 			glTexParameteri( opengl_texture_type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
@@ -2022,3 +2043,75 @@ int query_DXT_capability( void )
 	/*	let the user know if we can do DXT or not	*/
 	return has_DXT_capability;
 }
+
+int query_generate_mipmap_capability( void )
+{
+	/*	check for the capability	*/
+	if( has_generate_mipmap_capability == SOIL_CAPABILITY_UNKNOWN )
+	{
+		/*	glGenerateMipmap is core since OpenGL 3.0, before that it
+			comes with the framebuffer object extensions
+			(glGetString( GL_EXTENSIONS ) is gone from core profiles,
+			so check the version first)	*/
+		const char *version = (char const*)glGetString( GL_VERSION );
+		const char *name = NULL;
+		P_SOIL_GLGENERATEMIPMAPPROC ext_addr = NULL;
+		if( (NULL != version) && (version[0] >= '3') && (version[0] <= '9') )
+		{
+			name = "glGenerateMipmap";
+		} else if( NULL != strstr( (char const*)glGetString( GL_EXTENSIONS ),
+				"GL_ARB_framebuffer_object" ) )
+		{
+			name = "glGenerateMipmap";
+		} else if( NULL != strstr( (char const*)glGetString( GL_EXTENSIONS ),
+				"GL_EXT_framebuffer_object" ) )
+		{
+			name = "glGenerateMipmapEXT";
+		}
+		if( NULL != name )
+		{
+			/*	find the address of the function	*/
+			#ifdef WIN32
+				ext_addr = (P_SOIL_GLGENERATEMIPMAPPROC)
+						wglGetProcAddress( name );
+			#elif defined(__APPLE__) || defined(__APPLE_CC__)
+				CFBundleRef bundle;
+				CFURLRef bundleURL =
+					CFURLCreateWithFileSystemPath(
+						kCFAllocatorDefault,
+						CFSTR("/System/Library/Frameworks/OpenGL.framework"),
+						kCFURLPOSIXPathStyle,
+						true );
+				CFStringRef extensionName =
+					CFStringCreateWithCString(
+						kCFAllocatorDefault,
+						name,
+						kCFStringEncodingASCII );
+				bundle = CFBundleCreate( kCFAllocatorDefault, bundleURL );
+				assert( bundle != NULL );
+				ext_addr = (P_SOIL_GLGENERATEMIPMAPPROC)
+						CFBundleGetFunctionPointerForName
+						(
+							bundle, extensionName
+						);
+				CFRelease( bundleURL );
+				CFRelease( extensionName );
+				CFRelease( bundle );
+			#else
+				ext_addr = (P_SOIL_GLGENERATEMIPMAPPROC)
+						glXGetProcAddressARB( (const GLubyte *)name );
+			#endif
+		}
+		/*	Flag it so no checks needed later	*/
+		if( NULL == ext_addr )
+		{
+			has_generate_mipmap_capability = SOIL_CAPABILITY_NONE;
+		} else
+		{
+			soilGlGenerateMipmap = ext_addr;
+			has_generate_mipmap_capability = SOIL_CAPABILITY_PRESENT;
+		}
+	}
+	/*	let the user know if OpenGL can build the MIPmaps or not	*/
+	return has_generate_mipmap_capability;
+}
@@ -91,6 +91,8 @@ enum
 	SOIL_FLAG_NTSC_SAFE_RGB: clamps RGB components to the range [16,235]
 	SOIL_FLAG_CoCg_Y: Google YCoCg; RGB=>CoYCg, RGBA=>CoCgAY
 	SOIL_FLAG_TEXTURE_RECTANGE: uses ARB_texture_rectangle ; pixel indexed & no repeat or MIPmaps or cubemaps
+	SOIL_FLAG_GPU_MIPMAPS: with SOIL_FLAG_MIPMAPS, has OpenGL build the MIPmaps (glGenerateMipmap) ; 2D textures without DXT compression only, falls back to SOIL's MIPmaps
+	SOIL_FLAG_SRGB_MIPMAPS: with SOIL_FLAG_MIPMAPS, averages RGB in linear space ; for sRGB encoded color textures
 **/
 enum
 {
@@ -103,7 +105,9 @@ enum
 	SOIL_FLAG_DDS_LOAD_DIRECT = 64,
 	SOIL_FLAG_NTSC_SAFE_RGB = 128,
 	SOIL_FLAG_CoCg_Y = 256,
-	SOIL_FLAG_TEXTURE_RECTANGLE = 512
+	SOIL_FLAG_TEXTURE_RECTANGLE = 512,
+	SOIL_FLAG_GPU_MIPMAPS = 1024,
+	SOIL_FLAG_SRGB_MIPMAPS = 2048
 };
 
 /**
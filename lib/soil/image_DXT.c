@@ -8,6 +8,7 @@
 */
 
 #include "image_DXT.h"
+#include "soil_parallel.h"
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -38,6 +39,160 @@ void compress_DDS_alpha_block(
 				const unsigned char *const uncompressed,
 				unsigned char compressed[8] );
 
+/*
+	Compresses an image to DXT1 (dxt5 = 0) or DXT5 (dxt5 = 1),
+	splitting the block rows across threads.
+*/
+static unsigned char* convert_image_to_DXT(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		int dxt5, int *out_size );
+
+/********* Block Compressor Selection *********/
+/*	the SIMD kernels mirror the covariance matrix method only	*/
+#if USE_COV_MAT && (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#define DXT_X86_SIMD	1
+#include <immintrin.h>
+#else
+#define DXT_X86_SIMD	0
+#endif
+
+/*	widest kernel	*/
+#define DXT_MAX_LANES	8
+/*	blocks a thread has to compress at least to be worth starting	*/
+#define DXT_MIN_BLOCKS_PER_THREAD	1024
+
+/*	compresses lanes color blocks (unused by the scalar path)	*/
+typedef void (*DXT_color_kernel)( const float *soa, unsigned char *const *out );
+
+/*	a block compressor, and how many blocks it takes per call	*/
+typedef struct
+{
+	DXT_color_kernel kernel;
+	int lanes;
+	const char *name;
+} DXT_kernel_info;
+
+/*	an image to compress, split across threads by block rows	*/
+typedef struct
+{
+	const unsigned char *uncompressed;
+	int width, height, channels;
+	int dxt5;
+	unsigned char *compressed;
+	const DXT_kernel_info *kernel;
+} DXT_job;
+
+static void DXT_scalar_kernel( const float *soa, unsigned char *const *out )
+{
+	(void)soa;
+	(void)out;
+}
+
+#if DXT_X86_SIMD
+/*	SSE4.1: 4 blocks per call	*/
+#define DXT_TARGET	__attribute__((target("sse4.1")))
+#define DXT_KERNEL_NAME	compress_DDS_color_blocks_SSE41
+#define DXT_LANES	4
+#define DXT_VF	__m128
+#define DXT_VI	__m128i
+#define DXT_VF_LOAD( p )	_mm_loadu_ps( p )
+#define DXT_VF_SET1( x )	_mm_set1_ps( x )
+#define DXT_VF_ADD( a, b )	_mm_add_ps( a, b )
+#define DXT_VF_SUB( a, b )	_mm_sub_ps( a, b )
+#define DXT_VF_MUL( a, b )	_mm_mul_ps( a, b )
+#define DXT_VF_DIV( a, b )	_mm_div_ps( a, b )
+#define DXT_VF_MIN( a, b )	_mm_min_ps( a, b )
+#define DXT_VF_MAX( a, b )	_mm_max_ps( a, b )
+#define DXT_VF_AND( a, b )	_mm_and_ps( a, b )
+#define DXT_VF_CMPGT( a, b )	_mm_cmpgt_ps( a, b )
+#define DXT_VF_TO_VI( a )	_mm_cvttps_epi32( a )
+#define DXT_VI_TO_VF( a )	_mm_cvtepi32_ps( a )
+#define DXT_VI_SET1( x )	_mm_set1_epi32( x )
+#define DXT_VI_ADD( a, b )	_mm_add_epi32( a, b )
+#define DXT_VI_MUL( a, b )	_mm_mullo_epi32( a, b )
+#define DXT_VI_MIN( a, b )	_mm_min_epi32( a, b )
+#define DXT_VI_MAX( a, b )	_mm_max_epi32( a, b )
+#define DXT_VI_AND( a, b )	_mm_and_si128( a, b )
+#define DXT_VI_OR( a, b )	_mm_or_si128( a, b )
+#define DXT_VI_XOR( a, b )	_mm_xor_si128( a, b )
+#define DXT_VI_SLL( a, n )	_mm_sll_epi32( a, _mm_cvtsi32_si128( n ) )
+#define DXT_VI_SRL( a, n )	_mm_srl_epi32( a, _mm_cvtsi32_si128( n ) )
+#define DXT_VI_STORE( p, a )	_mm_storeu_si128( (__m128i*)(p), a )
+#include "image_DXT_kernel.h"
+#undef DXT_TARGET
+#undef DXT_KERNEL_NAME
+#undef DXT_LANES
+#undef DXT_VF
+#undef DXT_VI
+#undef DXT_VF_LOAD
+#undef DXT_VF_SET1
+#undef DXT_VF_ADD
+#undef DXT_VF_SUB
+#undef DXT_VF_MUL
+#undef DXT_VF_DIV
+#undef DXT_VF_MIN
+#undef DXT_VF_MAX
+#undef DXT_VF_AND
+#undef DXT_VF_CMPGT
+#undef DXT_VF_TO_VI
+#undef DXT_VI_TO_VF
+#undef DXT_VI_SET1
+#undef DXT_VI_ADD
+#undef DXT_VI_MUL
+#undef DXT_VI_MIN
+#undef DXT_VI_MAX
+#undef DXT_VI_AND
+#undef DXT_VI_OR
+#undef DXT_VI_XOR
+#undef DXT_VI_SLL
+#undef DXT_VI_SRL
+#undef DXT_VI_STORE
+
+/*	AVX2: 8 blocks per call	*/
+#define DXT_TARGET	__attribute__((target("avx2")))
+#define DXT_KERNEL_NAME	compress_DDS_color_blocks_AVX2
+#define DXT_LANES	8
+#define DXT_VF	__m256
+#define DXT_VI	__m256i
+#define DXT_VF_LOAD( p )	_mm256_loadu_ps( p )
+#define DXT_VF_SET1( x )	_mm256_set1_ps( x )
+#define DXT_VF_ADD( a, b )	_mm256_add_ps( a, b )
+#define DXT_VF_SUB( a, b )	_mm256_sub_ps( a, b )
+#define DXT_VF_MUL( a, b )	_mm256_mul_ps( a, b )
+#define DXT_VF_DIV( a, b )	_mm256_div_ps( a, b )
+#define DXT_VF_MIN( a, b )	_mm256_min_ps( a, b )
+#define DXT_VF_MAX( a, b )	_mm256_max_ps( a, b )
+#define DXT_VF_AND( a, b )	_mm256_and_ps( a, b )
+#define DXT_VF_CMPGT( a, b )	_mm256_cmp_ps( a, b, _CMP_GT_OQ )
+#define DXT_VF_TO_VI( a )	_mm256_cvttps_epi32( a )
+#define DXT_VI_TO_VF( a )	_mm256_cvtepi32_ps( a )
+#define DXT_VI_SET1( x )	_mm256_set1_epi32( x )
+#define DXT_VI_ADD( a, b )	_mm256_add_epi32( a, b )
+#define DXT_VI_MUL( a, b )	_mm256_mullo_epi32( a, b )
+#define DXT_VI_MIN( a, b )	_mm256_min_epi32( a, b )
+#define DXT_VI_MAX( a, b )	_mm256_max_epi32( a, b )
+#define DXT_VI_AND( a, b )	_mm256_and_si256( a, b )
+#define DXT_VI_OR( a, b )	_mm256_or_si256( a, b )
+#define DXT_VI_XOR( a, b )	_mm256_xor_si256( a, b )
+#define DXT_VI_SLL( a, n )	_mm256_sll_epi32( a, _mm_cvtsi32_si128( n ) )
+#define DXT_VI_SRL( a, n )	_mm256_srl_epi32( a, _mm_cvtsi32_si128( n ) )
+#define DXT_VI_STORE( p, a )	_mm256_storeu_si256( (__m256i*)(p), a )
+#include "image_DXT_kernel.h"
+#endif
+
+static const DXT_kernel_info DXT_scalar = { DXT_scalar_kernel, 1, "scalar" };
+#if DXT_X86_SIMD
+static const DXT_kernel_info DXT_SSE41 = { compress_DDS_color_blocks_SSE41, 4, "SSE4.1" };
+static const DXT_kernel_info DXT_AVX2 = { compress_DDS_color_blocks_AVX2, 8, "AVX2" };
+#endif
+/*	the block compressor set by set_DXT_compression_SIMD, NULL = the
+	widest one the CPU supports.  Every image reads it once, so all
+	threads compressing an image use the same one.	*/
+static const DXT_kernel_info *DXT_kernel = NULL;
+/*	threads to split images across, 0 = one per processor	*/
+static int DXT_thread_count = 0;
+
 /********* Actual Exposed Functions *********/
 int
 	save_image_as_DDS
@@ -103,174 +258,194 @@ unsigned char* convert_image_to_DXT1(
 		int width, int height, int channels,
 		int *out_size )
 {
-	unsigned char *compressed;
-	int i, j, x, y;
-	unsigned char ublock[16*3];
-	unsigned char cblock[8];
-	int index = 0, chan_step = 1;
-	int block_count = 0;
-	/*	error check	*/
-	*out_size = 0;
-	if( (width < 1) || (height < 1) ||
-		(NULL == uncompressed) ||
-		(channels < 1) || (channels > 4) )
+	return convert_image_to_DXT( uncompressed, width, height, channels, 0, out_size );
+}
+
+unsigned char* convert_image_to_DXT5(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		int *out_size )
+{
+	return convert_image_to_DXT( uncompressed, width, height, channels, 1, out_size );
+}
+
+/*	the block compressor to use, only reads the CPU features	*/
+static const DXT_kernel_info* pick_DXT_kernel( int enable )
+{
+	#if DXT_X86_SIMD
+	if( enable )
 	{
-		return NULL;
+		__builtin_cpu_init();
+		if( __builtin_cpu_supports( "avx2" ) )
+		{
+			return &DXT_AVX2;
+		} else if( __builtin_cpu_supports( "sse4.1" ) )
+		{
+			return &DXT_SSE41;
+		}
 	}
-	/*	for channels == 1 or 2, I do not step forward for R,G,B values	*/
-	if( channels < 3 )
+	#else
+	(void)enable;
+	#endif
+	return &DXT_scalar;
+}
+
+const char* set_DXT_compression_SIMD( int enable )
+{
+	const DXT_kernel_info *kernel = pick_DXT_kernel( enable );
+	DXT_kernel = kernel;
+	return kernel->name;
+}
+
+void set_DXT_compression_threads( int threads )
+{
+	DXT_thread_count = (threads < 0) ? 0 : threads;
+}
+
+/********* Block Row Compression *********/
+/*
+	Copies the 4x4 block at block (bx,by) into an RGBA block,
+	repeating the first pixel where the block leaves the image
+	(exactly as the original block loops did).
+*/
+static void extract_DXT_block(
+		const DXT_job *job, int bx, int by,
+		unsigned char ublock[16*4] )
+{
+	int x, y, idx = 0;
+	int chan_step = (job->channels < 3) ? 0 : 1;
+	int has_alpha = 1 - (job->channels & 1);
+	int mx = 4, my = 4;
+	int i = bx * 4, j = by * 4;
+	if( j+4 >= job->height )
 	{
-		chan_step = 0;
+		my = job->height - j;
 	}
-	/*	get the RAM for the compressed image
-		(8 bytes per 4x4 pixel block)	*/
-	*out_size = ((width+3) >> 2) * ((height+3) >> 2) * 8;
-	compressed = (unsigned char*)malloc( *out_size );
-	/*	go through each block	*/
-	for( j = 0; j < height; j += 4 )
+	if( i+4 >= job->width )
 	{
-		for( i = 0; i < width; i += 4 )
+		mx = job->width - i;
+	}
+	if( (job->channels == 4) && (mx == 4) && (my == 4) )
+	{
+		/*	interior RGBA block, rows copy straight over	*/
+		for( y = 0; y < 4; ++y )
 		{
-			/*	copy this block into a new one	*/
-			int idx = 0;
-			int mx = 4, my = 4;
-			if( j+4 >= height )
-			{
-				my = height - j;
-			}
-			if( i+4 >= width )
-			{
-				mx = width - i;
-			}
-			for( y = 0; y < my; ++y )
+			memcpy( ublock + y*16, job->uncompressed + ((j+y)*job->width + i)*4, 16 );
+		}
+		return;
+	}
+	for( y = 0; y < my; ++y )
+	{
+		const unsigned char *row = job->uncompressed + ((j+y)*job->width + i)*job->channels;
+		for( x = 0; x < mx; ++x )
+		{
+			ublock[idx++] = row[x*job->channels];
+			ublock[idx++] = row[x*job->channels+chan_step];
+			ublock[idx++] = row[x*job->channels+chan_step+chan_step];
+			ublock[idx++] = has_alpha ? row[x*job->channels+job->channels-1] : 255;
+		}
+		for( x = mx; x < 4; ++x, idx += 4 )
+		{
+			memcpy( ublock + idx, ublock, 4 );
+		}
+	}
+	for( ; idx < 16*4; idx += 4 )
+	{
+		memcpy( ublock + idx, ublock, 4 );
+	}
+}
+
+static void compress_DXT_block_rows( void *ctx, int row_begin, int row_end )
+{
+	const DXT_job *job = (const DXT_job*)ctx;
+	int bx, by, l, p, c;
+	int blocks_x = (job->width + 3) >> 2;
+	int block_size = job->dxt5 ? 16 : 8;
+	int lanes = job->kernel->lanes;
+	unsigned char ublock[16*4];
+	float soa[16*3*DXT_MAX_LANES];
+	unsigned char *out[DXT_MAX_LANES];
+	unsigned char spill[DXT_MAX_LANES][8];
+	for( by = row_begin; by < row_end; ++by )
+	{
+		unsigned char *row_out = job->compressed + by * blocks_x * block_size;
+		for( bx = 0; bx < blocks_x; bx += lanes )
+		{
+			for( l = 0; l < lanes; ++l )
 			{
-				for( x = 0; x < mx; ++x )
+				/*	lanes past the row end repeat its last block, their output is dropped	*/
+				int x = (bx + l < blocks_x) ? bx + l : blocks_x - 1;
+				unsigned char *block_out = row_out + x * block_size;
+				extract_DXT_block( job, x, by, ublock );
+				if( job->dxt5 )
 				{
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step+chan_step];
+					compress_DDS_alpha_block( ublock, block_out );
+					block_out += 8;
 				}
-				for( x = mx; x < 4; ++x )
+				if( lanes == 1 )
 				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
+					compress_DDS_color_block( 4, ublock, block_out );
+					continue;
 				}
-			}
-			for( y = my; y < 4; ++y )
-			{
-				for( x = 0; x < 4; ++x )
+				out[l] = (bx + l < blocks_x) ? block_out : spill[l];
+				for( p = 0; p < 16; ++p )
 				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
+					for( c = 0; c < 3; ++c )
+					{
+						soa[(p*3+c)*lanes + l] = ublock[p*4+c];
+					}
 				}
 			}
-			/*	compress the block	*/
-			++block_count;
-			compress_DDS_color_block( 3, ublock, cblock );
-			/*	copy the data from the block into the main block	*/
-			for( x = 0; x < 8; ++x )
+			if( lanes > 1 )
 			{
-				compressed[index++] = cblock[x];
+				job->kernel->kernel( soa, out );
 			}
 		}
 	}
-	return compressed;
 }
 
-unsigned char* convert_image_to_DXT5(
+static unsigned char* convert_image_to_DXT(
 		const unsigned char *const uncompressed,
 		int width, int height, int channels,
-		int *out_size )
+		int dxt5, int *out_size )
 {
 	unsigned char *compressed;
-	int i, j, x, y;
-	unsigned char ublock[16*4];
-	unsigned char cblock[8];
-	int index = 0, chan_step = 1;
-	int block_count = 0, has_alpha;
+	DXT_job job;
+	int blocks_x, block_rows;
 	/*	error check	*/
 	*out_size = 0;
 	if( (width < 1) || (height < 1) ||
 		(NULL == uncompressed) ||
-		(channels < 1) || ( channels > 4) )
+		(channels < 1) || (channels > 4) )
 	{
 		return NULL;
 	}
-	/*	for channels == 1 or 2, I do not step forward for R,G,B vales	*/
-	if( channels < 3 )
-	{
-		chan_step = 0;
-	}
-	/*	# channels = 1 or 3 have no alpha, 2 & 4 do have alpha	*/
-	has_alpha = 1 - (channels & 1);
 	/*	get the RAM for the compressed image
-		(16 bytes per 4x4 pixel block)	*/
-	*out_size = ((width+3) >> 2) * ((height+3) >> 2) * 16;
+		(8 or 16 bytes per 4x4 pixel block)	*/
+	blocks_x = (width+3) >> 2;
+	block_rows = (height+3) >> 2;
+	*out_size = blocks_x * block_rows * (dxt5 ? 16 : 8);
 	compressed = (unsigned char*)malloc( *out_size );
-	/*	go through each block	*/
-	for( j = 0; j < height; j += 4 )
+	if( NULL == compressed )
 	{
-		for( i = 0; i < width; i += 4 )
-		{
-			/*	local variables, and my block counter	*/
-			int idx = 0;
-			int mx = 4, my = 4;
-			if( j+4 >= height )
-			{
-				my = height - j;
-			}
-			if( i+4 >= width )
-			{
-				mx = width - i;
-			}
-			for( y = 0; y < my; ++y )
-			{
-				for( x = 0; x < mx; ++x )
-				{
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step+chan_step];
-					ublock[idx++] =
-						has_alpha * uncompressed[(j+y)*width*channels+(i+x)*channels+channels-1]
-						+ (1-has_alpha)*255;
-				}
-				for( x = mx; x < 4; ++x )
-				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
-					ublock[idx++] = ublock[3];
-				}
-			}
-			for( y = my; y < 4; ++y )
-			{
-				for( x = 0; x < 4; ++x )
-				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
-					ublock[idx++] = ublock[3];
-				}
-			}
-			/*	now compress the alpha block	*/
-			compress_DDS_alpha_block( ublock, cblock );
-			/*	copy the data from the compressed alpha block into the main buffer	*/
-			for( x = 0; x < 8; ++x )
-			{
-				compressed[index++] = cblock[x];
-			}
-			/*	then compress the color block	*/
-			++block_count;
-			compress_DDS_color_block( 4, ublock, cblock );
-			/*	copy the data from the compressed color block into the main buffer	*/
-			for( x = 0; x < 8; ++x )
-			{
-				compressed[index++] = cblock[x];
-			}
-		}
+		*out_size = 0;
+		return NULL;
+	}
+	/*	split the block rows across threads, small images are not worth it	*/
+	job.uncompressed = uncompressed;
+	job.width = width;
+	job.height = height;
+	job.channels = channels;
+	job.dxt5 = dxt5;
+	job.compressed = compressed;
+	job.kernel = DXT_kernel;
+	if( NULL == job.kernel )
+	{
+		/*	picked per image, so concurrent first calls share no state	*/
+		job.kernel = pick_DXT_kernel( 1 );
 	}
+	soil_parallel_for( block_rows, (DXT_MIN_BLOCKS_PER_THREAD + blocks_x - 1) / blocks_x,
+			DXT_thread_count, compress_DXT_block_rows, &job );
 	return compressed;
 }
 
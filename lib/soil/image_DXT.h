@@ -45,6 +45,31 @@ convert_image_to_DXT5
     int *out_size
 );
 
+/**
+	Selects the color block compressor.  enable = 0 picks the scalar
+	version, otherwise the widest SIMD version the CPU supports is used
+	(AVX2 with 8 blocks or SSE4.1 with 4 blocks per iteration), which
+	is also the default.  Not thread safe, call before compressing.
+	\return the name of the compressor now in use
+**/
+const char*
+set_DXT_compression_SIMD
+(
+    int enable
+);
+
+/**
+	Sets the number of threads the block rows of an image are split
+	across.  0 = one per processor (the default), 1 = compress on the
+	calling thread only.  Small images always use fewer threads.
+	Not thread safe, call before compressing.
+**/
+void
+set_DXT_compression_threads
+(
+    int threads
+);
+
 /**	A bunch of DirectDraw Surface structures and flags **/
 typedef struct
 {
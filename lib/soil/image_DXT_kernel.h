@@ -0,0 +1,176 @@
+/*
+	SIMD DXT color block kernel
+
+	public domain
+
+	This file is included by image_DXT.c once per instruction set,
+	with the DXT_V* macros mapped to that instruction set's intrinsics.
+	Each SIMD lane compresses one 4x4 block, so DXT_LANES blocks are
+	encoded per call.  The math mirrors LSE_master_colors_max_min and
+	compress_DDS_color_block (covariance matrix method) step by step.
+*/
+
+/*
+	Compresses DXT_LANES color blocks.
+	soa holds the blocks' RGB values as floats, laid out
+	[pixel 0..15][channel 0..2][lane], and out points to the
+	8 byte destination of every lane's block.
+*/
+static void DXT_TARGET
+	DXT_KERNEL_NAME
+	(
+		const float *soa,
+		unsigned char *const *out
+	)
+{
+	int p, l;
+	DXT_VF r, g, b, dot, dot_min, dot_max;
+	DXT_VF sum_r, sum_g, sum_b, sum_rr, sum_gg, sum_bb, sum_rg, sum_rb, sum_gb;
+	DXT_VF dir_r, dir_g, dir_b, prev_r, prev_g, prev_b, vec_len2, dot_offset;
+	DXT_VF line_r, line_g, line_b, c0f_r, c0f_g, c0f_b;
+	DXT_VI c0_r, c0_g, c0_b, c1_r, c1_g, c1_b, enc_i, enc_j, enc_max, enc_min;
+	DXT_VI value, bits;
+	const DXT_VF zero = DXT_VF_SET1( 0.0f );
+	const DXT_VF half = DXT_VF_SET1( 0.5f );
+	const DXT_VF sixteen = DXT_VF_SET1( 16.0f );
+	const DXT_VI izero = DXT_VI_SET1( 0 );
+	const DXT_VI i255 = DXT_VI_SET1( 255 );
+	int enc0[DXT_LANES], enc1[DXT_LANES], indices[DXT_LANES];
+	/*	covariance matrix sums	*/
+	sum_r = sum_g = sum_b = zero;
+	sum_rr = sum_gg = sum_bb = zero;
+	sum_rg = sum_rb = sum_gb = zero;
+	for( p = 0; p < 16; ++p )
+	{
+		r = DXT_VF_LOAD( soa + (p*3+0)*DXT_LANES );
+		g = DXT_VF_LOAD( soa + (p*3+1)*DXT_LANES );
+		b = DXT_VF_LOAD( soa + (p*3+2)*DXT_LANES );
+		sum_r = DXT_VF_ADD( sum_r, r );
+		sum_rr = DXT_VF_ADD( sum_rr, DXT_VF_MUL( r, r ) );
+		sum_g = DXT_VF_ADD( sum_g, g );
+		sum_gg = DXT_VF_ADD( sum_gg, DXT_VF_MUL( g, g ) );
+		sum_b = DXT_VF_ADD( sum_b, b );
+		sum_bb = DXT_VF_ADD( sum_bb, DXT_VF_MUL( b, b ) );
+		sum_rg = DXT_VF_ADD( sum_rg, DXT_VF_MUL( r, g ) );
+		sum_rb = DXT_VF_ADD( sum_rb, DXT_VF_MUL( r, b ) );
+		sum_gb = DXT_VF_ADD( sum_gb, DXT_VF_MUL( g, b ) );
+	}
+	/*	averages, and the squares of the value - avg_value	*/
+	sum_r = DXT_VF_MUL( sum_r, DXT_VF_SET1( 1.0f / 16.0f ) );
+	sum_g = DXT_VF_MUL( sum_g, DXT_VF_SET1( 1.0f / 16.0f ) );
+	sum_b = DXT_VF_MUL( sum_b, DXT_VF_SET1( 1.0f / 16.0f ) );
+	sum_rr = DXT_VF_SUB( sum_rr, DXT_VF_MUL( DXT_VF_MUL( sixteen, sum_r ), sum_r ) );
+	sum_gg = DXT_VF_SUB( sum_gg, DXT_VF_MUL( DXT_VF_MUL( sixteen, sum_g ), sum_g ) );
+	sum_bb = DXT_VF_SUB( sum_bb, DXT_VF_MUL( DXT_VF_MUL( sixteen, sum_b ), sum_b ) );
+	sum_rg = DXT_VF_SUB( sum_rg, DXT_VF_MUL( DXT_VF_MUL( sixteen, sum_r ), sum_g ) );
+	sum_rb = DXT_VF_SUB( sum_rb, DXT_VF_MUL( DXT_VF_MUL( sixteen, sum_r ), sum_b ) );
+	sum_gb = DXT_VF_SUB( sum_gb, DXT_VF_MUL( DXT_VF_MUL( sixteen, sum_g ), sum_b ) );
+	/*	three power method iterations for the largest eigenvector	*/
+	dir_r = DXT_VF_SET1( 1.0f );
+	dir_g = DXT_VF_SET1( 2.718281828f );
+	dir_b = DXT_VF_SET1( 3.141592654f );
+	for( p = 0; p < 3; ++p )
+	{
+		prev_r = dir_r;
+		prev_g = dir_g;
+		prev_b = dir_b;
+		dir_r = DXT_VF_ADD( DXT_VF_ADD( DXT_VF_MUL( prev_r, sum_rr ), DXT_VF_MUL( prev_g, sum_rg ) ), DXT_VF_MUL( prev_b, sum_rb ) );
+		dir_g = DXT_VF_ADD( DXT_VF_ADD( DXT_VF_MUL( prev_r, sum_rg ), DXT_VF_MUL( prev_g, sum_gg ) ), DXT_VF_MUL( prev_b, sum_gb ) );
+		dir_b = DXT_VF_ADD( DXT_VF_ADD( DXT_VF_MUL( prev_r, sum_rb ), DXT_VF_MUL( prev_g, sum_gb ) ), DXT_VF_MUL( prev_b, sum_bb ) );
+	}
+	vec_len2 = DXT_VF_ADD( DXT_VF_ADD( DXT_VF_ADD( DXT_VF_SET1( 0.00001f ),
+			DXT_VF_MUL( dir_r, dir_r ) ), DXT_VF_MUL( dir_g, dir_g ) ), DXT_VF_MUL( dir_b, dir_b ) );
+	vec_len2 = DXT_VF_DIV( DXT_VF_SET1( 1.0f ), vec_len2 );
+	/*	finding the max and min vector values	*/
+	dot_min = DXT_VF_SET1( 3.4e38f );
+	dot_max = DXT_VF_SET1( -3.4e38f );
+	for( p = 0; p < 16; ++p )
+	{
+		r = DXT_VF_LOAD( soa + (p*3+0)*DXT_LANES );
+		g = DXT_VF_LOAD( soa + (p*3+1)*DXT_LANES );
+		b = DXT_VF_LOAD( soa + (p*3+2)*DXT_LANES );
+		dot = DXT_VF_ADD( DXT_VF_ADD( DXT_VF_MUL( dir_r, r ), DXT_VF_MUL( dir_g, g ) ), DXT_VF_MUL( dir_b, b ) );
+		dot_min = DXT_VF_MIN( dot_min, dot );
+		dot_max = DXT_VF_MAX( dot_max, dot );
+	}
+	/*	and the offset (from the average location)	*/
+	dot = DXT_VF_ADD( DXT_VF_ADD( DXT_VF_MUL( dir_r, sum_r ), DXT_VF_MUL( dir_g, sum_g ) ), DXT_VF_MUL( dir_b, sum_b ) );
+	dot_min = DXT_VF_MUL( DXT_VF_SUB( dot_min, dot ), vec_len2 );
+	dot_max = DXT_VF_MUL( DXT_VF_SUB( dot_max, dot ), vec_len2 );
+	/*	build the master colors	*/
+	#define DXT_MASTER( AVG, DIR, DOT ) \
+		DXT_VI_MIN( DXT_VI_MAX( DXT_VF_TO_VI( DXT_VF_ADD( DXT_VF_ADD( half, AVG ), DXT_VF_MUL( DOT, DIR ) ) ), izero ), i255 )
+	c0_r = DXT_MASTER( sum_r, dir_r, dot_max );
+	c0_g = DXT_MASTER( sum_g, dir_g, dot_max );
+	c0_b = DXT_MASTER( sum_b, dir_b, dot_max );
+	c1_r = DXT_MASTER( sum_r, dir_r, dot_min );
+	c1_g = DXT_MASTER( sum_g, dir_g, dot_min );
+	c1_b = DXT_MASTER( sum_b, dir_b, dot_min );
+	#undef DXT_MASTER
+	/*	down_sample to 565, as convert_bit_range does	*/
+	#define DXT_TO_BITS( C, BITS ) \
+		DXT_VI_SRL( DXT_VI_ADD( DXT_VI_ADD( DXT_VI_SET1( 128 ), DXT_VI_MUL( C, DXT_VI_SET1( (1 << BITS) - 1 ) ) ), \
+			DXT_VI_SRL( DXT_VI_ADD( DXT_VI_SET1( 128 ), DXT_VI_MUL( C, DXT_VI_SET1( (1 << BITS) - 1 ) ) ), 8 ) ), 8 )
+	enc_i = DXT_VI_OR( DXT_VI_OR( DXT_VI_SLL( DXT_TO_BITS( c0_r, 5 ), 11 ), DXT_VI_SLL( DXT_TO_BITS( c0_g, 6 ), 5 ) ), DXT_TO_BITS( c0_b, 5 ) );
+	enc_j = DXT_VI_OR( DXT_VI_OR( DXT_VI_SLL( DXT_TO_BITS( c1_r, 5 ), 11 ), DXT_VI_SLL( DXT_TO_BITS( c1_g, 6 ), 5 ) ), DXT_TO_BITS( c1_b, 5 ) );
+	#undef DXT_TO_BITS
+	enc_max = DXT_VI_MAX( enc_i, enc_j );
+	enc_min = DXT_VI_MIN( enc_i, enc_j );
+	/*	reconstitute the master color vectors, as rgb_888_from_565 does	*/
+	#define DXT_FROM_BITS( C, SHIFT, MASK, BITS ) \
+		DXT_VI_SRL( DXT_VI_ADD( DXT_VI_ADD( DXT_VI_SET1( 1 << (BITS - 1) ), \
+			DXT_VI_MUL( DXT_VI_AND( DXT_VI_SRL( C, SHIFT ), DXT_VI_SET1( MASK ) ), i255 ) ), \
+			DXT_VI_SRL( DXT_VI_ADD( DXT_VI_SET1( 1 << (BITS - 1) ), \
+			DXT_VI_MUL( DXT_VI_AND( DXT_VI_SRL( C, SHIFT ), DXT_VI_SET1( MASK ) ), i255 ) ), BITS ) ), BITS )
+	c0_r = DXT_FROM_BITS( enc_max, 11, 31, 5 );
+	c0_g = DXT_FROM_BITS( enc_max, 5, 63, 6 );
+	c0_b = DXT_FROM_BITS( enc_max, 0, 31, 5 );
+	c1_r = DXT_FROM_BITS( enc_min, 11, 31, 5 );
+	c1_g = DXT_FROM_BITS( enc_min, 5, 63, 6 );
+	c1_b = DXT_FROM_BITS( enc_min, 0, 31, 5 );
+	#undef DXT_FROM_BITS
+	/*	the new vector, pre-scaled (left at 0 for single color blocks)	*/
+	c0f_r = DXT_VI_TO_VF( c0_r );
+	c0f_g = DXT_VI_TO_VF( c0_g );
+	c0f_b = DXT_VI_TO_VF( c0_b );
+	line_r = DXT_VF_SUB( DXT_VI_TO_VF( c1_r ), c0f_r );
+	line_g = DXT_VF_SUB( DXT_VI_TO_VF( c1_g ), c0f_g );
+	line_b = DXT_VF_SUB( DXT_VI_TO_VF( c1_b ), c0f_b );
+	vec_len2 = DXT_VF_ADD( DXT_VF_ADD( DXT_VF_MUL( line_r, line_r ), DXT_VF_MUL( line_g, line_g ) ), DXT_VF_MUL( line_b, line_b ) );
+	vec_len2 = DXT_VF_AND( DXT_VF_DIV( DXT_VF_SET1( 1.0f ), vec_len2 ), DXT_VF_CMPGT( vec_len2, zero ) );
+	line_r = DXT_VF_MUL( line_r, vec_len2 );
+	line_g = DXT_VF_MUL( line_g, vec_len2 );
+	line_b = DXT_VF_MUL( line_b, vec_len2 );
+	dot_offset = DXT_VF_ADD( DXT_VF_ADD( DXT_VF_MUL( line_r, c0f_r ), DXT_VF_MUL( line_g, c0f_g ) ), DXT_VF_MUL( line_b, c0f_b ) );
+	/*	place every pixel on the line and map it to [0,3]	*/
+	bits = izero;
+	for( p = 0; p < 16; ++p )
+	{
+		r = DXT_VF_LOAD( soa + (p*3+0)*DXT_LANES );
+		g = DXT_VF_LOAD( soa + (p*3+1)*DXT_LANES );
+		b = DXT_VF_LOAD( soa + (p*3+2)*DXT_LANES );
+		dot = DXT_VF_SUB( DXT_VF_ADD( DXT_VF_ADD( DXT_VF_MUL( line_r, r ), DXT_VF_MUL( line_g, g ) ), DXT_VF_MUL( line_b, b ) ), dot_offset );
+		value = DXT_VF_TO_VI( DXT_VF_ADD( DXT_VF_MUL( dot, DXT_VF_SET1( 3.0f ) ), half ) );
+		value = DXT_VI_MIN( DXT_VI_MAX( value, izero ), DXT_VI_SET1( 3 ) );
+		/*	stupid order {0,2,3,1}: high bit is b0^b1, low bit is b1	*/
+		value = DXT_VI_OR(
+				DXT_VI_SLL( DXT_VI_AND( DXT_VI_XOR( value, DXT_VI_SRL( value, 1 ) ), DXT_VI_SET1( 1 ) ), 1 ),
+				DXT_VI_SRL( value, 1 ) );
+		bits = DXT_VI_OR( bits, DXT_VI_SLL( value, 2*p ) );
+	}
+	/*	store the blocks	*/
+	DXT_VI_STORE( enc0, enc_max );
+	DXT_VI_STORE( enc1, enc_min );
+	DXT_VI_STORE( indices, bits );
+	for( l = 0; l < DXT_LANES; ++l )
+	{
+		out[l][0] = (enc0[l] >> 0) & 255;
+		out[l][1] = (enc0[l] >> 8) & 255;
+		out[l][2] = (enc1[l] >> 0) & 255;
+		out[l][3] = (enc1[l] >> 8) & 255;
+		out[l][4] = (indices[l] >> 0) & 255;
+		out[l][5] = (indices[l] >> 8) & 255;
+		out[l][6] = (indices[l] >> 16) & 255;
+		out[l][7] = (indices[l] >> 24) & 255;
+	}
+}
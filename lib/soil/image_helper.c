@@ -7,9 +7,466 @@
 */
 
 #include "image_helper.h"
+#include "soil_parallel.h"
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#define IH_X86_SIMD	1
+#include <immintrin.h>
+#else
+#define IH_X86_SIMD	0
+#endif
+
+/*	output bytes a thread has to produce at least to be worth starting	*/
+#define IH_MIN_BYTES_PER_THREAD	(1024*1024)
+
+/*	a part of an image to transform (a range of rows or pixels)	*/
+typedef struct IH_job
+{
+	void (*run)( const struct IH_job *job );
+	const unsigned char *orig;
+	unsigned char *out;
+	int width, height, channels;
+	int out_width, out_height;
+	/*	up scaling: vertical step, byte offset of the left sample
+		and its weights (1-x, x) per output column	*/
+	float dy;
+	const int *x_offset;
+	const float *x_weight;
+	int begin, end;
+} IH_job;
+
+/*
+	Kernels transform the first pixels of a range and
+	return how many they did, the rest is left to the
+	scalar loops.  The scalar "kernels" do nothing.
+*/
+/*	one RGBA output row of up_scale_image	*/
+typedef int (*IH_upscale_kernel)(
+		const unsigned char *row0, const unsigned char *row1,
+		const int *x_offset, const float *x_weight,
+		float wy0, float wy1, unsigned char *out, int count );
+/*	count bytes (whole pixels) of scale_image_RGB_to_NTSC_safe	*/
+typedef int (*IH_NTSC_kernel)( unsigned char *img, int count, int channels );
+/*	count RGB(A) pixels of convert_RGB_to_YCoCg	*/
+typedef int (*IH_YCoCg_kernel)( unsigned char *img, int count );
+
+static int IH_scalar_upscale(
+		const unsigned char *row0, const unsigned char *row1,
+		const int *x_offset, const float *x_weight,
+		float wy0, float wy1, unsigned char *out, int count )
+{
+	(void)row0;
+	(void)row1;
+	(void)x_offset;
+	(void)x_weight;
+	(void)wy0;
+	(void)wy1;
+	(void)out;
+	(void)count;
+	return 0;
+}
+
+static int IH_scalar_NTSC( unsigned char *img, int count, int channels )
+{
+	(void)img;
+	(void)count;
+	(void)channels;
+	return 0;
+}
+
+static int IH_scalar_YCoCg( unsigned char *img, int count )
+{
+	(void)img;
+	(void)count;
+	return 0;
+}
+
+static IH_upscale_kernel IH_upscale = IH_scalar_upscale;
+static IH_NTSC_kernel IH_NTSC = IH_scalar_NTSC;
+static IH_YCoCg_kernel IH_YCoCg3 = IH_scalar_YCoCg;
+static IH_YCoCg_kernel IH_YCoCg4 = IH_scalar_YCoCg;
+static const char *IH_kernel_name = "scalar";
+static int IH_kernel_selected = 0;
+/*	0 = one thread per processor	*/
+static int IH_thread_count = 0;
+
+/*
+	The NTSC safe scale maps [0,255] to [16,235]:
+	(i * 1767 + 31731) >> 11 reproduces the
+	original float look up table exactly.
+*/
+#define IH_NTSC_MUL	1767
+#define IH_NTSC_ADD	31731
+#define IH_NTSC_SHIFT	11
+
+#if IH_X86_SIMD
+/*	SSE2: 1 RGBA pixel per iteration	*/
+__attribute__((target("sse2")))
+static int IH_upscale_SSE2(
+		const unsigned char *row0, const unsigned char *row1,
+		const int *x_offset, const float *x_weight,
+		float wy0, float wy1, unsigned char *out, int count )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 half = _mm_set1_ps( 0.5f );
+	const __m128 vy0 = _mm_set1_ps( wy0 );
+	const __m128 vy1 = _mm_set1_ps( wy1 );
+	int x;
+	for( x = 0; x < count; ++x )
+	{
+		const int o = x_offset[x];
+		const __m128 wx0 = _mm_set1_ps( x_weight[2*x] );
+		const __m128 wx1 = _mm_set1_ps( x_weight[2*x+1] );
+		int p00, p10, p01, p11;
+		__m128 v;
+		__m128i i;
+		memcpy( &p00, row0 + o, 4 );
+		memcpy( &p10, row0 + o + 4, 4 );
+		memcpy( &p01, row1 + o, 4 );
+		memcpy( &p11, row1 + o + 4, 4 );
+		/*	same operations in the same order as the scalar loop	*/
+		#define IH_TAP( p, wx, wy )	_mm_mul_ps( _mm_mul_ps( _mm_cvtepi32_ps( \
+				_mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( p ), zero ), zero ) ), wx ), wy )
+		v = _mm_add_ps( half, IH_TAP( p00, wx0, vy0 ) );
+		v = _mm_add_ps( v, IH_TAP( p10, wx1, vy0 ) );
+		v = _mm_add_ps( v, IH_TAP( p01, wx0, vy1 ) );
+		v = _mm_add_ps( v, IH_TAP( p11, wx1, vy1 ) );
+		#undef IH_TAP
+		i = _mm_cvttps_epi32( v );
+		i = _mm_packs_epi32( i, i );
+		p00 = _mm_cvtsi128_si32( _mm_packus_epi16( i, i ) );
+		memcpy( out + 4*x, &p00, 4 );
+	}
+	return count;
+}
+
+/*	SSE2: 16 bytes per iteration	*/
+__attribute__((target("sse2")))
+static int IH_NTSC_SSE2( unsigned char *img, int count, int channels )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16( 1 );
+	const __m128i coef = _mm_set1_epi32( IH_NTSC_MUL | (IH_NTSC_ADD << 16) );
+	const __m128i keep = (channels == 2) ? _mm_set1_epi16( (short)0xFF00 ) :
+			(channels == 4) ? _mm_set1_epi32( (int)0xFF000000 ) : zero;
+	int i;
+	for( i = 0; i + 16 <= count; i += 16 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i*)(img + i) );
+		__m128i lo = _mm_unpacklo_epi8( v, zero );
+		__m128i hi = _mm_unpackhi_epi8( v, zero );
+		/*	(x,1) pairs times (MUL,ADD)	*/
+		lo = _mm_packs_epi32(
+				_mm_srli_epi32( _mm_madd_epi16( _mm_unpacklo_epi16( lo, one ), coef ), IH_NTSC_SHIFT ),
+				_mm_srli_epi32( _mm_madd_epi16( _mm_unpackhi_epi16( lo, one ), coef ), IH_NTSC_SHIFT ) );
+		hi = _mm_packs_epi32(
+				_mm_srli_epi32( _mm_madd_epi16( _mm_unpacklo_epi16( hi, one ), coef ), IH_NTSC_SHIFT ),
+				_mm_srli_epi32( _mm_madd_epi16( _mm_unpackhi_epi16( hi, one ), coef ), IH_NTSC_SHIFT ) );
+		lo = _mm_packus_epi16( lo, hi );
+		/*	alpha stays	*/
+		v = _mm_or_si128( _mm_and_si128( keep, v ), _mm_andnot_si128( keep, lo ) );
+		_mm_storeu_si128( (__m128i*)(img + i), v );
+	}
+	return i;
+}
+
+/*
+	YCoCg of the RGB(A) pixel in each 32 bit lane: Co, Y, Cg in the
+	low 3 bytes (CoYCg), or Co, Cg, A, Y with alpha (CoCgAY)
+*/
+__attribute__((target("sse2")))
+static __inline__ __m128i IH_YCoCg_SSE2( __m128i v, int with_alpha )
+{
+	const __m128i byte = _mm_set1_epi32( 0xFF );
+	const __m128i r = _mm_and_si128( v, byte );
+	const __m128i b = _mm_and_si128( _mm_srli_epi32( v, 16 ), byte );
+	__m128i g = _mm_and_si128( _mm_srli_epi32( v, 8 ), byte );
+	__m128i tmp, co, cg, y;
+	g = _mm_srli_epi32( _mm_add_epi32( g, _mm_set1_epi32( 1 ) ), 1 );
+	tmp = _mm_srli_epi32( _mm_add_epi32( _mm_add_epi32( r, b ), _mm_set1_epi32( 2 ) ), 2 );
+	co = _mm_add_epi32( _mm_set1_epi32( 128 ),
+			_mm_srai_epi32( _mm_add_epi32( _mm_sub_epi32( r, b ), _mm_set1_epi32( 1 ) ), 1 ) );
+	cg = _mm_sub_epi32( _mm_add_epi32( _mm_set1_epi32( 128 ), g ), tmp );
+	y = _mm_add_epi32( g, tmp );
+	/*	all of them are in [0,256], so a 16 bit min clamps	*/
+	co = _mm_min_epi16( co, byte );
+	cg = _mm_min_epi16( cg, byte );
+	y = _mm_min_epi16( y, byte );
+	if( with_alpha )
+	{
+		return _mm_or_si128(
+				_mm_or_si128( co, _mm_slli_epi32( cg, 8 ) ),
+				_mm_or_si128( _mm_slli_epi32( _mm_srli_epi32( v, 24 ), 16 ), _mm_slli_epi32( y, 24 ) ) );
+	}
+	return _mm_or_si128( _mm_or_si128( co, _mm_slli_epi32( y, 8 ) ), _mm_slli_epi32( cg, 16 ) );
+}
+
+/*	SSE2: 4 RGBA pixels per iteration	*/
+__attribute__((target("sse2")))
+static int IH_YCoCg4_SSE2( unsigned char *img, int count )
+{
+	int i;
+	for( i = 0; i + 4 <= count; i += 4 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i*)(img + 4*i) );
+		_mm_storeu_si128( (__m128i*)(img + 4*i), IH_YCoCg_SSE2( v, 1 ) );
+	}
+	return i;
+}
+
+/*	AVX2: 2 RGBA pixels per iteration	*/
+__attribute__((target("avx2")))
+static int IH_upscale_AVX2(
+		const unsigned char *row0, const unsigned char *row1,
+		const int *x_offset, const float *x_weight,
+		float wy0, float wy1, unsigned char *out, int count )
+{
+	const __m256 half = _mm256_set1_ps( 0.5f );
+	const __m256 vy0 = _mm256_set1_ps( wy0 );
+	const __m256 vy1 = _mm256_set1_ps( wy1 );
+	int x;
+	for( x = 0; x + 2 <= count; x += 2 )
+	{
+		const int o0 = x_offset[x], o1 = x_offset[x+1];
+		const __m256 wx0 = _mm256_setr_ps(
+				x_weight[2*x], x_weight[2*x], x_weight[2*x], x_weight[2*x],
+				x_weight[2*x+2], x_weight[2*x+2], x_weight[2*x+2], x_weight[2*x+2] );
+		const __m256 wx1 = _mm256_setr_ps(
+				x_weight[2*x+1], x_weight[2*x+1], x_weight[2*x+1], x_weight[2*x+1],
+				x_weight[2*x+3], x_weight[2*x+3], x_weight[2*x+3], x_weight[2*x+3] );
+		/*	left and right sample of both pixels, reordered to
+			left of pixel 0, left of pixel 1, right of 0, right of 1	*/
+		const __m128i top = _mm_unpacklo_epi32(
+				_mm_loadl_epi64( (const __m128i*)(row0 + o0) ),
+				_mm_loadl_epi64( (const __m128i*)(row0 + o1) ) );
+		const __m128i bottom = _mm_unpacklo_epi32(
+				_mm_loadl_epi64( (const __m128i*)(row1 + o0) ),
+				_mm_loadl_epi64( (const __m128i*)(row1 + o1) ) );
+		__m256 v;
+		__m256i i;
+		__m128i packed;
+		/*	same operations in the same order as the scalar loop	*/
+		#define IH_TAP( p, wx, wy )	_mm256_mul_ps( _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( p ) ), wx ), wy )
+		v = _mm256_add_ps( half, IH_TAP( top, wx0, vy0 ) );
+		v = _mm256_add_ps( v, IH_TAP( _mm_srli_si128( top, 8 ), wx1, vy0 ) );
+		v = _mm256_add_ps( v, IH_TAP( bottom, wx0, vy1 ) );
+		v = _mm256_add_ps( v, IH_TAP( _mm_srli_si128( bottom, 8 ), wx1, vy1 ) );
+		#undef IH_TAP
+		i = _mm256_cvttps_epi32( v );
+		packed = _mm_packs_epi32( _mm256_castsi256_si128( i ), _mm256_extracti128_si256( i, 1 ) );
+		_mm_storel_epi64( (__m128i*)(out + 4*x), _mm_packus_epi16( packed, packed ) );
+	}
+	return x;
+}
+
+/*	AVX2: 32 bytes per iteration	*/
+__attribute__((target("avx2")))
+static int IH_NTSC_AVX2( unsigned char *img, int count, int channels )
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi16( 1 );
+	const __m256i coef = _mm256_set1_epi32( IH_NTSC_MUL | (IH_NTSC_ADD << 16) );
+	const __m256i keep = (channels == 2) ? _mm256_set1_epi16( (short)0xFF00 ) :
+			(channels == 4) ? _mm256_set1_epi32( (int)0xFF000000 ) : zero;
+	int i;
+	for( i = 0; i + 32 <= count; i += 32 )
+	{
+		__m256i v = _mm256_loadu_si256( (const __m256i*)(img + i) );
+		__m256i lo = _mm256_unpacklo_epi8( v, zero );
+		__m256i hi = _mm256_unpackhi_epi8( v, zero );
+		lo = _mm256_packs_epi32(
+				_mm256_srli_epi32( _mm256_madd_epi16( _mm256_unpacklo_epi16( lo, one ), coef ), IH_NTSC_SHIFT ),
+				_mm256_srli_epi32( _mm256_madd_epi16( _mm256_unpackhi_epi16( lo, one ), coef ), IH_NTSC_SHIFT ) );
+		hi = _mm256_packs_epi32(
+				_mm256_srli_epi32( _mm256_madd_epi16( _mm256_unpacklo_epi16( hi, one ), coef ), IH_NTSC_SHIFT ),
+				_mm256_srli_epi32( _mm256_madd_epi16( _mm256_unpackhi_epi16( hi, one ), coef ), IH_NTSC_SHIFT ) );
+		/*	unpacking and packing within the 128 bit lanes keeps the byte order	*/
+		lo = _mm256_packus_epi16( lo, hi );
+		v = _mm256_blendv_epi8( lo, v, keep );
+		_mm256_storeu_si256( (__m256i*)(img + i), v );
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static __inline__ __m256i IH_YCoCg_AVX2( __m256i v, int with_alpha )
+{
+	const __m256i byte = _mm256_set1_epi32( 0xFF );
+	const __m256i r = _mm256_and_si256( v, byte );
+	const __m256i b = _mm256_and_si256( _mm256_srli_epi32( v, 16 ), byte );
+	__m256i g = _mm256_and_si256( _mm256_srli_epi32( v, 8 ), byte );
+	__m256i tmp, co, cg, y;
+	g = _mm256_srli_epi32( _mm256_add_epi32( g, _mm256_set1_epi32( 1 ) ), 1 );
+	tmp = _mm256_srli_epi32( _mm256_add_epi32( _mm256_add_epi32( r, b ), _mm256_set1_epi32( 2 ) ), 2 );
+	co = _mm256_add_epi32( _mm256_set1_epi32( 128 ),
+			_mm256_srai_epi32( _mm256_add_epi32( _mm256_sub_epi32( r, b ), _mm256_set1_epi32( 1 ) ), 1 ) );
+	cg = _mm256_sub_epi32( _mm256_add_epi32( _mm256_set1_epi32( 128 ), g ), tmp );
+	y = _mm256_add_epi32( g, tmp );
+	co = _mm256_min_epi32( co, byte );
+	cg = _mm256_min_epi32( cg, byte );
+	y = _mm256_min_epi32( y, byte );
+	if( with_alpha )
+	{
+		return _mm256_or_si256(
+				_mm256_or_si256( co, _mm256_slli_epi32( cg, 8 ) ),
+				_mm256_or_si256( _mm256_slli_epi32( _mm256_srli_epi32( v, 24 ), 16 ), _mm256_slli_epi32( y, 24 ) ) );
+	}
+	return _mm256_or_si256( _mm256_or_si256( co, _mm256_slli_epi32( y, 8 ) ), _mm256_slli_epi32( cg, 16 ) );
+}
+
+/*	AVX2: 8 RGBA pixels per iteration	*/
+__attribute__((target("avx2")))
+static int IH_YCoCg4_AVX2( unsigned char *img, int count )
+{
+	int i;
+	for( i = 0; i + 8 <= count; i += 8 )
+	{
+		__m256i v = _mm256_loadu_si256( (const __m256i*)(img + 4*i) );
+		_mm256_storeu_si256( (__m256i*)(img + 4*i), IH_YCoCg_AVX2( v, 1 ) );
+	}
+	return i;
+}
+
+/*	AVX2: 8 RGB pixels per iteration, spread to 32 bit lanes and back	*/
+__attribute__((target("avx2")))
+static int IH_YCoCg3_AVX2( unsigned char *img, int count )
+{
+	const __m256i spread = _mm256_setr_epi8(
+			0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+			0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 );
+	const __m256i gather = _mm256_setr_epi8(
+			0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+			0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 );
+	int i;
+	/*	the loads read 4 bytes past the 8 pixels	*/
+	for( i = 0; 3*i + 28 <= 3*count; i += 8 )
+	{
+		__m256i v = _mm256_setr_m128i(
+				_mm_loadu_si128( (const __m128i*)(img + 3*i) ),
+				_mm_loadu_si128( (const __m128i*)(img + 3*i + 12) ) );
+		__m128i lo, hi;
+		v = _mm256_shuffle_epi8( IH_YCoCg_AVX2( _mm256_shuffle_epi8( v, spread ), 0 ), gather );
+		lo = _mm256_castsi256_si128( v );
+		hi = _mm256_extracti128_si256( v, 1 );
+		/*	12 bytes from each lane	*/
+		_mm_storel_epi64( (__m128i*)(img + 3*i), lo );
+		_mm_storel_epi64( (__m128i*)(img + 3*i + 8), _mm_or_si128( _mm_srli_si128( lo, 8 ), _mm_slli_si128( hi, 4 ) ) );
+		_mm_storel_epi64( (__m128i*)(img + 3*i + 16), _mm_srli_si128( hi, 4 ) );
+	}
+	return i;
+}
+#endif
+
+const char* set_image_helper_SIMD( int enable )
+{
+	IH_upscale = IH_scalar_upscale;
+	IH_NTSC = IH_scalar_NTSC;
+	IH_YCoCg3 = IH_scalar_YCoCg;
+	IH_YCoCg4 = IH_scalar_YCoCg;
+	IH_kernel_name = "scalar";
+	#if IH_X86_SIMD
+	if( enable )
+	{
+		__builtin_cpu_init();
+		if( __builtin_cpu_supports( "avx2" ) )
+		{
+			IH_upscale = IH_upscale_AVX2;
+			IH_NTSC = IH_NTSC_AVX2;
+			IH_YCoCg3 = IH_YCoCg3_AVX2;
+			IH_YCoCg4 = IH_YCoCg4_AVX2;
+			IH_kernel_name = "AVX2";
+		} else if( __builtin_cpu_supports( "sse2" ) )
+		{
+			IH_upscale = IH_upscale_SSE2;
+			IH_NTSC = IH_NTSC_SSE2;
+			IH_YCoCg4 = IH_YCoCg4_SSE2;
+			IH_kernel_name = "SSE2";
+		}
+	}
+	#else
+	(void)enable;
+	#endif
+	IH_kernel_selected = 1;
+	return IH_kernel_name;
+}
+
+void set_image_helper_threads( int threads )
+{
+	IH_thread_count = (threads < 0) ? 0 : threads;
+}
+
+/********* Threads *********/
+/*	runs the units [begin,end) of the job ctx	*/
+static void IH_run_range( void *ctx, int begin, int end )
+{
+	IH_job range = *(const IH_job*)ctx;
+	range.begin = begin;
+	range.end = end;
+	range.run( &range );
+}
+
+/*
+	Splits [0,units) of the job across threads, each unit
+	produces unit_bytes bytes; small images are not worth it.
+*/
+static void run_IH_job( const IH_job *job, int units, int unit_bytes )
+{
+	if( !IH_kernel_selected )
+	{
+		set_image_helper_SIMD( 1 );
+	}
+	soil_parallel_for( units, (IH_MIN_BYTES_PER_THREAD + unit_bytes - 1) / unit_bytes,
+			IH_thread_count, IH_run_range, (void*)job );
+}
+
+/********* Up Scaling *********/
+static void up_scale_rows( const IH_job *job )
+{
+	const int ch = job->channels;
+	const int row = job->width * ch;
+	/*	a 1 pixel wide or high image samples that pixel twice	*/
+	const int right = (job->width > 1) ? ch : 0;
+	const int below = (job->height > 1) ? row : 0;
+	int x, y, c;
+	for( y = job->begin; y < job->end; ++y )
+	{
+		/* find the base y index and fractional offset from that	*/
+		float sampley = y * job->dy;
+		int inty = (int)sampley;
+		const unsigned char *row0, *row1;
+		unsigned char *out = job->out + (size_t)y * job->out_width * ch;
+		float wy0, wy1;
+		if( inty > job->height - 2 ) { inty = job->height - 2; }
+		if( inty < 0 ) { inty = 0; }
+		sampley -= inty;
+		wy0 = 1.0f - sampley;
+		wy1 = sampley;
+		row0 = job->orig + (size_t)inty * row;
+		row1 = row0 + below;
+		x = (ch == 4 && right) ? IH_upscale( row0, row1, job->x_offset, job->x_weight, wy0, wy1, out, job->out_width ) : 0;
+		for( ; x < job->out_width; ++x )
+		{
+			const int base_index = job->x_offset[x];
+			const float wx0 = job->x_weight[2*x];
+			const float wx1 = job->x_weight[2*x+1];
+			for ( c = 0; c < ch; ++c )
+			{
+				/*	do the sampling	*/
+				float value = 0.5f;
+				value += row0[base_index+c] * wx0 * wy0;
+				value += row0[base_index+c+right] * wx1 * wy0;
+				value += row1[base_index+c] * wx0 * wy1;
+				value += row1[base_index+c+right] * wx1 * wy1;
+				/*	save the new value	*/
+				out[x*ch+c] = (unsigned char)(value);
+			}
+		}
+	}
+}
+
 /*	Upscaling the image uses simple bilinear interpolation	*/
 int
 	up_scale_image
@@ -20,8 +477,11 @@ int
 		int resampled_width, int resampled_height
 	)
 {
-	float dx, dy;
-	int x, y, c;
+	IH_job job;
+	int *x_offset;
+	float *x_weight;
+	float dx;
+	int x;
 
     /* error(s) check	*/
     if ( 	(width < 1) || (height < 1) ||
@@ -32,51 +492,46 @@ int
         /*	signify badness	*/
         return 0;
     }
-    /*
+	/*
 		for each given pixel in the new map, find the exact location
 		from the original map which would contribute to this guy
+		(the columns are the same for every row, so look them up once)
 	*/
-    dx = (width - 1.0f) / (resampled_width - 1.0f);
-    dy = (height - 1.0f) / (resampled_height - 1.0f);
-    for ( y = 0; y < resampled_height; ++y )
-    {
-    	/* find the base y index and fractional offset from that	*/
-    	float sampley = y * dy;
-    	int inty = (int)sampley;
-    	/*	if( inty < 0 ) { inty = 0; } else	*/
-		if( inty > height - 2 ) { inty = height - 2; }
-		sampley -= inty;
-        for ( x = 0; x < resampled_width; ++x )
-        {
-			float samplex = x * dx;
-			int intx = (int)samplex;
-			int base_index;
-			/* find the base x index and fractional offset from that	*/
-			/*	if( intx < 0 ) { intx = 0; } else	*/
-			if( intx > width - 2 ) { intx = width - 2; }
-			samplex -= intx;
-			/*	base index into the original image	*/
-			base_index = (inty * width + intx) * channels;
-            for ( c = 0; c < channels; ++c )
-            {
-            	/*	do the sampling	*/
-				float value = 0.5f;
-				value += orig[base_index]
-							*(1.0f-samplex)*(1.0f-sampley);
-				value += orig[base_index+channels]
-							*(samplex)*(1.0f-sampley);
-				value += orig[base_index+width*channels]
-							*(1.0f-samplex)*(sampley);
-				value += orig[base_index+width*channels+channels]
-							*(samplex)*(sampley);
-				/*	move to the next channel	*/
-				++base_index;
-            	/*	save the new value	*/
-            	resampled[y*resampled_width*channels+x*channels+c] =
-						(unsigned char)(value);
-            }
-        }
-    }
+	x_offset = (int*)malloc( resampled_width * sizeof(int) );
+	x_weight = (float*)malloc( 2 * resampled_width * sizeof(float) );
+	if( (NULL == x_offset) || (NULL == x_weight) )
+	{
+		free( x_offset );
+		free( x_weight );
+		return 0;
+	}
+	dx = (width - 1.0f) / (resampled_width - 1.0f);
+	for( x = 0; x < resampled_width; ++x )
+	{
+		/* find the base x index and fractional offset from that	*/
+		float samplex = x * dx;
+		int intx = (int)samplex;
+		if( intx > width - 2 ) { intx = width - 2; }
+		if( intx < 0 ) { intx = 0; }
+		samplex -= intx;
+		x_offset[x] = intx * channels;
+		x_weight[2*x] = 1.0f - samplex;
+		x_weight[2*x+1] = samplex;
+	}
+	job.run = up_scale_rows;
+	job.orig = orig;
+	job.out = resampled;
+	job.width = width;
+	job.height = height;
+	job.channels = channels;
+	job.out_width = resampled_width;
+	job.out_height = resampled_height;
+	job.dy = (height - 1.0f) / (resampled_height - 1.0f);
+	job.x_offset = x_offset;
+	job.x_weight = x_weight;
+	run_IH_job( &job, resampled_height, resampled_width * channels );
+	free( x_offset );
+	free( x_weight );
     /*	done	*/
     return 1;
 }
@@ -151,6 +606,30 @@ int
 	return 1;
 }
 
+static void NTSC_safe_pixels( const IH_job *job )
+{
+	const int nc = job->channels - (1 - (job->channels & 1));
+	unsigned char *img = job->out + (size_t)job->begin * job->channels;
+	const int count = (job->end - job->begin) * job->channels;
+	int i, j;
+	/*	for channels = 2 or 4, ignore the alpha component	*/
+	for( i = IH_NTSC( img, count, job->channels ); (i < count) && (i % job->channels); ++i )
+	{
+		/*	finish the pixel the vectorized part stopped in	*/
+		if( i % job->channels < nc )
+		{
+			img[i] = (unsigned char)((img[i] * IH_NTSC_MUL + IH_NTSC_ADD) >> IH_NTSC_SHIFT);
+		}
+	}
+	for( ; i < count; i += job->channels )
+	{
+		for( j = 0; j < nc; ++j )
+		{
+			img[i+j] = (unsigned char)((img[i+j] * IH_NTSC_MUL + IH_NTSC_ADD) >> IH_NTSC_SHIFT);
+		}
+	}
+}
+
 int
 	scale_image_RGB_to_NTSC_safe
 	(
@@ -158,11 +637,7 @@ int
 		int width, int height, int channels
 	)
 {
-	const float scale_lo = 16.0f - 0.499f;
-	const float scale_hi = 235.0f + 0.499f;
-	int i, j;
-	int nc = channels;
-	unsigned char scale_LUT[256];
+	IH_job job;
 	/*	error check	*/
 	if( (width < 1) || (height < 1) ||
 		(channels < 1) || (orig == NULL) )
@@ -170,26 +645,58 @@ int
 		/*	nothing to do	*/
 		return 0;
 	}
-	/*	set up the scaling Look Up Table	*/
-	for( i = 0; i < 256; ++i )
-	{
-		scale_LUT[i] = (unsigned char)((scale_hi - scale_lo) * i / 255.0f + scale_lo);
-	}
-	/*	for channels = 2 or 4, ignore the alpha component	*/
-	nc -= 1 - (channels & 1);
 	/*	OK, go through the image and scale any non-alpha components	*/
-	for( i = 0; i < width*height*channels; i += channels )
+	memset( &job, 0, sizeof(job) );
+	job.run = NTSC_safe_pixels;
+	job.out = orig;
+	job.channels = channels;
+	run_IH_job( &job, width * height, channels );
+	return 1;
+}
+
+unsigned char clamp_byte( int x ) { return ( (x) < 0 ? (0) : ( (x) > 255 ? 255 : (x) ) ); }
+
+static void RGB_to_YCoCg_pixels( const IH_job *job )
+{
+	unsigned char *img = job->out + (size_t)job->begin * job->channels;
+	const int count = job->end - job->begin;
+	int i;
+	if( job->channels == 3 )
 	{
-		for( j = 0; j < nc; ++j )
+		for( i = 3 * IH_YCoCg3( img, count ); i < count*3; i += 3 )
 		{
-			orig[i+j] = scale_LUT[orig[i+j]];
+			int r = img[i+0];
+			int g = (img[i+1] + 1) >> 1;
+			int b = img[i+2];
+			int tmp = (2 + r + b) >> 2;
+			/*	Co	*/
+			img[i+0] = clamp_byte( 128 + ((r - b + 1) >> 1) );
+			/*	Y	*/
+			img[i+1] = clamp_byte( g + tmp );
+			/*	Cg	*/
+			img[i+2] = clamp_byte( 128 + g - tmp );
+		}
+	} else
+	{
+		for( i = 4 * IH_YCoCg4( img, count ); i < count*4; i += 4 )
+		{
+			int r = img[i+0];
+			int g = (img[i+1] + 1) >> 1;
+			int b = img[i+2];
+			unsigned char a = img[i+3];
+			int tmp = (2 + r + b) >> 2;
+			/*	Co	*/
+			img[i+0] = clamp_byte( 128 + ((r - b + 1) >> 1) );
+			/*	Cg	*/
+			img[i+1] = clamp_byte( 128 + g - tmp );
+			/*	Alpha	*/
+			img[i+2] = a;
+			/*	Y	*/
+			img[i+3] = clamp_byte( g + tmp );
 		}
 	}
-	return 1;
 }
 
-unsigned char clamp_byte( int x ) { return ( (x) < 0 ? (0) : ( (x) > 255 ? 255 : (x) ) ); }
-
 /*
 	This function takes the RGB components of the image
 	and converts them into YCoCg.  3 components will be
@@ -204,7 +711,7 @@ int
 		int width, int height, int channels
 	)
 {
-	int i;
+	IH_job job;
 	/*	error check	*/
 	if( (width < 1) || (height < 1) ||
 		(channels < 3) || (channels > 4) ||
@@ -214,40 +721,11 @@ int
 		return -1;
 	}
 	/*	do the conversion	*/
-	if( channels == 3 )
-	{
-		for( i = 0; i < width*height*3; i += 3 )
-		{
-			int r = orig[i+0];
-			int g = (orig[i+1] + 1) >> 1;
-			int b = orig[i+2];
-			int tmp = (2 + r + b) >> 2;
-			/*	Co	*/
-			orig[i+0] = clamp_byte( 128 + ((r - b + 1) >> 1) );
-			/*	Y	*/
-			orig[i+1] = clamp_byte( g + tmp );
-			/*	Cg	*/
-			orig[i+2] = clamp_byte( 128 + g - tmp );
-		}
-	} else
-	{
-		for( i = 0; i < width*height*4; i += 4 )
-		{
-			int r = orig[i+0];
-			int g = (orig[i+1] + 1) >> 1;
-			int b = orig[i+2];
-			unsigned char a = orig[i+3];
-			int tmp = (2 + r + b) >> 2;
-			/*	Co	*/
-			orig[i+0] = clamp_byte( 128 + ((r - b + 1) >> 1) );
-			/*	Cg	*/
-			orig[i+1] = clamp_byte( 128 + g - tmp );
-			/*	Alpha	*/
-			orig[i+2] = a;
-			/*	Y	*/
-			orig[i+3] = clamp_byte( g + tmp );
-		}
-	}
+	memset( &job, 0, sizeof(job) );
+	job.run = RGB_to_YCoCg_pixels;
+	job.out = orig;
+	job.channels = channels;
+	run_IH_job( &job, width * height, channels );
 	/*	done	*/
 	return 0;
 }
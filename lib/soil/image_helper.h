@@ -108,6 +108,33 @@ int
 		int rescale_to_max
 	);
 
+/**
+	Selects the kernels of up_scale_image (RGBA images),
+	scale_image_RGB_to_NTSC_safe and convert_RGB_to_YCoCg.
+	enable = 0 picks the scalar versions, otherwise the widest
+	SIMD versions the CPU supports are used (AVX2 or SSE2), which
+	is also the default.  Every version gives identical results.
+	Not thread safe, call before transforming images.
+	\return the name of the kernels now in use
+**/
+const char*
+	set_image_helper_SIMD
+	(
+		int enable
+	);
+
+/**
+	Sets the number of threads the functions above split an image
+	across.  0 = one per processor (the default), 1 = the calling
+	thread only.  Small images always use fewer threads.
+	Not thread safe, call before transforming images.
+**/
+void
+	set_image_helper_threads
+	(
+		int threads
+	);
+
 #ifdef __cplusplus
 }
 #endif
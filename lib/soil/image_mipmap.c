@@ -0,0 +1,338 @@
+/*
+	Mipmap chain generation
+
+	MIT license
+*/
+
+#include "image_mipmap.h"
+#include "soil_parallel.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#define MIP_X86_SIMD	1
+#include <immintrin.h>
+#else
+#define MIP_X86_SIMD	0
+#endif
+
+/*	output pixels a thread has to compute at least to be worth starting	*/
+#define MIP_MIN_PIXELS_PER_THREAD	(64*1024)
+
+/*	a level to compute, split across threads by output rows	*/
+typedef struct
+{
+	const unsigned char *src;
+	int width, height, channels;
+	int srgb;
+	unsigned char *dst;
+	int dst_width;
+} MIP_job;
+
+/*
+	reduces count RGBA pixel pairs of the rows s0 and s1 to d,
+	returns how many output pixels were done (the rest is left
+	to the scalar loop)
+*/
+typedef int (*MIP_row_kernel)(
+		const unsigned char *s0, const unsigned char *s1,
+		unsigned char *d, int count );
+
+static int MIP_scalar_kernel(
+		const unsigned char *s0, const unsigned char *s1,
+		unsigned char *d, int count )
+{
+	(void)s0;
+	(void)s1;
+	(void)d;
+	(void)count;
+	return 0;
+}
+
+static MIP_row_kernel MIP_kernel = MIP_scalar_kernel;
+static MIP_row_kernel MIP_linear_kernel = MIP_scalar_kernel;
+static const char *MIP_kernel_name = "scalar";
+static int MIP_kernel_selected = 0;
+/*	0 = one thread per processor	*/
+static int MIP_thread_count = 0;
+
+/*
+	sRGB <-> linear tables: 8 bit sRGB to 16 bit linear, and 16 bit
+	linear back to 8 bit sRGB (padded so a 32 bit gather of the last
+	entry stays inside the table)
+*/
+static int MIP_to_linear[256];
+static unsigned char MIP_to_srgb[65536 + 3];
+static int MIP_tables_built = 0;
+
+static void build_MIP_tables( void )
+{
+	int i;
+	for( i = 0; i < 256; ++i )
+	{
+		double c = i / 255.0;
+		c = (c <= 0.04045) ? c / 12.92 : pow( (c + 0.055) / 1.055, 2.4 );
+		MIP_to_linear[i] = (int)(c * 65535.0 + 0.5);
+	}
+	for( i = 0; i < 65536; ++i )
+	{
+		double l = i / 65535.0;
+		l = (l <= 0.0031308) ? l * 12.92 : 1.055 * pow( l, 1.0 / 2.4 ) - 0.055;
+		MIP_to_srgb[i] = (unsigned char)(l * 255.0 + 0.5);
+	}
+	MIP_tables_built = 1;
+}
+
+#if MIP_X86_SIMD
+/*	SSE2: 2 output pixels per iteration	*/
+__attribute__((target("sse2")))
+static int MIP_box_SSE2(
+		const unsigned char *s0, const unsigned char *s1,
+		unsigned char *d, int count )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i two = _mm_set1_epi16( 2 );
+	int i;
+	for( i = 0; i + 2 <= count; i += 2 )
+	{
+		__m128i a = _mm_loadu_si128( (const __m128i*)(s0 + i*8) );
+		__m128i b = _mm_loadu_si128( (const __m128i*)(s1 + i*8) );
+		/*	vertical sums of pixels 0,1 and 2,3	*/
+		__m128i lo = _mm_add_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) );
+		__m128i hi = _mm_add_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) );
+		/*	horizontal: pixel 0 + 1, pixel 2 + 3	*/
+		__m128i sum = _mm_add_epi16(
+				_mm_unpacklo_epi64( lo, hi ),
+				_mm_unpackhi_epi64( lo, hi ) );
+		sum = _mm_srli_epi16( _mm_add_epi16( sum, two ), 2 );
+		_mm_storel_epi64( (__m128i*)(d + i*4), _mm_packus_epi16( sum, sum ) );
+	}
+	return i;
+}
+
+/*	AVX2: 4 output pixels per iteration	*/
+__attribute__((target("avx2")))
+static int MIP_box_AVX2(
+		const unsigned char *s0, const unsigned char *s1,
+		unsigned char *d, int count )
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i two = _mm256_set1_epi16( 2 );
+	int i;
+	for( i = 0; i + 4 <= count; i += 4 )
+	{
+		__m256i a = _mm256_loadu_si256( (const __m256i*)(s0 + i*8) );
+		__m256i b = _mm256_loadu_si256( (const __m256i*)(s1 + i*8) );
+		/*	per 128 bit lane, exactly as the SSE2 version	*/
+		__m256i lo = _mm256_add_epi16( _mm256_unpacklo_epi8( a, zero ), _mm256_unpacklo_epi8( b, zero ) );
+		__m256i hi = _mm256_add_epi16( _mm256_unpackhi_epi8( a, zero ), _mm256_unpackhi_epi8( b, zero ) );
+		__m256i sum = _mm256_add_epi16(
+				_mm256_unpacklo_epi64( lo, hi ),
+				_mm256_unpackhi_epi64( lo, hi ) );
+		sum = _mm256_srli_epi16( _mm256_add_epi16( sum, two ), 2 );
+		sum = _mm256_packus_epi16( sum, sum );
+		/*	pixels 0,1 are in the low, 2,3 in the high lane	*/
+		sum = _mm256_permute4x64_epi64( sum, 0x08 );
+		_mm_storeu_si128( (__m128i*)(d + i*4), _mm256_castsi256_si128( sum ) );
+	}
+	return i;
+}
+
+/*	AVX2, linear space: 2 output pixels per iteration	*/
+__attribute__((target("avx2")))
+static int MIP_linear_AVX2(
+		const unsigned char *s0, const unsigned char *s1,
+		unsigned char *d, int count )
+{
+	const __m256i two = _mm256_set1_epi32( 2 );
+	const __m256i byte = _mm256_set1_epi32( 0xFF );
+	int i;
+	for( i = 0; i + 2 <= count; i += 2 )
+	{
+		/*	reorder to pixels 0,2,1,3 so the low halves hold
+			the left and the high halves the right pixels	*/
+		__m128i a = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i*)(s0 + i*8) ), 0xD8 );
+		__m128i b = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i*)(s1 + i*8) ), 0xD8 );
+		__m256i a0 = _mm256_cvtepu8_epi32( a );
+		__m256i a1 = _mm256_cvtepu8_epi32( _mm_srli_si128( a, 8 ) );
+		__m256i b0 = _mm256_cvtepu8_epi32( b );
+		__m256i b1 = _mm256_cvtepu8_epi32( _mm_srli_si128( b, 8 ) );
+		__m256i alpha = _mm256_add_epi32( _mm256_add_epi32( a0, a1 ), _mm256_add_epi32( b0, b1 ) );
+		__m256i lin = _mm256_add_epi32(
+				_mm256_add_epi32( _mm256_i32gather_epi32( MIP_to_linear, a0, 4 ), _mm256_i32gather_epi32( MIP_to_linear, a1, 4 ) ),
+				_mm256_add_epi32( _mm256_i32gather_epi32( MIP_to_linear, b0, 4 ), _mm256_i32gather_epi32( MIP_to_linear, b1, 4 ) ) );
+		__m256i color;
+		__m128i packed;
+		alpha = _mm256_srli_epi32( _mm256_add_epi32( alpha, two ), 2 );
+		lin = _mm256_srli_epi32( _mm256_add_epi32( lin, two ), 2 );
+		color = _mm256_and_si256( _mm256_i32gather_epi32( (const int*)MIP_to_srgb, lin, 1 ), byte );
+		/*	every 4th lane is alpha	*/
+		color = _mm256_blend_epi32( color, alpha, 0x88 );
+		packed = _mm_packus_epi32( _mm256_castsi256_si128( color ), _mm256_extracti128_si256( color, 1 ) );
+		_mm_storel_epi64( (__m128i*)(d + i*4), _mm_packus_epi16( packed, packed ) );
+	}
+	return i;
+}
+#endif
+
+const char* set_mipmap_SIMD( int enable )
+{
+	if( !MIP_tables_built )
+	{
+		build_MIP_tables();
+	}
+	MIP_kernel = MIP_scalar_kernel;
+	MIP_linear_kernel = MIP_scalar_kernel;
+	MIP_kernel_name = "scalar";
+	#if MIP_X86_SIMD
+	if( enable )
+	{
+		__builtin_cpu_init();
+		if( __builtin_cpu_supports( "avx2" ) )
+		{
+			MIP_kernel = MIP_box_AVX2;
+			MIP_linear_kernel = MIP_linear_AVX2;
+			MIP_kernel_name = "AVX2";
+		} else if( __builtin_cpu_supports( "sse2" ) )
+		{
+			MIP_kernel = MIP_box_SSE2;
+			MIP_kernel_name = "SSE2";
+		}
+	}
+	#else
+	(void)enable;
+	#endif
+	MIP_kernel_selected = 1;
+	return MIP_kernel_name;
+}
+
+void set_mipmap_threads( int threads )
+{
+	MIP_thread_count = (threads < 0) ? 0 : threads;
+}
+
+/********* Level Reduction *********/
+static void reduce_MIP_rows( void *ctx, int row_begin, int row_end )
+{
+	const MIP_job *job = (const MIP_job*)ctx;
+	const int ch = job->channels;
+	/*	a 1 pixel wide or high level averages that pixel with itself,
+		which rounds exactly as a 1x2 or 2x1 block would	*/
+	const int dx = (job->width > 1) ? ch : 0;
+	const int row = job->width * ch;
+	const int linear = job->srgb && (ch >= 3);
+	const MIP_row_kernel kernel = (ch != 4 || !dx) ? MIP_scalar_kernel :
+			(linear ? MIP_linear_kernel : MIP_kernel);
+	int j, i, c;
+	for( j = row_begin; j < row_end; ++j )
+	{
+		const unsigned char *s0 = job->src + (size_t)(2*j) * row;
+		const unsigned char *s1 = (job->height > 1) ? s0 + row : s0;
+		unsigned char *d = job->dst + (size_t)j * job->dst_width * ch;
+		i = kernel( s0, s1, d, job->dst_width );
+		s0 += i * 2 * ch;
+		s1 += i * 2 * ch;
+		d += i * ch;
+		for( ; i < job->dst_width; ++i )
+		{
+			for( c = 0; c < ch; ++c )
+			{
+				if( linear && (c < 3) )
+				{
+					d[c] = MIP_to_srgb[(MIP_to_linear[s0[c]] + MIP_to_linear[s0[c+dx]] +
+							MIP_to_linear[s1[c]] + MIP_to_linear[s1[c+dx]] + 2) >> 2];
+				} else
+				{
+					d[c] = (unsigned char)((s0[c] + s0[c+dx] + s1[c] + s1[c+dx] + 2) >> 2);
+				}
+			}
+			s0 += 2 * ch;
+			s1 += 2 * ch;
+			d += ch;
+		}
+	}
+}
+
+/*	box filters src (width x height) into the next level dst	*/
+static void reduce_MIP_level(
+		const unsigned char *src,
+		int width, int height, int channels,
+		int srgb, unsigned char *dst )
+{
+	MIP_job job;
+	job.src = src;
+	job.width = width;
+	job.height = height;
+	job.channels = channels;
+	job.srgb = srgb;
+	job.dst = dst;
+	job.dst_width = (width > 1) ? width / 2 : 1;
+	/*	split the rows across threads, small levels are not worth it	*/
+	soil_parallel_for( (height > 1) ? height / 2 : 1,
+			(MIP_MIN_PIXELS_PER_THREAD + job.dst_width - 1) / job.dst_width,
+			MIP_thread_count, reduce_MIP_rows, &job );
+}
+
+/********* Chains *********/
+int mipmap_chain_levels( int width, int height )
+{
+	int levels = 1;
+	if( (width < 1) || (height < 1) )
+	{
+		return 0;
+	}
+	while( (width > 1) || (height > 1) )
+	{
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+		++levels;
+	}
+	return levels;
+}
+
+size_t mipmap_chain_size( int width, int height, int channels )
+{
+	size_t size = 0;
+	if( (width < 1) || (height < 1) || (channels < 1) )
+	{
+		return 0;
+	}
+	for( ;; )
+	{
+		size += (size_t)width * height * channels;
+		if( (width == 1) && (height == 1) )
+		{
+			return size;
+		}
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+	}
+}
+
+int mipmap_chain( unsigned char* chain, int width, int height, int channels, int srgb )
+{
+	int levels = 1;
+	/*	error check	*/
+	if( (width < 1) || (height < 1) ||
+		(channels < 1) || (channels > 4) ||
+		(chain == NULL) )
+	{
+		return 0;
+	}
+	if( !MIP_kernel_selected )
+	{
+		set_mipmap_SIMD( 1 );
+	}
+	/*	every level is filtered from the one just above it	*/
+	while( (width > 1) || (height > 1) )
+	{
+		unsigned char *next = chain + (size_t)width * height * channels;
+		reduce_MIP_level( chain, width, height, channels, srgb, next );
+		chain = next;
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+		++levels;
+	}
+	return levels;
+}
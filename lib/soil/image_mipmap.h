@@ -0,0 +1,85 @@
+/*
+	Mipmap chain generation
+
+	MIT license
+*/
+
+#ifndef HEADER_IMAGE_MIPMAP
+#define HEADER_IMAGE_MIPMAP
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+	The number of levels of a complete mipmap chain, level 0 and every
+	level down to 1x1 (each level is half the size of the one above,
+	rounded down, but at least 1).
+**/
+int
+	mipmap_chain_levels
+	(
+		int width, int height
+	);
+
+/**
+	The size in bytes of a complete mipmap chain, all levels
+	stored one after another, level 0 first.
+**/
+size_t
+	mipmap_chain_size
+	(
+		int width, int height, int channels
+	);
+
+/**
+	Builds a complete mipmap chain in place.  chain has to hold
+	mipmap_chain_size() bytes and start with level 0, every following
+	level is filled in as the 2x2 box filtered previous level
+	(odd last rows and columns are dropped, exactly as mipmap_image
+	with 2x2 blocks does).  With srgb != 0 the color channels of RGB
+	and RGBA images are averaged in linear space, alpha always is
+	averaged as stored.  Large levels are split across threads.
+	\return the number of levels in the chain, 0 if failed
+**/
+int
+	mipmap_chain
+	(
+		unsigned char* chain,
+		int width, int height, int channels,
+		int srgb
+	);
+
+/**
+	Selects the 2x2 reduction kernels for 4 channel images.
+	enable = 0 picks the scalar version, otherwise the widest SIMD
+	version the CPU supports is used (AVX2 or SSE2), which is also
+	the default.  Other channel counts always use the scalar version.
+	Not thread safe, call before building chains.
+	\return the name of the kernels now in use
+**/
+const char*
+	set_mipmap_SIMD
+	(
+		int enable
+	);
+
+/**
+	Sets the number of threads the rows of a level are split across.
+	0 = one per processor (the default), 1 = the calling thread only.
+	Small levels always use fewer threads.
+	Not thread safe, call before building chains.
+**/
+void
+	set_mipmap_threads
+	(
+		int threads
+	);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEADER_IMAGE_MIPMAP	*/
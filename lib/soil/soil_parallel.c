@@ -0,0 +1,127 @@
+/*
+	Splitting work across threads, shared by the image functions
+
+	MIT license
+*/
+
+#include "soil_parallel.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/*	one thread's range of the work	*/
+typedef struct
+{
+	soil_parallel_fn fn;
+	void *ctx;
+	int begin, end;
+} SOIL_range;
+
+#ifdef _WIN32
+static DWORD WINAPI SOIL_thread_main( LPVOID range )
+{
+	const SOIL_range *r = (const SOIL_range*)range;
+	r->fn( r->ctx, r->begin, r->end );
+	return 0;
+}
+#else
+static void* SOIL_thread_main( void *range )
+{
+	const SOIL_range *r = (const SOIL_range*)range;
+	r->fn( r->ctx, r->begin, r->end );
+	return NULL;
+}
+#endif
+
+int soil_processor_count( void )
+{
+	#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	return (info.dwNumberOfProcessors > 0) ? (int)info.dwNumberOfProcessors : 1;
+	#else
+	long count = sysconf( _SC_NPROCESSORS_ONLN );
+	return (count > 0) ? (int)count : 1;
+	#endif
+}
+
+void soil_parallel_for( int units, int min_units, int threads, soil_parallel_fn fn, void *ctx )
+{
+	SOIL_range ranges[SOIL_MAX_THREADS];
+	int t, units_per_thread;
+	if( units < 1 )
+	{
+		return;
+	}
+	if( min_units < 1 )
+	{
+		min_units = 1;
+	}
+	if( threads < 1 )
+	{
+		threads = soil_processor_count();
+	}
+	if( threads > SOIL_MAX_THREADS )
+	{
+		threads = SOIL_MAX_THREADS;
+	}
+	/*	small ranges are not worth starting a thread for	*/
+	if( units / min_units < threads )
+	{
+		threads = units / min_units;
+	}
+	if( threads < 1 )
+	{
+		threads = 1;
+	}
+	if( threads == 1 )
+	{
+		fn( ctx, 0, units );
+		return;
+	}
+	units_per_thread = (units + threads - 1) / threads;
+	threads = (units + units_per_thread - 1) / units_per_thread;
+	for( t = 0; t < threads; ++t )
+	{
+		ranges[t].fn = fn;
+		ranges[t].ctx = ctx;
+		ranges[t].begin = t * units_per_thread;
+		ranges[t].end = (t+1) * units_per_thread < units ? (t+1) * units_per_thread : units;
+	}
+	{
+		/*	the calling thread takes the first range, and any a thread could not be started for	*/
+		#ifdef _WIN32
+		HANDLE handles[SOIL_MAX_THREADS];
+		#else
+		pthread_t handles[SOIL_MAX_THREADS];
+		#endif
+		int started[SOIL_MAX_THREADS];
+		for( t = 1; t < threads; ++t )
+		{
+			#ifdef _WIN32
+			handles[t] = CreateThread( NULL, 0, SOIL_thread_main, &ranges[t], 0, NULL );
+			started[t] = (handles[t] != NULL);
+			#else
+			started[t] = (pthread_create( &handles[t], NULL, SOIL_thread_main, &ranges[t] ) == 0);
+			#endif
+		}
+		fn( ctx, ranges[0].begin, ranges[0].end );
+		for( t = 1; t < threads; ++t )
+		{
+			if( !started[t] )
+			{
+				fn( ctx, ranges[t].begin, ranges[t].end );
+				continue;
+			}
+			#ifdef _WIN32
+			WaitForSingleObject( handles[t], INFINITE );
+			CloseHandle( handles[t] );
+			#else
+			pthread_join( handles[t], NULL );
+			#endif
+		}
+	}
+}
@@ -0,0 +1,50 @@
+/*
+	Splitting work across threads, shared by the image functions
+
+	MIT license
+*/
+
+#ifndef HEADER_SOIL_PARALLEL
+#define HEADER_SOIL_PARALLEL
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**	most threads a range of work is split across	**/
+#define SOIL_MAX_THREADS	64
+
+/**
+	Does the units [begin,end) of the work described by ctx.
+**/
+typedef void (*soil_parallel_fn)( void *ctx, int begin, int end );
+
+/**
+	The number of processors, at least 1.
+**/
+int
+	soil_processor_count
+	(
+		void
+	);
+
+/**
+	Splits the units [0,units) into one contiguous range per thread
+	and calls fn for every range, returns when all are done.  threads
+	is the number of threads to use, 0 = one per processor; fewer are
+	used when a thread would get less than min_units units.  The
+	calling thread does the first range, and every range a thread
+	could not be started for.
+**/
+void
+	soil_parallel_for
+	(
+		int units, int min_units, int threads,
+		soil_parallel_fn fn, void *ctx
+	);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEADER_SOIL_PARALLEL	*/
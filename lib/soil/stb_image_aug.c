@@ -94,6 +94,11 @@ typedef   signed short  int16;
 typedef unsigned int   uint32;
 typedef   signed int    int32;
 typedef unsigned int   uint;
+#ifdef _MSC_VER
+typedef unsigned __int64 uint64;
+#else
+typedef unsigned long long uint64;
+#endif
 
 // should produce compiler error if size is wrong
 typedef unsigned char validate_uint32[sizeof(uint32)==4];
@@ -106,6 +111,15 @@ typedef unsigned char validate_uint32[sizeof(uint32)==4];
 #include "stbi_DDS_aug.h"
 #endif
 
+// 16 byte alignment of blocks passed to the installable IDCT
+#if STBI_SIMD && defined(_MSC_VER)
+#define STBI_SIMD_ALIGN(type, name)   __declspec(align(16)) type name
+#elif STBI_SIMD && defined(__GNUC__)
+#define STBI_SIMD_ALIGN(type, name)   type name __attribute__((aligned(16)))
+#else
+#define STBI_SIMD_ALIGN(type, name)   type name
+#endif
+
 //	I (JLD) want full messages for SOIL
 #define STBI_FAILURE_USERMSG 1
 
@@ -114,8 +128,16 @@ typedef unsigned char validate_uint32[sizeof(uint32)==4];
 // Generic API that works on all image types
 //
 
-// this is not threadsafe
-static char *failure_reason;
+// one per thread, so concurrent decoders each report their own failure;
+// probing for the image type sets it even when decoding then succeeds
+#if defined(_MSC_VER)
+#define STBI_THREAD_LOCAL   __declspec(thread)
+#elif defined(__GNUC__)
+#define STBI_THREAD_LOCAL   __thread
+#else
+#define STBI_THREAD_LOCAL
+#endif
+static STBI_THREAD_LOCAL char *failure_reason;
 
 char *stbi_failure_reason(void)
 {
@@ -980,7 +1002,7 @@ static stbi_idct_8x8 stbi_idct_installed = idct_block;
 
 extern void stbi_install_idct(stbi_idct_8x8 func)
 {
-   stbi_idct_installed = func;
+   stbi_idct_installed = func ? func : idct_block;
 }
 #endif
 
@@ -1022,10 +1044,7 @@ static int parse_entropy_coded_data(jpeg *z)
    reset(z);
    if (z->scan_n == 1) {
       int i,j;
-      #if STBI_SIMD
-      __declspec(align(16))
-      #endif
-      short data[64];
+      STBI_SIMD_ALIGN(short, data[64]);
       int n = z->order[0];
       // non-interleaved data, we just need to process one block at a time,
       // in trivial scanline order
@@ -1053,7 +1072,7 @@ static int parse_entropy_coded_data(jpeg *z)
       }
    } else { // interleaved!
       int i,j,k,x,y;
-      short data[64];
+      STBI_SIMD_ALIGN(short, data[64]);
       for (j=0; j < z->img_mcu_y; ++j) {
          for (i=0; i < z->img_mcu_x; ++i) {
             // scan an interleaved mcu... process scan_n components in order
@@ -1116,7 +1135,7 @@ static int process_marker(jpeg *z, int m)
                z->dequant[t][dezigzag[i]] = get8u(&z->s);
             #if STBI_SIMD
             for (i=0; i < 64; ++i)
-               z->dequant2[t][i] = dequant[t][i];
+               z->dequant2[t][i] = z->dequant[t][i];
             #endif
             L -= 65;
          }
@@ -1382,7 +1401,7 @@ static uint8 *resample_row_generic(uint8 *out, uint8 *in_near, uint8 *in_far, in
 
 // 0.38 seconds on 3*anemones.jpg   (0.25 with processor = Pro)
 // VC6 without processor=Pro is generating multiple LEAs per multiply!
-static void YCbCr_to_RGB_row(uint8 *out, uint8 *y, uint8 *pcb, uint8 *pcr, int count, int step)
+static void YCbCr_to_RGB_row(uint8 *out, uint8 const *y, uint8 const *pcb, uint8 const *pcr, int count, int step)
 {
    int i;
    for (i=0; i < count; ++i) {
@@ -1412,7 +1431,7 @@ static stbi_YCbCr_to_RGB_run stbi_YCbCr_installed = YCbCr_to_RGB_row;
 
 void stbi_install_YCbCr_to_RGB(stbi_YCbCr_to_RGB_run func)
 {
-   stbi_YCbCr_installed = func;
+   stbi_YCbCr_installed = func ? func : YCbCr_to_RGB_row;
 }
 #endif
 
@@ -1601,17 +1620,23 @@ extern int      stbi_jpeg_info_from_memory(stbi_uc const *buffer, int len, int *
 //      - all input must be provided in an upfront buffer
 //      - all output is written to a single output buffer (can malloc/realloc)
 //    performance
-//      - fast huffman
+//      - fast huffman, 64-bit bit buffer refilled a word at a time
+//      - literal/length table decodes up to two literals per lookup
 
 // fast-way is faster to check than jpeg huffman, but slow way is slower
-#define ZFAST_BITS  9 // accelerate all cases in default tables
+#define ZFAST_BITS  10 // accelerate all cases in default tables
 #define ZFAST_MASK  ((1 << ZFAST_BITS) - 1)
 
+// fast table entries: bits 0-7 code length, 16-31 symbol; 0 = not in table.
+// ZFAST_PAIR entries hold two literals in bits 16-23 and 24-31 and their
+// combined code length
+#define ZFAST_PAIR  0x100
+
 // zlib-style huffman encoding
 // (jpegs packs from left, zlib from right, so can't share code)
 typedef struct
 {
-   uint16 fast[1 << ZFAST_BITS];
+   uint32 fast[1 << ZFAST_BITS];
    uint16 firstcode[16];
    int maxcode[17];
    uint16 firstsymbol[16];
@@ -1636,14 +1661,14 @@ __forceinline static int bit_reverse(int v, int bits)
    return bitreverse16(v) >> (16-bits);
 }
 
-static int zbuild_huffman(zhuffman *z, uint8 *sizelist, int num)
+static int zbuild_huffman(zhuffman *z, uint8 *sizelist, int num, int pairs)
 {
    int i,k=0;
    int code, next_code[16], sizes[17];
 
    // DEFLATE spec for generating codes
    memset(sizes, 0, sizeof(sizes));
-   memset(z->fast, 255, sizeof(z->fast));
+   memset(z->fast, 0, sizeof(z->fast));
    for (i=0; i < num; ++i)
       ++sizes[sizelist[i]];
    sizes[0] = 0;
@@ -1671,13 +1696,26 @@ static int zbuild_huffman(zhuffman *z, uint8 *sizelist, int num)
          if (s <= ZFAST_BITS) {
             int k = bit_reverse(next_code[s],s);
             while (k < (1 << ZFAST_BITS)) {
-               z->fast[k] = (uint16) c;
+               z->fast[k] = (uint32) s | ((uint32) i << 16);
                k += (1 << s);
             }
          }
          ++next_code[s];
       }
    }
+   if (pairs) {
+      // a literal whose code leaves room for a second literal's code in
+      // the same lookup gets both. the bits after the first code index
+      // a lower entry, so going downwards reads it before it's merged
+      for (i=(1 << ZFAST_BITS)-1; i >= 0; --i) {
+         uint32 f1 = z->fast[i], f2;
+         int s1 = f1 & 255;
+         if (f1 == 0 || (f1 >> 16) >= 256 || s1 >= ZFAST_BITS) continue;
+         f2 = z->fast[i >> s1];
+         if (f2 == 0 || (f2 & ZFAST_PAIR) || (f2 >> 16) >= 256 || (int) (f2 & 255) > ZFAST_BITS - s1) continue;
+         z->fast[i] = (uint32) (s1 + (f2 & 255)) | ZFAST_PAIR | (f1 & 0xff0000) | ((f2 >> 16) << 24);
+      }
+   }
    return 1;
 }
 
@@ -1691,7 +1729,7 @@ typedef struct
 {
    uint8 *zbuffer, *zbuffer_end;
    int num_bits;
-   uint32 code_buffer;
+   uint64 code_buffer;
 
    char *zout;
    char *zout_start;
@@ -1707,40 +1745,45 @@ __forceinline static int zget8(zbuf *z)
    return *z->zbuffer++;
 }
 
+// tops the bit buffer up to at least 57 bits; past the end of the
+// input it is padded with zeros
 static void fill_bits(zbuf *z)
 {
-   do {
-      assert(z->code_buffer < (1U << z->num_bits));
-      z->code_buffer |= zget8(z) << z->num_bits;
-      z->num_bits += 8;
-   } while (z->num_bits <= 24);
+   assert(z->code_buffer < ((uint64) 1 << z->num_bits));
+   if (z->zbuffer_end - z->zbuffer >= 8) {
+      // load 8 bytes, keep the whole ones that fit
+      uint8 *p = z->zbuffer;
+      uint64 word = (uint64) p[0]       | ((uint64) p[1] <<  8) | ((uint64) p[2] << 16) | ((uint64) p[3] << 24) |
+                   ((uint64) p[4] << 32) | ((uint64) p[5] << 40) | ((uint64) p[6] << 48) | ((uint64) p[7] << 56);
+      z->code_buffer |= word << z->num_bits;
+      z->zbuffer += (63 - z->num_bits) >> 3;
+      z->num_bits |= 56;
+      z->code_buffer &= ((uint64) 1 << z->num_bits) - 1;
+   } else {
+      while (z->num_bits <= 56) {
+         z->code_buffer |= (uint64) zget8(z) << z->num_bits;
+         z->num_bits += 8;
+      }
+   }
 }
 
 __forceinline static unsigned int zreceive(zbuf *z, int n)
 {
    unsigned int k;
    if (z->num_bits < n) fill_bits(z);
-   k = z->code_buffer & ((1 << n) - 1);
+   k = (unsigned int) (z->code_buffer & ((1 << n) - 1));
    z->code_buffer >>= n;
    z->num_bits -= n;
    return k;
 }
 
-__forceinline static int zhuffman_decode(zbuf *a, zhuffman *z)
+// decodes a code longer than ZFAST_BITS, the bit buffer must hold 16 bits
+static int zhuffman_decode_slow(zbuf *a, zhuffman *z)
 {
    int b,s,k;
-   if (a->num_bits < 16) fill_bits(a);
-   b = z->fast[a->code_buffer & ZFAST_MASK];
-   if (b < 0xffff) {
-      s = z->size[b];
-      a->code_buffer >>= s;
-      a->num_bits -= s;
-      return z->value[b];
-   }
-
    // not resolved by fast table, so compute it the slow way
    // use jpeg approach, which requires MSbits at top
-   k = bit_reverse(a->code_buffer, 16);
+   k = bit_reverse((int) (a->code_buffer & 0xffff), 16);
    for (s=ZFAST_BITS+1; ; ++s)
       if (k < z->maxcode[s])
          break;
@@ -1753,6 +1796,21 @@ __forceinline static int zhuffman_decode(zbuf *a, zhuffman *z)
    return z->value[b];
 }
 
+// decodes one symbol of a table built without pairs
+__forceinline static int zhuffman_decode(zbuf *a, zhuffman *z)
+{
+   uint32 f;
+   if (a->num_bits < 16) fill_bits(a);
+   f = z->fast[a->code_buffer & ZFAST_MASK];
+   if (f) {
+      assert(!(f & ZFAST_PAIR));
+      a->code_buffer >>= f & 255;
+      a->num_bits -= f & 255;
+      return (int) (f >> 16);
+   }
+   return zhuffman_decode_slow(a, z);
+}
+
 static int expand(zbuf *z, int n)  // need to make room for n bytes
 {
    char *q;
@@ -1787,27 +1845,69 @@ static int dist_extra[32] =
 static int parse_huffman_block(zbuf *a)
 {
    for(;;) {
-      int z = zhuffman_decode(a, &a->z_length);
+      uint32 f;
+      int z;
+      // one refill covers a length, a distance and their extra bits (48 bits)
+      if (a->num_bits < 48) fill_bits(a);
+      f = a->z_length.fast[a->code_buffer & ZFAST_MASK];
+      if (f & ZFAST_PAIR) {
+         if (a->zout + 2 > a->zout_end) if (!expand(a, 2)) return 0;
+         a->zout[0] = (char) (f >> 16);
+         a->zout[1] = (char) (f >> 24);
+         a->zout += 2;
+         a->code_buffer >>= f & 255;
+         a->num_bits -= f & 255;
+         continue;
+      }
+      if (f) {
+         a->code_buffer >>= f & 255;
+         a->num_bits -= f & 255;
+         z = (int) (f >> 16);
+      } else
+         z = zhuffman_decode_slow(a, &a->z_length);
       if (z < 256) {
          if (z < 0) return e("bad huffman code","Corrupt PNG"); // error in huffman codes
          if (a->zout >= a->zout_end) if (!expand(a, 1)) return 0;
          *a->zout++ = (char) z;
       } else {
-         uint8 *p;
-         int len,dist;
+         uint8 *p, *q;
+         int len,dist,n;
          if (z == 256) return 1;
          z -= 257;
          len = length_base[z];
          if (length_extra[z]) len += zreceive(a, length_extra[z]);
-         z = zhuffman_decode(a, &a->z_distance);
+         f = a->z_distance.fast[a->code_buffer & ZFAST_MASK];
+         if (f) {
+            a->code_buffer >>= f & 255;
+            a->num_bits -= f & 255;
+            z = (int) (f >> 16);
+         } else
+            z = zhuffman_decode_slow(a, &a->z_distance);
          if (z < 0) return e("bad huffman code","Corrupt PNG");
          dist = dist_base[z];
          if (dist_extra[z]) dist += zreceive(a, dist_extra[z]);
          if (a->zout - a->zout_start < dist) return e("bad dist","Corrupt PNG");
          if (a->zout + len > a->zout_end) if (!expand(a, len)) return 0;
          p = (uint8 *) (a->zout - dist);
-         while (len--)
-            *a->zout++ = *p++;
+         q = (uint8 *) a->zout;
+         n = len;
+         if (dist == 1) {
+            // run of a single byte
+            memset(q, *p, len);
+         } else if (dist >= 8 && a->zout_end - a->zout >= len + 8) {
+            // words never overlap the bytes they are copied to, and
+            // may run up to 7 bytes past the match into the slack
+            do {
+               memcpy(q, p, 8);
+               q += 8;
+               p += 8;
+               n -= 8;
+            } while (n > 0);
+         } else {
+            while (n--)
+               *q++ = *p++;
+         }
+         a->zout += len;
       }
    }
 }
@@ -1829,7 +1929,7 @@ static int compute_huffman_codes(zbuf *a)
       int s = zreceive(a,3);
       codelength_sizes[length_dezigzag[i]] = (uint8) s;
    }
-   if (!zbuild_huffman(&z_codelength, codelength_sizes, 19)) return 0;
+   if (!zbuild_huffman(&z_codelength, codelength_sizes, 19, 0)) return 0;
 
    n = 0;
    while (n < hlit + hdist) {
@@ -1853,8 +1953,8 @@ static int compute_huffman_codes(zbuf *a)
       }
    }
    if (n != hlit+hdist) return e("bad codelengths","Corrupt PNG");
-   if (!zbuild_huffman(&a->z_length, lencodes, hlit)) return 0;
-   if (!zbuild_huffman(&a->z_distance, lencodes+hlit, hdist)) return 0;
+   if (!zbuild_huffman(&a->z_length, lencodes, hlit, 1)) return 0;
+   if (!zbuild_huffman(&a->z_distance, lencodes+hlit, hdist, 0)) return 0;
    return 1;
 }
 
@@ -1866,21 +1966,27 @@ static int parse_uncompressed_block(zbuf *a)
       zreceive(a, a->num_bits & 7); // discard
    // drain the bit-packed data into header
    k = 0;
-   while (a->num_bits > 0) {
-      header[k++] = (uint8) (a->code_buffer & 255); // wtf this warns?
+   while (a->num_bits > 0 && k < 4) {
+      header[k++] = (uint8) (a->code_buffer & 255);
       a->code_buffer >>= 8;
       a->num_bits -= 8;
    }
-   assert(a->num_bits == 0);
    // now fill header the normal way
    while (k < 4)
       header[k++] = (uint8) zget8(a);
    len  = header[1] * 256 + header[0];
    nlen = header[3] * 256 + header[2];
    if (nlen != (len ^ 0xffff)) return e("zlib corrupt","Corrupt PNG");
-   if (a->zbuffer + len > a->zbuffer_end) return e("read past buffer","Corrupt PNG");
+   if (a->zbuffer + len - a->num_bits / 8 > a->zbuffer_end) return e("read past buffer","Corrupt PNG");
    if (a->zout + len > a->zout_end)
       if (!expand(a, len)) return 0;
+   // bytes still in the bit buffer come first
+   while (a->num_bits > 0 && len > 0) {
+      *a->zout++ = (char) (a->code_buffer & 255);
+      a->code_buffer >>= 8;
+      a->num_bits -= 8;
+      --len;
+   }
    memcpy(a->zout, a->zbuffer, len);
    a->zbuffer += len;
    a->zout += len;
@@ -1931,8 +2037,8 @@ static int parse_zlib(zbuf *a, int parse_header)
          if (type == 1) {
             // use fixed code lengths
             if (!default_distance[31]) init_defaults();
-            if (!zbuild_huffman(&a->z_length  , default_length  , 288)) return 0;
-            if (!zbuild_huffman(&a->z_distance, default_distance,  32)) return 0;
+            if (!zbuild_huffman(&a->z_length  , default_length  , 288, 1)) return 0;
+            if (!zbuild_huffman(&a->z_distance, default_distance,  32, 0)) return 0;
          } else {
             if (!compute_huffman_codes(a)) return 0;
          }
@@ -2075,6 +2181,15 @@ static int paeth(int a, int b, int c)
    return c;
 }
 
+#if STBI_SIMD
+static stbi_png_unfilter_run stbi_png_unfilter_installed = NULL;
+
+extern void stbi_install_png_unfilter(stbi_png_unfilter_run func)
+{
+   stbi_png_unfilter_installed = func;
+}
+#endif
+
 // create the png data from post-deflated data
 static int create_png_image(png *a, uint8 *raw, uint32 raw_len, int out_n)
 {
@@ -2082,6 +2197,9 @@ static int create_png_image(png *a, uint8 *raw, uint32 raw_len, int out_n)
    uint32 i,j,stride = s->img_x*out_n;
    int k;
    int img_n = s->img_n; // copy it into a local for later
+   #if STBI_SIMD
+   stbi_png_unfilter_run unfilter = stbi_png_unfilter_installed;
+   #endif
    assert(out_n == s->img_n || out_n == s->img_n+1);
    a->out = (uint8 *) malloc(s->img_x * s->img_y * out_n);
    if (!a->out) return e("outofmem", "Out of memory");
@@ -2093,6 +2211,13 @@ static int create_png_image(png *a, uint8 *raw, uint32 raw_len, int out_n)
       if (filter > 4) return e("invalid filter","Corrupt PNG");
       // if first row, use special filter that doesn't sample previous row
       if (j == 0) filter = first_row_filter[filter];
+      #if STBI_SIMD
+      if (unfilter)
+         if (unfilter(cur, raw, prior, filter, s->img_x, img_n, out_n)) {
+            raw += s->img_x * img_n;
+            continue;
+         }
+      #endif
       // handle first pixel explicitly
       for (k=0; k < img_n; ++k) {
          switch(filter) {
@@ -111,7 +111,8 @@
 // If image loading fails for any reason, the return value will be NULL,
 // and *x, *y, *comp will be unchanged. The function stbi_failure_reason()
 // can be queried for an extremely brief, end-user unfriendly explanation
-// of why the load failed. Define STBI_NO_FAILURE_STRINGS to avoid
+// of why the load failed, on the thread that called the loader.
+// Define STBI_NO_FAILURE_STRINGS to avoid
 // compiling these strings at all, and STBI_FAILURE_USERMSG to get slightly
 // more user-friendly ones.
 //
@@ -326,13 +327,18 @@ typedef struct
 extern int stbi_register_loader(stbi_loader *loader);
 
 // define faster low-level operations (typically SIMD support)
+// (enabled for SOIL, stbi_SIMD.c provides the accelerated versions)
+#ifndef STBI_SIMD
+#define STBI_SIMD 1
+#endif
+
 #if STBI_SIMD
-typedef void (*stbi_idct_8x8)(uint8 *out, int out_stride, short data[64], unsigned short *dequantize);
+typedef void (*stbi_idct_8x8)(unsigned char *out, int out_stride, short data[64], unsigned short *dequantize);
 // compute an integer IDCT on "input"
 //     input[x] = data[x] * dequantize[x]
 //     write results to 'out': 64 samples, each run of 8 spaced by 'out_stride'
 //                             CLAMP results to 0..255
-typedef void (*stbi_YCbCr_to_RGB_run)(uint8 *output, uint8 const *y, uint8 const *cb, uint8 const *cr, int count, int step);
+typedef void (*stbi_YCbCr_to_RGB_run)(unsigned char *output, unsigned char const *y, unsigned char const *cb, unsigned char const *cr, int count, int step);
 // compute a conversion from YCbCr to RGB
 //     'count' pixels
 //     write pixels to 'output'; each pixel is 'step' bytes (either 3 or 4; if 4, write '255' as 4th), order R,G,B
@@ -340,8 +346,18 @@ typedef void (*stbi_YCbCr_to_RGB_run)(uint8 *output, uint8 const *y, uint8 const
 //     cb: Cb input channel; scale/biased to be 0..255
 //     cr: Cr input channel; scale/biased to be 0..255
 
+typedef int (*stbi_png_unfilter_run)(unsigned char *cur, unsigned char const *raw, unsigned char const *prior, int filter, int count, int img_n, int out_n);
+// reconstruct one row of a PNG from its filtered bytes
+//     'count' pixels of 'img_n' bytes read from 'raw'
+//     write pixels to 'cur'; each pixel is 'out_n' bytes (img_n or img_n+1; if img_n+1, write '255' as last)
+//     prior: previous reconstructed row, 'out_n' bytes per pixel
+//     filter: 0 none, 1 sub, 2 up, 3 avg, 4 paeth, 5 avg and 6 paeth of the first row (prior is not read)
+//     return 0 to leave the row to the built-in version
+
+// passing NULL restores the built-in version; NOT THREADSAFE
 extern void stbi_install_idct(stbi_idct_8x8 func);
 extern void stbi_install_YCbCr_to_RGB(stbi_YCbCr_to_RGB_run func);
+extern void stbi_install_png_unfilter(stbi_png_unfilter_run func);
 #endif // STBI_SIMD
 
 #ifdef __cplusplus
@@ -0,0 +1,472 @@
+/*
+	SIMD kernels for stb_image_aug's installable JPEG and PNG hooks
+
+	public domain
+
+	Each kernel does exactly the same fixed point math as the scalar
+	versions in stb_image_aug.c (idct_block and YCbCr_to_RGB_row),
+	just on 4 (SSE2) or 8 (AVX2) columns, rows or pixels at a time.
+	The IDCT works on 32 bit lanes, so results are bit exact.
+	PNG unfiltering depends on the pixel to the left, so it handles
+	the bytes of one pixel in parallel (SSE2 only, AVX2 can't help).
+*/
+
+#include <string.h>
+#include "stb_image_aug.h"
+#include "stbi_SIMD.h"
+
+#if STBI_SIMD && (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#define STBI_X86_SIMD	1
+#include <immintrin.h>
+#else
+#define STBI_X86_SIMD	0
+#endif
+
+#if STBI_X86_SIMD
+
+/*	fixed point constants, exactly as in stb_image_aug.c	*/
+#define f2f(x)  (int) (((x) * 4096 + 0.5))
+#define float2fixed(x)  ((int) ((x) * 65536 + 0.5))
+
+/*	converts the remaining pixels of a row, exactly as YCbCr_to_RGB_row	*/
+static void YCbCr_to_RGB_tail( unsigned char *out, unsigned char const *y, unsigned char const *pcb, unsigned char const *pcr, int count, int step )
+{
+	int i;
+	for( i = 0; i < count; ++i )
+	{
+		int y_fixed = (y[i] << 16) + 32768;
+		int r, g, b;
+		int cr = pcr[i] - 128;
+		int cb = pcb[i] - 128;
+		r = y_fixed + cr*float2fixed(1.40200f);
+		g = y_fixed - cr*float2fixed(0.71414f) - cb*float2fixed(0.34414f);
+		b = y_fixed                            + cb*float2fixed(1.77200f);
+		r >>= 16;
+		g >>= 16;
+		b >>= 16;
+		if( (unsigned) r > 255 ) { if( r < 0 ) r = 0; else r = 255; }
+		if( (unsigned) g > 255 ) { if( g < 0 ) g = 0; else g = 255; }
+		if( (unsigned) b > 255 ) { if( b < 0 ) b = 0; else b = 255; }
+		out[0] = (unsigned char)r;
+		out[1] = (unsigned char)g;
+		out[2] = (unsigned char)b;
+		if( step == 4 )
+		{
+			out[3] = 255;
+		}
+		out += step;
+	}
+}
+
+/*	interleaves 8 pixels of packed R, G and B bytes into RGBA or RGB	*/
+static __inline__ __attribute__((target("sse2"))) void
+	store_RGB_8( unsigned char *out, __m128i r8, __m128i g8, __m128i b8, int step )
+{
+	__m128i rg = _mm_unpacklo_epi8( r8, g8 );
+	__m128i ba = _mm_unpacklo_epi8( b8, _mm_set1_epi8( (char)255 ) );
+	__m128i lo = _mm_unpacklo_epi16( rg, ba );
+	__m128i hi = _mm_unpackhi_epi16( rg, ba );
+	if( step == 4 )
+	{
+		_mm_storeu_si128( (__m128i*)out, lo );
+		_mm_storeu_si128( (__m128i*)(out + 16), hi );
+	} else
+	{
+		unsigned char rgba[32];
+		int i;
+		_mm_storeu_si128( (__m128i*)rgba, lo );
+		_mm_storeu_si128( (__m128i*)(rgba + 16), hi );
+		for( i = 0; i < 8; ++i )
+		{
+			out[i*3+0] = rgba[i*4+0];
+			out[i*3+1] = rgba[i*4+1];
+			out[i*3+2] = rgba[i*4+2];
+		}
+	}
+}
+
+/*	transposes a 4x4 block of 32 bit values	*/
+#define STBI_TRANSPOSE4( a, b, c, d ) \
+	{ \
+		__m128i t0 = _mm_unpacklo_epi32( a, b ), t1 = _mm_unpacklo_epi32( c, d ); \
+		__m128i t2 = _mm_unpackhi_epi32( a, b ), t3 = _mm_unpackhi_epi32( c, d ); \
+		a = _mm_unpacklo_epi64( t0, t1 ); \
+		b = _mm_unpackhi_epi64( t0, t1 ); \
+		c = _mm_unpacklo_epi64( t2, t3 ); \
+		d = _mm_unpackhi_epi64( t2, t3 ); \
+	}
+
+/********* SSE2 *********/
+/*	SSE2 has no 32 bit multiply keeping the low half, build it from two 32x32->64 ones	*/
+static __inline__ __attribute__((target("sse2"))) __m128i mullo_epi32_SSE2( __m128i a, __m128i b )
+{
+	__m128i even = _mm_mul_epu32( a, b );
+	__m128i odd = _mm_mul_epu32( _mm_srli_si128( a, 4 ), _mm_srli_si128( b, 4 ) );
+	return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ), _mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+}
+
+#define STBI_TARGET	__attribute__((target("sse2")))
+#define STBI_NAME( x )	x##_SSE2
+#define STBI_VI	__m128i
+#define STBI_SET1( x )	_mm_set1_epi32( x )
+#define STBI_ADD( a, b )	_mm_add_epi32( a, b )
+#define STBI_SUB( a, b )	_mm_sub_epi32( a, b )
+#define STBI_MUL( a, b )	mullo_epi32_SSE2( a, b )
+#define STBI_SLL( a, n )	_mm_slli_epi32( a, n )
+#define STBI_SRA( a, n )	_mm_sra_epi32( a, _mm_cvtsi32_si128( n ) )
+#include "stbi_SIMD_kernel.h"
+
+static void STBI_TARGET idct_block_SSE2( unsigned char *out, int out_stride, short data[64], unsigned short *dequantize )
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo[8], hi[8];
+	int i;
+	/*	columns: lo holds columns 0-3 and hi columns 4-7 of each row	*/
+	for( i = 0; i < 8; ++i )
+	{
+		__m128i d = _mm_loadu_si128( (const __m128i*)(data + i*8) );
+		__m128i q = _mm_loadu_si128( (const __m128i*)(dequantize + i*8) );
+		lo[i] = mullo_epi32_SSE2( _mm_srai_epi32( _mm_unpacklo_epi16( d, d ), 16 ), _mm_unpacklo_epi16( q, zero ) );
+		hi[i] = mullo_epi32_SSE2( _mm_srai_epi32( _mm_unpackhi_epi16( d, d ), 16 ), _mm_unpackhi_epi16( q, zero ) );
+	}
+	idct_1d_SSE2( lo, 512, 10 );
+	idct_1d_SSE2( hi, 512, 10 );
+	/*	rows: lo now holds rows 0-3 and hi rows 4-7 of each column,
+		the row pass also adds clamp()'s level shift of 128	*/
+	{
+		__m128i top[8], bottom[8];
+		top[0] = lo[0]; top[1] = lo[1]; top[2] = lo[2]; top[3] = lo[3];
+		top[4] = hi[0]; top[5] = hi[1]; top[6] = hi[2]; top[7] = hi[3];
+		bottom[0] = lo[4]; bottom[1] = lo[5]; bottom[2] = lo[6]; bottom[3] = lo[7];
+		bottom[4] = hi[4]; bottom[5] = hi[5]; bottom[6] = hi[6]; bottom[7] = hi[7];
+		STBI_TRANSPOSE4( top[0], top[1], top[2], top[3] );
+		STBI_TRANSPOSE4( top[4], top[5], top[6], top[7] );
+		STBI_TRANSPOSE4( bottom[0], bottom[1], bottom[2], bottom[3] );
+		STBI_TRANSPOSE4( bottom[4], bottom[5], bottom[6], bottom[7] );
+		idct_1d_SSE2( top, 65536 + (128 << 17), 17 );
+		idct_1d_SSE2( bottom, 65536 + (128 << 17), 17 );
+		/*	back to rows, and clamp to 0..255 while packing	*/
+		STBI_TRANSPOSE4( top[0], top[1], top[2], top[3] );
+		STBI_TRANSPOSE4( top[4], top[5], top[6], top[7] );
+		STBI_TRANSPOSE4( bottom[0], bottom[1], bottom[2], bottom[3] );
+		STBI_TRANSPOSE4( bottom[4], bottom[5], bottom[6], bottom[7] );
+		for( i = 0; i < 4; ++i )
+		{
+			__m128i row = _mm_packs_epi32( top[i], top[i+4] );
+			_mm_storel_epi64( (__m128i*)(out + i*out_stride), _mm_packus_epi16( row, row ) );
+			row = _mm_packs_epi32( bottom[i], bottom[i+4] );
+			_mm_storel_epi64( (__m128i*)(out + (i+4)*out_stride), _mm_packus_epi16( row, row ) );
+		}
+	}
+}
+
+static void STBI_TARGET YCbCr_to_RGB_row_SSE2( unsigned char *out, unsigned char const *y, unsigned char const *pcb, unsigned char const *pcr, int count, int step )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16( 128 );
+	int i;
+	for( i = 0; i + 8 <= count; i += 8, out += 8*step )
+	{
+		__m128i y16 = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i*)(y + i) ), zero );
+		__m128i cb16 = _mm_sub_epi16( _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i*)(pcb + i) ), zero ), bias );
+		__m128i cr16 = _mm_sub_epi16( _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i*)(pcr + i) ), zero ), bias );
+		__m128i r[2], g[2], b[2];
+		int h;
+		for( h = 0; h < 2; ++h )
+		{
+			__m128i yv = h ? _mm_unpackhi_epi16( y16, zero ) : _mm_unpacklo_epi16( y16, zero );
+			__m128i cb = h ? _mm_unpackhi_epi16( cb16, cb16 ) : _mm_unpacklo_epi16( cb16, cb16 );
+			__m128i cr = h ? _mm_unpackhi_epi16( cr16, cr16 ) : _mm_unpacklo_epi16( cr16, cr16 );
+			__m128i y_fixed;
+			cb = _mm_srai_epi32( cb, 16 );
+			cr = _mm_srai_epi32( cr, 16 );
+			y_fixed = _mm_add_epi32( _mm_slli_epi32( yv, 16 ), _mm_set1_epi32( 32768 ) );
+			r[h] = _mm_srai_epi32( _mm_add_epi32( y_fixed, mullo_epi32_SSE2( cr, _mm_set1_epi32( float2fixed(1.40200f) ) ) ), 16 );
+			g[h] = _mm_srai_epi32( _mm_sub_epi32( _mm_sub_epi32( y_fixed,
+					mullo_epi32_SSE2( cr, _mm_set1_epi32( float2fixed(0.71414f) ) ) ),
+					mullo_epi32_SSE2( cb, _mm_set1_epi32( float2fixed(0.34414f) ) ) ), 16 );
+			b[h] = _mm_srai_epi32( _mm_add_epi32( y_fixed, mullo_epi32_SSE2( cb, _mm_set1_epi32( float2fixed(1.77200f) ) ) ), 16 );
+		}
+		/*	saturating packs clamp to 0..255	*/
+		{
+			__m128i r16 = _mm_packs_epi32( r[0], r[1] );
+			__m128i g16 = _mm_packs_epi32( g[0], g[1] );
+			__m128i b16 = _mm_packs_epi32( b[0], b[1] );
+			store_RGB_8( out, _mm_packus_epi16( r16, r16 ), _mm_packus_epi16( g16, g16 ), _mm_packus_epi16( b16, b16 ), step );
+		}
+	}
+	YCbCr_to_RGB_tail( out, y + i, pcb + i, pcr + i, count - i, step );
+}
+
+/*	loads one pixel of n (3 or 4) bytes into the low lanes, the others are zero	*/
+static __inline__ STBI_TARGET __m128i load_pixel_SSE2( unsigned char const *p, int n )
+{
+	unsigned int v;
+	if( n == 4 )
+	{
+		memcpy( &v, p, 4 );
+	} else
+	{
+		v = p[0] | (p[1] << 8) | (p[2] << 16);
+	}
+	return _mm_cvtsi32_si128( (int)v );
+}
+
+/*	stores the low n (3 or 4) lanes	*/
+static __inline__ STBI_TARGET void store_pixel_SSE2( unsigned char *p, __m128i x, int n )
+{
+	unsigned int v = (unsigned int)_mm_cvtsi128_si32( x );
+	if( n == 4 )
+	{
+		memcpy( p, &v, 4 );
+	} else
+	{
+		p[0] = (unsigned char)v;
+		p[1] = (unsigned char)(v >> 8);
+		p[2] = (unsigned char)(v >> 16);
+	}
+}
+
+/*	Paeth predictor of every byte lane, exactly as stb_image_aug's paeth()	*/
+static __inline__ STBI_TARGET __m128i paeth_SSE2( __m128i a, __m128i b, __m128i c )
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i a16 = _mm_unpacklo_epi8( a, zero );
+	__m128i b16 = _mm_unpacklo_epi8( b, zero );
+	__m128i c16 = _mm_unpacklo_epi8( c, zero );
+	/*	with p = a + b - c: p - a = b - c, p - b = a - c, p - c = sum of both	*/
+	__m128i pa = _mm_sub_epi16( b16, c16 );
+	__m128i pb = _mm_sub_epi16( a16, c16 );
+	__m128i pc = _mm_add_epi16( pa, pb );
+	__m128i not_a, use_c, r;
+	pa = _mm_max_epi16( pa, _mm_sub_epi16( zero, pa ) );
+	pb = _mm_max_epi16( pb, _mm_sub_epi16( zero, pb ) );
+	pc = _mm_max_epi16( pc, _mm_sub_epi16( zero, pc ) );
+	not_a = _mm_or_si128( _mm_cmpgt_epi16( pa, pb ), _mm_cmpgt_epi16( pa, pc ) );
+	use_c = _mm_cmpgt_epi16( pb, pc );
+	r = _mm_or_si128( _mm_and_si128( use_c, c16 ), _mm_andnot_si128( use_c, b16 ) );
+	r = _mm_or_si128( _mm_and_si128( not_a, r ), _mm_andnot_si128( not_a, a16 ) );
+	return _mm_packus_epi16( r, r );
+}
+
+/*
+	Reconstructs a row pixel by pixel, the byte lanes of a pixel in parallel.
+	a, b and c are the left, upper and upper left pixels as named by the PNG spec,
+	the loop body computes b and predict from them.
+*/
+#define STBI_UNFILTER_LOOP( body ) \
+	for( i = 0; i < count; ++i, raw += img_n, cur += out_n, prior += out_n ) \
+	{ \
+		body \
+		a = _mm_add_epi8( load_pixel_SSE2( raw, img_n ), predict ); \
+		store_pixel_SSE2( cur, _mm_or_si128( a, alpha ), out_n ); \
+	}
+
+static __inline__ STBI_TARGET void unfilter_row_SSE2( unsigned char *cur, unsigned char const *raw, unsigned char const *prior, int filter, int count, const int img_n, const int out_n )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha = img_n != out_n ? _mm_cvtsi32_si128( (int)0xff000000 ) : zero;
+	__m128i a = zero, b, c = zero, predict;
+	int i;
+	switch( filter )
+	{
+	case 0:
+		if( img_n == out_n )
+		{
+			memcpy( cur, raw, count * img_n );
+			return;
+		}
+		STBI_UNFILTER_LOOP( predict = zero; )
+		break;
+	case 1:
+		STBI_UNFILTER_LOOP( predict = a; )
+		break;
+	case 2:
+		if( img_n == out_n )
+		{
+			/*	no dependency between pixels, go 16 bytes at a time	*/
+			int n = count * img_n;
+			for( i = 0; i + 16 <= n; i += 16 )
+			{
+				__m128i x = _mm_loadu_si128( (const __m128i*)(raw + i) );
+				__m128i y = _mm_loadu_si128( (const __m128i*)(prior + i) );
+				_mm_storeu_si128( (__m128i*)(cur + i), _mm_add_epi8( x, y ) );
+			}
+			for( ; i < n; ++i )
+			{
+				cur[i] = (unsigned char)(raw[i] + prior[i]);
+			}
+			return;
+		}
+		STBI_UNFILTER_LOOP( predict = load_pixel_SSE2( prior, img_n ); )
+		break;
+	case 3:
+		/*	floor of the average, _mm_avg_epu8 rounds up	*/
+		STBI_UNFILTER_LOOP(
+			b = load_pixel_SSE2( prior, img_n );
+			predict = _mm_sub_epi8( _mm_avg_epu8( a, b ), _mm_and_si128( _mm_xor_si128( a, b ), _mm_set1_epi8( 1 ) ) ); )
+		break;
+	case 4:
+		STBI_UNFILTER_LOOP(
+			b = load_pixel_SSE2( prior, img_n );
+			predict = paeth_SSE2( a, b, c );
+			c = b; )
+		break;
+	case 5:
+		STBI_UNFILTER_LOOP( predict = _mm_and_si128( _mm_srli_epi16( a, 1 ), _mm_set1_epi8( 0x7f ) ); )
+		break;
+	case 6:
+		/*	paeth(a, 0, 0) is a	*/
+		STBI_UNFILTER_LOOP( predict = a; )
+		break;
+	}
+}
+
+#undef STBI_UNFILTER_LOOP
+
+static int STBI_TARGET png_unfilter_SSE2( unsigned char *cur, unsigned char const *raw, unsigned char const *prior, int filter, int count, int img_n, int out_n )
+{
+	/*	specialized for the common RGB / RGBA layouts	*/
+	if( img_n == 4 && out_n == 4 )
+	{
+		unfilter_row_SSE2( cur, raw, prior, filter, count, 4, 4 );
+	} else if( img_n == 3 && out_n == 4 )
+	{
+		unfilter_row_SSE2( cur, raw, prior, filter, count, 3, 4 );
+	} else if( img_n == 3 && out_n == 3 )
+	{
+		unfilter_row_SSE2( cur, raw, prior, filter, count, 3, 3 );
+	} else
+	{
+		return 0;
+	}
+	return 1;
+}
+
+#undef STBI_TARGET
+#undef STBI_NAME
+#undef STBI_VI
+#undef STBI_SET1
+#undef STBI_ADD
+#undef STBI_SUB
+#undef STBI_MUL
+#undef STBI_SLL
+#undef STBI_SRA
+
+/********* AVX2 *********/
+#define STBI_TARGET	__attribute__((target("avx2")))
+#define STBI_NAME( x )	x##_AVX2
+#define STBI_VI	__m256i
+#define STBI_SET1( x )	_mm256_set1_epi32( x )
+#define STBI_ADD( a, b )	_mm256_add_epi32( a, b )
+#define STBI_SUB( a, b )	_mm256_sub_epi32( a, b )
+#define STBI_MUL( a, b )	_mm256_mullo_epi32( a, b )
+#define STBI_SLL( a, n )	_mm256_slli_epi32( a, n )
+#define STBI_SRA( a, n )	_mm256_sra_epi32( a, _mm_cvtsi32_si128( n ) )
+#include "stbi_SIMD_kernel.h"
+
+/*	transposes an 8x8 block of 32 bit values	*/
+static __inline__ STBI_TARGET void transpose8_AVX2( __m256i v[8] )
+{
+	__m256i t[8], u[8];
+	int i;
+	for( i = 0; i < 8; i += 2 )
+	{
+		t[i] = _mm256_unpacklo_epi32( v[i], v[i+1] );
+		t[i+1] = _mm256_unpackhi_epi32( v[i], v[i+1] );
+	}
+	for( i = 0; i < 8; i += 4 )
+	{
+		u[i+0] = _mm256_unpacklo_epi64( t[i+0], t[i+2] );
+		u[i+1] = _mm256_unpackhi_epi64( t[i+0], t[i+2] );
+		u[i+2] = _mm256_unpacklo_epi64( t[i+1], t[i+3] );
+		u[i+3] = _mm256_unpackhi_epi64( t[i+1], t[i+3] );
+	}
+	for( i = 0; i < 4; ++i )
+	{
+		v[i] = _mm256_permute2x128_si256( u[i], u[i+4], 0x20 );
+		v[i+4] = _mm256_permute2x128_si256( u[i], u[i+4], 0x31 );
+	}
+}
+
+static void STBI_TARGET idct_block_AVX2( unsigned char *out, int out_stride, short data[64], unsigned short *dequantize )
+{
+	__m256i v[8];
+	int i;
+	/*	columns, one row per vector	*/
+	for( i = 0; i < 8; ++i )
+	{
+		__m256i d = _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i*)(data + i*8) ) );
+		__m256i q = _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i*)(dequantize + i*8) ) );
+		v[i] = _mm256_mullo_epi32( d, q );
+	}
+	idct_1d_AVX2( v, 512, 10 );
+	/*	rows, one column per vector, adding clamp()'s level shift of 128	*/
+	transpose8_AVX2( v );
+	idct_1d_AVX2( v, 65536 + (128 << 17), 17 );
+	transpose8_AVX2( v );
+	/*	clamp to 0..255 while packing	*/
+	for( i = 0; i < 8; ++i )
+	{
+		__m128i row = _mm_packs_epi32( _mm256_castsi256_si128( v[i] ), _mm256_extracti128_si256( v[i], 1 ) );
+		_mm_storel_epi64( (__m128i*)(out + i*out_stride), _mm_packus_epi16( row, row ) );
+	}
+}
+
+static void STBI_TARGET YCbCr_to_RGB_row_AVX2( unsigned char *out, unsigned char const *y, unsigned char const *pcb, unsigned char const *pcr, int count, int step )
+{
+	const __m256i bias = _mm256_set1_epi32( 128 );
+	int i;
+	for( i = 0; i + 8 <= count; i += 8, out += 8*step )
+	{
+		__m256i yv = _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)(y + i) ) );
+		__m256i cb = _mm256_sub_epi32( _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)(pcb + i) ) ), bias );
+		__m256i cr = _mm256_sub_epi32( _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)(pcr + i) ) ), bias );
+		__m256i y_fixed = _mm256_add_epi32( _mm256_slli_epi32( yv, 16 ), _mm256_set1_epi32( 32768 ) );
+		__m256i r = _mm256_srai_epi32( _mm256_add_epi32( y_fixed, _mm256_mullo_epi32( cr, _mm256_set1_epi32( float2fixed(1.40200f) ) ) ), 16 );
+		__m256i g = _mm256_srai_epi32( _mm256_sub_epi32( _mm256_sub_epi32( y_fixed,
+				_mm256_mullo_epi32( cr, _mm256_set1_epi32( float2fixed(0.71414f) ) ) ),
+				_mm256_mullo_epi32( cb, _mm256_set1_epi32( float2fixed(0.34414f) ) ) ), 16 );
+		__m256i b = _mm256_srai_epi32( _mm256_add_epi32( y_fixed, _mm256_mullo_epi32( cb, _mm256_set1_epi32( float2fixed(1.77200f) ) ) ), 16 );
+		/*	saturating packs clamp to 0..255	*/
+		__m128i r16 = _mm_packs_epi32( _mm256_castsi256_si128( r ), _mm256_extracti128_si256( r, 1 ) );
+		__m128i g16 = _mm_packs_epi32( _mm256_castsi256_si128( g ), _mm256_extracti128_si256( g, 1 ) );
+		__m128i b16 = _mm_packs_epi32( _mm256_castsi256_si128( b ), _mm256_extracti128_si256( b, 1 ) );
+		store_RGB_8( out, _mm_packus_epi16( r16, r16 ), _mm_packus_epi16( g16, g16 ), _mm_packus_epi16( b16, b16 ), step );
+	}
+	YCbCr_to_RGB_tail( out, y + i, pcb + i, pcr + i, count - i, step );
+}
+
+#endif /* STBI_X86_SIMD	*/
+
+const char* stbi_install_SIMD( int enable )
+{
+	#if STBI_X86_SIMD
+	if( enable )
+	{
+		__builtin_cpu_init();
+		if( __builtin_cpu_supports( "avx2" ) )
+		{
+			stbi_install_idct( idct_block_AVX2 );
+			stbi_install_YCbCr_to_RGB( YCbCr_to_RGB_row_AVX2 );
+			stbi_install_png_unfilter( png_unfilter_SSE2 );
+			return "AVX2";
+		}
+		if( __builtin_cpu_supports( "sse2" ) )
+		{
+			stbi_install_idct( idct_block_SSE2 );
+			stbi_install_YCbCr_to_RGB( YCbCr_to_RGB_row_SSE2 );
+			stbi_install_png_unfilter( png_unfilter_SSE2 );
+			return "SSE2";
+		}
+	}
+	#else
+	(void)enable;
+	#endif
+	#if STBI_SIMD
+	stbi_install_idct( NULL );
+	stbi_install_YCbCr_to_RGB( NULL );
+	stbi_install_png_unfilter( NULL );
+	#endif
+	return "scalar";
+}
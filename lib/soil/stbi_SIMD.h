@@ -0,0 +1,35 @@
+/*
+	SIMD kernels for stb_image_aug's installable JPEG and PNG hooks
+
+	public domain
+
+	SSE2 and AVX2 versions of the dequantizing IDCT and the
+	YCbCr to RGB conversion, and an SSE2 PNG row unfilter.
+	All produce exactly the same output as the built-in
+	scalar versions.
+*/
+
+#ifndef HEADER_STBI_SIMD
+#define HEADER_STBI_SIMD
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+	Installs the widest kernels the CPU supports into stb_image_aug
+	(enable != 0), or restores the built-in scalar ones (enable = 0).
+	Not thread safe, call before decoding JPEGs.
+	\return the name of the instruction set now in use
+**/
+const char*
+stbi_install_SIMD
+(
+    int enable
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEADER_STBI_SIMD	*/
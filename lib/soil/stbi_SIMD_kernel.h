@@ -0,0 +1,75 @@
+/*
+	SIMD 1D IDCT kernel
+
+	public domain
+
+	This file is included by stbi_SIMD.c once per instruction set,
+	with the STBI_* macros mapped to that instruction set's intrinsics.
+	Each 32 bit lane transforms one column (or row) of the 8x8 block,
+	the math mirrors stb_image_aug's IDCT_1D step by step.
+*/
+
+/*
+	Transforms the 8 vectors in s in place.
+	bias is added to the even part before the final
+	arithmetic shift right by shift.
+*/
+static __inline__ void STBI_TARGET
+	STBI_NAME( idct_1d )
+	(
+		STBI_VI *s,
+		int bias,
+		int shift
+	)
+{
+	STBI_VI t0, t1, t2, t3, p1, p2, p3, p4, p5, x0, x1, x2, x3;
+	/*	even part	*/
+	p2 = s[2];
+	p3 = s[6];
+	p1 = STBI_MUL( STBI_ADD( p2, p3 ), STBI_SET1( f2f(0.5411961f) ) );
+	t2 = STBI_ADD( p1, STBI_MUL( p3, STBI_SET1( f2f(-1.847759065f) ) ) );
+	t3 = STBI_ADD( p1, STBI_MUL( p2, STBI_SET1( f2f( 0.765366865f) ) ) );
+	p2 = s[0];
+	p3 = s[4];
+	t0 = STBI_SLL( STBI_ADD( p2, p3 ), 12 );
+	t1 = STBI_SLL( STBI_SUB( p2, p3 ), 12 );
+	x0 = STBI_ADD( t0, t3 );
+	x3 = STBI_SUB( t0, t3 );
+	x1 = STBI_ADD( t1, t2 );
+	x2 = STBI_SUB( t1, t2 );
+	/*	odd part	*/
+	t0 = s[7];
+	t1 = s[5];
+	t2 = s[3];
+	t3 = s[1];
+	p3 = STBI_ADD( t0, t2 );
+	p4 = STBI_ADD( t1, t3 );
+	p1 = STBI_ADD( t0, t3 );
+	p2 = STBI_ADD( t1, t2 );
+	p5 = STBI_MUL( STBI_ADD( p3, p4 ), STBI_SET1( f2f( 1.175875602f) ) );
+	t0 = STBI_MUL( t0, STBI_SET1( f2f( 0.298631336f) ) );
+	t1 = STBI_MUL( t1, STBI_SET1( f2f( 2.053119869f) ) );
+	t2 = STBI_MUL( t2, STBI_SET1( f2f( 3.072711026f) ) );
+	t3 = STBI_MUL( t3, STBI_SET1( f2f( 1.501321110f) ) );
+	p1 = STBI_ADD( p5, STBI_MUL( p1, STBI_SET1( f2f(-0.899976223f) ) ) );
+	p2 = STBI_ADD( p5, STBI_MUL( p2, STBI_SET1( f2f(-2.562915447f) ) ) );
+	p3 = STBI_MUL( p3, STBI_SET1( f2f(-1.961570560f) ) );
+	p4 = STBI_MUL( p4, STBI_SET1( f2f(-0.390180644f) ) );
+	t3 = STBI_ADD( t3, STBI_ADD( p1, p4 ) );
+	t2 = STBI_ADD( t2, STBI_ADD( p2, p3 ) );
+	t1 = STBI_ADD( t1, STBI_ADD( p2, p4 ) );
+	t0 = STBI_ADD( t0, STBI_ADD( p1, p3 ) );
+	/*	scale back down	*/
+	x0 = STBI_ADD( x0, STBI_SET1( bias ) );
+	x1 = STBI_ADD( x1, STBI_SET1( bias ) );
+	x2 = STBI_ADD( x2, STBI_SET1( bias ) );
+	x3 = STBI_ADD( x3, STBI_SET1( bias ) );
+	s[0] = STBI_SRA( STBI_ADD( x0, t3 ), shift );
+	s[7] = STBI_SRA( STBI_SUB( x0, t3 ), shift );
+	s[1] = STBI_SRA( STBI_ADD( x1, t2 ), shift );
+	s[6] = STBI_SRA( STBI_SUB( x1, t2 ), shift );
+	s[2] = STBI_SRA( STBI_ADD( x2, t1 ), shift );
+	s[5] = STBI_SRA( STBI_SUB( x2, t1 ), shift );
+	s[3] = STBI_SRA( STBI_ADD( x3, t0 ), shift );
+	s[4] = STBI_SRA( STBI_SUB( x3, t0 ), shift );
+}
@@ -0,0 +1,18 @@
+#version 330
+
+// Multisampled attachment texture
+uniform sampler2DMS uTextureUnit;
+
+// Destination rectangle (x, y, width, height) in window pixels
+uniform vec4 uViewport;
+
+out vec4 fColor;
+
+void main()
+{
+	// Multisampled textures can only be fetched, so map the fragment to a texel
+	vec2 uv = (gl_FragCoord.xy - uViewport.xy) / uViewport.zw;
+	ivec2 texel = ivec2(uv * vec2(textureSize(uTextureUnit)));
+
+	fColor = vec4(texelFetch(uTextureUnit, texel, 0).rgb, 1.0);
+}
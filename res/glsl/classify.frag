@@ -0,0 +1,43 @@
+#version 330
+
+#include "include/gbuffer.glsl"
+
+// Multisampled G-buffer attachments
+uniform sampler2DMS uNormalUnit;
+uniform sampler2DMS uDepthUnit;
+
+// Number of samples per G-buffer texel, injected so the loop is unrolled
+#ifndef SAMPLE_COUNT
+#define SAMPLE_COUNT 4
+#endif
+
+// Size of the default framebuffer in pixels
+uniform vec2 uScreenSize;
+
+// Normals further apart than this mark an edge
+const float NORMAL_THRESHOLD = 0.1;
+
+// Depths deviating by more than this mark an edge
+const float DEPTH_THRESHOLD = 0.0005;
+
+// Keeps the fragment (and thereby writes the stencil reference value)
+// for pixels whose samples differ, discards it for all others.
+void main()
+{
+	// The G-buffer may be rendered at a lower resolution than the window
+	ivec2 texel = ivec2(gl_FragCoord.xy * vec2(textureSize(uNormalUnit)) / uScreenSize);
+
+	vec3 normal = decodeNormal(texelFetch(uNormalUnit, texel, 0));
+	float depth = texelFetch(uDepthUnit, texel, 0).x;
+
+	for(int s = 1; s < SAMPLE_COUNT; ++s)
+	{
+		vec3 n = decodeNormal(texelFetch(uNormalUnit, texel, s));
+		float d = texelFetch(uDepthUnit, texel, s).x;
+
+		if(distance(n, normal) > NORMAL_THRESHOLD || abs(d - depth) > DEPTH_THRESHOLD)
+			return;
+	}
+
+	discard;
+}
@@ -0,0 +1,46 @@
+// Engine uniform blocks, see fuel/graphics/UniformBlocks.h for the CPU side.
+// Binding points are assigned by the engine, blocks a shader does not use are inactive.
+
+#ifndef MAX_POINT_LIGHTS
+#define MAX_POINT_LIGHTS 64
+#endif
+
+// Camera matrices, updated once per frame
+layout(std140) uniform CameraBlock
+{
+	mat4 uView;
+	mat4 uProjection;
+	mat4 uViewProjection;
+	mat4 uPreviousViewProjection;
+	vec4 uCameraPosition;
+};
+
+// Frame constants, updated once per frame
+layout(std140) uniform FrameBlock
+{
+	vec4  uRenderSize;   // width, height, 1 / width, 1 / height
+	vec4  uOutputSize;   // width, height, 1 / width, 1 / height
+	vec2  uFrameJitter;  // in render pixels
+	float uTime;         // seconds since startup
+};
+
+struct PointLight
+{
+	vec4 positionRadius;
+	vec4 color;
+	vec4 attenuation;    // linear, quadratic
+};
+
+// Scene lights
+layout(std140) uniform LightBlock
+{
+	ivec4 uLightCount;   // point lights in x
+	PointLight uPointLights[MAX_POINT_LIGHTS];
+};
+
+// Per-object data of the current draw
+layout(std140) uniform ObjectBlock
+{
+	mat4 uWorld;
+	mat4 uPreviousWorld;
+};
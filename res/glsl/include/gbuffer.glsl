@@ -0,0 +1,41 @@
+// G-buffer normal encoding, selected by NORMAL_ENCODING:
+//   0: view space normal stored as is in xyz
+//   1: octahedral encoding in xy, allowing two-channel normal attachments
+#ifndef NORMAL_ENCODING
+#define NORMAL_ENCODING 0
+#endif
+
+#if NORMAL_ENCODING == 1
+
+vec2 signNotZero(vec2 v)
+{
+	return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec4 encodeNormal(vec3 n)
+{
+	vec2 p = n.xy / (abs(n.x) + abs(n.y) + abs(n.z));
+	p = (n.z <= 0.0) ? (1.0 - abs(p.yx)) * signNotZero(p) : p;
+	return vec4(p, 0.0, 0.0);
+}
+
+vec3 decodeNormal(vec4 encoded)
+{
+	vec3 n = vec3(encoded.xy, 1.0 - abs(encoded.x) - abs(encoded.y));
+	if(n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * signNotZero(n.xy);
+	return normalize(n);
+}
+
+#else
+
+vec4 encodeNormal(vec3 n)
+{
+	return vec4(n, 0.0);
+}
+
+vec3 decodeNormal(vec4 encoded)
+{
+	return encoded.xyz;
+}
+
+#endif
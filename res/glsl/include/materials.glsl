@@ -0,0 +1,45 @@
+// Material textures, see fuel/graphics/GLMaterialTable.h for the CPU side.
+// With FUEL_BINDLESS defined, the handles of all materials' textures are read from
+// a storage buffer and the material is selected per draw. Otherwise the current
+// material's textures are bound to the units of uMaterialTextures.
+// Include before any declaration, the bindless path enables extensions.
+//
+// Sample with MATERIAL_TEXTURE(material, slot), slot being a constant expression.
+// The material has to be dynamically uniform, e.g. a uniform or gl_DrawIDARB,
+// unless FUEL_NONUNIFORM_MATERIALS is defined (GLMaterialTable::isNonUniformSupported()),
+// which allows it to vary per instance or vertex through NV_gpu_shader5.
+
+#ifndef MATERIAL_TEXTURES
+#define MATERIAL_TEXTURES 4
+#endif
+
+#ifndef MATERIAL_BINDING
+#define MATERIAL_BINDING 0
+#endif
+
+#ifdef FUEL_BINDLESS
+
+#extension GL_ARB_bindless_texture : require
+#extension GL_ARB_shader_storage_buffer_object : require
+#extension GL_ARB_shading_language_420pack : require
+
+#ifdef FUEL_NONUNIFORM_MATERIALS
+#extension GL_NV_gpu_shader5 : require
+#endif
+
+// Texture handles, MATERIAL_TEXTURES per material
+layout(std430, binding = MATERIAL_BINDING) readonly buffer MaterialBlock
+{
+	uvec2 uMaterialHandles[];
+};
+
+#define MATERIAL_TEXTURE(material, slot) sampler2D(uMaterialHandles[(material) * MATERIAL_TEXTURES + (slot)])
+
+#else
+
+// Textures of the current material, set to the units from the firstUnit passed to GLMaterialTable::bind() on
+uniform sampler2D uMaterialTextures[MATERIAL_TEXTURES];
+
+#define MATERIAL_TEXTURE(material, slot) uMaterialTextures[slot]
+
+#endif
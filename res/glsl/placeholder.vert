@@ -0,0 +1,12 @@
+#version 330
+
+// Bound to attribute 0 like in every program, only keeps the attribute active
+in vec3 vPosition;
+
+// Stands in for programs which are still being compiled. Moves every vertex
+// behind the far plane, so the geometry is not drawn at all instead of being
+// drawn with uniforms meant for a different program.
+void main()
+{
+	gl_Position = vec4(vPosition * 0.0, 0.0) + vec4(0.0, 0.0, 2.0, 1.0);
+}
@@ -0,0 +1,111 @@
+#version 330
+
+// Lit image at render resolution
+uniform sampler2D uColorUnit;
+
+// Accumulated image of the previous frame at output resolution
+uniform sampler2D uHistoryUnit;
+
+// G-buffer motion vectors (current - previous position in texture space)
+uniform sampler2D uVelocityUnit;
+
+// G-buffer depth
+uniform sampler2D uDepthUnit;
+
+// Jitter offset of the current frame in render pixels
+uniform vec2 uJitter;
+
+// Render and output resolution in pixels
+uniform vec2 uRenderSize;
+uniform vec2 uOutputSize;
+
+// 0 if the history holds no usable content
+uniform float uHistoryValid;
+
+out vec4 fColor;
+
+// Blend factor of the current frame for a sample right on the pixel centre
+const float CURRENT_WEIGHT = 0.1;
+
+// Width of the variance clipping box in standard deviations
+const float VARIANCE_CLIP = 1.25;
+
+vec3 toYCoCg(vec3 c)
+{
+	return vec3(
+		 0.25 * c.r + 0.5 * c.g + 0.25 * c.b,
+		 0.5  * c.r              - 0.5  * c.b,
+		-0.25 * c.r + 0.5 * c.g - 0.25 * c.b
+	);
+}
+
+vec3 toRGB(vec3 c)
+{
+	return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+vec3 fetchColor(ivec2 texel)
+{
+	texel = clamp(texel, ivec2(0), ivec2(uRenderSize) - 1);
+	return toYCoCg(texelFetch(uColorUnit, texel, 0).rgb);
+}
+
+void main()
+{
+	vec2 uv = gl_FragCoord.xy / uOutputSize;
+	vec2 renderPos = uv * uRenderSize;
+	ivec2 center = ivec2(renderPos);
+
+	// Use the motion of the closest surface around the pixel, so edges are not smeared
+	ivec2 closestTexel = center;
+	float closestDepth = 1.0;
+	for(int y = -1; y <= 1; ++y)
+	{
+		for(int x = -1; x <= 1; ++x)
+		{
+			ivec2 texel = clamp(center + ivec2(x, y), ivec2(0), ivec2(uRenderSize) - 1);
+			float depth = texelFetch(uDepthUnit, texel, 0).x;
+			if(depth < closestDepth){ closestDepth = depth; closestTexel = texel; }
+		}
+	}
+	vec2 velocity = texelFetch(uVelocityUnit, closestTexel, 0).xy;
+
+	// The jittered projection moved the scene by uJitter, so texel t saw the
+	// scene at t + 0.5 - uJitter. Find the texel whose sample is nearest.
+	vec2 samplePos = renderPos + uJitter - 0.5;
+	ivec2 nearest = ivec2(floor(samplePos + 0.5));
+	vec3 current = fetchColor(nearest);
+
+	// Neighbourhood statistics of the current frame
+	vec3 m1 = vec3(0.0), m2 = vec3(0.0);
+	vec3 lo = current, hi = current;
+	for(int y = -1; y <= 1; ++y)
+	{
+		for(int x = -1; x <= 1; ++x)
+		{
+			vec3 c = fetchColor(nearest + ivec2(x, y));
+			m1 += c;
+			m2 += c * c;
+			lo = min(lo, c);
+			hi = max(hi, c);
+		}
+	}
+	vec3 mean = m1 / 9.0;
+	vec3 sigma = sqrt(max(m2 / 9.0 - mean * mean, 0.0));
+	lo = max(lo, mean - VARIANCE_CLIP * sigma);
+	hi = min(hi, mean + VARIANCE_CLIP * sigma);
+
+	// Reproject and clamp the history
+	vec2 historyUV = uv - velocity;
+	vec3 history = clamp(toYCoCg(texture(uHistoryUnit, historyUV).rgb), lo, hi);
+
+	// Samples far from the output pixel centre contribute less (matters when upsampling)
+	vec2 offset = (samplePos - vec2(nearest)) * (uOutputSize / uRenderSize);
+	float weight = CURRENT_WEIGHT * exp(-2.29 * dot(offset, offset));
+
+	// Without valid history take the current frame as is
+	bool offscreen = any(lessThan(historyUV, vec2(0.0))) || any(greaterThan(historyUV, vec2(1.0)));
+	float alpha = (uHistoryValid < 0.5 || offscreen) ? 1.0 : max(weight, 0.02);
+
+	fColor = vec4(toRGB(mix(history, current, alpha)), 1.0);
+}
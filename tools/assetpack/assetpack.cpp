@@ -0,0 +1,276 @@
+/*****************************************************************
+ * assetpack.cpp
+ *****************************************************************
+ * Created on: 20.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+/*
+ * Asset pack builder.
+ * Packs files into an .fpk asset pack (see fuel/core/PackFile.h), which the
+ * engine mounts at startup instead of opening every file on its own.
+ * Directories are packed recursively. Entries are named by their path as
+ * given on the command line, with forward slashes, which has to match the
+ * file names the engine opens (e.g. run from the game's working directory:
+ * assetpack res.fpk res).
+ *
+ * Usage: assetpack [-c] <output.fpk> <file|directory> [...]
+ * -c stores entries as LZ4 blocks where that saves at least an eighth of
+ * their size. Compressed entries are decompressed on every open, so leave
+ * textures that are uploaded straight from the pack (.ftx) uncompressed.
+ *
+ * Build from the repository root, e.g.:
+ * g++ -std=gnu++11 -O2 tools/assetpack/assetpack.cpp fuel/core/LZ4.cpp -o assetpack
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <dirent.h>
+#include "../../fuel/core/Util.h"
+#include "../../fuel/core/LZ4.h"
+#include "../../fuel/core/PackFile.h"
+
+using namespace std;
+using namespace fuel;
+
+namespace
+{
+	// File to pack
+	struct Asset
+	{
+		string name;
+		uint64_t hash;
+
+		// Payload as stored and its encoding
+		vector<uint8_t> data;
+		uint64_t originalSize;
+		uint32_t compression;
+	};
+
+	/**
+	 * Adds a file or, recursively, the files of a directory.
+	 */
+	void collect(const string &path, vector<string> &files)
+	{
+		DIR *pDir = opendir(path.c_str());
+		if(pDir == nullptr)
+		{
+			files.push_back(path);
+			return;
+		}
+		while(dirent *pEntry = readdir(pDir))
+		{
+			if(strcmp(pEntry->d_name, ".") != 0 && strcmp(pEntry->d_name, "..") != 0) collect(path + "/" + pEntry->d_name, files);
+		}
+		closedir(pDir);
+	}
+
+	/**
+	 * Converts a path into an entry name.
+	 */
+	string normalize(string path)
+	{
+		replace(path.begin(), path.end(), '\\', '/');
+		while(path.compare(0, 2, "./") == 0) path.erase(0, 2);
+		return path;
+	}
+
+	/**
+	 * Finds a displacement seed for every bucket, such that all names land in distinct slots.
+	 * Buckets are placed largest first, while most slots are still free.
+	 */
+	bool buildPerfectHash(const vector<Asset> &assets, uint32_t buckets, vector<uint32_t> &seeds, vector<uint32_t> &slots)
+	{
+		uint32_t entries = assets.size();
+		vector<vector<uint32_t>> members(buckets);
+		for(uint32_t i = 0; i < entries; ++i) members[PackFile::bucket(assets[i].hash, buckets)].push_back(i);
+
+		vector<uint32_t> order(buckets);
+		for(uint32_t i = 0; i < buckets; ++i) order[i] = i;
+		stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){ return members[a].size() > members[b].size(); });
+
+		seeds.assign(buckets, 0);
+		slots.assign(entries, 0);
+		vector<bool> taken(entries, false);
+		vector<uint32_t> candidate;
+		for(uint32_t bucket : order)
+		{
+			const vector<uint32_t> &bucketMembers = members[bucket];
+			if(bucketMembers.empty()) break;
+
+			uint32_t seed = 0;
+			for(;; ++seed)
+			{
+				if(seed == 0xFFFFFFFF) return false;
+
+				candidate.clear();
+				bool fits = true;
+				for(uint32_t i : bucketMembers)
+				{
+					uint32_t slot = PackFile::slot(assets[i].hash, seed, entries);
+					if(taken[slot] || find(candidate.begin(), candidate.end(), slot) != candidate.end()){ fits = false; break; }
+					candidate.push_back(slot);
+				}
+				if(fits) break;
+			}
+
+			seeds[bucket] = seed;
+			for(size_t i = 0; i < bucketMembers.size(); ++i)
+			{
+				taken[candidate[i]] = true;
+				slots[bucketMembers[i]] = candidate[i];
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Pads the file with zeros up to the next multiple of the alignment.
+	 */
+	uint64_t pad(FILE *pFile, uint64_t position, uint64_t alignment)
+	{
+		static const vector<uint8_t> zeros(PackFile::ALIGNMENT, 0);
+		uint64_t padding = (alignment - position % alignment) % alignment;
+		fwrite(zeros.data(), 1, padding, pFile);
+		return position + padding;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int arg = 1;
+	bool compress = arg < argc && strcmp(argv[arg], "-c") == 0;
+	if(compress) ++arg;
+	if(argc - arg < 2)
+	{
+		cerr << "Usage: assetpack [-c] <output.fpk> <file|directory> [...]" << endl;
+		return 1;
+	}
+	string output = argv[arg++];
+
+	// Gather the files, the output itself is never packed
+	vector<string> files;
+	for(; arg < argc; ++arg) collect(argv[arg], files);
+	for(string &file : files) file = normalize(file);
+	sort(files.begin(), files.end());
+	files.erase(unique(files.begin(), files.end()), files.end());
+	files.erase(remove(files.begin(), files.end(), normalize(output)), files.end());
+
+	vector<Asset> assets;
+	uint64_t originalTotal = 0, storedTotal = 0;
+	for(const string &file : files)
+	{
+		Asset asset;
+		asset.name = file;
+		asset.hash = hashFNV1a(file);
+		asset.compression = PackFile::NONE;
+		if(!readFile(file, asset.data))
+		{
+			cerr << "Could not read '" << file << "'." << endl;
+			return 1;
+		}
+		asset.originalSize = asset.data.size();
+
+		if(compress && !asset.data.empty())
+		{
+			vector<uint8_t> block(LZ4::compressBound(asset.data.size()));
+			block.resize(LZ4::compress(asset.data.data(), asset.data.size(), block.data(), block.size()));
+			if(block.size() <= asset.data.size() - asset.data.size() / 8)
+			{
+				asset.data = std::move(block);
+				asset.compression = PackFile::LZ4;
+			}
+		}
+		originalTotal += asset.originalSize;
+		storedTotal += asset.data.size();
+		assets.push_back(std::move(asset));
+	}
+	if(assets.size() > 0xFFFFFFFFu)
+	{
+		cerr << "Too many files." << endl;
+		return 1;
+	}
+
+	// Distinct names with equal 64-bit hashes cannot be told apart by the table
+	vector<uint64_t> hashes;
+	for(const Asset &asset : assets) hashes.push_back(asset.hash);
+	sort(hashes.begin(), hashes.end());
+	if(adjacent_find(hashes.begin(), hashes.end()) != hashes.end())
+	{
+		cerr << "Hash collision between two file names." << endl;
+		return 1;
+	}
+
+	PackFile::Header header = {};
+	header.magic = PackFile::MAGIC;
+	header.entries = assets.size();
+	header.buckets = std::max<uint32_t>((header.entries + PackFile::BUCKET_SIZE - 1) / PackFile::BUCKET_SIZE, 1);
+
+	vector<uint32_t> seeds, slots;
+	if(!buildPerfectHash(assets, header.buckets, seeds, slots))
+	{
+		cerr << "Could not build the lookup table." << endl;
+		return 1;
+	}
+
+	// Lay out tables, names and payloads
+	uint64_t tableOffset = (sizeof(PackFile::Header) + seeds.size() * 4 + 7) & ~7ULL;
+	header.namesOffset = tableOffset + assets.size() * sizeof(PackFile::Entry);
+	vector<PackFile::Entry> table(assets.size());
+	string names;
+	uint64_t position = header.namesOffset;
+	for(const Asset &asset : assets) position += asset.name.size();
+	header.namesSize = position - header.namesOffset;
+	for(size_t i = 0; i < assets.size(); ++i)
+	{
+		const Asset &asset = assets[i];
+		position = (position + PackFile::ALIGNMENT - 1) / PackFile::ALIGNMENT * PackFile::ALIGNMENT;
+
+		PackFile::Entry &entry = table[slots[i]];
+		entry.hash = asset.hash;
+		entry.offset = position;
+		entry.size = asset.data.size();
+		entry.originalSize = asset.originalSize;
+		entry.nameOffset = names.size();
+		entry.nameLength = asset.name.size();
+		entry.compression = asset.compression;
+		entry.padding = 0;
+		names += asset.name;
+		position += asset.data.size();
+	}
+
+	FILE *pFile = fopen(output.c_str(), "wb");
+	if(pFile == nullptr)
+	{
+		cerr << "Could not write '" << output << "'." << endl;
+		return 1;
+	}
+	fwrite(&header, sizeof(header), 1, pFile);
+	fwrite(seeds.data(), 4, seeds.size(), pFile);
+	pad(pFile, sizeof(header) + seeds.size() * 4, 8);
+	fwrite(table.data(), sizeof(PackFile::Entry), table.size(), pFile);
+	fwrite(names.data(), 1, names.size(), pFile);
+	position = header.namesOffset + names.size();
+	for(const Asset &asset : assets)
+	{
+		position = pad(pFile, position, PackFile::ALIGNMENT);
+		fwrite(asset.data.data(), 1, asset.data.size(), pFile);
+		position += asset.data.size();
+	}
+	bool success = ferror(pFile) == 0;
+	success = fclose(pFile) == 0 && success;
+	if(!success)
+	{
+		cerr << "Could not write '" << output << "'." << endl;
+		return 1;
+	}
+
+	cout << "Packed " << assets.size() << " files, " << originalTotal / 1024 << " KiB stored in "
+		 << storedTotal / 1024 << " KiB, pack size " << position / 1024 << " KiB." << endl;
+	return 0;
+}
@@ -0,0 +1,228 @@
+/*****************************************************************
+ * dxtbench.cpp
+ *****************************************************************
+ * Created on: 15.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+/*
+ * DXT compressor benchmark.
+ * Compresses an image (or a generated 4096x4096 test pattern) with the scalar,
+ * SIMD and multithreaded SIMD block compressors of lib/soil/image_DXT.c and
+ * reports throughput, RMSE against the source and blocks differing from the
+ * scalar output.
+ *
+ * Usage: dxtbench [input image]
+ *
+ * Build from the repository root, e.g.:
+ * gcc -O2 -c lib/soil/stb_image_aug.c lib/soil/image_DXT.c lib/soil/soil_parallel.c
+ * g++ -std=gnu++11 -O2 -Ilib/soil tools/dxtbench/dxtbench.cpp stb_image_aug.o image_DXT.o soil_parallel.o -pthread -o dxtbench
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <stb_image_aug.h>
+extern "C"
+{
+#include <image_DXT.h>
+}
+
+using namespace std;
+
+namespace
+{
+	// Compression runs per configuration, the fastest one counts
+	const int RUNS = 3;
+
+	/**
+	 * Expands a 565 color to 888.
+	 */
+	void from565(unsigned color, int rgb[3])
+	{
+		rgb[0] = ((color >> 11) & 31) * 255 / 31;
+		rgb[1] = ((color >> 5) & 63) * 255 / 63;
+		rgb[2] = (color & 31) * 255 / 31;
+	}
+
+	/**
+	 * Decodes a DXT1 or DXT5 image to RGBA.
+	 */
+	vector<uint8_t> decode(const vector<uint8_t> &blocks, int width, int height, bool dxt5)
+	{
+		vector<uint8_t> image(static_cast<size_t>(width) * height * 4);
+		int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+		const uint8_t *pBlock = blocks.data();
+		for(int by = 0; by < blocksY; ++by)
+		{
+			for(int bx = 0; bx < blocksX; ++bx)
+			{
+				// Alpha palette
+				int alpha[8] = {255, 255, 255, 255, 255, 255, 255, 255};
+				uint64_t alphaBits = 0;
+				if(dxt5)
+				{
+					alpha[0] = pBlock[0];
+					alpha[1] = pBlock[1];
+					for(int i = 2; i < 8; ++i)
+					{
+						alpha[i] = (alpha[0] > alpha[1])
+							? ((8 - i) * alpha[0] + (i - 1) * alpha[1]) / 7
+							: (i < 6 ? ((6 - i) * alpha[0] + (i - 1) * alpha[1]) / 5 : (i == 6 ? 0 : 255));
+					}
+					for(int i = 0; i < 6; ++i) alphaBits |= static_cast<uint64_t>(pBlock[2 + i]) << (8 * i);
+					pBlock += 8;
+				}
+
+				// Color palette
+				unsigned c0 = pBlock[0] | (pBlock[1] << 8), c1 = pBlock[2] | (pBlock[3] << 8);
+				int palette[4][3];
+				from565(c0, palette[0]);
+				from565(c1, palette[1]);
+				for(int c = 0; c < 3; ++c)
+				{
+					if(c0 > c1 || dxt5)
+					{
+						palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+						palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+					}
+					else
+					{
+						palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+						palette[3][c] = 0;
+					}
+				}
+				uint32_t colorBits = pBlock[4] | (pBlock[5] << 8) | (pBlock[6] << 16) | (static_cast<uint32_t>(pBlock[7]) << 24);
+				pBlock += 8;
+
+				for(int p = 0; p < 16; ++p)
+				{
+					int x = bx * 4 + (p & 3), y = by * 4 + (p >> 2);
+					if(x >= width || y >= height) continue;
+					uint8_t *pTexel = &image[(static_cast<size_t>(y) * width + x) * 4];
+					const int *pColor = palette[(colorBits >> (2 * p)) & 3];
+					pTexel[0] = pColor[0];
+					pTexel[1] = pColor[1];
+					pTexel[2] = pColor[2];
+					pTexel[3] = alpha[(alphaBits >> (3 * p)) & 7];
+				}
+			}
+		}
+		return image;
+	}
+
+	/**
+	 * Calculates the RMSE between two RGBA images over the given channels.
+	 */
+	double rmse(const vector<uint8_t> &a, const vector<uint8_t> &b, int firstChannel, int channels)
+	{
+		double sum = 0.0;
+		size_t count = 0;
+		for(size_t i = 0; i < a.size(); i += 4)
+		{
+			for(int c = firstChannel; c < firstChannel + channels; ++c, ++count)
+			{
+				double difference = static_cast<double>(a[i + c]) - b[i + c];
+				sum += difference * difference;
+			}
+		}
+		return sqrt(sum / count);
+	}
+
+	/**
+	 * Generates a test pattern of gradients, hard edges, noise and varying alpha.
+	 */
+	vector<uint8_t> generate(int width, int height)
+	{
+		vector<uint8_t> image(static_cast<size_t>(width) * height * 4);
+		srand(42);
+		for(int y = 0; y < height; ++y)
+		{
+			for(int x = 0; x < width; ++x)
+			{
+				uint8_t *pTexel = &image[(static_cast<size_t>(y) * width + x) * 4];
+				int region = ((x / 512) + (y / 512)) % 3;
+				pTexel[0] = region == 0 ? x * 255 / width : ((x / 64 + y / 64) & 1) * 255;
+				pTexel[1] = region == 1 ? rand() & 255 : y * 255 / height;
+				pTexel[2] = static_cast<uint8_t>(128 + 127 * sin(x * 0.01 + y * 0.02));
+				pTexel[3] = static_cast<uint8_t>((x ^ y) & 255);
+			}
+		}
+		return image;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int width = 4096, height = 4096;
+	vector<uint8_t> image;
+	if(argc > 1)
+	{
+		int channels;
+		stbi_uc *pTexels = stbi_load(argv[1], &width, &height, &channels, 4);
+		if(pTexels == nullptr)
+		{
+			cerr << "Could not load '" << argv[1] << "': " << stbi_failure_reason() << endl;
+			return 1;
+		}
+		image.assign(pTexels, pTexels + static_cast<size_t>(width) * height * 4);
+		stbi_image_free(pTexels);
+	}
+	else image = generate(width, height);
+
+	cout << "Image: " << width << "x" << height << endl;
+	cout << left << setw(8) << "Format" << setw(10) << "Kernel" << setw(9) << "Threads"
+		 << right << setw(10) << "ms" << setw(12) << "MPixel/s" << setw(10) << "RMSE" << setw(10) << "RMSE a"
+		 << setw(16) << "Differ scalar" << endl;
+
+	for(int dxt5 = 0; dxt5 <= 1; ++dxt5)
+	{
+		vector<uint8_t> reference;
+		const struct { int simd, threads; } CONFIGS[] = {{0, 1}, {1, 1}, {1, 0}};
+		for(const auto &config : CONFIGS)
+		{
+			const char *kernel = set_DXT_compression_SIMD(config.simd);
+			set_DXT_compression_threads(config.threads);
+
+			double best = 1e30;
+			vector<uint8_t> blocks;
+			for(int run = 0; run < RUNS; ++run)
+			{
+				int size = 0;
+				auto start = chrono::high_resolution_clock::now();
+				unsigned char *pBlocks = dxt5
+					? convert_image_to_DXT5(image.data(), width, height, 4, &size)
+					: convert_image_to_DXT1(image.data(), width, height, 4, &size);
+				double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+				best = std::min(best, seconds);
+				blocks.assign(pBlocks, pBlocks + size);
+				free(pBlocks);
+			}
+			if(reference.empty()) reference = blocks;
+
+			// Blocks whose encoding differs from the scalar compressor's
+			size_t blockSize = dxt5 ? 16 : 8, differing = 0;
+			for(size_t i = 0; i < blocks.size(); i += blockSize)
+			{
+				if(memcmp(&blocks[i], &reference[i], blockSize) != 0) ++differing;
+			}
+
+			vector<uint8_t> decoded = decode(blocks, width, height, dxt5);
+			cout << left << setw(8) << (dxt5 ? "DXT5" : "DXT1") << setw(10) << kernel
+				 << setw(9) << (config.threads ? to_string(config.threads) : string("all")) << right << fixed
+				 << setprecision(1) << setw(10) << best * 1000.0
+				 << setw(12) << width * static_cast<double>(height) / best / 1e6
+				 << setprecision(3) << setw(10) << rmse(image, decoded, 0, 3)
+				 << setw(10) << (dxt5 ? rmse(image, decoded, 3, 1) : 0.0)
+				 << setw(16) << differing << endl;
+		}
+	}
+	return 0;
+}
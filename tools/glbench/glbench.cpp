@@ -0,0 +1,278 @@
+/*****************************************************************
+ * glbench.cpp
+ *****************************************************************
+ * Created on: 24.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+/*
+ * OpenGL startup and submission benchmark, run in a hidden window.
+ *
+ * glbench link [variants]   (default: 4)
+ * Links every program of res/glsl (placeholder.vert with each fragment shader)
+ * in the given number of variants through GLShaderProgram and reports the time
+ * until all are ready and the binary program cache statistics. Run it once after
+ * deleting cache/glsl for a cold start, then again for a warm one. Drivers keep
+ * their own shader caches as well, start every run with an empty one to measure
+ * the engine's cache alone (e.g. Mesa: MESA_SHADER_CACHE_DIR=<empty directory>;
+ * disabling Mesa's cache also disables program binaries).
+ *
+ * glbench draw [objects] [frames]   (default: 1000 200)
+ * Draws one triangle per object and frame, setting the camera and per-object
+ * matrices as individual uniforms, then through the engine's uniform blocks
+ * (camera block per frame, object block per draw from a GLUniformRing). Reports
+ * the OpenGL calls per frame as counted by GLCallCounter, and the median time to
+ * submit a frame and until the GPU finished it.
+ *
+ * Run from the repository root. Build there as well, e.g. on Windows:
+ * g++ -std=gnu++11 -O2 -DGLEW_STATIC -Ilib/glew-1.12.0/include -Ilib/glfw-3.1.1/include -Ilib/glm-0.9.6.3
+ *     tools/glbench/glbench.cpp fuel/core/AssetPack.cpp fuel/core/MappedFile.cpp fuel/core/LZ4.cpp
+ *     fuel/graphics/GLCallCounter.cpp fuel/graphics/GLMemoryCounter.cpp fuel/graphics/GLUniformBuffer.cpp
+ *     fuel/graphics/GLUniformRing.cpp fuel/graphics/shaders/GLProgramCache.cpp fuel/graphics/shaders/GLShader.cpp
+ *     fuel/graphics/shaders/GLShaderPreprocessor.cpp fuel/graphics/shaders/GLShaderProgram.cpp
+ *     fuel/graphics/shaders/GLUniform.cpp -Llib -lglfw3 -lglew32 -lopengl32 -lgdi32 -o glbench
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <glm/gtc/matrix_transform.hpp>
+#include "../../fuel/graphics/shaders/GLShaderProgram.h"
+#include "../../fuel/graphics/shaders/GLProgramCache.h"
+#include "../../fuel/graphics/GLUniformBuffer.h"
+#include "../../fuel/graphics/GLUniformRing.h"
+#include "../../fuel/graphics/UniformBlocks.h"
+#include "../../fuel/graphics/GLCallCounter.h"
+
+using namespace std;
+using namespace fuel;
+
+namespace
+{
+	// Frames drawn before measuring
+	const unsigned WARMUP_FRAMES = 20;
+
+	/**
+	 * Returns the seconds elapsed since the given time point.
+	 */
+	double secondsSince(const chrono::high_resolution_clock::time_point &start)
+	{
+		return chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+	}
+
+	/**
+	 * Links all programs in the given number of variants and waits for them.
+	 */
+	int benchLink(unsigned variants)
+	{
+		static const char *fragmentShaders[] =
+		{
+			"res/glsl/placeholder.frag", "res/glsl/blit_ms.frag", "res/glsl/classify.frag", "res/glsl/taa.frag"
+		};
+
+		cout << "Binary program cache: " << (GLProgramCache::isSupported() ? "supported" : "not supported") << endl;
+
+		auto start = chrono::high_resolution_clock::now();
+		vector<unique_ptr<GLShaderProgram>> programs;
+		for(const char *fragmentShader : fragmentShaders)
+		{
+			for(unsigned variant = 0; variant < variants; ++variant)
+			{
+				// Each variant has different sources, so it is a program of its own
+				auto pProgram = fuel::make_unique<GLShaderProgram>();
+				pProgram->setDefine("GLBENCH_VARIANT", to_string(variant));
+				pProgram->setShader(EGLShaderType::VERTEX,   "res/glsl/placeholder.vert");
+				pProgram->setShader(EGLShaderType::FRAGMENT, fragmentShader);
+				pProgram->bindVertexAttribute(0, "vPosition");
+				pProgram->link();
+				programs.push_back(std::move(pProgram));
+			}
+		}
+
+		unsigned failed = 0;
+		for(auto &pProgram : programs)
+		{
+			if(!pProgram->finish()) ++failed;
+		}
+		double seconds = secondsSince(start);
+
+		GLProgramCache::printStatistics();
+		cout << programs.size() << " programs ready after " << seconds * 1000.0 << " ms";
+		if(failed > 0) cout << ", " << failed << " failed";
+		cout << endl;
+		return failed > 0 ? 1 : 0;
+	}
+
+	/**
+	 * Draws the given number of frames and prints the calls and median times per frame.
+	 */
+	void measure(const string &name, unsigned frames, const function<void(void)> &frame)
+	{
+		vector<double> submitTimes, frameTimes;
+		unsigned calls[static_cast<unsigned>(EGLCall::COUNT)] = {};
+		for(unsigned i = 0; i < WARMUP_FRAMES + frames; ++i)
+		{
+			GLCallCounter::reset();
+			auto start = chrono::high_resolution_clock::now();
+			frame();
+			double submitted = secondsSince(start);
+			glFinish();
+			if(i < WARMUP_FRAMES) continue;
+
+			submitTimes.push_back(submitted);
+			frameTimes.push_back(secondsSince(start));
+			for(unsigned call = 0; call < static_cast<unsigned>(EGLCall::COUNT); ++call)
+			{
+				calls[call] = GLCallCounter::get(static_cast<EGLCall>(call));
+			}
+		}
+		nth_element(submitTimes.begin(), submitTimes.begin() + frames / 2, submitTimes.end());
+		nth_element(frameTimes.begin(), frameTimes.begin() + frames / 2, frameTimes.end());
+
+		unsigned total = 0;
+		for(unsigned count : calls) total += count;
+		cout << setw(10) << name << setw(10) << total
+			 << setw(10) << calls[static_cast<unsigned>(EGLCall::UNIFORM)]
+			 << setw(10) << calls[static_cast<unsigned>(EGLCall::BUFFER)]
+			 << setw(10) << calls[static_cast<unsigned>(EGLCall::PROGRAM)]
+			 << setw(10) << calls[static_cast<unsigned>(EGLCall::DRAW)]
+			 << setw(12) << fixed << setprecision(3) << submitTimes[frames / 2] * 1000.0
+			 << setw(12) << frameTimes[frames / 2] * 1000.0 << endl;
+	}
+
+	/**
+	 * Draws the objects with uniforms and with uniform blocks.
+	 */
+	int benchDraw(unsigned objects, unsigned frames)
+	{
+		// One small triangle, drawn once per object
+		const GLfloat vertices[] = { -0.01f, -0.01f, 0.0f, 0.01f, -0.01f, 0.0f, 0.0f, 0.01f, 0.0f };
+		GLuint vertexArrayID, bufferID;
+		glGenVertexArrays(1, &vertexArrayID);
+		glBindVertexArray(vertexArrayID);
+		glGenBuffers(1, &bufferID);
+		glBindBuffer(GL_ARRAY_BUFFER, bufferID);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+		GLShaderProgram::setDefaultBlockBinding("CameraBlock", CAMERA_BLOCK);
+		GLShaderProgram::setDefaultBlockBinding("ObjectBlock", OBJECT_BLOCK);
+
+		GLShaderProgram uniformProgram, blockProgram;
+		uniformProgram.setShader(EGLShaderType::VERTEX,   "tools/glbench/object_uniforms.vert");
+		uniformProgram.setShader(EGLShaderType::FRAGMENT, "res/glsl/placeholder.frag");
+		uniformProgram.bindVertexAttribute(0, "vPosition");
+		uniformProgram.link();
+		blockProgram.setShader(EGLShaderType::VERTEX,   "tools/glbench/object_blocks.vert");
+		blockProgram.setShader(EGLShaderType::FRAGMENT, "res/glsl/placeholder.frag");
+		blockProgram.bindVertexAttribute(0, "vPosition");
+		blockProgram.link();
+		if(!uniformProgram.finish() || !blockProgram.finish())
+		{
+			cerr << "Could not link the benchmark programs." << endl;
+			return 1;
+		}
+
+		auto viewProjection = uniformProgram.getUniformHandle<glm::mat4>("uViewProjection");
+		auto world = uniformProgram.getUniformHandle<glm::mat4>("uWorld");
+		auto previousWorld = uniformProgram.getUniformHandle<glm::mat4>("uPreviousWorld");
+
+		GLUniformBuffer cameraUBO(CAMERA_BLOCK, sizeof(CameraBlock));
+		GLUniformRing objectUBO(OBJECT_BLOCK, sizeof(ObjectBlock), objects);
+
+		// Objects scattered across the view
+		srand(1);
+		vector<glm::mat4> worlds(objects);
+		for(glm::mat4 &matrix : worlds)
+		{
+			matrix = glm::translate(glm::mat4(1.0f), glm::vec3(rand() % 200 / 100.0f - 1.0f, rand() % 200 / 100.0f - 1.0f, 0.0f));
+		}
+		CameraBlock camera = {};
+		camera.viewProjection = glm::mat4(1.0f);
+
+		cout << objects << " objects, " << frames << " frames" << endl
+			 << setw(10) << "Path" << setw(10) << "GL calls" << setw(10) << "uniform" << setw(10) << "buffer"
+			 << setw(10) << "program" << setw(10) << "draw" << setw(12) << "submit ms" << setw(12) << "frame ms" << endl;
+
+		measure("uniforms", frames, [&]()
+		{
+			uniformProgram.use();
+			viewProjection.set(camera.viewProjection);
+			for(const glm::mat4 &matrix : worlds)
+			{
+				world.set(matrix);
+				previousWorld.set(matrix);
+				glDrawArrays(GL_TRIANGLES, 0, 3);
+				GLCallCounter::count(EGLCall::DRAW);
+			}
+		});
+
+		measure("blocks", frames, [&]()
+		{
+			objectUBO.beginFrame();
+			cameraUBO.update(camera);
+			cameraUBO.bind();
+			blockProgram.use();
+			for(const glm::mat4 &matrix : worlds)
+			{
+				ObjectBlock object;
+				object.world = matrix;
+				object.previousWorld = matrix;
+				objectUBO.push(object);
+				glDrawArrays(GL_TRIANGLES, 0, 3);
+				GLCallCounter::count(EGLCall::DRAW);
+			}
+			objectUBO.endFrame();
+		});
+
+		glBindVertexArray(GL_NONE);
+		glDeleteBuffers(1, &bufferID);
+		glDeleteVertexArrays(1, &vertexArrayID);
+		return 0;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	string mode = (argc > 1) ? argv[1] : "";
+	if(mode != "link" && mode != "draw")
+	{
+		cerr << "Usage: glbench link [variants] | glbench draw [objects] [frames]" << endl;
+		return 1;
+	}
+
+	if(glfwInit() != GL_TRUE)
+	{
+		cerr << "Could not initialize GLFW." << endl;
+		return 1;
+	}
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	GLFWwindow *pWindow = glfwCreateWindow(256, 256, "glbench", nullptr, nullptr);
+	if(pWindow == nullptr)
+	{
+		cerr << "Could not create GLFW window." << endl;
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(pWindow);
+	glewExperimental = true;
+	glewInit();
+	cout << "GPU: " << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << endl;
+
+	int result;
+	if(mode == "link") result = benchLink((argc > 2) ? atoi(argv[2]) : 4);
+	else result = benchDraw((argc > 2) ? atoi(argv[2]) : 1000, std::max((argc > 3) ? atoi(argv[3]) : 200, 1));
+
+	// The placeholder program has to be released while the context exists
+	GLShaderProgram::setPlaceholder(nullptr);
+	glfwDestroyWindow(pWindow);
+	glfwTerminate();
+	return result;
+}
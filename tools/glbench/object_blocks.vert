@@ -0,0 +1,13 @@
+#version 330
+
+// Camera and object matrices from the engine's uniform blocks
+#include "../../res/glsl/include/blocks.glsl"
+
+in vec3 vPosition;
+
+void main()
+{
+	// Both world matrices are read, like a geometry pass writing motion vectors
+	vec4 position = vec4(vPosition, 1.0);
+	gl_Position = uViewProjection * (uWorld * position + uPreviousWorld * position) * 0.5;
+}
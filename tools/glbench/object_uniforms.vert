@@ -0,0 +1,15 @@
+#version 330
+
+// Camera and object matrices as individual uniforms, set before every draw
+uniform mat4 uViewProjection;
+uniform mat4 uWorld;
+uniform mat4 uPreviousWorld;
+
+in vec3 vPosition;
+
+void main()
+{
+	// Both world matrices are read, like a geometry pass writing motion vectors
+	vec4 position = vec4(vPosition, 1.0);
+	gl_Position = uViewProjection * (uWorld * position + uPreviousWorld * position) * 0.5;
+}
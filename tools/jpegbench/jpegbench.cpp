@@ -0,0 +1,129 @@
+/*****************************************************************
+ * jpegbench.cpp
+ *****************************************************************
+ * Created on: 16.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+/*
+ * JPEG decoder benchmark.
+ * Decodes every image of a corpus to RGBA with stb_image_aug's built-in scalar
+ * IDCT / color conversion and with the SIMD kernels of lib/soil/stbi_SIMD.c,
+ * reports throughput in MB/s of compressed input and MPixel/s and verifies
+ * both decoders produce identical output.
+ *
+ * Usage: jpegbench <image> [image ...]
+ *
+ * Build from the repository root, e.g.:
+ * gcc -O2 -c lib/soil/stb_image_aug.c lib/soil/stbi_SIMD.c
+ * g++ -std=gnu++11 -O2 -Ilib/soil tools/jpegbench/jpegbench.cpp stb_image_aug.o stbi_SIMD.o -o jpegbench
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <stb_image_aug.h>
+#include <stbi_SIMD.h>
+
+using namespace std;
+
+namespace
+{
+	// Decode runs per file and kernel, the fastest one counts
+	const int RUNS = 5;
+
+	struct Result
+	{
+		double seconds = 1e30;
+		vector<uint8_t> image;
+	};
+
+	/**
+	 * Decodes an in-memory JPEG RUNS times with the currently installed kernels.
+	 */
+	bool decode(const vector<uint8_t> &file, int &width, int &height, Result &result)
+	{
+		for(int run = 0; run < RUNS; ++run)
+		{
+			int channels;
+			auto start = chrono::high_resolution_clock::now();
+			stbi_uc *pTexels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, 4);
+			double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+			if(pTexels == nullptr) return false;
+
+			result.seconds = std::min(result.seconds, seconds);
+			result.image.assign(pTexels, pTexels + static_cast<size_t>(width) * height * 4);
+			stbi_image_free(pTexels);
+		}
+		return true;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	if(argc < 2)
+	{
+		cerr << "Usage: jpegbench <image> [image ...]" << endl;
+		return 1;
+	}
+
+	cout << left << setw(32) << "File" << right << setw(12) << "Size" << setw(12) << "KiB"
+		 << setw(14) << "scalar MB/s" << setw(12) << "SIMD MB/s" << setw(14) << "SIMD MPix/s"
+		 << setw(10) << "Speedup" << setw(10) << "Exact" << endl;
+
+	const char *kernel = "scalar";
+	double totalBytes = 0.0, totalPixels = 0.0, totalScalar = 0.0, totalSIMD = 0.0;
+	int mismatches = 0;
+	for(int i = 1; i < argc; ++i)
+	{
+		ifstream in(argv[i], ios::binary);
+		vector<uint8_t> file((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+		int width, height;
+		Result scalar, simd;
+		stbi_install_SIMD(0);
+		bool ok = !file.empty() && decode(file, width, height, scalar);
+		kernel = stbi_install_SIMD(1);
+		ok = ok && decode(file, width, height, simd);
+		if(!ok)
+		{
+			cerr << "Skipping '" << argv[i] << "': " << (file.empty() ? "unreadable" : stbi_failure_reason()) << endl;
+			continue;
+		}
+
+		bool exact = scalar.image == simd.image;
+		if(!exact) ++mismatches;
+
+		double megabytes = file.size() / 1e6, pixels = width * static_cast<double>(height);
+		totalBytes += megabytes;
+		totalPixels += pixels;
+		totalScalar += scalar.seconds;
+		totalSIMD += simd.seconds;
+
+		string name = argv[i];
+		if(name.size() > 30) name = "..." + name.substr(name.size() - 27);
+		cout << left << setw(32) << name << right
+			 << setw(12) << (to_string(width) + "x" + to_string(height))
+			 << fixed << setprecision(1) << setw(12) << file.size() / 1024.0
+			 << setw(14) << megabytes / scalar.seconds << setw(12) << megabytes / simd.seconds
+			 << setw(14) << pixels / simd.seconds / 1e6
+			 << setprecision(2) << setw(10) << scalar.seconds / simd.seconds
+			 << setw(10) << (exact ? "yes" : "NO") << endl;
+	}
+
+	if(totalSIMD > 0.0)
+	{
+		cout << "Kernels: " << kernel << endl << fixed << setprecision(1)
+			 << "Total: scalar " << totalBytes / totalScalar << " MB/s (" << totalPixels / totalScalar / 1e6 << " MPixel/s), "
+			 << "SIMD " << totalBytes / totalSIMD << " MB/s (" << totalPixels / totalSIMD / 1e6 << " MPixel/s), "
+			 << setprecision(2) << "speedup " << totalScalar / totalSIMD << "x" << endl;
+	}
+	return mismatches == 0 ? 0 : 2;
+}
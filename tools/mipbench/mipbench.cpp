@@ -0,0 +1,122 @@
+/*****************************************************************
+ * mipbench.cpp
+ *****************************************************************
+ * Created on: 18.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+/*
+ * Mipmap generation benchmark.
+ * Builds the complete RGBA mipmap chain of noise images of the given sizes
+ * the way SOIL used to (every level box filtered from level 0 into its own
+ * allocation), by iterating mipmap_image, and with mipmap_chain from
+ * lib/soil/image_mipmap.c using the scalar and the SIMD kernels, single
+ * threaded and on all processors. The chains of iterated mipmap_image and
+ * every mipmap_chain configuration have to match byte for byte.
+ *
+ * Usage: mipbench [size ...]   (default: 256 1024 2048 4096)
+ *
+ * Build from the repository root, e.g.:
+ * gcc -O2 -c lib/soil/image_helper.c lib/soil/image_mipmap.c lib/soil/soil_parallel.c
+ * g++ -std=gnu++11 -O2 -Ilib/soil tools/mipbench/mipbench.cpp image_helper.o image_mipmap.o soil_parallel.o -pthread -o mipbench
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <image_helper.h>
+#include <image_mipmap.h>
+
+using namespace std;
+
+namespace
+{
+	// Runs per size and configuration, the fastest one counts
+	const int RUNS = 5;
+
+	/**
+	 * Times a chain builder, returns the fastest run in seconds.
+	 */
+	template<typename Builder> double time(vector<uint8_t> &chain, const vector<uint8_t> &base, Builder build)
+	{
+		double best = 1e30;
+		for(int run = 0; run < RUNS; ++run)
+		{
+			copy(base.begin(), base.end(), chain.begin());
+			auto start = chrono::high_resolution_clock::now();
+			build(chain.data());
+			best = std::min(best, chrono::duration<double>(chrono::high_resolution_clock::now() - start).count());
+		}
+		return best;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	vector<int> sizes;
+	for(int i = 1; i < argc; ++i) sizes.push_back(atoi(argv[i]));
+	if(sizes.empty()) sizes = {256, 1024, 2048, 4096};
+
+	const char *kernel = set_mipmap_SIMD(1);
+	cout << "Kernels: " << kernel << endl
+		 << setw(10) << "Size" << setw(12) << "SOIL ms" << setw(12) << "iter ms" << setw(12) << "scalar ms"
+		 << setw(12) << "SIMD ms" << setw(12) << "threads ms" << setw(12) << "linear ms" << setw(10) << "Speedup" << setw(8) << "Exact" << endl;
+
+	int mismatches = 0;
+	srand(1);
+	for(int size : sizes)
+	{
+		if(size < 1) continue;
+		vector<uint8_t> base(static_cast<size_t>(size) * size * 4);
+		for(uint8_t &texel : base) texel = rand();
+		vector<uint8_t> reference(mipmap_chain_size(size, size, 4)), chain(reference.size());
+
+		// Former SOIL_FLAG_MIPMAPS path: each level from level 0, one allocation per level
+		double soil = time(reference, base, [size](uint8_t *pChain)
+		{
+			for(int level = 1; (1 << level) <= size; ++level)
+			{
+				int mipSize = size >> level;
+				uint8_t *pLevel = static_cast<uint8_t *>(malloc(static_cast<size_t>(mipSize) * mipSize * 4));
+				mipmap_image(pChain, size, size, 4, pLevel, 1 << level, 1 << level);
+				free(pLevel);
+			}
+		});
+
+		// Iterated 2x2 mipmap_image into one chain, the reference output
+		double iterated = time(reference, base, [size](uint8_t *pChain)
+		{
+			for(int w = size; w > 1; pChain += static_cast<size_t>(w) * w * 4, w /= 2)
+			{
+				mipmap_image(pChain, w, w, 4, pChain + static_cast<size_t>(w) * w * 4, 2, 2);
+			}
+		});
+
+		bool exact = true;
+		auto build = [&](int simd, int threads, int srgb)
+		{
+			set_mipmap_SIMD(simd);
+			set_mipmap_threads(threads);
+			double seconds = time(chain, base, [size, srgb](uint8_t *pChain){ mipmap_chain(pChain, size, size, 4, srgb); });
+			if(!srgb) exact = exact && chain == reference;
+			return seconds;
+		};
+		double scalar = build(0, 1, 0);
+		double simd = build(1, 1, 0);
+		double threaded = build(1, 0, 0);
+		double linear = build(1, 0, 1);
+		if(!exact) ++mismatches;
+
+		cout << setw(10) << (to_string(size) + "^2") << fixed << setprecision(2)
+			 << setw(12) << soil * 1e3 << setw(12) << iterated * 1e3 << setw(12) << scalar * 1e3
+			 << setw(12) << simd * 1e3 << setw(12) << threaded * 1e3 << setw(12) << linear * 1e3
+			 << setw(10) << iterated / threaded << setw(8) << (exact ? "yes" : "NO") << endl;
+	}
+	return mismatches == 0 ? 0 : 2;
+}
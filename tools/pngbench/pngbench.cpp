@@ -0,0 +1,183 @@
+/*****************************************************************
+ * pngbench.cpp
+ *****************************************************************
+ * Created on: 17.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+/*
+ * PNG decoder benchmark.
+ * Times stb_image_aug's zlib inflate alone on every image's IDAT stream and
+ * the complete decode to RGBA with the built-in and the SIMD row unfilter of
+ * lib/soil/stbi_SIMD.c. Prints a hash of every decoded image, so the output
+ * of a binary built against another stb_image_aug.c revision can be compared
+ * directly.
+ *
+ * Usage: pngbench <image> [image ...]
+ *
+ * Build from the repository root, e.g.:
+ * gcc -O2 -c lib/soil/stb_image_aug.c lib/soil/stbi_SIMD.c
+ * g++ -std=gnu++11 -O2 -Ilib/soil tools/pngbench/pngbench.cpp stb_image_aug.o stbi_SIMD.o -o pngbench
+ *
+ * Decoders without the SIMD hooks, e.g. a previous revision from git, build
+ * with -DPNGBENCH_BASELINE and without stbi_SIMD.o:
+ * git show <revision>:lib/soil/stb_image_aug.c > lib/soil/stb_image_old.c
+ * gcc -O2 -c lib/soil/stb_image_old.c
+ * g++ -std=gnu++11 -O2 -DPNGBENCH_BASELINE -Ilib/soil tools/pngbench/pngbench.cpp stb_image_old.o -o pngbench_old
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <stb_image_aug.h>
+#ifndef PNGBENCH_BASELINE
+#include <stbi_SIMD.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+#ifdef PNGBENCH_BASELINE
+	// Without the hooks both configurations use the built-in unfilter
+	const char *stbi_install_SIMD(int){ return "scalar"; }
+#endif
+
+	// Runs per file and configuration, the fastest one counts
+	const int RUNS = 5;
+
+	/**
+	 * Concatenates the IDAT chunks of a PNG file, i.e. its zlib stream.
+	 */
+	vector<char> extractIDAT(const vector<uint8_t> &file)
+	{
+		vector<char> stream;
+		for(size_t pos = 8; pos + 12 <= file.size();)
+		{
+			uint32_t length = (file[pos] << 24) | (file[pos + 1] << 16) | (file[pos + 2] << 8) | file[pos + 3];
+			if(pos + 12 + length > file.size()) break;
+			if(equal(&file[pos + 4], &file[pos + 8], "IDAT")) stream.insert(stream.end(), &file[pos + 8], &file[pos + 8] + length);
+			pos += 12 + length;
+		}
+		return stream;
+	}
+
+	/**
+	 * Times inflating a zlib stream, returns the decompressed size.
+	 */
+	int inflate(const vector<char> &stream, double &best)
+	{
+		int size = 0;
+		for(int run = 0; run < RUNS; ++run)
+		{
+			auto start = chrono::high_resolution_clock::now();
+			char *pData = stbi_zlib_decode_malloc(stream.data(), static_cast<int>(stream.size()), &size);
+			best = std::min(best, chrono::duration<double>(chrono::high_resolution_clock::now() - start).count());
+			if(pData == nullptr) return -1;
+			free(pData);
+		}
+		return size;
+	}
+
+	/**
+	 * Times decoding a PNG to RGBA with the currently installed row unfilter.
+	 */
+	bool decode(const vector<uint8_t> &file, int &width, int &height, double &best, vector<uint8_t> &image)
+	{
+		for(int run = 0; run < RUNS; ++run)
+		{
+			int channels;
+			auto start = chrono::high_resolution_clock::now();
+			stbi_uc *pTexels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, 4);
+			best = std::min(best, chrono::duration<double>(chrono::high_resolution_clock::now() - start).count());
+			if(pTexels == nullptr) return false;
+
+			image.assign(pTexels, pTexels + static_cast<size_t>(width) * height * 4);
+			stbi_image_free(pTexels);
+		}
+		return true;
+	}
+
+	/**
+	 * FNV-1a hash of the decoded image.
+	 */
+	uint32_t fnv1a(const vector<uint8_t> &image)
+	{
+		uint32_t h = 2166136261u;
+		for(uint8_t byte : image) h = (h ^ byte) * 16777619u;
+		return h;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	if(argc < 2)
+	{
+		cerr << "Usage: pngbench <image> [image ...]" << endl;
+		return 1;
+	}
+
+	cout << left << setw(24) << "File" << right << setw(12) << "Size" << setw(10) << "KiB"
+		 << setw(14) << "inflate MB/s" << setw(16) << "scalar MPix/s" << setw(14) << "SIMD MPix/s"
+		 << setw(8) << "Exact" << setw(11) << "Hash" << endl;
+
+	double totalIn = 0.0, totalOut = 0.0, totalInflate = 0.0, totalPixels = 0.0, totalScalar = 0.0, totalSIMD = 0.0;
+	int mismatches = 0;
+	for(int i = 1; i < argc; ++i)
+	{
+		ifstream in(argv[i], ios::binary);
+		vector<uint8_t> file((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+		int width, height;
+		double inflateTime = 1e30, scalarTime = 1e30, simdTime = 1e30;
+		vector<uint8_t> scalar, simd;
+		stbi_install_SIMD(0);
+		bool ok = !file.empty() && decode(file, width, height, scalarTime, scalar);
+		stbi_install_SIMD(1);
+		ok = ok && decode(file, width, height, simdTime, simd);
+		vector<char> stream = ok ? extractIDAT(file) : vector<char>();
+		int inflated = ok ? inflate(stream, inflateTime) : -1;
+		if(!ok || inflated < 0)
+		{
+			cerr << "Skipping '" << argv[i] << "': " << (file.empty() ? "unreadable" : stbi_failure_reason()) << endl;
+			continue;
+		}
+
+		bool exact = scalar == simd;
+		if(!exact) ++mismatches;
+
+		double pixels = width * static_cast<double>(height);
+		totalIn += stream.size() / 1e6;
+		totalOut += inflated / 1e6;
+		totalInflate += inflateTime;
+		totalPixels += pixels;
+		totalScalar += scalarTime;
+		totalSIMD += simdTime;
+
+		string name = argv[i];
+		if(name.size() > 22) name = "..." + name.substr(name.size() - 19);
+		cout << left << setw(24) << name << right
+			 << setw(12) << (to_string(width) + "x" + to_string(height))
+			 << fixed << setprecision(1) << setw(10) << file.size() / 1024.0
+			 << setw(14) << stream.size() / 1e6 / inflateTime
+			 << setw(16) << pixels / scalarTime / 1e6 << setw(14) << pixels / simdTime / 1e6
+			 << setw(8) << (exact ? "yes" : "NO")
+			 << "  " << hex << setfill('0') << setw(8) << fnv1a(simd) << dec << setfill(' ') << endl;
+	}
+
+	if(totalSIMD > 0.0)
+	{
+		cout << fixed << setprecision(1)
+			 << "Inflate: " << totalIn / totalInflate << " MB/s compressed, " << totalOut / totalInflate << " MB/s decompressed" << endl
+			 << "Decode: scalar unfilter " << totalPixels / totalScalar / 1e6 << " MPixel/s, "
+			 << "SIMD unfilter " << totalPixels / totalSIMD / 1e6 << " MPixel/s" << endl;
+	}
+	return mismatches == 0 ? 0 : 2;
+}
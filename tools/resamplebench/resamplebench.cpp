@@ -0,0 +1,141 @@
+/*****************************************************************
+ * resamplebench.cpp
+ *****************************************************************
+ * Created on: 19.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+/*
+ * Image transform benchmark.
+ * Times lib/soil/image_helper.c's up_scale_image (non power of two RGBA noise
+ * scaled up to the next power of two, as SOIL does without NPOT support),
+ * scale_image_RGB_to_NTSC_safe and convert_RGB_to_YCoCg on 1K, 2K and 4K
+ * images with the scalar kernels on one thread, the SIMD kernels on one
+ * thread and the SIMD kernels on all processors, and verifies all three
+ * produce identical output. Prints a hash of every result, so the output of
+ * a binary built against another image_helper.c revision can be compared
+ * directly.
+ *
+ * Usage: resamplebench [size ...]   (default: 1000 2000 4000)
+ *
+ * Build from the repository root, e.g.:
+ * gcc -O2 -c lib/soil/image_helper.c lib/soil/soil_parallel.c
+ * g++ -std=gnu++11 -O2 -Ilib/soil tools/resamplebench/resamplebench.cpp image_helper.o soil_parallel.o -pthread -o resamplebench
+ *
+ * image_helper.c revisions without the SIMD kernels, e.g. a previous one
+ * from git, build with -DRESAMPLEBENCH_BASELINE:
+ * git show <revision>:lib/soil/image_helper.c > lib/soil/image_helper_old.c
+ * gcc -O2 -c lib/soil/image_helper_old.c
+ * g++ -std=gnu++11 -O2 -DRESAMPLEBENCH_BASELINE -Ilib/soil tools/resamplebench/resamplebench.cpp image_helper_old.o -o resamplebench_old
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <image_helper.h>
+
+using namespace std;
+
+#ifdef RESAMPLEBENCH_BASELINE
+// Without the kernels all configurations run the same code
+extern "C" const char *set_image_helper_SIMD(int){ return "scalar"; }
+extern "C" void set_image_helper_threads(int){ ; }
+#endif
+
+namespace
+{
+	// Runs per transform and configuration, the fastest one counts
+	const int RUNS = 5;
+
+	/**
+	 * FNV-1a hash of an image.
+	 */
+	uint32_t fnv1a(const vector<uint8_t> &image)
+	{
+		uint32_t h = 2166136261u;
+		for(uint8_t byte : image) h = (h ^ byte) * 16777619u;
+		return h;
+	}
+
+	/**
+	 * Times a transform writing into result, restoring the source before every run.
+	 */
+	double time(const vector<uint8_t> &source, vector<uint8_t> &result, const function<void(vector<uint8_t> &)> &transform)
+	{
+		double best = 1e30;
+		for(int run = 0; run < RUNS; ++run)
+		{
+			if(result.size() == source.size()) result = source;
+			auto start = chrono::high_resolution_clock::now();
+			transform(result);
+			best = std::min(best, chrono::duration<double>(chrono::high_resolution_clock::now() - start).count());
+		}
+		return best;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	vector<int> sizes;
+	for(int i = 1; i < argc; ++i) sizes.push_back(atoi(argv[i]));
+	if(sizes.empty()) sizes = {1000, 2000, 4000};
+
+	const char *kernel = set_image_helper_SIMD(1);
+	cout << "Kernels: " << kernel << endl
+		 << left << setw(26) << "Transform" << right << setw(12) << "scalar ms" << setw(12) << "SIMD ms"
+		 << setw(12) << "threads ms" << setw(10) << "Speedup" << setw(8) << "Exact" << setw(11) << "Hash" << endl;
+
+	int mismatches = 0;
+	srand(1);
+	for(int size : sizes)
+	{
+		if(size < 2) continue;
+		int pot = 1;
+		while(pot < size) pot *= 2;
+
+		vector<uint8_t> image(static_cast<size_t>(size) * size * 4);
+		for(uint8_t &texel : image) texel = rand();
+
+		struct Transform
+		{
+			string name;
+			size_t outputSize;
+			function<void(vector<uint8_t> &)> run;
+		};
+		const vector<Transform> transforms =
+		{
+			{"up_scale_image " + to_string(size) + "->" + to_string(pot), static_cast<size_t>(pot) * pot * 4,
+				[&](vector<uint8_t> &out){ up_scale_image(image.data(), size, size, 4, out.data(), pot, pot); }},
+			{"NTSC safe " + to_string(size), image.size(),
+				[size](vector<uint8_t> &out){ scale_image_RGB_to_NTSC_safe(out.data(), size, size, 4); }},
+			{"YCoCg " + to_string(size), image.size(),
+				[size](vector<uint8_t> &out){ convert_RGB_to_YCoCg(out.data(), size, size, 4); }}
+		};
+
+		for(const Transform &transform : transforms)
+		{
+			vector<uint8_t> scalar(transform.outputSize), simd(transform.outputSize), threaded(transform.outputSize);
+			set_image_helper_SIMD(0);
+			set_image_helper_threads(1);
+			double scalarTime = time(image, scalar, transform.run);
+			set_image_helper_SIMD(1);
+			double simdTime = time(image, simd, transform.run);
+			set_image_helper_threads(0);
+			double threadedTime = time(image, threaded, transform.run);
+
+			bool exact = scalar == simd && simd == threaded;
+			if(!exact) ++mismatches;
+			cout << left << setw(26) << transform.name << right << fixed << setprecision(2)
+				 << setw(12) << scalarTime * 1e3 << setw(12) << simdTime * 1e3 << setw(12) << threadedTime * 1e3
+				 << setw(10) << scalarTime / threadedTime << setw(8) << (exact ? "yes" : "NO")
+				 << "  " << hex << setfill('0') << setw(8) << fnv1a(threaded) << dec << setfill(' ') << endl;
+		}
+	}
+	return mismatches == 0 ? 0 : 2;
+}
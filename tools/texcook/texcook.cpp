@@ -0,0 +1,175 @@
+/*****************************************************************
+ * texcook.cpp
+ *****************************************************************
+ * Created on: 14.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+/*
+ * Offline texture cooker.
+ * Converts an image into a .ftx texture container (see fuel/graphics/TextureContainer.h)
+ * holding the complete mipmap chain, block-compressed ahead of time.
+ *
+ * Usage: texcook [-f rgba8|bc1|bc3] [-l] <input image> <output.ftx>
+ * Without -f, images with alpha become BC3 and all others BC1.
+ * -l filters the mipmaps in linear space, for sRGB encoded color textures.
+ *
+ * Build from the repository root, e.g.:
+ * gcc -O2 -c lib/soil/stb_image_aug.c lib/soil/image_mipmap.c lib/soil/image_DXT.c lib/soil/soil_parallel.c
+ * g++ -std=gnu++11 -O2 -Ilib/soil tools/texcook/texcook.cpp stb_image_aug.o image_mipmap.o image_DXT.o soil_parallel.o -pthread -o texcook
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <stb_image_aug.h>
+#include <image_mipmap.h>
+extern "C"
+{
+#include <image_DXT.h>
+}
+#include "../../fuel/graphics/TextureContainer.h"
+
+using namespace std;
+using namespace fuel;
+
+namespace
+{
+	// Uncompressed mipmap level
+	struct Image
+	{
+		int width, height;
+
+		// RGBA8 texels within the chain
+		const uint8_t *pTexels;
+	};
+
+	/**
+	 * Encodes one mipmap level in the container format.
+	 *
+	 * @param image
+	 * 		RGBA8 level.
+	 *
+	 * @param format
+	 * 		Target format.
+	 *
+	 * @return Encoded level data.
+	 */
+	vector<uint8_t> encode(const Image &image, TextureContainer::EFormat format)
+	{
+		if(format == TextureContainer::RGBA8) return vector<uint8_t>(image.pTexels, image.pTexels + static_cast<size_t>(image.width) * image.height * 4);
+
+		int size = 0;
+		unsigned char *pBlocks = (format == TextureContainer::BC1)
+			? convert_image_to_DXT1(image.pTexels, image.width, image.height, 4, &size)
+			: convert_image_to_DXT5(image.pTexels, image.width, image.height, 4, &size);
+
+		vector<uint8_t> result(pBlocks, pBlocks + size);
+		free(pBlocks);
+		return result;
+	}
+
+	/**
+	 * Prints the command line usage.
+	 *
+	 * @return Process exit code.
+	 */
+	int usage(void)
+	{
+		cerr << "Usage: texcook [-f rgba8|bc1|bc3] [-l] <input image> <output.ftx>" << endl;
+		return 1;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int arg = 1;
+	string formatName;
+	bool linear = false;
+	for(; arg < argc && argv[arg][0] == '-'; ++arg)
+	{
+		if(strcmp(argv[arg], "-f") == 0 && arg + 1 < argc) formatName = argv[++arg];
+		else if(strcmp(argv[arg], "-l") == 0) linear = true;
+		else return usage();
+	}
+	if(argc - arg != 2) return usage();
+	const char *input = argv[arg], *output = argv[arg + 1];
+
+	int width, height, channels;
+	stbi_uc *pTexels = stbi_load(input, &width, &height, &channels, 4);
+	if(pTexels == nullptr)
+	{
+		cerr << "Could not load '" << input << "': " << stbi_failure_reason() << endl;
+		return 1;
+	}
+
+	TextureContainer::EFormat format = (channels == 2 || channels == 4) ? TextureContainer::BC3 : TextureContainer::BC1;
+	if(formatName == "rgba8") format = TextureContainer::RGBA8;
+	else if(formatName == "bc1") format = TextureContainer::BC1;
+	else if(formatName == "bc3") format = TextureContainer::BC3;
+	else if(formatName == "bc7")
+	{
+		cerr << "No BC7 encoder available, the runtime only loads BC7 containers cooked elsewhere." << endl;
+		return 1;
+	}
+	else if(!formatName.empty()) return usage();
+
+	// Bottom row first, as OpenGL expects it
+	vector<uint8_t> texels(mipmap_chain_size(width, height, 4));
+	size_t rowSize = width * 4;
+	for(int y = 0; y < height; ++y)
+	{
+		memcpy(&texels[(height - 1 - y) * rowSize], pTexels + y * rowSize, rowSize);
+	}
+	stbi_image_free(pTexels);
+
+	// Box filtered mipmap chain down to a single texel
+	vector<Image> chain(mipmap_chain(texels.data(), width, height, 4, linear));
+	const uint8_t *pLevel = texels.data();
+	for(size_t i = 0, w = width, h = height; i < chain.size(); ++i, w = std::max<size_t>(w / 2, 1), h = std::max<size_t>(h / 2, 1))
+	{
+		chain[i] = {static_cast<int>(w), static_cast<int>(h), pLevel};
+		pLevel += w * h * 4;
+	}
+
+	// Lay out header, level table and aligned level data
+	TextureContainer::Header header = {TextureContainer::MAGIC, format,
+		static_cast<uint32_t>(width), static_cast<uint32_t>(height), static_cast<uint32_t>(chain.size()), 0};
+	vector<TextureContainer::Level> table(chain.size());
+	vector<vector<uint8_t>> data(chain.size());
+	uint64_t offset = sizeof(header) + table.size() * sizeof(TextureContainer::Level);
+	for(size_t i = 0; i < chain.size(); ++i)
+	{
+		data[i] = encode(chain[i], format);
+		offset = (offset + TextureContainer::ALIGNMENT - 1) / TextureContainer::ALIGNMENT * TextureContainer::ALIGNMENT;
+		table[i] = {offset, data[i].size(), static_cast<uint32_t>(chain[i].width), static_cast<uint32_t>(chain[i].height)};
+		offset += data[i].size();
+	}
+
+	FILE *pFile = fopen(output, "wb");
+	if(pFile == nullptr)
+	{
+		cerr << "Could not open '" << output << "' for writing." << endl;
+		return 1;
+	}
+	fwrite(&header, sizeof(header), 1, pFile);
+	fwrite(table.data(), sizeof(TextureContainer::Level), table.size(), pFile);
+	for(size_t i = 0; i < chain.size(); ++i)
+	{
+		// Zero padding up to the level's offset
+		static const uint8_t zeros[TextureContainer::ALIGNMENT] = {};
+		fwrite(zeros, 1, table[i].offset - ftell(pFile), pFile);
+		fwrite(data[i].data(), 1, data[i].size(), pFile);
+	}
+	fclose(pFile);
+
+	static const char *FORMAT_NAMES[] = {"RGBA8", "BC1", "BC3", "BC7"};
+	cout << "Cooked '" << input << "' into '" << output << "': " << width << "x" << height << ", "
+		 << chain.size() << " levels, " << FORMAT_NAMES[format] << ", " << offset << " bytes." << endl;
+	return 0;
+}
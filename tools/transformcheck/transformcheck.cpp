@@ -0,0 +1,86 @@
+/*****************************************************************
+ * transformcheck.cpp
+ *****************************************************************
+ * Created on: 24.07.2015
+ * Author: HAUSWALD, Tom.
+ *****************************************************************
+ *****************************************************************/
+
+/*
+ * Checks the world matrices Transform commits per frame for motion vectors,
+ * as Game::setObjectTransform commits them: moves a transform across frames
+ * and verifies that the previous world matrix of every frame equals the world
+ * matrix of the frame before, also when the transform is committed more than
+ * once per frame, and that a transform not drawn during the frame before has
+ * no motion. Prints every failed check and returns 1 if any failed.
+ *
+ * Usage: transformcheck
+ *
+ * Build from the repository root, e.g.:
+ * g++ -std=gnu++11 -Ilib/glew-1.12.0/include -Ilib/glfw-3.1.1/include -Ilib/glm-0.9.6.3
+ *     tools/transformcheck/transformcheck.cpp fuel/core/Transform.cpp -o transformcheck
+ */
+
+#include <string>
+#include <iostream>
+#include "../../fuel/core/Transform.h"
+
+using namespace std;
+using namespace fuel;
+
+namespace
+{
+	// Number of failed checks
+	unsigned failures = 0;
+
+	/**
+	 * Reports a failed check if the matrices differ.
+	 */
+	void expectEqual(const string &name, const glm::mat4 &actual, const glm::mat4 &expected)
+	{
+		if(actual == expected) return;
+		cerr << "Failed: " << name << endl;
+		++failures;
+	}
+}
+
+int main(void)
+{
+	Transform transform({1, 2, 3});
+	const glm::mat4 initial = transform.calculateWorldMatrix();
+
+	// Frame 1: drawn where it was created
+	expectEqual("frame 1 world", transform.commitWorldMatrix(1), initial);
+	expectEqual("frame 1 previous world", transform.getPreviousWorldMatrix(), initial);
+
+	// Frame 2: moved and rotated, previous world is frame 1's
+	transform.setPosition({4, 5, 6});
+	transform.setRotation({0, 90, 0});
+	const glm::mat4 moved = transform.calculateWorldMatrix();
+	expectEqual("frame 2 world", transform.commitWorldMatrix(2), moved);
+	expectEqual("frame 2 previous world", transform.getPreviousWorldMatrix(), initial);
+
+	// Drawn again during frame 2 (another pass), previous world stays frame 1's
+	expectEqual("frame 2 second world", transform.commitWorldMatrix(2), moved);
+	expectEqual("frame 2 second previous world", transform.getPreviousWorldMatrix(), initial);
+
+	// Frame 3: moved again, previous world is frame 2's
+	transform.setPosition({7, 8, 9});
+	const glm::mat4 movedAgain = transform.calculateWorldMatrix();
+	expectEqual("frame 3 world", transform.commitWorldMatrix(3), movedAgain);
+	expectEqual("frame 3 previous world", transform.getPreviousWorldMatrix(), moved);
+
+	// Frame 5: not drawn during frame 4, so no motion
+	transform.setScale({2, 2, 2});
+	const glm::mat4 scaled = transform.calculateWorldMatrix();
+	expectEqual("frame 5 world", transform.commitWorldMatrix(5), scaled);
+	expectEqual("frame 5 previous world", transform.getPreviousWorldMatrix(), scaled);
+
+	if(failures > 0)
+	{
+		cerr << failures << " checks failed." << endl;
+		return 1;
+	}
+	cout << "All checks passed." << endl;
+	return 0;
+}